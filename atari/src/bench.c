@@ -0,0 +1,80 @@
+/*
+ * This file is part of the Blue2Joy project - an interface converter
+ * between a Bluetooth gamepad and a retro console joystick
+ * (https://github.com/cepetr/blue2joy).
+ * Copyright (c) 2025
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "spi.h"
+#include "sys.h"
+
+// Size of a single benchmark transfer (must match the firmware SPIS buffer)
+#define BENCH_BLOCK_SIZE 32
+
+// Number of frames a benchmark run takes
+#define BENCH_FRAMES 100
+
+static uint8_t g_tx[2][BENCH_BLOCK_SIZE];
+static uint8_t g_rx[BENCH_BLOCK_SIZE];
+
+// Runs a loop-back benchmark on the given port.
+//
+// The firmware echoes each received block back in the following
+// transfer, so every block received is compared with the one sent
+// before it.
+static void spi_benchmark(uint8_t port)
+{
+    uint16_t blocks = 0;
+    uint16_t errors = 0;
+    uint8_t cur = 0;
+
+    // Start at a frame boundary
+    sys_wait_frames(1);
+    uint8_t start = sys_frames();
+
+    while ((uint8_t)(sys_frames() - start) < BENCH_FRAMES) {
+        uint8_t *tx = g_tx[cur];
+        for (uint8_t i = 0; i < BENCH_BLOCK_SIZE; i++) {
+            tx[i] = (uint8_t)(blocks + i);
+        }
+
+        spi_transfer(port, tx, g_rx, BENCH_BLOCK_SIZE);
+
+        if (blocks > 0 && memcmp(g_rx, g_tx[cur ^ 1], BENCH_BLOCK_SIZE) != 0) {
+            errors++;
+        }
+
+        cur ^= 1;
+        blocks++;
+    }
+
+    uint32_t bytes = (uint32_t)blocks * BENCH_BLOCK_SIZE;
+
+    printf("Port %u: %lu bytes in %u frames\n", port, bytes, BENCH_FRAMES);
+    printf("  %lu bytes/frame, %u errors\n", bytes / BENCH_FRAMES, errors);
+}
+
+int main()
+{
+    for (;;) {
+        spi_benchmark(0);
+        spi_benchmark(1);
+    }
+
+    return 0;
+}
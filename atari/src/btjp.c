@@ -0,0 +1,649 @@
+/*
+ * This file is part of the Blue2Joy project - an interface converter
+ * between a Bluetooth gamepad and a retro console joystick
+ * (https://github.com/cepetr/blue2joy).
+ * Copyright (c) 2025
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include "btjp.h"
+#include "spi.h"
+#include "sys.h"
+
+// Length byte sent by the SPIS when no buffer is armed
+#define LINK_NOT_READY 0xFF
+
+// Maximum size of a single message (incl. header)
+#define LINK_MAX_MSG_SIZE 254
+
+// Response is still expected
+#define RSP_PENDING 0xFF
+
+typedef struct {
+    // SPI port
+    uint8_t port;
+    // Event callback
+    btjp_event_cb_t event_cb;
+    // Sequence number of the last request
+    uint8_t seq;
+
+    // Outgoing stream ([N][message]) and its length
+    uint8_t tx_buf[1 + LINK_MAX_MSG_SIZE];
+    uint8_t tx_len;
+    // Number of bytes of tx_buf already sent in the current transaction
+    uint8_t tx_pos;
+
+    // Incoming message
+    uint8_t rx_buf[LINK_MAX_MSG_SIZE];
+
+    // Pending response
+    struct {
+        uint8_t seq;
+        uint8_t status;
+        void *buf;
+        uint8_t size;
+    } rsp;
+
+    btjp_state_t state;
+
+} btjp_client_t;
+
+static btjp_client_t g_btjp;
+
+void btjp_init(uint8_t port, btjp_event_cb_t event_cb)
+{
+    memset(&g_btjp, 0, sizeof(g_btjp));
+    g_btjp.state.active_profile = BTJP_ACTIVE_PROFILE_NONE;
+    g_btjp.port = port;
+    g_btjp.event_cb = event_cb;
+}
+
+const btjp_state_t *btjp_state(void)
+{
+    return &g_btjp.state;
+}
+
+// Clocks `len` bytes within the current transaction, sending the rest
+// of the outgoing stream (or zeros) and storing the received bytes
+static void link_exchange(uint8_t *rx, uint8_t len)
+{
+    uint8_t tx_left = g_btjp.tx_len - g_btjp.tx_pos;
+
+    if (tx_left > 0) {
+        uint8_t n = len < tx_left ? len : tx_left;
+        spi_exchange(&g_btjp.tx_buf[g_btjp.tx_pos], rx, n);
+        g_btjp.tx_pos += n;
+        rx = rx != NULL ? rx + n : NULL;
+        len -= n;
+    }
+
+    if (len > 0) {
+        spi_exchange(NULL, rx, len);
+    }
+}
+
+// Profile encoding (see firmware/src/mapper/profile_dto.h)
+#define SLOT_POT(i)  (BTJP_PIN_COUNT + (i))
+#define SLOT_INTG(i) (BTJP_PIN_COUNT + BTJP_POT_COUNT + (i))
+#define SLOT_PROGRAM SLOT_INTG(BTJP_INTG_COUNT)
+#define SLOT_CHORD   (SLOT_PROGRAM + 1)
+#define SLOT_NAME    (SLOT_CHORD + 1)
+
+typedef struct {
+    uint8_t *ptr;
+    uint8_t *end;
+    uint8_t error;
+} codec_t;
+
+static uint8_t get_u8(codec_t *c)
+{
+    if (c->ptr < c->end) {
+        return *c->ptr++;
+    }
+    c->error = 1;
+    return 0;
+}
+
+static uint32_t get_varint(codec_t *c)
+{
+    uint32_t value = 0;
+
+    for (uint8_t shift = 0; shift < 35; shift += 7) {
+        uint8_t byte = get_u8(c);
+        value |= (uint32_t)(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return value;
+        }
+    }
+
+    c->error = 1;
+    return 0;
+}
+
+static int16_t get_svarint(codec_t *c)
+{
+    uint32_t value = get_varint(c);
+    return (int16_t)((value >> 1) ^ -(value & 1));
+}
+
+static void put_u8(codec_t *c, uint8_t value)
+{
+    if (c->ptr < c->end) {
+        *c->ptr++ = value;
+    } else {
+        c->error = 1;
+    }
+}
+
+static void put_varint(codec_t *c, uint32_t value)
+{
+    do {
+        uint8_t byte = value & 0x7F;
+        value >>= 7;
+        put_u8(c, value != 0 ? byte | 0x80 : byte);
+    } while (value != 0);
+}
+
+static void put_svarint(codec_t *c, int16_t value)
+{
+    put_varint(c, ((uint32_t)(int32_t)value << 1) ^ (uint32_t)(value < 0 ? -1L : 0));
+}
+
+static void get_curve(codec_t *c, btjp_curve_t *curve)
+{
+    curve->type = get_u8(c);
+
+    if (curve->type == BTJP_CURVE_EXPO || curve->type == BTJP_CURVE_S) {
+        curve->amount = get_u8(c);
+    } else if (curve->type == BTJP_CURVE_CUSTOM) {
+        for (uint8_t i = 0; i < sizeof(curve->points); i++) {
+            curve->points[i] = get_u8(c);
+        }
+    } else if (curve->type != BTJP_CURVE_LINEAR) {
+        c->error = 1;
+    }
+}
+
+static void put_curve(codec_t *c, const btjp_curve_t *curve)
+{
+    put_u8(c, curve->type);
+
+    if (curve->type == BTJP_CURVE_EXPO || curve->type == BTJP_CURVE_S) {
+        put_u8(c, curve->amount);
+    } else if (curve->type == BTJP_CURVE_CUSTOM) {
+        for (uint8_t i = 0; i < sizeof(curve->points); i++) {
+            put_u8(c, curve->points[i]);
+        }
+    }
+}
+
+static uint8_t curve_is_linear(const btjp_curve_t *curve)
+{
+    return curve->type == BTJP_CURVE_LINEAR;
+}
+
+static uint8_t profile_decode(uint8_t *data, uint8_t size, btjp_profile_t *profile)
+{
+    codec_t c = {data, data + size, 0};
+
+    memset(profile, 0, sizeof(*profile));
+
+    if (get_u8(&c) != BTJP_PROFILE_DATA_VERSION) {
+        return 0;
+    }
+
+    uint16_t present = get_u8(&c);
+    present |= (uint16_t)get_u8(&c) << 8;
+
+    for (uint8_t i = 0; i < BTJP_PIN_COUNT; i++) {
+        if (present & (1 << i)) {
+            btjp_pin_config_t *pin = &profile->pins[i];
+            pin->source = get_varint(&c);
+            uint8_t flags = get_u8(&c);
+            pin->invert = flags & 0x01;
+            pin->hat_switch = flags >> 4;
+            pin->threshold = get_u8(&c);
+            pin->hysteresis = get_u8(&c);
+            if (flags & 0x02) {
+                pin->autofire = get_u8(&c);
+            }
+        }
+    }
+
+    for (uint8_t i = 0; i < BTJP_POT_COUNT; i++) {
+        if (present & (1 << SLOT_POT(i))) {
+            btjp_pot_config_t *pot = &profile->pots[i];
+            pot->source = get_varint(&c);
+            pot->low = get_svarint(&c);
+            pot->high = get_svarint(&c);
+            get_curve(&c, &pot->curve);
+        }
+    }
+
+    for (uint8_t i = 0; i < BTJP_INTG_COUNT; i++) {
+        if (present & (1 << SLOT_INTG(i))) {
+            btjp_intg_config_t *intg = &profile->intgs[i];
+            intg->source = get_varint(&c);
+            intg->mode = get_u8(&c);
+            intg->dead_zone = get_u8(&c);
+            intg->gain = get_svarint(&c);
+            intg->max = get_svarint(&c);
+            get_curve(&c, &intg->curve);
+        }
+    }
+
+    if (present & (1 << SLOT_PROGRAM)) {
+        btjp_program_t *program = &profile->program;
+        program->size = get_u8(&c);
+        if (program->size > sizeof(program->code)) {
+            return 0;
+        }
+        for (uint8_t i = 0; i < program->size; i++) {
+            program->code[i] = get_u8(&c);
+        }
+    }
+
+    if (present & (1 << SLOT_CHORD)) {
+        profile->chord = get_varint(&c);
+    }
+
+    if (present & (1 << SLOT_NAME)) {
+        uint8_t len = get_u8(&c);
+        if (len > BTJP_PROFILE_NAME_LEN) {
+            return 0;
+        }
+        for (uint8_t i = 0; i < len; i++) {
+            profile->name[i] = get_u8(&c);
+        }
+    }
+
+    return !c.error && c.ptr == c.end;
+}
+
+static uint8_t profile_encode(const btjp_profile_t *profile, uint8_t *data, uint8_t size)
+{
+    codec_t c = {data, data + size, 0};
+    uint16_t present = 0;
+
+    for (uint8_t i = 0; i < BTJP_PIN_COUNT; i++) {
+        const btjp_pin_config_t *pin = &profile->pins[i];
+        if (pin->source || pin->invert || pin->hat_switch || pin->threshold || pin->hysteresis ||
+            pin->autofire) {
+            present |= 1 << i;
+        }
+    }
+
+    for (uint8_t i = 0; i < BTJP_POT_COUNT; i++) {
+        const btjp_pot_config_t *pot = &profile->pots[i];
+        if (pot->source || pot->low || pot->high || !curve_is_linear(&pot->curve)) {
+            present |= 1 << SLOT_POT(i);
+        }
+    }
+
+    for (uint8_t i = 0; i < BTJP_INTG_COUNT; i++) {
+        const btjp_intg_config_t *intg = &profile->intgs[i];
+        if (intg->source || intg->mode || intg->dead_zone || intg->gain || intg->max ||
+            !curve_is_linear(&intg->curve)) {
+            present |= 1 << SLOT_INTG(i);
+        }
+    }
+
+    if (profile->program.size > 0) {
+        present |= 1 << SLOT_PROGRAM;
+    }
+
+    if (profile->chord) {
+        present |= 1 << SLOT_CHORD;
+    }
+
+    uint8_t name_len = strlen(profile->name);
+    if (name_len > 0) {
+        present |= 1 << SLOT_NAME;
+    }
+
+    put_u8(&c, BTJP_PROFILE_DATA_VERSION);
+    put_u8(&c, present & 0xFF);
+    put_u8(&c, present >> 8);
+
+    for (uint8_t i = 0; i < BTJP_PIN_COUNT; i++) {
+        if (present & (1 << i)) {
+            const btjp_pin_config_t *pin = &profile->pins[i];
+            put_varint(&c, pin->source);
+            put_u8(&c, (pin->invert ? 0x01 : 0) | (pin->autofire ? 0x02 : 0) |
+                           (pin->hat_switch << 4));
+            put_u8(&c, pin->threshold);
+            put_u8(&c, pin->hysteresis);
+            if (pin->autofire) {
+                put_u8(&c, pin->autofire);
+            }
+        }
+    }
+
+    for (uint8_t i = 0; i < BTJP_POT_COUNT; i++) {
+        if (present & (1 << SLOT_POT(i))) {
+            const btjp_pot_config_t *pot = &profile->pots[i];
+            put_varint(&c, pot->source);
+            put_svarint(&c, pot->low);
+            put_svarint(&c, pot->high);
+            put_curve(&c, &pot->curve);
+        }
+    }
+
+    for (uint8_t i = 0; i < BTJP_INTG_COUNT; i++) {
+        if (present & (1 << SLOT_INTG(i))) {
+            const btjp_intg_config_t *intg = &profile->intgs[i];
+            put_varint(&c, intg->source);
+            put_u8(&c, intg->mode);
+            put_u8(&c, intg->dead_zone);
+            put_svarint(&c, intg->gain);
+            put_svarint(&c, intg->max);
+            put_curve(&c, &intg->curve);
+        }
+    }
+
+    if (present & (1 << SLOT_PROGRAM)) {
+        put_u8(&c, profile->program.size);
+        for (uint8_t i = 0; i < profile->program.size; i++) {
+            put_u8(&c, profile->program.code[i]);
+        }
+    }
+
+    if (present & (1 << SLOT_CHORD)) {
+        put_varint(&c, profile->chord);
+    }
+
+    if (present & (1 << SLOT_NAME)) {
+        put_u8(&c, name_len);
+        for (uint8_t i = 0; i < name_len; i++) {
+            put_u8(&c, profile->name[i]);
+        }
+    }
+
+    return c.error ? 0 : c.ptr - data;
+}
+
+static void dev_list_update(const btjp_evt_dev_list_update_t *evt)
+{
+    btjp_state_t *state = &g_btjp.state;
+    uint8_t i;
+
+    for (i = 0; i < state->dev_count; i++) {
+        if (memcmp(&state->dev[i].addr, &evt->addr, sizeof(evt->addr)) == 0) {
+            break;
+        }
+    }
+
+    if (evt->deleted) {
+        if (i < state->dev_count) {
+            memmove(&state->dev[i], &state->dev[i + 1],
+                    (state->dev_count - i - 1) * sizeof(state->dev[0]));
+            state->dev_count--;
+        }
+        return;
+    }
+
+    if (i == state->dev_count) {
+        if (state->dev_count >= BTJP_MAX_DEVICES) {
+            return;
+        }
+        state->dev_count++;
+        state->dev[i].addr = evt->addr;
+    }
+
+    state->dev[i].conn_state = evt->conn_state;
+    state->dev[i].profile = evt->profile;
+    state->dev[i].flags = evt->flags;
+}
+
+static void process_event(const btjp_msg_header_t *hdr, const uint8_t *payload)
+{
+    btjp_state_t *state = &g_btjp.state;
+
+    switch (hdr->msg_id) {
+    case BTJP_MSG_EVT_SYS_STATE_UPDATE:
+        if (hdr->size >= sizeof(state->sys)) {
+            memcpy(&state->sys, payload, sizeof(state->sys));
+        }
+        break;
+
+    case BTJP_MSG_EVT_IO_PORT_UPDATE:
+        if (hdr->size >= sizeof(state->io)) {
+            memcpy(&state->io, payload, sizeof(state->io));
+        }
+        break;
+
+    case BTJP_MSG_EVT_DEV_LIST_UPDATE:
+        if (hdr->size >= sizeof(btjp_evt_dev_list_update_t)) {
+            dev_list_update((const btjp_evt_dev_list_update_t *)payload);
+        }
+        break;
+
+    case BTJP_MSG_EVT_PROFILE_UPDATE:
+        if (hdr->size > 1 && payload[0] < BTJP_MAX_PROFILES) {
+            uint8_t idx = payload[0];
+            if (profile_decode((uint8_t *)payload + 1, hdr->size - 1, &state->profile[idx])) {
+                state->profile_valid |= 1 << idx;
+            }
+        }
+        break;
+
+    case BTJP_MSG_EVT_ACTIVE_PROFILE_UPDATE:
+        if (hdr->size >= 1) {
+            state->active_profile = payload[0];
+        }
+        break;
+
+    case BTJP_MSG_EVT_LIST_RESET:
+        // Deletions were lost, the complete list follows
+        state->dev_count = 0;
+        break;
+
+    default:
+        break;
+    }
+
+    if (g_btjp.event_cb != NULL) {
+        g_btjp.event_cb(hdr, payload);
+    }
+}
+
+static void process_response(const btjp_msg_header_t *hdr, const uint8_t *payload)
+{
+    if (g_btjp.rsp.status != RSP_PENDING || hdr->seq != g_btjp.rsp.seq) {
+        // Stale or unsolicited response
+        return;
+    }
+
+    if ((hdr->flags & BTJP_MSG_TYPE_MASK) == BTJP_MSG_TYPE_ERROR) {
+        g_btjp.rsp.status =
+            (hdr->size > 0 && payload[0] != 0) ? payload[0] : BTJP_ERR_INVALID_REQ;
+    } else if (hdr->size != g_btjp.rsp.size) {
+        g_btjp.rsp.status = BTJP_ERR_RSP_SIZE;
+    } else {
+        if (g_btjp.rsp.size > 0) {
+            memcpy(g_btjp.rsp.buf, payload, g_btjp.rsp.size);
+        }
+        g_btjp.rsp.status = BTJP_ERR_NONE;
+    }
+}
+
+static void process_message(uint8_t len)
+{
+    const btjp_msg_header_t *hdr = (const btjp_msg_header_t *)g_btjp.rx_buf;
+    const uint8_t *payload = &g_btjp.rx_buf[sizeof(btjp_msg_header_t)];
+
+    if (len < sizeof(btjp_msg_header_t) || hdr->size > len - sizeof(btjp_msg_header_t)) {
+        // Malformed message
+        return;
+    }
+
+    switch (hdr->flags & BTJP_MSG_TYPE_MASK) {
+    case BTJP_MSG_TYPE_EVENT:
+        process_event(hdr, payload);
+        break;
+    case BTJP_MSG_TYPE_RESPONSE:
+    case BTJP_MSG_TYPE_ERROR:
+        process_response(hdr, payload);
+        break;
+    default:
+        break;
+    }
+}
+
+uint8_t btjp_poll(void)
+{
+    uint8_t count = 0;
+    uint8_t ready = 1;
+
+    g_btjp.tx_pos = 0;
+
+    spi_begin(g_btjp.port);
+
+    while (count < BTJP_LINK_BATCH) {
+        uint8_t len;
+        link_exchange(&len, 1);
+
+        if (len == LINK_NOT_READY && count == 0) {
+            // The slave is still busy with the previous transaction
+            // and ignores everything we send
+            ready = 0;
+            break;
+        }
+
+        if (len == 0 || len > LINK_MAX_MSG_SIZE) {
+            break;
+        }
+
+        link_exchange(g_btjp.rx_buf, len);
+        process_message(len);
+        count++;
+    }
+
+    // Finish sending our own message if the slave had less to say
+    if (g_btjp.tx_pos < g_btjp.tx_len) {
+        link_exchange(NULL, g_btjp.tx_len - g_btjp.tx_pos);
+    }
+
+    spi_end(g_btjp.port);
+
+    if (ready) {
+        // The outgoing message is sent only once
+        g_btjp.tx_len = 0;
+    }
+
+    return count;
+}
+
+int btjp_request(uint8_t msg_id, const void *req, uint8_t req_size, void *rsp, uint8_t rsp_size)
+{
+    uint8_t msg_size = sizeof(btjp_msg_header_t) + req_size;
+
+    if (msg_size > LINK_MAX_MSG_SIZE) {
+        return -BTJP_ERR_INVALID_REQ;
+    }
+
+    btjp_msg_header_t *hdr = (btjp_msg_header_t *)&g_btjp.tx_buf[1];
+    // The local state is only updated from the events
+    hdr->flags = BTJP_MSG_TYPE_REQUEST | BTJP_MSG_FLAG_ECHO;
+    hdr->msg_id = msg_id;
+    hdr->seq = ++g_btjp.seq;
+    hdr->size = req_size;
+
+    if (req_size > 0) {
+        memcpy(&g_btjp.tx_buf[1 + sizeof(btjp_msg_header_t)], req, req_size);
+    }
+
+    g_btjp.tx_buf[0] = msg_size;
+    g_btjp.tx_len = 1 + msg_size;
+
+    g_btjp.rsp.seq = hdr->seq;
+    g_btjp.rsp.status = RSP_PENDING;
+    g_btjp.rsp.buf = rsp;
+    g_btjp.rsp.size = rsp_size;
+
+    uint8_t start = sys_frames();
+
+    do {
+        btjp_poll();
+
+        if (g_btjp.rsp.status != RSP_PENDING) {
+            return -(int)g_btjp.rsp.status;
+        }
+    } while ((uint8_t)(sys_frames() - start) < BTJP_RSP_TIMEOUT);
+
+    // Ignore the response if it arrives later
+    g_btjp.rsp.status = BTJP_ERR_TIMEOUT;
+    return -BTJP_ERR_TIMEOUT;
+}
+
+int btjp_sync(void)
+{
+    int err = btjp_request(BTJP_MSG_GET_API_VERSION, NULL, 0, &g_btjp.state.api_version,
+                           sizeof(g_btjp.state.api_version));
+    if (err < 0) {
+        return err;
+    }
+
+    if (g_btjp.state.api_version.major != BTJP_API_VERSION_MAJOR) {
+        return -BTJP_ERR_VERSION;
+    }
+
+    uint8_t all = (1 << BTJP_MAX_PROFILES) - 1;
+    uint8_t start = sys_frames();
+
+    while (g_btjp.state.profile_valid != all) {
+        if ((uint8_t)(sys_frames() - start) >= BTJP_RSP_TIMEOUT) {
+            return -BTJP_ERR_TIMEOUT;
+        }
+        btjp_poll();
+    }
+
+    return 0;
+}
+
+const btjp_profile_t *btjp_get_profile(uint8_t idx)
+{
+    if (idx >= BTJP_MAX_PROFILES || !(g_btjp.state.profile_valid & (1 << idx))) {
+        return NULL;
+    }
+
+    return &g_btjp.state.profile[idx];
+}
+
+int btjp_set_profile(uint8_t idx, const btjp_profile_t *profile)
+{
+    btjp_profile_msg_t req;
+
+    req.profile = idx;
+
+    uint8_t size = profile_encode(profile, req.data, sizeof(req.data));
+    if (size == 0) {
+        return -BTJP_ERR_INVALID_ARG;
+    }
+
+    return btjp_request(BTJP_MSG_SET_PROFILE, &req, 1 + size, NULL, 0);
+}
+
+int btjp_set_dev_config(const btjp_dev_addr_t *addr, uint8_t profile, uint8_t flags)
+{
+    btjp_req_set_dev_config_t req;
+
+    req.addr = *addr;
+    req.profile = profile;
+    req.flags = flags;
+
+    return btjp_request(BTJP_MSG_SET_DEV_CONFIG, &req, sizeof(req), NULL, 0);
+}
@@ -0,0 +1,159 @@
+/*
+ * This file is part of the Blue2Joy project - an interface converter
+ * between a Bluetooth gamepad and a retro console joystick
+ * (https://github.com/cepetr/blue2joy).
+ * Copyright (c) 2025
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "btjp_msg.h"
+
+// btjp client over the joystick port SPI link
+//
+// Link framing: the Atari is the SPI master and every transaction
+// (CS low ... CS high) carries a stream of length-prefixed messages
+// in both directions:
+//
+//   master -> slave:  [N][N bytes message] 00 00 ...
+//   slave -> master:  [M1][M1 bytes message][M2][M2 bytes message] ... 00
+//
+// A zero length ends the stream, 0xFF (the SPIS default character)
+// means the slave has no buffer armed yet (the request is then sent
+// again in the next transaction). The master stops reading
+// after BTJP_LINK_BATCH messages; the slave keeps every message whose
+// bytes were not completely clocked out and sends it again in the next
+// transaction. The slave side is firmware/src/io/spislave.c.
+// The library only depends on spi.h and sys.h, so it can be
+// linked against a host-side mock of both.
+
+// Maximum number of devices kept in the device list
+#define BTJP_MAX_DEVICES 4
+
+// Number of profiles supported by the firmware
+#define BTJP_MAX_PROFILES 4
+
+// Maximum number of messages read in one SPI transaction
+#define BTJP_LINK_BATCH 8
+
+// Number of frames to wait for a response
+#define BTJP_RSP_TIMEOUT 50
+
+// Client-side error codes (returned negated, next to BTJP_ERR_xxx)
+#define BTJP_ERR_TIMEOUT  16
+#define BTJP_ERR_RSP_SIZE 17
+#define BTJP_ERR_VERSION  18
+
+typedef struct {
+    btjp_dev_addr_t addr;
+    uint8_t conn_state;
+    uint8_t profile;
+    uint8_t flags;
+} btjp_dev_entry_t;
+
+// State mirrored from the received events
+typedef struct {
+    // API version reported by the firmware
+    btjp_rsp_get_api_version_t api_version;
+    // System state
+    btjp_evt_sys_state_update_t sys;
+    // Joystick port state
+    btjp_evt_io_port_update_t io;
+    // Device list
+    uint8_t dev_count;
+    btjp_dev_entry_t dev[BTJP_MAX_DEVICES];
+    // Profile used for mapping (BTJP_ACTIVE_PROFILE_NONE if none)
+    uint8_t active_profile;
+    // Bit mask of profiles received so far
+    uint8_t profile_valid;
+    btjp_profile_t profile[BTJP_MAX_PROFILES];
+} btjp_state_t;
+
+// Called for every event received (after the state was updated)
+typedef void (*btjp_event_cb_t)(const btjp_msg_header_t *hdr, const void *payload);
+
+/** Initializes the client
+ *
+ * @param port The SPI port the Blue2Joy is connected to (0 or 1)
+ * @param event_cb Optional callback invoked for each received event
+ *
+ * */
+void btjp_init(uint8_t port, btjp_event_cb_t event_cb);
+
+/** Returns the state mirrored from the received events
+ *
+ * */
+const btjp_state_t *btjp_state(void);
+
+/** Runs one SPI transaction and processes all messages received
+ *
+ * @return Number of messages received
+ *
+ * */
+uint8_t btjp_poll(void);
+
+/** Sends a request and waits for the response with the matching sequence number
+ *
+ * Events received while waiting are processed as in btjp_poll().
+ *
+ * @param msg_id Request message identifier
+ * @param req Request payload (can be NULL if req_size is 0)
+ * @param req_size Size of the request payload
+ * @param rsp Buffer for the response payload (can be NULL if rsp_size is 0)
+ * @param rsp_size Expected size of the response payload
+ *
+ * @return 0 on success, negative BTJP_ERR_xxx code otherwise
+ *
+ * */
+int btjp_request(uint8_t msg_id, const void *req, uint8_t req_size, void *rsp, uint8_t rsp_size);
+
+/** Checks the API version and waits until all profiles are received
+ *
+ * @return 0 on success, negative BTJP_ERR_xxx code otherwise
+ *
+ * */
+int btjp_sync(void);
+
+/** Returns the profile received from the firmware
+ *
+ * @param idx Profile index
+ *
+ * @return Pointer to the profile or NULL if not received yet
+ *
+ * */
+const btjp_profile_t *btjp_get_profile(uint8_t idx);
+
+/** Replaces the whole profile
+ *
+ * @param idx Profile index
+ * @param profile New profile configuration
+ *
+ * @return 0 on success, negative BTJP_ERR_xxx code otherwise
+ *
+ * */
+int btjp_set_profile(uint8_t idx, const btjp_profile_t *profile);
+
+/** Assigns a profile to a device
+ *
+ * @param addr Device address
+ * @param profile Profile index
+ * @param flags BTJP_DEV_FLAG_xxx
+ *
+ * @return 0 on success, negative BTJP_ERR_xxx code otherwise
+ *
+ * */
+int btjp_set_dev_config(const btjp_dev_addr_t *addr, uint8_t profile, uint8_t flags);
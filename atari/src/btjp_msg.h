@@ -0,0 +1,223 @@
+/*
+ * This file is part of the Blue2Joy project - an interface converter
+ * between a Bluetooth gamepad and a retro console joystick
+ * (https://github.com/cepetr/blue2joy).
+ * Copyright (c) 2025
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+// btjp wire definitions (see firmware/src/btjp/btjp_msg.h)
+//
+// The firmware structures are laid out with the natural ARM alignment,
+// the 6502 has none, so the padding is spelled out explicitly here.
+// All multi-byte values are little-endian on both sides.
+
+#define BTJP_API_VERSION_MAJOR 3
+
+#define BTJP_MSG_TYPE_MASK 0x03
+
+#define BTJP_MSG_TYPE_REQUEST  0
+#define BTJP_MSG_TYPE_EVENT    1
+#define BTJP_MSG_TYPE_RESPONSE 2
+#define BTJP_MSG_TYPE_ERROR    3
+
+// Request flag: events caused by the request are sent also to the
+// requesting client (by default only other clients get them)
+#define BTJP_MSG_FLAG_ECHO 0x04
+
+// Message identifiers
+#define BTJP_MSG_GET_API_VERSION 0
+#define BTJP_MSG_GET_SYS_INFO    1
+#define BTJP_MSG_SET_DEV_CONFIG  2
+#define BTJP_MSG_SET_PIN_CONFIG  3
+#define BTJP_MSG_SET_POT_CONFIG  4
+#define BTJP_MSG_SET_INTG_CONFIG 5
+#define BTJP_MSG_SET_PROFILE     6
+#define BTJP_MSG_SET_MODE        7
+#define BTJP_MSG_START_SCANNING  8
+#define BTJP_MSG_STOP_SCANNING   9
+#define BTJP_MSG_CONNECT_DEVICE  10
+#define BTJP_MSG_DELETE_DEVICE   11
+#define BTJP_MSG_FACTORY_RESET   12
+
+#define BTJP_MSG_EVT_SYS_STATE_UPDATE      64
+#define BTJP_MSG_EVT_IO_PORT_UPDATE        65
+#define BTJP_MSG_EVT_ADV_LIST_UPDATE       66
+#define BTJP_MSG_EVT_DEV_LIST_UPDATE       67
+#define BTJP_MSG_EVT_PROFILE_UPDATE        68
+#define BTJP_MSG_EVT_ACTIVE_PROFILE_UPDATE 69
+#define BTJP_MSG_EVT_LIST_RESET            72
+
+// Active profile if no report was mapped yet
+#define BTJP_ACTIVE_PROFILE_NONE 0xFF
+
+// Error codes carried by BTJP_MSG_TYPE_ERROR responses
+#define BTJP_ERR_NONE        0
+#define BTJP_ERR_UNKNOWN_MSG 1
+#define BTJP_ERR_INVALID_REQ 2
+#define BTJP_ERR_INVALID_ARG 3
+
+#define BTJP_PIN_COUNT  5
+#define BTJP_POT_COUNT  2
+#define BTJP_INTG_COUNT 2
+
+typedef struct {
+    uint8_t flags;
+    uint8_t msg_id;
+    uint8_t seq;
+    uint8_t size;
+} btjp_msg_header_t;
+
+// Device address (mac address + type)
+typedef struct {
+    uint8_t val[7];
+} btjp_dev_addr_t;
+
+typedef struct {
+    uint8_t major;
+    uint8_t minor;
+} btjp_rsp_get_api_version_t;
+
+typedef struct {
+    uint8_t hw_id[8];
+    uint32_t hw_version;
+    uint32_t sw_version;
+} btjp_rsp_get_sys_info_t;
+
+// Device configuration flags
+#define BTJP_DEV_FLAG_BOOT_PROTOCOL 0x01
+
+typedef struct {
+    btjp_dev_addr_t addr;
+    uint8_t profile;
+    uint8_t flags;
+} btjp_req_set_dev_config_t;
+
+typedef struct {
+    uint8_t mode;
+    uint8_t restart;
+} btjp_req_set_mode_t;
+
+// Decoded profile slots (SET_PROFILE and EVT_PROFILE_UPDATE carry them
+// in the compact profile encoding, see firmware/src/mapper/profile_dto.h)
+typedef struct {
+    uint32_t source;
+    uint8_t invert;
+    uint8_t hat_switch;
+    uint8_t threshold;
+    uint8_t hysteresis;
+    // Autofire period in frames (0 => off)
+    uint8_t autofire;
+} btjp_pin_config_t;
+
+// Response curve types
+#define BTJP_CURVE_LINEAR 0
+#define BTJP_CURVE_EXPO   1
+#define BTJP_CURVE_S      2
+#define BTJP_CURVE_CUSTOM 3
+
+typedef struct {
+    uint8_t type;
+    uint8_t amount;
+    uint8_t points[4];
+} btjp_curve_t;
+
+typedef struct {
+    uint32_t source;
+    int16_t low;
+    int16_t high;
+    btjp_curve_t curve;
+} btjp_pot_config_t;
+
+typedef struct {
+    uint32_t source;
+    uint8_t mode;
+    uint8_t dead_zone;
+    int16_t gain;
+    int16_t max;
+    btjp_curve_t curve;
+} btjp_intg_config_t;
+
+// Mapping program (carried through unchanged)
+#define BTJP_PROGRAM_SIZE 64
+
+typedef struct {
+    uint8_t size;
+    uint8_t code[BTJP_PROGRAM_SIZE];
+} btjp_program_t;
+
+// Maximum length of a profile name (without the terminating zero)
+#define BTJP_PROFILE_NAME_LEN 15
+
+typedef struct {
+    // Profile name (zero terminated, empty if unnamed)
+    char name[BTJP_PROFILE_NAME_LEN + 1];
+    btjp_pin_config_t pins[BTJP_PIN_COUNT];
+    btjp_pot_config_t pots[BTJP_POT_COUNT];
+    btjp_intg_config_t intgs[BTJP_INTG_COUNT];
+    btjp_program_t program;
+    // Chord button selecting profiles by the hat switch (0 => disabled)
+    uint32_t chord;
+} btjp_profile_t;
+
+// Version of the profile encoding
+#define BTJP_PROFILE_DATA_VERSION 2
+
+// Maximum size of an encoded profile
+#define BTJP_PROFILE_DATA_MAX_SIZE 208
+
+// Payload of SET_PROFILE and EVT_PROFILE_UPDATE
+typedef struct {
+    uint8_t profile;
+    uint8_t data[BTJP_PROFILE_DATA_MAX_SIZE];
+} btjp_profile_msg_t;
+
+typedef struct {
+    btjp_dev_addr_t addr;
+} btjp_req_connect_device_t;
+
+typedef struct {
+    btjp_dev_addr_t addr;
+} btjp_req_delete_device_t;
+
+typedef struct {
+    uint8_t scanning;
+    uint8_t mode;
+} btjp_evt_sys_state_update_t;
+
+typedef struct {
+    uint8_t deleted;
+    btjp_dev_addr_t addr;
+    int8_t rssi;
+    char name[30 + 1];
+} btjp_evt_adv_list_update_t;
+
+typedef struct {
+    uint8_t deleted;
+    btjp_dev_addr_t addr;
+    uint8_t conn_state;
+    uint8_t profile;
+    uint8_t flags;
+} btjp_evt_dev_list_update_t;
+
+typedef struct {
+    uint8_t pins;
+    uint8_t pots[2];
+} btjp_evt_io_port_update_t;
+
+_Static_assert(sizeof(btjp_evt_adv_list_update_t) == 40, "btjp_evt_adv_list_update_t size mismatch");
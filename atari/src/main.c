@@ -18,21 +18,325 @@
  */
 
 #include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
 #include <atari.h>
 
-#include "spi.h"
+#include "btjp.h"
+#include "sys.h"
+
+// Joystick port the Blue2Joy is connected to
+#define BTJP_PORT 0
+
+#define KEY_NONE   0xFF
+#define KEY_RETURN '\n'
+#define KEY_ESC    0x1B
+#define KEY_BKSP   0x08
+
+// ATASCII clear screen character
+#define CLEAR_SCREEN 0x7D
+
+// Keyboard code (without SHIFT/CTRL) to character
+static const char g_keymap[64] = {
+    'L', 'J', ';', 0,   0,   'K', '+', '*', 'O', 0,   'P', 'U', '\n', 'I', '-', '=',
+    'V', 0,   'C', 0,   0,   'B', 'X', 'Z', '4', 0,   '3', '6', 0x1B, '5', '2', '1',
+    ',', ' ', '.', 'N', 0,   'M', '/', 0,   'R', 0,   'E', 'Y', '\t', 'T', 'W', 'Q',
+    '9', 0,   '0', '7', 0x08, '8', '<', '>', 'F', 'H', 'D', 0,  0,    'G', 'S', 'A',
+};
+
+static const char *const g_pin_names[BTJP_PIN_COUNT] = {"UP", "DOWN", "LEFT", "RIGHT", "TRIG"};
+
+static const char *const g_conn_states[] = {"CLOSED", "ERROR", "CONN..", "CONN", "READY"};
+
+static const char *const g_modes[] = {"AUTO", "PAIR", "MANUAL"};
+
+// Set when an event changed the mirrored state
+static bool g_dirty;
+
+static void event_callback(const btjp_msg_header_t *hdr, const void *payload)
+{
+    if (hdr->msg_id != BTJP_MSG_EVT_IO_PORT_UPDATE) {
+        g_dirty = true;
+    }
+}
+
+// Returns the pressed key or KEY_NONE if no key was pressed during
+// the next frame (the btjp link is serviced meanwhile)
+static char poll_key(void)
+{
+    btjp_poll();
+    sys_wait_frames(1);
+
+    uint8_t code = OS.ch;
+    if (code == KEY_NONE) {
+        return KEY_NONE;
+    }
+
+    OS.ch = KEY_NONE;
+    return g_keymap[code & 0x3F];
+}
+
+static char get_key(void)
+{
+    char key;
+
+    while ((key = poll_key()) == (char)KEY_NONE) {
+    }
+
+    return key;
+}
+
+// Reads a number in the given base (10 or 16)
+static int32_t read_number(const char *prompt, uint8_t base)
+{
+    int32_t value = 0;
+    bool negative = false;
+
+    printf("%s", prompt);
+
+    for (;;) {
+        char key = get_key();
+        uint8_t digit;
+
+        if (key >= '0' && key <= '9') {
+            digit = key - '0';
+        } else if (base == 16 && key >= 'A' && key <= 'F') {
+            digit = key - 'A' + 10;
+        } else if (key == '-' && base == 10 && value == 0) {
+            negative = true;
+            putchar(key);
+            continue;
+        } else if (key == KEY_RETURN) {
+            putchar('\n');
+            return negative ? -value : value;
+        } else {
+            continue;
+        }
+
+        value = value * base + digit;
+        putchar(key);
+    }
+}
+
+static void print_addr(const btjp_dev_addr_t *addr)
+{
+    // Address is stored little-endian, the last byte is the type
+    for (int8_t i = 5; i >= 0; i--) {
+        printf("%02X", addr->val[i]);
+    }
+}
+
+static void print_item(const btjp_profile_t *profile, uint8_t item)
+{
+    if (item < BTJP_PIN_COUNT) {
+        const btjp_pin_config_t *pin = &profile->pins[item];
+        printf("%u %-5s %08lX I%u H%u T%u Y%u A%u\n", item, g_pin_names[item], pin->source,
+               pin->invert, pin->hat_switch, pin->threshold, pin->hysteresis, pin->autofire);
+        return;
+    }
+
+    item -= BTJP_PIN_COUNT;
+    if (item < BTJP_POT_COUNT) {
+        const btjp_pot_config_t *pot = &profile->pots[item];
+        printf("%u POT%u  %08lX L%d H%d\n", item + BTJP_PIN_COUNT, item + 1, pot->source,
+               pot->low, pot->high);
+        return;
+    }
+
+    item -= BTJP_POT_COUNT;
+    const btjp_intg_config_t *intg = &profile->intgs[item];
+    printf("%u INT%u  %08lX %s D%u G%d M%d\n", item + BTJP_PIN_COUNT + BTJP_POT_COUNT, item + 1,
+           intg->source, intg->mode ? "ABS" : "REL", intg->dead_zone, intg->gain, intg->max);
+}
+
+// Edits a single field of the selected item, returns false if the key
+// does not belong to the item
+static bool edit_item(btjp_profile_t *profile, uint8_t item, char key)
+{
+    if (item < BTJP_PIN_COUNT) {
+        btjp_pin_config_t *pin = &profile->pins[item];
+        switch (key) {
+        case 'S':
+            pin->source = read_number("SOURCE (HEX): ", 16);
+            return true;
+        case 'I':
+            pin->invert = !pin->invert;
+            return true;
+        case 'H':
+            pin->hat_switch = !pin->hat_switch;
+            return true;
+        case 'T':
+            pin->threshold = read_number("THRESHOLD: ", 10);
+            return true;
+        case 'Y':
+            pin->hysteresis = read_number("HYSTERESIS: ", 10);
+            return true;
+        case 'A':
+            pin->autofire = read_number("AUTOFIRE (FRAMES): ", 10);
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    item -= BTJP_PIN_COUNT;
+    if (item < BTJP_POT_COUNT) {
+        btjp_pot_config_t *pot = &profile->pots[item];
+        switch (key) {
+        case 'S':
+            pot->source = read_number("SOURCE (HEX): ", 16);
+            return true;
+        case 'L':
+            pot->low = read_number("LOW: ", 10);
+            return true;
+        case 'H':
+            pot->high = read_number("HIGH: ", 10);
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    item -= BTJP_POT_COUNT;
+    btjp_intg_config_t *intg = &profile->intgs[item];
+    switch (key) {
+    case 'S':
+        intg->source = read_number("SOURCE (HEX): ", 16);
+        return true;
+    case 'M':
+        intg->mode = !intg->mode;
+        return true;
+    case 'D':
+        intg->dead_zone = read_number("DEAD ZONE: ", 10);
+        return true;
+    case 'G':
+        intg->gain = read_number("GAIN: ", 10);
+        return true;
+    case 'X':
+        intg->max = read_number("MAX: ", 10);
+        return true;
+    default:
+        return false;
+    }
+}
+
+static void edit_profile(uint8_t idx)
+{
+    const btjp_profile_t *current = btjp_get_profile(idx);
+    if (current == NULL) {
+        return;
+    }
+
+    btjp_profile_t profile = *current;
+    uint8_t item = 0;
+    const uint8_t item_count = BTJP_PIN_COUNT + BTJP_POT_COUNT + BTJP_INTG_COUNT;
+
+    for (;;) {
+        putchar(CLEAR_SCREEN);
+        printf("PROFILE %u %s\n\n", idx + 1, profile.name);
+        for (uint8_t i = 0; i < item_count; i++) {
+            putchar(i == item ? '>' : ' ');
+            print_item(&profile, i);
+        }
+        printf("  CHORD %08lX\n", profile.chord);
+        printf("\n0-8 SELECT  S SOURCE  C CHORD\n");
+        printf("PIN: I INV H HAT T THR Y HYST A AUTO\n");
+        printf("POT: L LOW H HIGH\n");
+        printf("INT: M MODE D DZONE G GAIN X MAX\n");
+        printf("RETURN SAVE  ESC CANCEL\n");
+
+        char key = get_key();
+
+        if (key >= '0' && key < '0' + item_count) {
+            item = key - '0';
+        } else if (key == 'C') {
+            profile.chord = read_number("CHORD (HEX): ", 16);
+        } else if (key == KEY_ESC) {
+            return;
+        } else if (key == KEY_RETURN) {
+            int err = btjp_set_profile(idx, &profile);
+            if (err < 0) {
+                printf("SAVE FAILED (%d)\n", err);
+                get_key();
+            }
+            return;
+        } else {
+            edit_item(&profile, item, key);
+        }
+    }
+}
+
+static void draw_main_screen(void)
+{
+    const btjp_state_t *state = btjp_state();
+
+    putchar(CLEAR_SCREEN);
+    printf("BLUE2JOY CONFIG  API %u.%u\n\n", state->api_version.major,
+           state->api_version.minor);
+    printf("MODE %s%s\n", state->sys.mode < 3 ? g_modes[state->sys.mode] : "?",
+           state->sys.scanning ? "  SCANNING" : "");
+    if (state->active_profile != BTJP_ACTIVE_PROFILE_NONE) {
+        printf("ACTIVE PROFILE %u\n", state->active_profile + 1);
+    }
+    putchar('\n');
+
+    printf("DEVICES\n");
+    for (uint8_t i = 0; i < state->dev_count; i++) {
+        const btjp_dev_entry_t *dev = &state->dev[i];
+        printf("%u ", i + 1);
+        print_addr(&dev->addr);
+        printf(" %-6s P%u%s\n", dev->conn_state < 5 ? g_conn_states[dev->conn_state] : "?",
+               dev->profile + 1, (dev->flags & BTJP_DEV_FLAG_BOOT_PROTOCOL) ? " BOOT" : "");
+    }
+    if (state->dev_count == 0) {
+        printf("  (NONE)\n");
+    }
+
+    printf("\n1-4 CHANGE DEVICE PROFILE\n");
+    printf("P EDIT PROFILE  ESC QUIT\n");
+}
 
 int main()
 {
-    uint8_t tx[4] = {0xAA, 0x01, 0x02, 0x55};
-    uint8_t rx[4]; // = {0};
+    btjp_init(BTJP_PORT, event_callback);
+
+    printf("CONNECTING...\n");
+
+    int err;
+    while ((err = btjp_sync()) < 0) {
+        printf("SYNC FAILED (%d), RETRYING\n", err);
+        sys_wait_frames(50);
+    }
+
+    g_dirty = true;
+
+    for (;;) {
+        if (g_dirty) {
+            g_dirty = false;
+            draw_main_screen();
+        }
+
+        char key = poll_key();
+        const btjp_state_t *state = btjp_state();
 
-    for (;;)
-    {
-        spi_transfer(0, tx, rx, sizeof(tx));
-        printf("Received: %02x %02x %02x %02x\n", rx[0], rx[1], rx[2], rx[3]);
-        spi_transfer(1, tx, rx, sizeof(tx));
+        if (key >= '1' && key <= '4') {
+            uint8_t i = key - '1';
+            if (i < state->dev_count) {
+                const btjp_dev_entry_t *dev = &state->dev[i];
+                btjp_set_dev_config(&dev->addr, (dev->profile + 1) % BTJP_MAX_PROFILES,
+                                    dev->flags);
+            }
+        } else if (key == 'P') {
+            printf("PROFILE (1-4)? ");
+            key = get_key();
+            if (key >= '1' && key <= '4') {
+                edit_profile(key - '1');
+            }
+            g_dirty = true;
+        } else if (key == KEY_ESC) {
+            break;
+        }
     }
 
     return 0;
-}
\ No newline at end of file
+}
@@ -30,4 +30,30 @@
  * @param len The number of bytes to transfer
  *
  * */
-void spi_transfer(uint8_t port, const uint8_t *tx, uint8_t *rx, size_t len);
\ No newline at end of file
+void spi_transfer(uint8_t port, const uint8_t *tx, uint8_t *rx, size_t len);
+
+/** Starts an SPI transaction (sets CS low)
+ *
+ * Use together with spi_exchange() and spi_end() when the length
+ * of the transaction is not known in advance.
+ *
+ * @param port The SPI port to use (0 or 1)
+ *
+ * */
+void spi_begin(uint8_t port);
+
+/** Exchanges data within a transaction started by spi_begin()
+ *
+ * @param tx Pointer to the data to send (can be NULL to send zeros)
+ * @param rx Pointer to the buffer to store received data (can be NULL)
+ * @param len The number of bytes to transfer
+ *
+ * */
+void spi_exchange(const uint8_t *tx, uint8_t *rx, size_t len);
+
+/** Ends an SPI transaction started by spi_begin() (sets CS high)
+ *
+ * @param port The SPI port passed to spi_begin()
+ *
+ * */
+void spi_end(uint8_t port);
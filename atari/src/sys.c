@@ -0,0 +1,36 @@
+/*
+ * This file is part of the Blue2Joy project - an interface converter
+ * between a Bluetooth gamepad and a retro console joystick
+ * (https://github.com/cepetr/blue2joy).
+ * Copyright (c) 2025
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <atari.h>
+
+#include "sys.h"
+
+uint8_t sys_frames(void)
+{
+    return OS.rtclok[2];
+}
+
+void sys_wait_frames(uint8_t count)
+{
+    while (count-- > 0) {
+        uint8_t start = sys_frames();
+        while (sys_frames() == start) {
+        }
+    }
+}
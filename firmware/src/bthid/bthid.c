@@ -27,6 +27,7 @@ int bthid_init(const bthid_callbacks_t *callbacks)
     assert(callbacks != NULL);
     memset(&bthid, 0, sizeof(bthid_drv_t));
     bthid.cb = callbacks;
+    bthid.auto_slot = -1;
 
     int err;
 
@@ -60,3 +61,8 @@ void bthid_device_get_addr(bthid_device_t *dev, bt_addr_le_t *addr)
     bt_conn_get_info(dev->conn, &info);
     bt_addr_le_copy(addr, info.le.dst);
 }
+
+int bthid_device_get_slot(bthid_device_t *dev)
+{
+    return dev - bthid.devices;
+}
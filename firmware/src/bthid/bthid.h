@@ -27,8 +27,51 @@
 
 #define BTHID_DEFAULT_SLOT 0
 
+// Buckets of the report inter-arrival time histogram, upper bounds (ms)
+// of all but the last bucket, which is open
+#define BTHID_REPORT_INTERVAL_BOUNDS  {5, 10, 15, 20, 30, 50, 100}
+#define BTHID_REPORT_INTERVAL_BUCKETS 8
+
+// Number of remembered disconnection reasons
+#define BTHID_DISCONNECT_REASONS 4
+
 typedef struct bthid_device bthid_device_t;
 
+// Link statistics of a device
+// (kept over reconnections of the same device to the same slot)
+typedef struct {
+    // Connection interval (1.25 ms units), peripheral latency (connection
+    // events) and supervision timeout (10 ms units)
+    uint16_t conn_interval;
+    uint16_t conn_latency;
+    uint16_t conn_timeout;
+    // Transmit and receive PHY (BT_GAP_LE_PHY_xxx)
+    uint8_t tx_phy;
+    uint8_t rx_phy;
+    // RSSI of the connection (dBm, BT_GAP_RSSI_INVALID if not connected)
+    int8_t rssi;
+    // Number of received reports
+    uint32_t reports;
+    // Reports received in the last second
+    uint16_t report_rate;
+    // Report inter-arrival time histogram (see BTHID_REPORT_INTERVAL_BOUNDS)
+    uint32_t report_intervals[BTHID_REPORT_INTERVAL_BUCKETS];
+    // Estimated number of missed notifications
+    // (gaps of a few report periods in a steady report stream)
+    uint32_t missed;
+    // Number of disconnections and their reasons (HCI error codes,
+    // the most recent first, 0 => none)
+    uint16_t disconnects;
+    uint8_t disconnect_reasons[BTHID_DISCONNECT_REASONS];
+} bthid_link_stats_t;
+
+typedef enum {
+    // Full HID report protocol, report map is read and parsed
+    BTHID_PROTOCOL_REPORT = 0,
+    // Boot protocol (mice and keyboards), fixed report layout
+    BTHID_PROTOCOL_BOOT = 1,
+} bthid_protocol_t;
+
 // Note to `dev` argument in the callbacks:
 // Callback must not save the pointer to `dev` for later use.
 // It's ensured that the pointer is valid only during the callback execution.
@@ -37,6 +80,9 @@ typedef struct {
     // A device found during scanning
     void (*device_found)(const bt_addr_le_t *addr, int8_t rssi, const char *name);
 
+    // A device of the accept list connected (`dev` is NULL if the connection failed)
+    void (*auto_connected)(bthid_device_t *dev);
+
     void (*conn_opened)(bthid_device_t *dev);
     void (*conn_secured)(bthid_device_t *dev);
     void (*conn_closed)(bthid_device_t *dev);
@@ -47,7 +93,14 @@ typedef struct {
 
     void (*report_subscribe_completed)(bthid_device_t *dev);
     void (*report_subscribe_error)(bthid_device_t *dev);
-    void (*report_received)(bthid_device_t *dev, const uint8_t *data, size_t length);
+    // `report_id` identifies the report characteristic
+    // (the notified data don't start with the report ID)
+    void (*report_received)(bthid_device_t *dev, uint8_t report_id, const uint8_t *data,
+                            size_t length);
+
+    // Connection parameters or PHY of the device are being updated
+    // (called when the update is requested and when it completes)
+    void (*link_updating)(bthid_device_t *dev);
 } bthid_callbacks_t;
 
 // Initializes the bthid stack
@@ -66,6 +119,13 @@ int bthid_scan_stop(void);
 // Initiates a connection to a device at the specified slot
 int bthid_connect(int slot, const bt_addr_le_t *addr);
 
+// Loads the devices into the controller's filter accept list and lets
+// the controller connect the first one that advertises to the specified slot
+int bthid_auto_connect(int slot, const bt_addr_le_t *addrs, size_t count);
+
+// Stops waiting for the devices of the accept list
+int bthid_auto_connect_stop(void);
+
 // Disconnects from a device at the specified slot
 // If the slot is not connected, this function does nothing
 void bthid_disconnect(int slot);
@@ -79,7 +139,9 @@ bool bthid_device_is_secure(bthid_device_t *dev);
 
 // Starts discovery of the HID service on the device
 // This function discovers the HID service and its characteristics and finally reads the report map
-int bthid_device_discover(bthid_device_t *dev);
+// In boot protocol mode the report map is not read, the device is switched to the boot
+// protocol instead. If the device has no boot input report, report protocol is used.
+int bthid_device_discover(bthid_device_t *dev, bthid_protocol_t protocol);
 
 // Subscribes to HID report notifications for the device
 int bthid_device_subscribe(bthid_device_t *dev);
@@ -87,5 +149,16 @@ int bthid_device_subscribe(bthid_device_t *dev);
 // Get reference to the report map of the device
 hrm_t *bthid_device_get_report_map(bthid_device_t *dev);
 
+// Returns RAM used by the device (connection state and the used part of the report map)
+size_t bthid_device_get_mem_usage(bthid_device_t *dev);
+
 // Gets device's Bluetooth address
 void bthid_device_get_addr(bthid_device_t *dev, bt_addr_le_t *addr);
+
+// Gets the slot the device is connected to
+int bthid_device_get_slot(bthid_device_t *dev);
+
+// Gets link statistics of the device
+// (reads the RSSI from the controller, don't call it from the BT callbacks)
+// Returns -ENOENT if the device was not connected since the slot was reused
+int bthid_get_link_stats(const bt_addr_le_t *addr, bthid_link_stats_t *stats);
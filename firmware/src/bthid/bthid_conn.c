@@ -34,10 +34,53 @@ static void mtu_exchanged(struct bt_conn *conn, uint8_t err, struct bt_gatt_exch
     }
 }
 
+// Assigns a connection created by the controller from the accept list
+// to the waiting slot
+static bthid_device_t *claim_auto_connection(struct bt_conn *conn, uint8_t err)
+{
+    struct bt_conn_info info;
+
+    if (bt_conn_get_info(conn, &info) != 0 || info.role != BT_CONN_ROLE_CENTRAL) {
+        return NULL;
+    }
+
+    k_mutex_lock(&bthid.mutex, K_FOREVER);
+
+    int slot = bthid.auto_slot;
+    bthid_device_t *dev = slot >= 0 ? &bthid.devices[slot] : NULL;
+
+    if (dev != NULL) {
+        bthid.auto_slot = -1;
+        if (!err && dev->conn == NULL) {
+            dev->conn = bt_conn_ref(conn);
+        } else {
+            dev = NULL;
+        }
+    }
+
+    k_mutex_unlock(&bthid.mutex);
+
+    if (slot < 0) {
+        if (!err) {
+            // Established just after bthid_auto_connect_stop()
+            bt_conn_disconnect(conn, BT_HCI_ERR_REMOTE_USER_TERM_CONN);
+        }
+    } else if (err != BT_HCI_ERR_UNKNOWN_CONN_ID) {
+        // Not reported if cancelled by bthid_auto_connect_stop()
+        bthid.cb->auto_connected(dev);
+    }
+
+    return dev;
+}
+
 static void connected(struct bt_conn *conn, uint8_t err)
 {
     bthid_device_t *dev = bthid_device_find(conn);
 
+    if (dev == NULL) {
+        dev = claim_auto_connection(conn, err);
+    }
+
     if (dev == NULL) {
         return;
     }
@@ -54,6 +97,8 @@ static void connected(struct bt_conn *conn, uint8_t err)
 
     LOG_INF("Connected {peer: %s}", addr_str);
 
+    bthid_stats_connected(dev);
+
     static struct bt_gatt_exchange_params exchange_params;
     exchange_params = (struct bt_gatt_exchange_params){
         .func = mtu_exchanged,
@@ -90,6 +135,8 @@ static void disconnected(struct bt_conn *conn, uint8_t reason)
 
     LOG_INF("Disconnected {peer: %s, reason: 0x%02x %s", addr, reason, bt_hci_err_to_str(reason));
 
+    bthid_stats_disconnected(dev, reason);
+
     bthid.cb->conn_closed(dev);
 
     k_mutex_lock(&bthid.mutex, K_FOREVER);
@@ -118,10 +165,61 @@ static void security_changed(struct bt_conn *conn, bt_security_t level, enum bt_
     }
 }
 
+static bool le_param_req(struct bt_conn *conn, struct bt_le_conn_param *param)
+{
+    bthid_device_t *dev = bthid_device_find(conn);
+
+    if (dev != NULL) {
+        bthid.cb->link_updating(dev);
+    }
+
+    // Accept the parameters requested by the peripheral
+    return true;
+}
+
+static void le_param_updated(struct bt_conn *conn, uint16_t interval, uint16_t latency,
+                             uint16_t timeout)
+{
+    bthid_device_t *dev = bthid_device_find(conn);
+
+    if (dev == NULL) {
+        return;
+    }
+
+    bthid.cb->link_updating(dev);
+
+    LOG_INF("Connection parameters updated {interval: %u, latency: %u, timeout: %u}", interval,
+            latency, timeout);
+
+    bthid_stats_param_updated(dev, interval, latency, timeout);
+}
+
+#ifdef CONFIG_BT_USER_PHY_UPDATE
+static void le_phy_updated(struct bt_conn *conn, struct bt_conn_le_phy_info *param)
+{
+    bthid_device_t *dev = bthid_device_find(conn);
+
+    if (dev == NULL) {
+        return;
+    }
+
+    bthid.cb->link_updating(dev);
+
+    LOG_INF("PHY updated {tx: %u, rx: %u}", param->tx_phy, param->rx_phy);
+
+    bthid_stats_phy_updated(dev, param->tx_phy, param->rx_phy);
+}
+#endif
+
 BT_CONN_CB_DEFINE(conn_callbacks) = {
     .connected = connected,
     .disconnected = disconnected,
     .security_changed = security_changed,
+    .le_param_req = le_param_req,
+    .le_param_updated = le_param_updated,
+#ifdef CONFIG_BT_USER_PHY_UPDATE
+    .le_phy_updated = le_phy_updated,
+#endif
 };
 
 int bthid_connect(int slot, const bt_addr_le_t *addr)
@@ -157,6 +255,67 @@ int bthid_connect(int slot, const bt_addr_le_t *addr)
     return err;
 }
 
+int bthid_auto_connect(int slot, const bt_addr_le_t *addrs, size_t count)
+{
+    assert(slot >= 0 && slot < BTHID_MAX_DEVICES);
+
+    k_mutex_lock(&bthid.mutex, K_FOREVER);
+
+    bthid_device_t *dev = &bthid.devices[slot];
+
+    if (dev->conn != NULL || bthid.auto_slot >= 0) {
+        k_mutex_unlock(&bthid.mutex);
+        return -EBUSY;
+    }
+
+    int err = bt_le_filter_accept_list_clear();
+
+    for (size_t i = 0; i < count && !err; i++) {
+        err = bt_le_filter_accept_list_add(&addrs[i]);
+    }
+
+    if (!err) {
+        memset(dev, 0, sizeof(*dev));
+        // Scans with 100% duty cycle, the controller connects on the first
+        // advertisement of any listed device
+        err = bt_conn_le_create_auto(BT_CONN_LE_CREATE_CONN_AUTO, BT_LE_CONN_PARAM_DEFAULT);
+    }
+
+    if (!err) {
+        bthid.auto_slot = slot;
+    }
+
+    k_mutex_unlock(&bthid.mutex);
+
+    if (err) {
+        LOG_ERR("Failed to start auto connection {err: %d}", err);
+    } else {
+        LOG_INF("Waiting for known devices {count: %zu}", count);
+    }
+
+    return err;
+}
+
+int bthid_auto_connect_stop(void)
+{
+    k_mutex_lock(&bthid.mutex, K_FOREVER);
+
+    int err = 0;
+
+    if (bthid.auto_slot >= 0) {
+        bthid.auto_slot = -1;
+        err = bt_conn_create_auto_stop();
+    }
+
+    k_mutex_unlock(&bthid.mutex);
+
+    if (err) {
+        LOG_ERR("Failed to stop auto connection {err: %d}", err);
+    }
+
+    return err;
+}
+
 void bthid_disconnect(int slot)
 {
     assert(slot >= 0 && slot < BTHID_MAX_DEVICES);
@@ -175,6 +334,9 @@ void bthid_device_disconnect(bthid_device_t *dev)
 {
     bt_conn_disconnect(dev->conn, BT_HCI_ERR_REMOTE_USER_TERM_CONN);
 
+    // The disconnected callback doesn't find the device anymore
+    bthid_stats_disconnected(dev, BT_HCI_ERR_LOCALHOST_TERM_CONN);
+
     k_mutex_lock(&bthid.mutex, K_FOREVER);
     bt_conn_unref(dev->conn);
     dev->conn = NULL;
@@ -35,23 +35,26 @@ static uint8_t report_map_read_cb(struct bt_conn *conn, uint8_t err,
         return BT_GATT_ITER_STOP;
     }
 
-    if (params->single.offset + length > sizeof(dev->report_map_raw)) {
+    if (params->single.offset + length > HRM_MAX_RAW_SIZE) {
         LOG_ERR("Report map too large");
         bthid.cb->discovery_error(dev);
         return BT_GATT_ITER_STOP;
     }
 
+    // The raw map is read directly into the report map arena
+    uint8_t *raw = hrm_raw_buffer(&dev->report_map);
+
     if (length > 0) {
-        memcpy(&dev->report_map_raw[params->single.offset], data, length);
+        memcpy(&raw[params->single.offset], data, length);
         dev->report_map_raw_size = params->single.offset + length;
     }
 
     if (length == 0) {
         LOG_INF("Report map read complete {size: %zu}", dev->report_map_raw_size);
-        LOG_HEXDUMP_INF(dev->report_map_raw, dev->report_map_raw_size, "Report map");
+        LOG_HEXDUMP_INF(raw, dev->report_map_raw_size, "Report map");
 
-        // Parse the report map
-        hrm_parse(&dev->report_map, dev->report_map_raw, dev->report_map_raw_size);
+        // Parse the report map (releases the raw data)
+        hrm_parse(&dev->report_map, raw, dev->report_map_raw_size);
 
         dev->discovered = true;
 
@@ -225,6 +228,97 @@ static int start_report_descriptor_discovery(bthid_device_t *dev)
     return err;
 }
 
+static uint8_t on_boot_report_desc(struct bt_conn *conn, const struct bt_gatt_attr *attr,
+                                   struct bt_gatt_discover_params *params)
+{
+    bthid_device_t *dev = bthid_device_find(conn);
+    assert(dev);
+
+    report_char_t *boot_report = dev->boot_report;
+
+    if (attr != NULL) {
+        if (0 == bt_uuid_cmp(attr->uuid, BT_UUID_GATT_CCC)) {
+            boot_report->ccc_handle = attr->handle;
+            LOG_INF("  CCCD found {report_handle: %u, cccd: %u}", boot_report->value_handle,
+                    attr->handle);
+        }
+        return BT_GATT_ITER_CONTINUE;
+    }
+
+    if (boot_report->ccc_handle == 0) {
+        LOG_ERR("Boot input report has no CCCD");
+        bthid.cb->discovery_error(dev);
+        return BT_GATT_ITER_STOP;
+    }
+
+    if (dev->handles.protocol_mode != 0) {
+        // Switch the device to the boot protocol
+        static const uint8_t boot_protocol[] = {
+            0x00, // Boot Protocol Mode
+        };
+
+        int err = bt_gatt_write_without_response(dev->conn, dev->handles.protocol_mode,
+                                                 boot_protocol, sizeof(boot_protocol), false);
+        if (err) {
+            LOG_ERR("Failed to set boot protocol mode {err: %d}", err);
+            bthid.cb->discovery_error(dev);
+            return BT_GATT_ITER_STOP;
+        }
+    }
+
+    // The boot report layout is fixed, no need to read the report map
+    bool mouse = (boot_report == &dev->handles.boot_mouse);
+    hrm_init_boot(&dev->report_map, mouse ? HRM_BOOT_MOUSE : HRM_BOOT_KEYBOARD);
+
+    LOG_INF("Boot protocol selected {device: %s}", mouse ? "mouse" : "keyboard");
+
+    dev->discovered = true;
+
+    bthid.cb->discovery_completed(dev);
+    return BT_GATT_ITER_STOP;
+}
+
+// Starts boot protocol setup if the device has a boot input report
+// Returns -ENOENT if the boot protocol is not supported by the device
+static int start_boot_report_discovery(bthid_device_t *dev)
+{
+    uint16_t end;
+
+    // Mice are preferred (combo devices usually expose both reports)
+    if (dev->handles.boot_mouse.value_handle != 0) {
+        dev->boot_report = &dev->handles.boot_mouse;
+        end = dev->handles.boot_mouse_end;
+    } else if (dev->handles.boot_kb.value_handle != 0) {
+        dev->boot_report = &dev->handles.boot_kb;
+        end = dev->handles.boot_kb_end;
+    } else {
+        return -ENOENT;
+    }
+
+    if (end == 0) {
+        end = dev->handles.service_end;
+    }
+
+    static struct bt_gatt_discover_params dp;
+    dp = (struct bt_gatt_discover_params){
+        .uuid = NULL, // discover all descriptors in range
+        .func = on_boot_report_desc,
+        .start_handle = dev->boot_report->value_handle + 1,
+        .end_handle = end,
+        .type = BT_GATT_DISCOVER_DESCRIPTOR,
+    };
+
+    int err = bt_gatt_discover(dev->conn, &dp);
+    if (err) {
+        LOG_ERR("Failed to start descriptor discovery {err: %d}", err);
+        dev->boot_report = NULL;
+    } else {
+        LOG_INF("Discovering boot report descriptors {range: %u - %u}", dp.start_handle, end);
+    }
+
+    return err;
+}
+
 static uint8_t on_hid_characteristic(struct bt_conn *conn, const struct bt_gatt_attr *attr,
                                      struct bt_gatt_discover_params *params)
 {
@@ -232,6 +326,14 @@ static uint8_t on_hid_characteristic(struct bt_conn *conn, const struct bt_gatt_
     assert(dev != NULL);
 
     if (attr == NULL) {
+        if (dev->protocol == BTHID_PROTOCOL_BOOT) {
+            int err = start_boot_report_discovery(dev);
+            if (err == 0) {
+                return BT_GATT_ITER_STOP;
+            }
+            LOG_WRN("Boot protocol not available, using report protocol");
+        }
+
         if (dev->handles.report_count > 0) {
             LOG_INF("%d HID report characteristics found", dev->handles.report_count);
             dev->report_index = 0;
@@ -256,6 +358,14 @@ static uint8_t on_hid_characteristic(struct bt_conn *conn, const struct bt_gatt_
             dev->handles.report_end = attr->handle - 1;
         }
 
+        if (dev->handles.boot_mouse.value_handle != 0 && dev->handles.boot_mouse_end == 0) {
+            dev->handles.boot_mouse_end = attr->handle - 1;
+        }
+
+        if (dev->handles.boot_kb.value_handle != 0 && dev->handles.boot_kb_end == 0) {
+            dev->handles.boot_kb_end = attr->handle - 1;
+        }
+
         LOG_INF("Characteristics {uuid: %s, handle: %u, props: 0x%02x}", uuid_str, attr->handle,
                 chrc->properties);
 
@@ -273,6 +383,16 @@ static uint8_t on_hid_characteristic(struct bt_conn *conn, const struct bt_gatt_
                 dev->handles.report_count++;
                 dev->handles.report_end = 0;
             }
+        } else if (0 == bt_uuid_cmp(chrc->uuid, BT_UUID_HIDS_PROTOCOL_MODE)) {
+            dev->handles.protocol_mode = chrc->value_handle;
+        } else if (0 == bt_uuid_cmp(chrc->uuid, BT_UUID_HIDS_BOOT_MOUSE_IN_REPORT)) {
+            dev->handles.boot_mouse.decl_handle = attr->handle;
+            dev->handles.boot_mouse.value_handle = chrc->value_handle;
+            dev->handles.boot_mouse_end = 0;
+        } else if (0 == bt_uuid_cmp(chrc->uuid, BT_UUID_HIDS_BOOT_KB_IN_REPORT)) {
+            dev->handles.boot_kb.decl_handle = attr->handle;
+            dev->handles.boot_kb.value_handle = chrc->value_handle;
+            dev->handles.boot_kb_end = 0;
         }
     }
 
@@ -336,9 +456,11 @@ static uint8_t on_primary_service(struct bt_conn *conn, const struct bt_gatt_att
     return BT_GATT_ITER_CONTINUE;
 }
 
-int bthid_device_discover(bthid_device_t *dev)
+int bthid_device_discover(bthid_device_t *dev, bthid_protocol_t protocol)
 {
     dev->discovered = false;
+    dev->protocol = protocol;
+    dev->boot_report = NULL;
 
     static struct bt_gatt_discover_params discover_params;
     discover_params = (struct bt_gatt_discover_params){
@@ -363,3 +485,14 @@ hrm_t *bthid_device_get_report_map(bthid_device_t *dev)
 {
     return dev->discovered ? &dev->report_map : NULL;
 }
+
+size_t bthid_device_get_mem_usage(bthid_device_t *dev)
+{
+    size_t size = sizeof(bthid_device_t) - sizeof(dev->report_map);
+
+    if (dev->discovered) {
+        size += hrm_mem_usage(&dev->report_map);
+    }
+
+    return size;
+}
@@ -47,6 +47,12 @@ struct bthid_device {
     // Currently discovered report characteristic
     int report_index;
 
+    // Requested protocol mode
+    bthid_protocol_t protocol;
+    // Boot input report used in boot protocol mode
+    // (points to handles.boot_mouse or handles.boot_kb)
+    report_char_t *boot_report;
+
     // Handles of the HID service characteristics
     struct {
         uint16_t control_point;
@@ -61,17 +67,44 @@ struct bthid_device {
         uint16_t report_count;
         // Report characteristic handles
         report_char_t report[16];
+
+        uint16_t protocol_mode;
+        // Boot input report characteristics and their last handles
+        report_char_t boot_mouse;
+        uint16_t boot_mouse_end;
+        report_char_t boot_kb;
+        uint16_t boot_kb_end;
     } handles;
 
-    // Received report map data
-    uint8_t report_map_raw[512];
-    // Report map data size
+    // Received report map data size
+    // (the data is read into the report map arena)
     size_t report_map_raw_size;
 
     // Parsed report map
     hrm_t report_map;
 };
 
+// Link statistics of a device slot
+typedef struct {
+    // Device the statistics belong to
+    bool valid;
+    bt_addr_le_t addr;
+
+    bthid_link_stats_t data;
+
+    // Cycle counter value of the last report
+    bool has_last_report;
+    uint32_t last_report;
+    // Smoothed period of the report stream (us)
+    uint32_t report_period;
+    // Report rate measurement window
+    uint32_t window_start;
+    uint32_t window_reports;
+    // Uptime of the last RSSI read (data.rssi is cached until it expires)
+    bool has_rssi;
+    uint32_t rssi_time;
+} bthid_link_t;
+
 // Driver state
 typedef struct {
     // List of connected devices
@@ -80,6 +113,12 @@ typedef struct {
     struct k_mutex mutex;
     // High-level callbacks for bthid events
     const bthid_callbacks_t *cb;
+    // Slot waiting for a device of the accept list (-1 => none)
+    int auto_slot;
+    // Link statistics of the device slots
+    // (updated from the BT callbacks, protected by the spinlock)
+    bthid_link_t links[BTHID_MAX_DEVICES];
+    struct k_spinlock links_lock;
 } bthid_drv_t;
 
 // Global HID driver instance
@@ -90,3 +129,20 @@ int bthid_bonds_init(void);
 
 // Finds a device structure by its connection
 bthid_device_t *bthid_device_find(struct bt_conn *conn);
+
+// Starts the link statistics of a new connection
+// (resets them if another device was connected to the slot before)
+void bthid_stats_connected(bthid_device_t *dev);
+
+// Records changed connection parameters
+void bthid_stats_param_updated(bthid_device_t *dev, uint16_t interval, uint16_t latency,
+                               uint16_t timeout);
+
+// Records changed PHYs
+void bthid_stats_phy_updated(bthid_device_t *dev, uint8_t tx_phy, uint8_t rx_phy);
+
+// Records a received report
+void bthid_stats_report(bthid_device_t *dev);
+
+// Records a disconnection and its reason (HCI error code)
+void bthid_stats_disconnected(bthid_device_t *dev, uint8_t reason);
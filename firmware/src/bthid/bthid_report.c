@@ -22,13 +22,32 @@
 
 #include "bthid_internal.h"
 
+// Returns the report ID of the notified characteristic
+static uint8_t get_report_id(bthid_device_t *dev, uint16_t value_handle)
+{
+    for (int i = 0; i < dev->handles.report_count; i++) {
+        if (dev->handles.report[i].value_handle == value_handle) {
+            return dev->handles.report[i].report_id;
+        }
+    }
+
+    // Boot protocol - the fixed report map has a single report
+    return dev->report_map.report_count > 0 ? dev->report_map.reports[0].id : 0;
+}
+
 static uint8_t hid_report_received(struct bt_conn *conn, struct bt_gatt_subscribe_params *params,
                                    const void *data, uint16_t length)
 {
     bthid_device_t *dev = bthid_device_find(conn);
     assert(dev != NULL);
 
-    bthid.cb->report_received(dev, data, length);
+    if (data != NULL) {
+        bthid_stats_report(dev);
+    }
+
+    uint8_t report_id = get_report_id(dev, params->value_handle);
+
+    bthid.cb->report_received(dev, report_id, data, length);
 
     return BT_GATT_ITER_CONTINUE;
 }
@@ -52,6 +71,12 @@ report_char_t *get_report_char_to_subscribe(bthid_device_t *dev)
 {
     report_char_t *report_char = NULL;
 
+    if (dev->boot_report != NULL) {
+        // Boot protocol - there's just one input report
+        LOG_INF("Subscribing to boot input report");
+        return dev->boot_report;
+    }
+
     if (dev->report_map.report_count > 0) {
         // Currently we subscribe just to one report - the first one in the report map
         uint8_t report_id = dev->report_map.reports[0].id;
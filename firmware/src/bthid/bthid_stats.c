@@ -0,0 +1,284 @@
+/*
+ * This file is part of the Blue2Joy project
+ * (https://github.com/cepetr/blue2joy).
+ * Copyright (c) 2025
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include <zephyr/bluetooth/gap.h>
+#include <zephyr/bluetooth/hci.h>
+#include <zephyr/sys/byteorder.h>
+
+#include "bthid_internal.h"
+
+// Length of the report rate measurement window (ms)
+#define REPORT_RATE_WINDOW 1000
+
+// Smoothing of the report period (new sample weight is 1/2^n)
+#define REPORT_PERIOD_SHIFT 3
+
+// Gaps longer than this number of report periods are pauses
+// of the device, not missed notifications
+#define MISSED_MAX_PERIODS 4
+
+// Maximum age of the cached RSSI (ms), the statistics of a link
+// are read by all sessions in the same interval
+#define RSSI_MAX_AGE 500
+
+static const uint16_t interval_bounds[] = BTHID_REPORT_INTERVAL_BOUNDS;
+
+BUILD_ASSERT(ARRAY_SIZE(interval_bounds) == BTHID_REPORT_INTERVAL_BUCKETS - 1,
+             "Report interval bounds mismatch");
+
+static bthid_link_t *get_link(bthid_device_t *dev)
+{
+    return &bthid.links[dev - bthid.devices];
+}
+
+static size_t interval_bucket(uint32_t us)
+{
+    size_t i = 0;
+
+    while (i < ARRAY_SIZE(interval_bounds) && us >= interval_bounds[i] * 1000) {
+        i++;
+    }
+
+    return i;
+}
+
+void bthid_stats_connected(bthid_device_t *dev)
+{
+    struct bt_conn_info info;
+
+    if (bt_conn_get_info(dev->conn, &info) != 0) {
+        return;
+    }
+
+    bthid_link_t *link = get_link(dev);
+
+    k_spinlock_key_t key = k_spin_lock(&bthid.links_lock);
+
+    if (!link->valid || bt_addr_le_cmp(&link->addr, info.le.dst) != 0) {
+        memset(link, 0, sizeof(*link));
+        bt_addr_le_copy(&link->addr, info.le.dst);
+        link->valid = true;
+    }
+
+    link->data.conn_interval = info.le.interval;
+    link->data.conn_latency = info.le.latency;
+    link->data.conn_timeout = info.le.timeout;
+#ifdef CONFIG_BT_USER_PHY_UPDATE
+    link->data.tx_phy = info.le.phy->tx_phy;
+    link->data.rx_phy = info.le.phy->rx_phy;
+#else
+    link->data.tx_phy = BT_GAP_LE_PHY_1M;
+    link->data.rx_phy = BT_GAP_LE_PHY_1M;
+#endif
+    link->data.report_rate = 0;
+
+    link->has_last_report = false;
+    link->report_period = 0;
+    link->window_start = k_uptime_get_32();
+    link->window_reports = 0;
+    link->has_rssi = false;
+
+    k_spin_unlock(&bthid.links_lock, key);
+}
+
+void bthid_stats_param_updated(bthid_device_t *dev, uint16_t interval, uint16_t latency,
+                               uint16_t timeout)
+{
+    bthid_link_t *link = get_link(dev);
+
+    k_spinlock_key_t key = k_spin_lock(&bthid.links_lock);
+    link->data.conn_interval = interval;
+    link->data.conn_latency = latency;
+    link->data.conn_timeout = timeout;
+    k_spin_unlock(&bthid.links_lock, key);
+}
+
+void bthid_stats_phy_updated(bthid_device_t *dev, uint8_t tx_phy, uint8_t rx_phy)
+{
+    bthid_link_t *link = get_link(dev);
+
+    k_spinlock_key_t key = k_spin_lock(&bthid.links_lock);
+    link->data.tx_phy = tx_phy;
+    link->data.rx_phy = rx_phy;
+    k_spin_unlock(&bthid.links_lock, key);
+}
+
+void bthid_stats_report(bthid_device_t *dev)
+{
+    uint32_t now = k_cycle_get_32();
+    uint32_t uptime = k_uptime_get_32();
+
+    bthid_link_t *link = get_link(dev);
+
+    k_spinlock_key_t key = k_spin_lock(&bthid.links_lock);
+
+    link->data.reports++;
+
+    if (link->has_last_report) {
+        uint32_t gap = k_cyc_to_us_floor32(now - link->last_report);
+
+        link->data.report_intervals[interval_bucket(gap)]++;
+
+        if (link->report_period == 0) {
+            link->report_period = gap;
+        } else {
+            // The device can't report more often than once per connection event
+            uint32_t period = MAX(link->report_period, link->data.conn_interval * 1250);
+
+            if (gap < period * MISSED_MAX_PERIODS) {
+                if (gap > period * 3 / 2) {
+                    link->data.missed += (gap + period / 2) / period - 1;
+                }
+                link->report_period += ((int32_t)gap - (int32_t)link->report_period) >>
+                                       REPORT_PERIOD_SHIFT;
+            }
+        }
+    }
+
+    link->has_last_report = true;
+    link->last_report = now;
+
+    link->window_reports++;
+    uint32_t window = uptime - link->window_start;
+    if (window >= REPORT_RATE_WINDOW) {
+        link->data.report_rate = link->window_reports * 1000 / window;
+        link->window_start = uptime;
+        link->window_reports = 0;
+    }
+
+    k_spin_unlock(&bthid.links_lock, key);
+}
+
+void bthid_stats_disconnected(bthid_device_t *dev, uint8_t reason)
+{
+    bthid_link_t *link = get_link(dev);
+
+    k_spinlock_key_t key = k_spin_lock(&bthid.links_lock);
+
+    link->data.disconnects++;
+    memmove(&link->data.disconnect_reasons[1], &link->data.disconnect_reasons[0],
+            sizeof(link->data.disconnect_reasons) - 1);
+    link->data.disconnect_reasons[0] = reason;
+    link->data.report_rate = 0;
+    link->data.rssi = BT_GAP_RSSI_INVALID;
+    link->has_rssi = false;
+
+    k_spin_unlock(&bthid.links_lock, key);
+}
+
+static int read_conn_rssi(struct bt_conn *conn, int8_t *rssi)
+{
+    uint16_t handle;
+
+    int err = bt_hci_get_conn_handle(conn, &handle);
+    if (err) {
+        return err;
+    }
+
+    struct net_buf *buf =
+        bt_hci_cmd_create(BT_HCI_OP_READ_RSSI, sizeof(struct bt_hci_cp_read_rssi));
+    if (buf == NULL) {
+        return -ENOBUFS;
+    }
+
+    struct bt_hci_cp_read_rssi *cp = net_buf_add(buf, sizeof(*cp));
+    cp->handle = sys_cpu_to_le16(handle);
+
+    struct net_buf *rsp;
+    err = bt_hci_cmd_send_sync(BT_HCI_OP_READ_RSSI, buf, &rsp);
+    if (err) {
+        return err;
+    }
+
+    struct bt_hci_rp_read_rssi *rp = (struct bt_hci_rp_read_rssi *)rsp->data;
+    *rssi = rp->status == 0 ? rp->rssi : BT_GAP_RSSI_INVALID;
+    net_buf_unref(rsp);
+
+    return 0;
+}
+
+// Reads RSSI of the link from the controller (while the device is connected)
+static void read_link_rssi(bthid_link_t *link, int slot, const bt_addr_le_t *addr)
+{
+    struct bt_conn *conn = NULL;
+
+    k_mutex_lock(&bthid.mutex, K_FOREVER);
+    struct bt_conn *dev_conn = bthid.devices[slot].conn;
+    if (dev_conn != NULL && bt_addr_le_cmp(bt_conn_get_dst(dev_conn), addr) == 0) {
+        conn = bt_conn_ref(dev_conn);
+    }
+    k_mutex_unlock(&bthid.mutex);
+
+    int8_t rssi = BT_GAP_RSSI_INVALID;
+
+    if (conn != NULL) {
+        int err = read_conn_rssi(conn, &rssi);
+        if (err) {
+            LOG_WRN("Failed to read RSSI {err: %d}", err);
+            rssi = BT_GAP_RSSI_INVALID;
+        }
+        bt_conn_unref(conn);
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&bthid.links_lock);
+    if (link->valid && bt_addr_le_cmp(&link->addr, addr) == 0) {
+        link->data.rssi = rssi;
+        link->has_rssi = conn != NULL;
+        link->rssi_time = k_uptime_get_32();
+    }
+    k_spin_unlock(&bthid.links_lock, key);
+}
+
+int bthid_get_link_stats(const bt_addr_le_t *addr, bthid_link_stats_t *stats)
+{
+    int slot = -1;
+    bool rssi_cached = false;
+
+    k_spinlock_key_t key = k_spin_lock(&bthid.links_lock);
+    for (int i = 0; i < ARRAY_SIZE(bthid.links); i++) {
+        bthid_link_t *link = &bthid.links[i];
+        if (link->valid && bt_addr_le_cmp(&link->addr, addr) == 0) {
+            rssi_cached = link->has_rssi && k_uptime_get_32() - link->rssi_time < RSSI_MAX_AGE;
+            slot = i;
+            break;
+        }
+    }
+    k_spin_unlock(&bthid.links_lock, key);
+
+    if (slot < 0) {
+        return -ENOENT;
+    }
+
+    bthid_link_t *link = &bthid.links[slot];
+
+    if (!rssi_cached) {
+        read_link_rssi(link, slot, addr);
+    }
+
+    key = k_spin_lock(&bthid.links_lock);
+    *stats = link->data;
+    if (k_uptime_get_32() - link->window_start >= 2 * REPORT_RATE_WINDOW) {
+        // No reports in the last window
+        stats->report_rate = 0;
+    }
+    k_spin_unlock(&bthid.links_lock, key);
+
+    return 0;
+}
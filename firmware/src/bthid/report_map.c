@@ -184,8 +184,8 @@ static int32_t hrm_item_i32(const hrm_item_t *item)
     int32_t value = (int32_t)get_u32_le(item->data, item->size);
 
     // Manual sign-extension for 1–3-byte integers
-    if (item->size < 4 && (item->data[item->size - 1] & 0x80)) {
-        value |= ~((1 << (8 * item->size)) - 1);
+    if (item->size > 0 && item->size < 4 && (item->data[item->size - 1] & 0x80)) {
+        value |= ~((1u << (8 * item->size)) - 1);
     }
 
     return value;
@@ -291,7 +291,7 @@ static bool process_local_item(const hrm_item_t *item, hrm_locals_t *locals)
         locals->string_max = hrm_item_u32(item);
         break;
     case ITEM_TAG_LOCAL_DELIMITER:
-        locals->delimiter = item->data[0];
+        locals->delimiter = hrm_item_u32(item);
         break;
     default:
         // Unknown/reserved local item
@@ -305,15 +305,172 @@ static hrm_report_t *hrm_create_report(hrm_t *hrm, uint8_t report_id)
 {
     if (hrm->report_count < ARRAY_SIZE(hrm->reports)) {
         hrm_report_t *report = &hrm->reports[hrm->report_count++];
+        memset(report, 0, sizeof(*report));
         report->id = report_id;
-        report->bit_size = 0;
-        report->field_count = 0;
+        report->map = hrm;
         return report;
     } else {
         return NULL;
     }
 }
 
+// Returns index of the value in the table, adds it if not present
+// Returns -1 if the table is full
+static int intern_page(hrm_t *hrm, uint16_t page)
+{
+    for (int i = 0; i < hrm->page_count; i++) {
+        if (hrm->pages[i] == page) {
+            return i;
+        }
+    }
+
+    if (hrm->page_count >= ARRAY_SIZE(hrm->pages)) {
+        return -1;
+    }
+
+    hrm->pages[hrm->page_count] = page;
+    return hrm->page_count++;
+}
+
+static int intern_range(hrm_t *hrm, int32_t min, int32_t max)
+{
+    for (int i = 0; i < hrm->range_count; i++) {
+        if (hrm->ranges[i].min == min && hrm->ranges[i].max == max) {
+            return i;
+        }
+    }
+
+    if (hrm->range_count >= ARRAY_SIZE(hrm->ranges)) {
+        return -1;
+    }
+
+    hrm->ranges[hrm->range_count] = (hrm_range_t){.min = min, .max = max};
+    return hrm->range_count++;
+}
+
+// Appends a packed field to the arena
+static bool hrm_add_field(hrm_t *hrm, hrm_report_t *report, const hrm_field_t *field)
+{
+    // The raw report map occupies the end of the arena while parsing
+    size_t free_size =
+        HRM_ARENA_SIZE - hrm->raw_size - hrm->field_count * sizeof(hrm_packed_field_t);
+
+    if (free_size < sizeof(hrm_packed_field_t)) {
+        LOG_ERR("Report map arena full {fields: %u}", hrm->field_count);
+        return false;
+    }
+
+    int page = intern_page(hrm, field->usage >> 16);
+    int range = intern_range(hrm, field->logical_min, field->logical_max);
+
+    if (page < 0 || range < 0) {
+        LOG_ERR("Too many distinct usage pages or logical ranges");
+        return false;
+    }
+
+    hrm->fields[hrm->field_count++] = (hrm_packed_field_t){
+        .bit_offset = field->bit_offset,
+        .bit_size = field->bit_size,
+        .page = page,
+        .usage = field->usage & 0xFFFF,
+        .range = range,
+        .report = report - hrm->reports,
+    };
+
+    report->field_count++;
+
+    return true;
+}
+
+// Groups the packed fields by report and sets up report field pointers
+static void hrm_link_fields(hrm_t *hrm)
+{
+    // Stable insertion sort by report index,
+    // fields of a report keep the descriptor order
+    for (size_t i = 1; i < hrm->field_count; i++) {
+        hrm_packed_field_t field = hrm->fields[i];
+        size_t j = i;
+        while (j > 0 && hrm->fields[j - 1].report > field.report) {
+            hrm->fields[j] = hrm->fields[j - 1];
+            j--;
+        }
+        hrm->fields[j] = field;
+    }
+
+    const hrm_packed_field_t *next = hrm->fields;
+
+    for (size_t i = 0; i < hrm->report_count; i++) {
+        hrm->reports[i].fields = next;
+        next += hrm->reports[i].field_count;
+    }
+}
+
+// Resets the report map, keeping the arena content
+static void hrm_reset(hrm_t *hrm)
+{
+    hrm->report_count = 0;
+    hrm->page_count = 0;
+    hrm->range_count = 0;
+    hrm->field_count = 0;
+    hrm->raw_size = 0;
+}
+
+// Advance the report size by `bit_size` bits
+// Returns false if the report would exceed HRM_MAX_REPORT_BITS
+static bool hrm_report_skip_bits(hrm_report_t *report, uint64_t bit_size)
+{
+    if (report->bit_size + bit_size > HRM_MAX_REPORT_BITS) {
+        LOG_ERR("Report with ID %d is too long", report->id);
+        return false;
+    }
+
+    report->bit_size += bit_size;
+    return true;
+}
+
+static bool process_array_item(hrm_globals_t *globals, hrm_locals_t *locals,
+                               hrm_report_t *report)
+{
+    uint64_t bit_size = (uint64_t)globals->report_size * globals->report_count;
+
+    if (report->bit_size + bit_size > HRM_MAX_REPORT_BITS) {
+        LOG_ERR("Report with ID %d is too long", report->id);
+        return false;
+    }
+
+    uint16_t usage_min = locals->usage_min;
+    uint16_t usage_max = locals->usage_max;
+
+    if (locals->usages_count > 0 && usage_min == 0 && usage_max == 0) {
+        // Usages listed individually, only contiguous lists are supported
+        usage_min = locals->usages[0];
+        usage_max = locals->usages[locals->usages_count - 1];
+    }
+
+    if (globals->report_size == 0 || globals->report_size > 16 || globals->report_count > 255 ||
+        usage_max < usage_min) {
+        LOG_WRN("Unsupported array item {size: %u, count: %u}", globals->report_size,
+                globals->report_count);
+        return hrm_report_skip_bits(report, bit_size);
+    }
+
+    if (report->array_count >= ARRAY_SIZE(report->arrays)) {
+        LOG_WRN("Too many array items in report with ID %d", globals->report_id);
+        return hrm_report_skip_bits(report, bit_size);
+    }
+
+    hrm_array_t *array = &report->arrays[report->array_count++];
+    array->bit_offset = report->bit_size;
+    array->bit_size = globals->report_size;
+    array->count = globals->report_count;
+    array->usage_page = globals->usage_page;
+    array->usage_min = usage_min;
+    array->usage_max = MIN(usage_max, usage_min + HRM_ARRAY_USAGES - 1);
+    array->logical_min = globals->logical_min;
+
+    return hrm_report_skip_bits(report, bit_size);
+}
+
 static bool process_input_item(const hrm_item_t *item, hrm_globals_t *globals, hrm_locals_t *locals,
                                hrm_collection_stack_t *cstack, hrm_t *hrm)
 {
@@ -335,10 +492,27 @@ static bool process_input_item(const hrm_item_t *item, hrm_globals_t *globals, h
         }
     }
 
+    uint64_t bit_size = (uint64_t)globals->report_size * globals->report_count;
+
     if (item_flags & ITEM_FLAG_CONSTANT) {
         // Constant item, no fields to add
-        report->bit_size += globals->report_size * globals->report_count;
-        return true;
+        return hrm_report_skip_bits(report, bit_size);
+    }
+
+    if (!(item_flags & ITEM_FLAG_VARIABLE)) {
+        // Array item - slots hold indices of active usages
+        return process_array_item(globals, locals, report);
+    }
+
+    if (globals->report_size == 0 || globals->report_size > 32) {
+        // Values wider than 32 bits can't be extracted
+        LOG_WRN("Unsupported variable item {size: %u}", globals->report_size);
+        return hrm_report_skip_bits(report, bit_size);
+    }
+
+    if (report->bit_size + bit_size > HRM_MAX_REPORT_BITS) {
+        LOG_ERR("Report with ID %d is too long", globals->report_id);
+        return false;
     }
 
     bool have_range = (locals->usage_min != 0 || locals->usage_max != 0);
@@ -352,16 +526,16 @@ static bool process_input_item(const hrm_item_t *item, hrm_globals_t *globals, h
             usage = locals->usage_min + i;
         }
 
-        if (report->field_count < ARRAY_SIZE(report->fields)) {
-            hrm_field_t *field = &report->fields[report->field_count++];
-            field->bit_offset = report->bit_size;
-            field->bit_size = globals->report_size;
-            field->usage = (globals->usage_page << 16) | usage;
-            field->logical_min = globals->logical_min;
-            field->logical_max = globals->logical_max;
-        } else {
-            // Too many fields in the report
-            LOG_ERR("Field array overflow in report with ID %d", globals->report_id);
+        hrm_field_t field = {
+            .bit_offset = report->bit_size,
+            .bit_size = globals->report_size,
+            .usage = ((uint32_t)globals->usage_page << 16) | usage,
+            .logical_min = globals->logical_min,
+            .logical_max = globals->logical_max,
+        };
+
+        if (!hrm_add_field(hrm, report, &field)) {
+            LOG_ERR("Cannot add field to report with ID %d", globals->report_id);
             return false;
         }
 
@@ -424,10 +598,21 @@ void hrm_parse(hrm_t *hrm, const uint8_t *data, size_t size)
     hrm_global_stack_t gstack = {0};
     hrm_collection_stack_t cstack = {0};
 
-    const uint8_t *p = data;
-    const uint8_t *end = data + size;
+    hrm_reset(hrm);
+
+    if (size > HRM_MAX_RAW_SIZE) {
+        LOG_ERR("Report map too large {size: %zu}", size);
+        return;
+    }
+
+    // Keep the raw map at the end of the arena,
+    // the packed fields grow from the start
+    uint8_t *raw = &hrm->arena[HRM_ARENA_SIZE - size];
+    memmove(raw, data, size);
+    hrm->raw_size = size;
 
-    memset(hrm, 0, sizeof(*hrm));
+    const uint8_t *p = raw;
+    const uint8_t *end = raw + size;
 
     hrm_item_t item;
     while (p < end && (p = parse_item(p, end, &item)) != NULL) {
@@ -448,7 +633,7 @@ void hrm_parse(hrm_t *hrm, const uint8_t *data, size_t size)
             break;
 
         default:
-            LOG_WRN("Unknown type %u @%td", item.type, p - data);
+            LOG_WRN("Unknown type %u @%td", item.type, p - raw);
         }
 
         if (!ok) {
@@ -456,11 +641,88 @@ void hrm_parse(hrm_t *hrm, const uint8_t *data, size_t size)
         }
     }
 
+    // Release the raw map
+    hrm->raw_size = 0;
+
+    hrm_link_fields(hrm);
+
     if (p == NULL) {
         LOG_ERR("Parsing error");
     } else {
         LOG_INF("Parsing completed successfully.");
     }
+
+    LOG_INF("Report map {reports: %zu, fields: %u, memory: %zu bytes}", hrm->report_count,
+            hrm->field_count, hrm_mem_usage(hrm));
+}
+
+uint8_t *hrm_raw_buffer(hrm_t *hrm)
+{
+    return hrm->arena;
+}
+
+size_t hrm_mem_usage(const hrm_t *hrm)
+{
+    return offsetof(hrm_t, arena) + hrm->field_count * sizeof(hrm_packed_field_t);
+}
+
+// Boot mouse input report: buttons, X, Y
+static const hrm_field_t boot_mouse_fields[] = {
+    {.bit_offset = 0, .bit_size = 1, .usage = HRM_USAGE_BUTTON_1, .logical_max = 1},
+    {.bit_offset = 1, .bit_size = 1, .usage = HRM_USAGE_BUTTON_2, .logical_max = 1},
+    {.bit_offset = 2, .bit_size = 1, .usage = HRM_USAGE_BUTTON_3, .logical_max = 1},
+    {.bit_offset = 8, .bit_size = 8, .usage = HRM_USAGE_X, .logical_min = -127, .logical_max = 127},
+    {.bit_offset = 16, .bit_size = 8, .usage = HRM_USAGE_Y, .logical_min = -127, .logical_max = 127},
+};
+
+// Boot keyboard input report: modifier keys, reserved byte, 6 key codes
+static const hrm_field_t boot_keyboard_fields[] = {
+    {.bit_offset = 0, .bit_size = 1, .usage = HRM_USAGE_KEY_LEFT_CTRL, .logical_max = 1},
+    {.bit_offset = 1, .bit_size = 1, .usage = HRM_USAGE_KEY_LEFT_SHIFT, .logical_max = 1},
+    {.bit_offset = 2, .bit_size = 1, .usage = HRM_USAGE_KEY_LEFT_ALT, .logical_max = 1},
+    {.bit_offset = 3, .bit_size = 1, .usage = HRM_USAGE_KEY_LEFT_GUI, .logical_max = 1},
+    {.bit_offset = 4, .bit_size = 1, .usage = HRM_USAGE_KEY_RIGHT_CTRL, .logical_max = 1},
+    {.bit_offset = 5, .bit_size = 1, .usage = HRM_USAGE_KEY_RIGHT_SHIFT, .logical_max = 1},
+    {.bit_offset = 6, .bit_size = 1, .usage = HRM_USAGE_KEY_RIGHT_ALT, .logical_max = 1},
+    {.bit_offset = 7, .bit_size = 1, .usage = HRM_USAGE_KEY_RIGHT_GUI, .logical_max = 1},
+};
+
+static const hrm_array_t boot_keyboard_keys = {
+    .bit_offset = 16,
+    .bit_size = 8,
+    .count = 6,
+    .usage_page = 0x07,
+    .usage_min = 0x00,
+    .usage_max = 0xFF,
+    .logical_min = 0,
+};
+
+void hrm_init_boot(hrm_t *hrm, hrm_boot_t type)
+{
+    hrm_reset(hrm);
+
+    hrm_report_t *report = hrm_create_report(hrm, 0);
+
+    const hrm_field_t *fields;
+    size_t field_count;
+
+    if (type == HRM_BOOT_MOUSE) {
+        fields = boot_mouse_fields;
+        field_count = ARRAY_SIZE(boot_mouse_fields);
+        report->bit_size = 3 * 8;
+    } else {
+        fields = boot_keyboard_fields;
+        field_count = ARRAY_SIZE(boot_keyboard_fields);
+        report->arrays[0] = boot_keyboard_keys;
+        report->array_count = 1;
+        report->bit_size = 8 * 8;
+    }
+
+    for (size_t i = 0; i < field_count; i++) {
+        hrm_add_field(hrm, report, &fields[i]);
+    }
+
+    hrm_link_fields(hrm);
 }
 
 const hrm_report_t *hrm_find_report(const hrm_t *hrm, uint8_t report_id)
@@ -473,14 +735,25 @@ const hrm_report_t *hrm_find_report(const hrm_t *hrm, uint8_t report_id)
     return NULL;
 }
 
-const hrm_field_t *hrm_report_find_field(const hrm_report_t *report, hrm_usage_t usage)
+bool hrm_report_find_field(const hrm_report_t *report, hrm_usage_t usage, hrm_field_t *field)
 {
+    const hrm_t *hrm = report->map;
+
     for (size_t i = 0; i < report->field_count; ++i) {
-        if (report->fields[i].usage == usage) {
-            return &report->fields[i];
+        const hrm_packed_field_t *packed = &report->fields[i];
+
+        if (packed->usage != (usage & 0xFFFF) || hrm->pages[packed->page] != (usage >> 16)) {
+            continue;
         }
+
+        field->bit_offset = packed->bit_offset;
+        field->bit_size = packed->bit_size;
+        field->usage = usage;
+        field->logical_min = hrm->ranges[packed->range].min;
+        field->logical_max = hrm->ranges[packed->range].max;
+        return true;
     }
-    return NULL;
+    return false;
 }
 
 int32_t hrm_field_extract(const hrm_field_t *field, const uint8_t *data)
@@ -495,7 +768,7 @@ int32_t hrm_field_extract(const hrm_field_t *field, const uint8_t *data)
         size_t bit_idx = src_pos & 7;
         size_t chunk_bits = MIN(8 - bit_idx, bits_left);
 
-        uint32_t chunk = (data[byte_idx] >> bit_idx) & ((1 << chunk_bits) - 1);
+        uint32_t chunk = (data[byte_idx] >> bit_idx) & ((1u << chunk_bits) - 1);
 
         acc |= chunk << dst_pos;
 
@@ -504,13 +777,55 @@ int32_t hrm_field_extract(const hrm_field_t *field, const uint8_t *data)
         bits_left -= chunk_bits;
     }
 
-    if (field->logical_min < 0) {
+    if (field->logical_min < 0 && field->bit_size > 0 && field->bit_size < 32) {
         // Sign-extend the value
         size_t sign_bit = field->bit_size - 1;
-        if (acc & (1 << sign_bit)) {
-            acc |= ~((1 << field->bit_size) - 1);
+        if (acc & (1u << sign_bit)) {
+            acc |= ~((1u << field->bit_size) - 1);
         }
     }
 
     return acc;
 }
+
+int hrm_report_find_array(const hrm_report_t *report, hrm_usage_t usage, uint16_t *bit)
+{
+    uint16_t usage_page = usage >> 16;
+    uint16_t usage_id = usage & 0xFFFF;
+
+    for (size_t i = 0; i < report->array_count; ++i) {
+        const hrm_array_t *array = &report->arrays[i];
+        if (array->usage_page == usage_page && usage_id >= array->usage_min &&
+            usage_id <= array->usage_max) {
+            *bit = usage_id - array->usage_min;
+            return i;
+        }
+    }
+    return -1;
+}
+
+void hrm_report_decode_arrays(const hrm_report_t *report, const uint8_t *data,
+                              hrm_usage_set_t *set)
+{
+    for (size_t i = 0; i < report->array_count; ++i) {
+        const hrm_array_t *array = &report->arrays[i];
+
+        memset(set->bits[i], 0, sizeof(set->bits[i]));
+
+        hrm_field_t slot = {
+            .bit_offset = array->bit_offset,
+            .bit_size = array->bit_size,
+        };
+
+        uint32_t usage_count = array->usage_max - array->usage_min + 1;
+
+        for (uint8_t j = 0; j < array->count; j++) {
+            // Slot values outside the usage range are ignored
+            uint32_t idx = hrm_field_extract(&slot, data) - array->logical_min;
+            if (idx < usage_count) {
+                set->bits[i][idx >> 5] |= 1u << (idx & 31);
+            }
+            slot.bit_offset += array->bit_size;
+        }
+    }
+}
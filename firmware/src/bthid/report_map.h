@@ -18,6 +18,7 @@
 
 #pragma once
 
+#include <stdbool.h>
 #include <stdint.h>
 #include <stddef.h>
 
@@ -64,6 +65,21 @@ typedef enum {
     HRM_USAGE_BUTTON_30 = 0x09001E,
     HRM_USAGE_BUTTON_31 = 0x09001F,
     HRM_USAGE_BUTTON_32 = 0x090020,
+    HRM_USAGE_KEY_ENTER = 0x070028,
+    HRM_USAGE_KEY_ESCAPE = 0x070029,
+    HRM_USAGE_KEY_SPACE = 0x07002C,
+    HRM_USAGE_KEY_RIGHT = 0x07004F,
+    HRM_USAGE_KEY_LEFT = 0x070050,
+    HRM_USAGE_KEY_DOWN = 0x070051,
+    HRM_USAGE_KEY_UP = 0x070052,
+    HRM_USAGE_KEY_LEFT_CTRL = 0x0700E0,
+    HRM_USAGE_KEY_LEFT_SHIFT = 0x0700E1,
+    HRM_USAGE_KEY_LEFT_ALT = 0x0700E2,
+    HRM_USAGE_KEY_LEFT_GUI = 0x0700E3,
+    HRM_USAGE_KEY_RIGHT_CTRL = 0x0700E4,
+    HRM_USAGE_KEY_RIGHT_SHIFT = 0x0700E5,
+    HRM_USAGE_KEY_RIGHT_ALT = 0x0700E6,
+    HRM_USAGE_KEY_RIGHT_GUI = 0x0700E7,
     HRM_USAGE_BUTTON_PLAY = 0x0C00CD,
     HRM_USAGE_BUTTON_VOL_INC = 0x0C00E9,
     HRM_USAGE_BUTTON_VOL_DEC = 0x0C00EA,
@@ -78,6 +94,13 @@ typedef enum {
     HRM_USAGE_INTG1_ABS = 0xFFF00102, // Integrator 1, absolute value
     HRM_USAGE_INTG1_ENC = 0xFFF00103, // Integrator 1, encoder value
 
+    // Custom usages internally used for mapping pins to mapping program expressions
+    HRM_USAGE_EXPR0 = 0xFFE00000, // Expression 0
+    HRM_USAGE_EXPR1 = 0xFFE00001, // Expression 1
+    HRM_USAGE_EXPR2 = 0xFFE00002, // Expression 2
+    HRM_USAGE_EXPR3 = 0xFFE00003, // Expression 3
+    HRM_USAGE_EXPR4 = 0xFFE00004, // Expression 4
+
 } hrm_usage_t;
 
 #define HRM_USAGE_IS_INTG(source)        ((source & 0xFFF00000) == 0xFFF00000)
@@ -86,7 +109,11 @@ typedef enum {
 #define HRM_USAGE_IS_INTG_ABS(source)    ((source & 0x000000FF) == 0x02)
 #define HRM_USAGE_IS_INTG_ENC(source)    ((source & 0x000000FF) == 0x03)
 
+#define HRM_USAGE_IS_EXPR(source)      ((source & 0xFFF00000) == 0xFFE00000)
+#define HRM_USAGE_GET_EXPR_IDX(source) (source & 0x000000FF)
+
 // HID report field definition
+// (unpacked form returned by hrm_report_find_field())
 typedef struct {
     // Bit offset from the start of the report
     uint16_t bit_offset;
@@ -100,34 +127,153 @@ typedef struct {
     int32_t logical_max;
 } hrm_field_t;
 
+// Packed HID report field as stored in the report map arena
+typedef struct {
+    // Bit offset from the start of the report
+    uint16_t bit_offset;
+    // Size of the field in bits
+    uint8_t bit_size;
+    // Index to hrm_t.pages
+    uint8_t page;
+    // Usage ID within the usage page
+    uint16_t usage;
+    // Index to hrm_t.ranges
+    uint8_t range;
+    // Index to hrm_t.reports (used while parsing)
+    uint8_t report;
+} hrm_packed_field_t;
+
+// Logical range shared by fields
+typedef struct {
+    int32_t min;
+    int32_t max;
+} hrm_range_t;
+
+// Number of usages covered by one array field
+#define HRM_ARRAY_USAGES 256
+
+// HID report array field definition
+// (`count` slots, each holding an index of a currently active usage,
+// e.g. key codes of pressed keys)
+typedef struct {
+    // Bit offset of the first slot from the start of the report
+    uint16_t bit_offset;
+    // Size of one slot in bits
+    uint8_t bit_size;
+    // Number of slots
+    uint8_t count;
+    // Usage page of the selected usages
+    uint16_t usage_page;
+    // Usage selected by the slot value `logical_min`
+    uint16_t usage_min;
+    // Last usage that can be selected
+    uint16_t usage_max;
+    // Slot value of `usage_min`
+    int32_t logical_min;
+} hrm_array_t;
+
+// Usages currently selected by the array fields of a report
+// (one bit per usage, bit index is usage - usage_min)
+typedef struct {
+    uint32_t bits[2][HRM_ARRAY_USAGES / 32];
+} hrm_usage_set_t;
+
+struct hrm;
+
 // HID report definition
 typedef struct {
     // ID of the report (found at the start of the report)
     uint8_t id;
     // Sum of the bit size of all fields in the report
     uint16_t bit_size;
-    // Array of fields in the report
-    hrm_field_t fields[32];
+    // Fields of the report (in the report map arena)
+    const hrm_packed_field_t *fields;
     // Number of fields in the report
-    size_t field_count;
+    uint16_t field_count;
+    // Array fields in the report
+    hrm_array_t arrays[2];
+    // Number of array fields in the report
+    size_t array_count;
+    // Report map the report belongs to
+    const struct hrm *map;
 } hrm_report_t;
 
+// Size of the per-device arena holding the raw report map
+// while it's parsed and the packed fields afterwards
+#define HRM_ARENA_SIZE 1024
+
+// Largest report map that can be parsed
+#define HRM_MAX_RAW_SIZE 512
+
+// Longest report that can be described (maximum ATT attribute size)
+#define HRM_MAX_REPORT_BITS (512 * 8)
+
 // HID report map definition
-typedef struct {
+typedef struct hrm {
     // List of reports
     hrm_report_t reports[4];
     // Number of reports in the report map
     size_t report_count;
+    // Usage pages referenced by fields
+    uint16_t pages[8];
+    uint8_t page_count;
+    // Logical ranges referenced by fields
+    hrm_range_t ranges[16];
+    uint8_t range_count;
+    // Number of packed fields at the start of the arena
+    uint16_t field_count;
+    // Size of the raw report map kept at the end of the arena
+    // (zero once parsed)
+    uint16_t raw_size;
+    // Packed fields, followed by free space
+    // and the raw report map while parsing
+    union {
+        hrm_packed_field_t fields[HRM_ARENA_SIZE / sizeof(hrm_packed_field_t)];
+        uint8_t arena[HRM_ARENA_SIZE];
+    };
 } hrm_t;
 
+// Boot protocol report layouts
+typedef enum {
+    HRM_BOOT_MOUSE = 0,
+    HRM_BOOT_KEYBOARD = 1,
+} hrm_boot_t;
+
+// Returns the buffer the raw report map should be read into
+// (HRM_MAX_RAW_SIZE bytes, aliases the arena, so it's invalidated by parsing)
+uint8_t *hrm_raw_buffer(hrm_t *hrm);
+
 // Parse HID report map into the list of reports and fields
+// `data` may point to hrm_raw_buffer()
 void hrm_parse(hrm_t *hrm, const uint8_t *data, size_t size);
 
+// Returns the number of arena bytes used by the parsed report map
+size_t hrm_mem_usage(const hrm_t *hrm);
+
+// Initialize the report map with the fixed boot protocol report layout
+// (HID 1.11, Appendix B)
+void hrm_init_boot(hrm_t *hrm, hrm_boot_t type);
+
 // Find a report by its ID in the report map
 const hrm_report_t *hrm_find_report(const hrm_t *hrm, uint8_t report_id);
 
 // Find a field by its usage ID in the report
-const hrm_field_t *hrm_report_find_field(const hrm_report_t *report, hrm_usage_t usage);
+// Returns true and fills `field` if found
+bool hrm_report_find_field(const hrm_report_t *report, hrm_usage_t usage, hrm_field_t *field);
 
 // Extract the value of a field from the report data
 int32_t hrm_field_extract(const hrm_field_t *field, const uint8_t *data);
+
+// Find the array field that can select the given usage
+// Returns the array index and stores the usage bit index to `bit`, or -1 if not found
+int hrm_report_find_array(const hrm_report_t *report, hrm_usage_t usage, uint16_t *bit);
+
+// Decode all array fields of the report into the set of selected usages
+void hrm_report_decode_arrays(const hrm_report_t *report, const uint8_t *data,
+                              hrm_usage_set_t *set);
+
+// Check if the usage bit returned by hrm_report_find_array() is set
+static inline bool hrm_usage_set_test(const hrm_usage_set_t *set, int array, uint16_t bit)
+{
+    return (set->bits[array][bit >> 5] & (1u << (bit & 31))) != 0;
+}
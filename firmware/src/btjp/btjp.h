@@ -21,9 +21,12 @@
 #include <event/event_queue.h>
 
 // Handles an incoming btjp message and prepares a response
-size_t btjp_handle_message(const void *inbuff, size_t insize, void *outbuff, size_t outsize);
+// (`evq` is the event queue of the requesting session)
+size_t btjp_handle_message(const void *inbuff, size_t insize, void *outbuff, size_t outsize,
+                           event_queue_t *evq);
 
 // Pops an event from the event queue and builds a btjp event message
+// (events with nothing to send are skipped, returns 0 only if the queue is empty)
 size_t btjp_build_evt_message(void *outbuff, size_t outsize, event_queue_t *evq);
 
 // Populates the event queue with initial events
@@ -27,6 +27,7 @@
 
 #include <devmgr/devmgr.h>
 #include <mapper/mapper.h>
+#include <mapper/profile_dto.h>
 
 #include "btjp.h"
 #include "btjp_utils.h"
@@ -34,6 +35,9 @@
 
 LOG_MODULE_DECLARE(blue2joy, CONFIG_LOG_DEFAULT_LEVEL);
 
+BUILD_ASSERT(PROFILE_DTO_MAX_SIZE <= BTJP_PROFILE_DATA_MAX_SIZE, "Profile data does not fit");
+BUILD_ASSERT(sizeof(((btjp_curve_t *)0)->points) == MAPPER_CURVE_POINTS, "Curve points mismatch");
+
 #define CHECK_REQ_SIZE(req, expected_size)                                                         \
     do {                                                                                           \
         if ((req)->hdr.size != (expected_size)) {                                                  \
@@ -68,14 +72,22 @@ static void hw_id_get_bytes(uint8_t *buff, size_t buff_size)
     }
 }
 
-static btjp_status_t btjp_handle_request(const btjp_req_t *req, btjp_rsp_t *rsp)
+static void curve_from_msg(const btjp_curve_t *msg, mapper_curve_t *curve)
+{
+    curve->type = (mapper_curve_type_t)msg->type;
+    curve->amount = msg->amount;
+    memcpy(curve->points, msg->points, sizeof(curve->points));
+}
+
+static btjp_status_t btjp_handle_request(const btjp_req_t *req, btjp_rsp_t *rsp,
+                                         event_queue_t *evq)
 {
     switch (req->hdr.msg_id) {
     case BTJP_MSG_GET_API_VERSION: {
         CHECK_REQ_SIZE(req, 0);
         rsp->hdr.size = sizeof(rsp->get_api_version);
-        rsp->get_api_version.major = 1;
-        rsp->get_api_version.minor = 0;
+        rsp->get_api_version.major = BTJP_API_VERSION_MAJOR;
+        rsp->get_api_version.minor = BTJP_API_VERSION_MINOR;
     } break;
 
     case BTJP_MSG_GET_SYS_INFO: {
@@ -86,6 +98,11 @@ static btjp_status_t btjp_handle_request(const btjp_req_t *req, btjp_rsp_t *rsp)
         rsp->get_sys_info.hw_version = 0;
     } break;
 
+    case BTJP_MSG_GET_SYS_STATS: {
+        CHECK_REQ_SIZE(req, 0);
+        rsp->hdr.size = sys_stats_to_msg(&rsp->get_sys_stats);
+    } break;
+
     case BTJP_MSG_SET_DEV_CONFIG: {
         CHECK_REQ_SIZE(req, sizeof(req->set_dev_config));
 
@@ -94,6 +111,7 @@ static btjp_status_t btjp_handle_request(const btjp_req_t *req, btjp_rsp_t *rsp)
 
         devmgr_device_config_t config = {0};
         config.profile = req->set_dev_config.profile;
+        config.boot_protocol = (req->set_dev_config.flags & BTJP_DEV_FLAG_BOOT_PROTOCOL) != 0;
 
         int err = devmgr_set_device_config(&addr, &config, true);
         if (err != 0) {
@@ -102,7 +120,10 @@ static btjp_status_t btjp_handle_request(const btjp_req_t *req, btjp_rsp_t *rsp)
     } break;
 
     case BTJP_MSG_SET_PIN_CONFIG: {
-        CHECK_REQ_SIZE(req, sizeof(req->set_pin_config));
+        bool has_autofire = req->hdr.size != BTJP_SET_PIN_CONFIG_V0_SIZE;
+        if (has_autofire) {
+            CHECK_REQ_SIZE(req, sizeof(req->set_pin_config));
+        }
 
         mapper_profile_t profile;
         int err = mapper_get_profile(req->set_pin_config.profile, &profile);
@@ -122,6 +143,9 @@ static btjp_status_t btjp_handle_request(const btjp_req_t *req, btjp_rsp_t *rsp)
         config->hat_switch = req->set_pin_config.hat_switch;
         config->threshold = req->set_pin_config.threshold;
         config->hysteresis = req->set_pin_config.hysteresis;
+        if (has_autofire) {
+            config->autofire = req->set_pin_config.autofire;
+        }
 
         err = mapper_set_profile(req->set_pin_config.profile, &profile, true);
         if (err != 0) {
@@ -132,6 +156,10 @@ static btjp_status_t btjp_handle_request(const btjp_req_t *req, btjp_rsp_t *rsp)
     case BTJP_MSG_SET_POT_CONFIG: {
         CHECK_REQ_SIZE(req, sizeof(req->set_pot_config));
 
+        mapper_curve_t curve;
+        curve_from_msg(&req->set_pot_config.curve, &curve);
+        CHECK_REQ_ARG(mapper_curve_valid(&curve));
+
         mapper_profile_t profile;
         int err = mapper_get_profile(req->set_pot_config.profile, &profile);
         if (err != 0) {
@@ -148,6 +176,7 @@ static btjp_status_t btjp_handle_request(const btjp_req_t *req, btjp_rsp_t *rsp)
         config->source = req->set_pot_config.source;
         config->low = req->set_pot_config.low;
         config->high = req->set_pot_config.high;
+        config->curve = curve;
 
         err = mapper_set_profile(req->set_pot_config.profile, &profile, true);
         if (err != 0) {
@@ -158,6 +187,10 @@ static btjp_status_t btjp_handle_request(const btjp_req_t *req, btjp_rsp_t *rsp)
     case BTJP_MSG_SET_INTG_CONFIG: {
         CHECK_REQ_SIZE(req, sizeof(req->set_intg_config));
 
+        mapper_curve_t curve;
+        curve_from_msg(&req->set_intg_config.curve, &curve);
+        CHECK_REQ_ARG(mapper_curve_valid(&curve));
+
         mapper_profile_t profile;
         int err = mapper_get_profile(req->set_intg_config.profile, &profile);
         if (err != 0) {
@@ -176,6 +209,7 @@ static btjp_status_t btjp_handle_request(const btjp_req_t *req, btjp_rsp_t *rsp)
         config->dead_zone = req->set_intg_config.dead_zone;
         config->gain = req->set_intg_config.gain;
         config->max = req->set_intg_config.max;
+        config->curve = curve;
 
         err = mapper_set_profile(req->set_intg_config.profile, &profile, true);
         if (err != 0) {
@@ -194,33 +228,16 @@ static btjp_status_t btjp_handle_request(const btjp_req_t *req, btjp_rsp_t *rsp)
     } break;
 
     case BTJP_MSG_SET_PROFILE: {
-        CHECK_REQ_SIZE(req, sizeof(req->set_profile));
-
-        mapper_profile_t profile = {0};
-
-        for (int i = 0; i < ARRAY_SIZE(req->set_profile.pins); i++) {
-            mapper_pin_config_t *pin = profile_pin(&profile, i);
-            pin->source = req->set_profile.pins[i].source;
-            pin->invert = req->set_profile.pins[i].invert ? true : false;
-            pin->hat_switch = req->set_profile.pins[i].hat_switch;
-            pin->threshold = req->set_profile.pins[i].threshold;
-            pin->hysteresis = req->set_profile.pins[i].hysteresis;
+        if (req->hdr.size < sizeof(req->set_profile.profile) + 1) {
+            return BTJP_ERR_INVALID_REQ;
         }
 
-        for (int i = 0; i < ARRAY_SIZE(req->set_profile.pots); i++) {
-            mapper_pot_config_t *pot = profile_pot(&profile, i);
-            pot->source = req->set_profile.pots[i].source;
-            pot->low = req->set_profile.pots[i].low;
-            pot->high = req->set_profile.pots[i].high;
-        }
+        mapper_profile_t profile;
+        size_t data_size = req->hdr.size - sizeof(req->set_profile.profile);
 
-        for (int i = 0; i < ARRAY_SIZE(req->set_profile.intgs); i++) {
-            mapper_intg_config_t *intg = profile_intg(&profile, i);
-            intg->source = req->set_profile.intgs[i].source;
-            intg->mode = (mapper_intr_mode_t)req->set_profile.intgs[i].mode;
-            intg->dead_zone = req->set_profile.intgs[i].dead_zone;
-            intg->gain = req->set_profile.intgs[i].gain;
-            intg->max = req->set_profile.intgs[i].max;
+        if (profile_dto_parse(req->set_profile.data, data_size, &profile) < 0) {
+            LOG_ERR("Invalid profile data");
+            return BTJP_ERR_INVALID_ARG;
         }
 
         // Save updated profile
@@ -228,7 +245,7 @@ static btjp_status_t btjp_handle_request(const btjp_req_t *req, btjp_rsp_t *rsp)
         if (err) {
             return BTJP_ERR_INVALID_ARG;
         }
-    }
+    } break;
 
     case BTJP_MSG_FACTORY_RESET: {
     } break;
@@ -272,6 +289,17 @@ static btjp_status_t btjp_handle_request(const btjp_req_t *req, btjp_rsp_t *rsp)
         }
     } break;
 
+    case BTJP_MSG_SUBSCRIBE: {
+        CHECK_REQ_SIZE(req, sizeof(req->subscribe));
+
+        uint32_t subjects = 0;
+        if (req->subscribe.events & BTJP_SUBSCRIBE_LINK_STATS) {
+            subjects |= BIT(EV_SUBJECT_LINK_STATS);
+        }
+
+        event_queue_subscribe(evq, subjects);
+    } break;
+
     default:
         return BTJP_ERR_UNKNOWN_MSG;
     }
@@ -279,7 +307,8 @@ static btjp_status_t btjp_handle_request(const btjp_req_t *req, btjp_rsp_t *rsp)
     return BTJP_ERR_NONE;
 }
 
-size_t btjp_handle_message(const void *inbuff, size_t insize, void *outbuff, size_t outsize)
+size_t btjp_handle_message(const void *inbuff, size_t insize, void *outbuff, size_t outsize,
+                           event_queue_t *evq)
 {
     if (insize < sizeof(btjp_msg_header_t) || outsize < sizeof(btjp_rsp_t)) {
         LOG_ERR("Invalid buffer size");
@@ -302,7 +331,7 @@ size_t btjp_handle_message(const void *inbuff, size_t insize, void *outbuff, siz
     rsp->hdr.msg_id = req->hdr.msg_id;
     rsp->hdr.flags = BTJP_MSG_TYPE_RESPONSE;
 
-    btjp_status_t status = btjp_handle_request(req, rsp);
+    btjp_status_t status = btjp_handle_request(req, rsp, evq);
 
     if (status != BTJP_ERR_NONE) {
         LOG_ERR("Request handling error {status: %d}", status);
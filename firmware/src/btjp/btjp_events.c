@@ -2,6 +2,7 @@
 
 #include <devmgr/devmgr.h>
 #include <mapper/mapper.h>
+#include <mapper/profile_dto.h>
 
 #include "btjp.h"
 #include "btjp_utils.h"
@@ -63,6 +64,7 @@ static size_t btjp_build_evt_dev_list_update(btjp_evt_t *evt, bt_addr_le_t *addr
         evt->dev_list_update.deleted = false;
         evt->dev_list_update.conn_state = (uint8_t)state.conn_state;
         evt->dev_list_update.profile = config.profile;
+        evt->dev_list_update.flags = config.boot_protocol ? BTJP_DEV_FLAG_BOOT_PROTOCOL : 0;
     } else {
         evt->dev_list_update.deleted = true;
     }
@@ -73,7 +75,6 @@ static size_t btjp_build_evt_dev_list_update(btjp_evt_t *evt, bt_addr_le_t *addr
 static size_t btjp_build_evt_profile_update(btjp_evt_t *evt, uint8_t idx)
 {
     evt->hdr.msg_id = BTJP_MSG_EVT_PROFILE_UPDATE;
-    evt->hdr.size = sizeof(evt->profile_update);
 
     mapper_profile_t profile;
 
@@ -85,30 +86,14 @@ static size_t btjp_build_evt_profile_update(btjp_evt_t *evt, uint8_t idx)
 
     evt->profile_update.profile = idx;
 
-    for (int i = 0; i < ARRAY_SIZE(evt->profile_update.pins); i++) {
-        mapper_pin_config_t *pin = profile_pin(&profile, i);
-        evt->profile_update.pins[i].source = pin->source;
-        evt->profile_update.pins[i].invert = pin->invert ? 1 : 0;
-        evt->profile_update.pins[i].hat_switch = pin->hat_switch;
-        evt->profile_update.pins[i].threshold = pin->threshold;
-        evt->profile_update.pins[i].hysteresis = pin->hysteresis;
-    }
-
-    for (int i = 0; i < ARRAY_SIZE(evt->profile_update.pots); i++) {
-        mapper_pot_config_t *pot = profile_pot(&profile, i);
-        evt->profile_update.pots[i].source = pot->source;
-        evt->profile_update.pots[i].low = pot->low;
-        evt->profile_update.pots[i].high = pot->high;
+    ssize_t data_size =
+        profile_dto_build(&profile, evt->profile_update.data, sizeof(evt->profile_update.data));
+    if (data_size < 0) {
+        LOG_ERR("Failed to encode profile %d", idx);
+        return 0;
     }
 
-    for (int i = 0; i < ARRAY_SIZE(evt->profile_update.intgs); i++) {
-        mapper_intg_config_t *intg = profile_intg(&profile, i);
-        evt->profile_update.intgs[i].source = intg->source;
-        evt->profile_update.intgs[i].mode = intg->mode;
-        evt->profile_update.intgs[i].dead_zone = intg->dead_zone;
-        evt->profile_update.intgs[i].gain = intg->gain;
-        evt->profile_update.intgs[i].max = intg->max;
-    }
+    evt->hdr.size = sizeof(evt->profile_update.profile) + data_size;
 
     return sizeof(btjp_msg_header_t) + evt->hdr.size;
 }
@@ -126,6 +111,122 @@ static size_t btjp_build_evt_io_port_update(btjp_evt_t *evt, const event_io_t *i
     return sizeof(btjp_msg_header_t) + evt->hdr.size;
 }
 
+// Sends the next profile of the library and queues the rest of the listing,
+// so that the whole library takes a single slot of the event queue
+static size_t btjp_build_evt_profile_list(btjp_evt_t *evt, uint8_t idx, event_queue_t *evq)
+{
+    int next = mapper_next_profile(idx);
+    if (next < 0) {
+        return 0;
+    }
+
+    if (next + 1 < MAPPER_MAX_PROFILES) {
+        event_t ev = {
+            .subject = EV_SUBJECT_PROFILE_LIST,
+            .action = EV_ACTION_UPDATE,
+            .idx = next + 1,
+        };
+        event_queue_push(evq, &ev);
+    }
+
+    return btjp_build_evt_profile_update(evt, next);
+}
+
+static size_t btjp_build_evt_active_profile_update(btjp_evt_t *evt)
+{
+    evt->hdr.msg_id = BTJP_MSG_EVT_ACTIVE_PROFILE_UPDATE;
+    evt->hdr.size = sizeof(evt->active_profile_update);
+
+    int idx = mapper_get_active_profile();
+
+    evt->active_profile_update.profile = idx >= 0 ? idx : BTJP_ACTIVE_PROFILE_NONE;
+
+    return sizeof(btjp_msg_header_t) + evt->hdr.size;
+}
+
+static size_t btjp_build_evt_sys_stats_update(btjp_evt_t *evt)
+{
+    evt->hdr.msg_id = BTJP_MSG_EVT_SYS_STATS_UPDATE;
+    evt->hdr.size = sys_stats_to_msg(&evt->sys_stats_update);
+
+    return sizeof(btjp_msg_header_t) + evt->hdr.size;
+}
+
+BUILD_ASSERT(BTJP_REPORT_INTERVAL_BUCKETS == BTHID_REPORT_INTERVAL_BUCKETS,
+             "Report interval buckets mismatch");
+BUILD_ASSERT(sizeof(((btjp_evt_link_stats_update_t *)0)->disconnect_reasons) ==
+                 BTHID_DISCONNECT_REASONS,
+             "Disconnect reasons mismatch");
+
+static size_t btjp_build_evt_link_stats_update(btjp_evt_t *evt, bt_addr_le_t *addr)
+{
+    bthid_link_stats_t stats;
+
+    int err = devmgr_get_link_stats(addr, &stats);
+    if (err != 0) {
+        // Device slot reused in the meantime
+        return 0;
+    }
+
+    evt->hdr.msg_id = BTJP_MSG_EVT_LINK_STATS_UPDATE;
+    evt->hdr.size = sizeof(evt->link_stats_update);
+
+    btjp_evt_link_stats_update_t *msg = &evt->link_stats_update;
+
+    dev_addr_from_bt_addr_le(&msg->addr, addr);
+    msg->rssi = stats.rssi;
+    msg->reports = stats.reports;
+    msg->missed = stats.missed;
+    memcpy(msg->report_intervals, stats.report_intervals, sizeof(msg->report_intervals));
+    msg->conn_interval = stats.conn_interval;
+    msg->conn_latency = stats.conn_latency;
+    msg->conn_timeout = stats.conn_timeout;
+    msg->report_rate = stats.report_rate;
+    msg->tx_phy = stats.tx_phy;
+    msg->rx_phy = stats.rx_phy;
+    msg->disconnects = stats.disconnects;
+    memcpy(msg->disconnect_reasons, stats.disconnect_reasons, sizeof(msg->disconnect_reasons));
+
+    return sizeof(btjp_msg_header_t) + evt->hdr.size;
+}
+
+static size_t btjp_build_evt_list_reset(btjp_evt_t *evt)
+{
+    evt->hdr.msg_id = BTJP_MSG_EVT_LIST_RESET;
+    evt->hdr.size = 0;
+
+    return sizeof(btjp_msg_header_t) + evt->hdr.size;
+}
+
+// Builds the message of a popped event
+// Returns 0 if there is nothing to send for the event
+static size_t btjp_build_evt(btjp_evt_t *evt, event_t *ev, event_queue_t *evq)
+{
+    switch (ev->subject) {
+    case EV_SUBJECT_SYS_STATE:
+        return btjp_build_evt_sys_state_update(evt);
+    case EV_SUBJECT_ADV_LIST:
+        return btjp_build_evt_adv_list_update(evt, &ev->addr);
+    case EV_SUBJECT_DEV_LIST:
+        return btjp_build_evt_dev_list_update(evt, &ev->addr);
+    case EV_SUBJECT_PROFILE:
+        return btjp_build_evt_profile_update(evt, ev->idx);
+    case EV_SUBJECT_PROFILE_LIST:
+        return btjp_build_evt_profile_list(evt, ev->idx, evq);
+    case EV_SUBJECT_IO_STATE:
+        return btjp_build_evt_io_port_update(evt, &ev->io);
+    case EV_SUBJECT_ACTIVE_PROFILE:
+        return btjp_build_evt_active_profile_update(evt);
+    case EV_SUBJECT_SYS_STATS:
+        return btjp_build_evt_sys_stats_update(evt);
+    case EV_SUBJECT_LINK_STATS:
+        return btjp_build_evt_link_stats_update(evt, &ev->addr);
+    default:
+        LOG_ERR("Unhandled event subject %d", ev->subject);
+        return 0;
+    }
+}
+
 size_t btjp_build_evt_message(void *outbuff, size_t outsize, event_queue_t *evq)
 {
     event_t ev;
@@ -142,20 +243,25 @@ size_t btjp_build_evt_message(void *outbuff, size_t outsize, event_queue_t *evq)
     evt->hdr.seq = 0;
     evt->hdr.flags = BTJP_MSG_TYPE_EVENT;
 
-    if (event_queue_pop(evq, &ev) != 0) {
-        switch (ev.subject) {
-        case EV_SUBJECT_SYS_STATE:
-            return btjp_build_evt_sys_state_update(evt);
-        case EV_SUBJECT_ADV_LIST:
-            return btjp_build_evt_adv_list_update(evt, &ev.addr);
-        case EV_SUBJECT_DEV_LIST:
-            return btjp_build_evt_dev_list_update(evt, &ev.addr);
-        case EV_SUBJECT_PROFILE:
-            return btjp_build_evt_profile_update(evt, ev.idx);
-        case EV_SUBJECT_IO_STATE:
-            return btjp_build_evt_io_port_update(evt, &ev.io);
-        default:
-            LOG_ERR("Unhandled event subject %d", ev.subject);
+    // Set together with resync, sent before the complete state
+    bool reset = event_queue_take_reset(evq);
+
+    if (event_queue_take_resync(evq)) {
+        // Some events were dropped, send the complete state again
+        LOG_WRN("Event queue overflow, resynchronizing");
+        btjp_populate_event_queue(evq);
+    }
+
+    if (reset) {
+        return btjp_build_evt_list_reset(evt);
+    }
+
+    // The transports stop draining on 0, so events with nothing
+    // to send (e.g. a device gone in the meantime) are skipped here
+    while (event_queue_pop(evq, &ev) != 0) {
+        size_t size = btjp_build_evt(evt, &ev, evq);
+        if (size != 0) {
+            return size;
         }
     }
 
@@ -172,20 +278,41 @@ void btjp_populate_event_queue(event_queue_t *evq)
     event_queue_push(evq, &ev);
 
     // Device list update
+    // (UPDATE, not CREATE, so that a following DELETE is not
+    // cancelled out on resync when the receiver knows the device)
     bt_addr_le_t addrs[DEVMGR_MAX_CONFIG_ENTRIES];
     int n = devmgr_get_devices(addrs);
     for (int i = 0; i < n; i++) {
         ev.subject = EV_SUBJECT_DEV_LIST;
-        ev.action = EV_ACTION_CREATE;
+        ev.action = EV_ACTION_UPDATE;
         bt_addr_le_copy(&ev.addr, &addrs[i]);
         event_queue_push(evq, &ev);
     }
 
-    // Profiles update
-    for (uint8_t i = 0; i < MAPPER_MAX_PROFILES; i++) {
-        ev.subject = EV_SUBJECT_PROFILE;
-        ev.action = EV_ACTION_CREATE;
-        ev.idx = i;
+    // Scan results update
+    bt_addr_le_t adv_addrs[DEVMGR_MAX_ADVLIST_ENTRIES];
+    n = devmgr_get_advertising_devices(adv_addrs);
+    for (int i = 0; i < n; i++) {
+        ev.subject = EV_SUBJECT_ADV_LIST;
+        ev.action = EV_ACTION_UPDATE;
+        bt_addr_le_copy(&ev.addr, &adv_addrs[i]);
         event_queue_push(evq, &ev);
     }
+
+    // Profiles update (streamed one by one from the flash)
+    ev.subject = EV_SUBJECT_PROFILE_LIST;
+    ev.action = EV_ACTION_CREATE;
+    ev.idx = 0;
+    event_queue_push(evq, &ev);
+
+    // Active profile update
+    ev.subject = EV_SUBJECT_ACTIVE_PROFILE;
+    ev.action = EV_ACTION_UPDATE;
+    event_queue_push(evq, &ev);
+
+    // IO port state update
+    ev.subject = EV_SUBJECT_IO_STATE;
+    ev.action = EV_ACTION_UPDATE;
+    mapper_get_io_state(&ev.io);
+    event_queue_push(evq, &ev);
 }
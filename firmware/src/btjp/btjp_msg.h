@@ -18,8 +18,15 @@
 
 #pragma once
 
+#include <stddef.h>
 #include <stdint.h>
 
+// Protocol version reported by GET_API_VERSION
+// (minor versions only add optional fields, see BTJP_SET_PIN_CONFIG_V0_SIZE,
+// events older clients ignore and new requests)
+#define BTJP_API_VERSION_MAJOR 3
+#define BTJP_API_VERSION_MINOR 3
+
 #define BTJP_MSG_TYPE_MASK 0x03
 
 #define BTJP_MSG_TYPE_REQUEST  0
@@ -27,6 +34,10 @@
 #define BTJP_MSG_TYPE_RESPONSE 2
 #define BTJP_MSG_TYPE_ERROR    3
 
+// Request flag: events caused by the request are sent also to the
+// requesting client (by default only other clients get them)
+#define BTJP_MSG_FLAG_ECHO 0x04
+
 typedef struct {
     uint8_t flags;
     uint8_t msg_id;
@@ -61,6 +72,8 @@ typedef enum {
     BTJP_MSG_CONNECT_DEVICE = 10,
     BTJP_MSG_DELETE_DEVICE = 11,
     BTJP_MSG_FACTORY_RESET = 12,
+    BTJP_MSG_GET_SYS_STATS = 13,
+    BTJP_MSG_SUBSCRIBE = 14,
 
     // Events
     BTJP_MSG_EVT_SYS_STATE_UPDATE = 64,
@@ -68,9 +81,37 @@ typedef enum {
     BTJP_MSG_EVT_ADV_LIST_UPDATE = 66,
     BTJP_MSG_EVT_DEV_LIST_UPDATE = 67,
     BTJP_MSG_EVT_PROFILE_UPDATE = 68,
+    BTJP_MSG_EVT_ACTIVE_PROFILE_UPDATE = 69,
+    BTJP_MSG_EVT_SYS_STATS_UPDATE = 70,
+    BTJP_MSG_EVT_LINK_STATS_UPDATE = 71,
+    // No payload, the client clears its device and scan result lists,
+    // the complete state follows (sent after an event queue overflow)
+    BTJP_MSG_EVT_LIST_RESET = 72,
 
 } btjp_msg_id_t;
 
+// --------------------------------------------------------------------------
+// Bulk data streams
+//
+// Streams are sent over an LE L2CAP connection-oriented channel
+// (PSM BTJP_STREAM_PSM). The client writes a single byte with the stream
+// id, the data follows in SDUs starting with btjp_stream_hdr_t. The last
+// SDU of the stream has BTJP_STREAM_FLAG_END set.
+
+#define BTJP_STREAM_PSM 0x00B2
+
+typedef enum {
+    // Captured HID reports (records described at devmgr_read_capture())
+    BTJP_STREAM_REPORT_CAPTURE = 0,
+} btjp_stream_id_t;
+
+#define BTJP_STREAM_FLAG_END 0x01
+
+typedef struct {
+    uint8_t stream;
+    uint8_t flags;
+} btjp_stream_hdr_t;
+
 // Pin identifiers
 typedef enum {
     BTJP_PIN_UP = 0,
@@ -114,9 +155,50 @@ typedef struct {
 
 // --------------------------------------------------------------------------
 
+// Maximum number of threads in the system statistics
+#define BTJP_SYS_STATS_MAX_THREADS 12
+
+typedef struct {
+    // Thread name (not terminated if it has 8 characters)
+    char name[8];
+    // Stack size and the part that was never used (bytes)
+    uint16_t stack_size;
+    uint16_t stack_unused;
+    // Share of the CPU time since boot (0.1 %)
+    uint16_t cpu;
+} btjp_thread_stats_t;
+
+// Sent as the GET_SYS_STATS response and the SYS_STATS_UPDATE event,
+// variable size (thread_count items of `thread`)
+typedef struct {
+    // Time since boot (ms)
+    uint32_t uptime;
+    // Log buffer size and its peak usage (bytes)
+    uint16_t log_buf_size;
+    uint16_t log_buf_peak;
+    // Highest number of pending events and the number of overflows
+    uint16_t evq_peak;
+    uint16_t evq_overflows;
+    // Network buffers in use
+    uint16_t bt_buf_used;
+    uint16_t bt_buf_total;
+    // Longest work latency of the input, protocol and persist queues (us)
+    uint16_t workq_latency_max[3];
+    uint8_t thread_count;
+    uint8_t _reserved;
+    btjp_thread_stats_t thread[BTJP_SYS_STATS_MAX_THREADS];
+} btjp_sys_stats_t;
+
+// --------------------------------------------------------------------------
+
+// Device configuration flags
+#define BTJP_DEV_FLAG_BOOT_PROTOCOL 0x01
+
 typedef struct {
     btjp_dev_addr_t addr;
     uint8_t profile;
+    // BTJP_DEV_FLAG_xxx
+    uint8_t flags;
 } btjp_req_set_dev_config_t;
 
 // --------------------------------------------------------------------------
@@ -130,10 +212,24 @@ typedef struct {
     uint8_t hat_switch;
     uint8_t threshold;
     uint8_t hysteresis;
+    // Autofire period in frames (0 => off), since API 3.1
+    uint8_t autofire;
+    uint8_t _reserved2[3];
 } btjp_req_set_pin_config_t;
 
+// Size of SET_PIN_CONFIG sent by API 3.0 clients (without the autofire
+// period, the configured one is kept)
+#define BTJP_SET_PIN_CONFIG_V0_SIZE offsetof(btjp_req_set_pin_config_t, autofire)
+
 // --------------------------------------------------------------------------
 
+// Response curve (see mapper_curve_t)
+typedef struct {
+    uint8_t type;
+    uint8_t amount;
+    uint8_t points[4];
+} btjp_curve_t;
+
 typedef struct {
     uint8_t profile;
     uint8_t pin_id;
@@ -141,6 +237,7 @@ typedef struct {
     uint32_t source;
     int16_t low;
     int16_t high;
+    btjp_curve_t curve;
 } btjp_req_set_pot_config_t;
 
 // --------------------------------------------------------------------------
@@ -154,39 +251,18 @@ typedef struct {
     uint8_t dead_zone;
     int16_t gain;
     int16_t max;
+    btjp_curve_t curve;
 } btjp_req_set_intg_config_t;
 
 // --------------------------------------------------------------------------
 
-typedef struct {
-    uint32_t source;
-    uint8_t invert;
-    uint8_t hat_switch;
-    uint8_t threshold;
-    uint8_t hysteresis;
-} btjp_pin_config_t;
-
-typedef struct {
-    uint32_t source;
-    int16_t low;
-    int16_t high;
-} btjp_pot_config_t;
-
-typedef struct {
-    uint32_t source;
-    uint8_t mode;
-    uint8_t dead_zone;
-    int16_t gain;
-    int16_t max;
-    uint8_t _reserved[2];
-} btjp_intg_config_t;
+// Maximum size of an encoded profile (PROFILE_DTO_MAX_SIZE)
+#define BTJP_PROFILE_DATA_MAX_SIZE 208
 
 typedef struct {
     uint8_t profile;
-    uint8_t _reserved[3];
-    btjp_pin_config_t pins[5];
-    btjp_pot_config_t pots[2];
-    btjp_intg_config_t intgs[2];
+    // Encoded profile (see mapper/profile_dto.h), variable size
+    uint8_t data[BTJP_PROFILE_DATA_MAX_SIZE];
 } btjp_req_set_profile_t;
 
 // --------------------------------------------------------------------------
@@ -210,6 +286,17 @@ typedef struct {
 
 // --------------------------------------------------------------------------
 
+// Periodic events sent only to the clients that subscribed to them
+// (e.g. while a view shows them)
+#define BTJP_SUBSCRIBE_LINK_STATS 0x01
+
+typedef struct {
+    // BTJP_SUBSCRIBE_xxx, replaces the previous subscription of the session
+    uint8_t events;
+} btjp_req_subscribe_t;
+
+// --------------------------------------------------------------------------
+
 typedef struct {
     uint8_t scanning;
     uint8_t mode;
@@ -231,16 +318,16 @@ typedef struct {
     btjp_dev_addr_t addr;
     uint8_t conn_state;
     uint8_t profile;
+    // BTJP_DEV_FLAG_xxx
+    uint8_t flags;
 } btjp_evt_dev_list_update_t;
 
 // --------------------------------------------------------------------------
 
 typedef struct {
     uint8_t profile;
-    uint8_t _reserved;
-    btjp_pin_config_t pins[5];
-    btjp_pot_config_t pots[2];
-    btjp_intg_config_t intgs[2];
+    // Encoded profile (see mapper/profile_dto.h), variable size
+    uint8_t data[BTJP_PROFILE_DATA_MAX_SIZE];
 } btjp_evt_profile_update_t;
 
 // --------------------------------------------------------------------------
@@ -252,12 +339,55 @@ typedef struct {
 
 // --------------------------------------------------------------------------
 
+// Value of `profile` if no report was mapped yet
+#define BTJP_ACTIVE_PROFILE_NONE 0xFF
+
+typedef struct {
+    // Profile used for mapping (the device profile or a switched one)
+    uint8_t profile;
+} btjp_evt_active_profile_update_t;
+
+// --------------------------------------------------------------------------
+
+// Buckets of the report interval histogram, upper bounds (ms)
+// of all but the last bucket, which is open
+#define BTJP_REPORT_INTERVAL_BOUNDS  {5, 10, 15, 20, 30, 50, 100}
+#define BTJP_REPORT_INTERVAL_BUCKETS 8
+
+typedef struct {
+    btjp_dev_addr_t addr;
+    // Connection RSSI (dBm, 127 => not connected)
+    int8_t rssi;
+    // Received reports and the estimate of missed notifications
+    uint32_t reports;
+    uint32_t missed;
+    // Report inter-arrival time histogram
+    uint32_t report_intervals[BTJP_REPORT_INTERVAL_BUCKETS];
+    // Connection interval (1.25 ms), peripheral latency (events)
+    // and supervision timeout (10 ms)
+    uint16_t conn_interval;
+    uint16_t conn_latency;
+    uint16_t conn_timeout;
+    // Reports received in the last second
+    uint16_t report_rate;
+    // Transmit and receive PHY (1 => 1M, 2 => 2M, 4 => Coded)
+    uint8_t tx_phy;
+    uint8_t rx_phy;
+    // Number of disconnections and their reasons
+    // (HCI error codes, the most recent first)
+    uint16_t disconnects;
+    uint8_t disconnect_reasons[4];
+} btjp_evt_link_stats_update_t;
+
+// --------------------------------------------------------------------------
+
 typedef struct {
     btjp_msg_header_t hdr;
     union {
         btjp_rsp_error_t error;
         btjp_rsp_get_api_version_t get_api_version;
         btjp_rsp_get_sys_info_t get_sys_info;
+        btjp_sys_stats_t get_sys_stats;
     };
 } btjp_rsp_t;
 
@@ -272,6 +402,7 @@ typedef struct {
         btjp_req_set_mode_t set_mode;
         btjp_req_connect_device_t connect_device;
         btjp_req_delete_device_t delete_device;
+        btjp_req_subscribe_t subscribe;
     };
 } btjp_req_t;
 
@@ -283,6 +414,9 @@ typedef struct {
         btjp_evt_dev_list_update_t dev_list_update;
         btjp_evt_profile_update_t profile_update;
         btjp_evt_io_port_update_t io_port_update;
+        btjp_evt_active_profile_update_t active_profile_update;
+        btjp_sys_stats_t sys_stats_update;
+        btjp_evt_link_stats_update_t link_stats_update;
     };
 
 } btjp_evt_t;
@@ -21,6 +21,13 @@
 #include "btjp_utils.h"
 
 #include <io/io_pin.h>
+#include <sysmon/sysmon.h>
+
+BUILD_ASSERT(SYSMON_MAX_THREADS <= BTJP_SYS_STATS_MAX_THREADS, "Thread statistics don't fit");
+BUILD_ASSERT(SYSMON_THREAD_NAME_LEN == sizeof(((btjp_thread_stats_t *)0)->name),
+             "Thread name length mismatch");
+BUILD_ASSERT(WORKQ_COUNT == ARRAY_SIZE(((btjp_sys_stats_t *)0)->workq_latency_max),
+             "Work queue count mismatch");
 
 void dev_addr_to_bt_addr_le(const btjp_dev_addr_t *src, bt_addr_le_t *dst)
 {
@@ -69,3 +76,38 @@ mapper_intg_config_t *profile_intg(mapper_profile_t *profile, uint8_t intg_id)
 
     return NULL;
 }
+
+static uint16_t saturate_u16(uint32_t value)
+{
+    return value > UINT16_MAX ? UINT16_MAX : (uint16_t)value;
+}
+
+size_t sys_stats_to_msg(btjp_sys_stats_t *dst)
+{
+    sysmon_stats_t stats;
+    sysmon_get_stats(&stats);
+
+    dst->uptime = stats.uptime;
+    dst->log_buf_size = saturate_u16(stats.log_buf_size);
+    dst->log_buf_peak = saturate_u16(stats.log_buf_peak);
+    dst->evq_peak = saturate_u16(stats.evq_peak);
+    dst->evq_overflows = saturate_u16(stats.evq_overflows);
+    dst->bt_buf_used = saturate_u16(stats.bt_buf_used);
+    dst->bt_buf_total = saturate_u16(stats.bt_buf_total);
+
+    for (int i = 0; i < ARRAY_SIZE(dst->workq_latency_max); i++) {
+        dst->workq_latency_max[i] = saturate_u16(stats.workq_latency_max[i]);
+    }
+
+    dst->thread_count = stats.thread_count;
+
+    for (size_t i = 0; i < stats.thread_count; i++) {
+        btjp_thread_stats_t *ts = &dst->thread[i];
+        memcpy(ts->name, stats.thread[i].name, sizeof(ts->name));
+        ts->stack_size = saturate_u16(stats.thread[i].stack_size);
+        ts->stack_unused = saturate_u16(stats.thread[i].stack_unused);
+        ts->cpu = stats.thread[i].cpu;
+    }
+
+    return offsetof(btjp_sys_stats_t, thread) + stats.thread_count * sizeof(btjp_thread_stats_t);
+}
@@ -33,3 +33,6 @@ mapper_pin_config_t *profile_pin(mapper_profile_t *profile, uint8_t pin_id);
 mapper_pot_config_t *profile_pot(mapper_profile_t *profile, uint8_t pin_id);
 
 mapper_intg_config_t *profile_intg(mapper_profile_t *profile, uint8_t intg_id);
+
+// Fills in the current system statistics, returns the size of the used part
+size_t sys_stats_to_msg(btjp_sys_stats_t *dst);
@@ -25,6 +25,7 @@
 #include <zephyr/bluetooth/conn.h>
 #include <zephyr/bluetooth/uuid.h>
 #include <zephyr/bluetooth/gatt.h>
+#include <zephyr/bluetooth/l2cap.h>
 
 #include <zephyr/sys/byteorder.h>
 
@@ -32,6 +33,8 @@
 #include <event/event_queue.h>
 #include <btjp/btjp_msg.h>
 #include <btjp/btjp.h>
+#include <devmgr/devmgr.h>
+#include <workq/workq.h>
 
 #include "btsvc.h"
 
@@ -44,8 +47,8 @@ LOG_MODULE_DECLARE(blue2joy, CONFIG_LOG_DEFAULT_LEVEL);
 typedef struct {
     struct bt_conn *conn;
 
-    struct k_work request_work;
-    struct k_work_delayable event_work;
+    workq_work_t request_work;
+    workq_work_t event_work;
 
     size_t rx_size;
     uint8_t rx_buf[256];
@@ -53,6 +56,22 @@ typedef struct {
     atomic_t txq_ready;
     event_queue_t evq;
 
+#ifdef CONFIG_BT_L2CAP_DYNAMIC_CHANNEL
+    // Bulk data stream channel
+    struct {
+        struct bt_l2cap_le_chan chan;
+        workq_work_t work;
+        // Channel is connected
+        bool open;
+        // Stream being sent (-1 => none)
+        int id;
+        // Report capture is recorded for the channel
+        bool capturing;
+        // Read position in the report capture
+        uint32_t capture_cursor;
+    } stream;
+#endif
+
 } btjp_session_t;
 
 typedef struct {
@@ -61,7 +80,7 @@ typedef struct {
     // Indicates if advertising is currently enabled
     atomic_t is_advertising;
     // Work item to stop advertising after timeout
-    struct k_work_delayable adv_timeout_work;
+    workq_work_t adv_timeout_work;
 } btsvc_t;
 
 static btsvc_t g_btsvc;
@@ -84,7 +103,7 @@ static ssize_t btjp_rxq_write(struct bt_conn *conn, const struct bt_gatt_attr *a
 {
     btjp_session_t *session = &g_btsvc.session[bt_conn_index(conn)];
 
-    if (k_work_busy_get(&session->request_work)) {
+    if (workq_is_busy(&session->request_work)) {
         // previous request is still being processed
         LOG_ERR("Previous request is still being processed");
         return BT_GATT_ERR(BT_ATT_ERR_PREPARE_QUEUE_FULL);
@@ -107,7 +126,7 @@ static ssize_t btjp_rxq_write(struct bt_conn *conn, const struct bt_gatt_attr *a
         btjp_msg_header_t *hdr = (btjp_msg_header_t *)session->rx_buf;
         if (session->rx_size == sizeof(btjp_msg_header_t) + hdr->size) {
             // complete message received
-            k_work_submit(&session->request_work);
+            workq_submit(&session->request_work);
         }
     }
 
@@ -136,26 +155,29 @@ BT_GATT_SERVICE_DEFINE(btjp_svc,
 
 const struct bt_gatt_attr *btjp_svc_txq_attr;
 
-// Flag to suppress event notifications about config changes caused
-// by request processed in btsvc connection context
-static __thread bool handling_own_request = false;
+// Session whose request is processed by the current thread. Configuration
+// events caused by the request are not sent back to it, the client
+// already made the change itself (unless it asked for BTJP_MSG_FLAG_ECHO).
+static __thread btjp_session_t *request_origin = NULL;
 
 // Processes a received request and sends a response
-static void request_work_handler(struct k_work *work)
+static void request_work_handler(workq_work_t *work)
 {
     btjp_session_t *session = CONTAINER_OF(work, btjp_session_t, request_work);
 
     uint8_t tx_buf[CONFIG_BT_L2CAP_TX_MTU];
 
     if (!atomic_set(&session->txq_ready, true)) {
-        k_work_reschedule(&session->event_work, K_MSEC(0));
+        workq_reschedule(&session->event_work, K_NO_WAIT);
     }
 
-    handling_own_request = true;
+    btjp_msg_header_t *hdr = (btjp_msg_header_t *)session->rx_buf;
+    request_origin = (hdr->flags & BTJP_MSG_FLAG_ECHO) ? NULL : session;
 
-    size_t tx_size = btjp_handle_message(session->rx_buf, session->rx_size, tx_buf, sizeof(tx_buf));
+    size_t tx_size = btjp_handle_message(session->rx_buf, session->rx_size, tx_buf, sizeof(tx_buf),
+                                         &session->evq);
 
-    handling_own_request = false;
+    request_origin = NULL;
 
     if (tx_size == 0) {
         // Nothing to send
@@ -176,7 +198,7 @@ static void notify_sent_cb(struct bt_conn *conn, void *user_data)
 
     if (!event_queue_is_empty(&session->evq)) {
         // Schecdule sending next event
-        k_work_reschedule(&session->event_work, K_MSEC(0));
+        workq_reschedule(&session->event_work, K_NO_WAIT);
     }
 }
 
@@ -197,10 +219,8 @@ static int send_notify(btjp_session_t *session, const void *data, size_t len)
 }
 
 // Work handler for sending event notifications
-static void event_work_handler(struct k_work *work_)
+static void event_work_handler(workq_work_t *work)
 {
-    struct k_work_delayable *work = (struct k_work_delayable *)work_;
-
     btjp_session_t *session = CONTAINER_OF(work, btjp_session_t, event_work);
 
     uint8_t tx_buf[CONFIG_BT_L2CAP_TX_MTU];
@@ -226,17 +246,174 @@ static void event_callback(void *context, const event_t *ev)
 {
     btjp_session_t *session = (btjp_session_t *)context;
 
-    /* if (handling_own_request || config_changed) {
-        continue;
-    }*/
+    if (session == request_origin &&
+        (ev->subject == EV_SUBJECT_PROFILE || ev->subject == EV_SUBJECT_DEV_LIST)) {
+        // Echo of the session's own configuration change
+        return;
+    }
 
     event_queue_push(&session->evq, ev);
 
     if (atomic_get(&session->txq_ready)) {
-        k_work_reschedule(&session->event_work, K_MSEC(20));
+        workq_reschedule(&session->event_work, K_MSEC(20));
+    }
+}
+
+// ------------------------------------------------------------------
+// Bulk data streams (L2CAP CoC)
+// ------------------------------------------------------------------
+
+#ifdef CONFIG_BT_L2CAP_DYNAMIC_CHANNEL
+
+// Largest SDU sent (limited by the MTU of the client as well)
+#define BTSVC_STREAM_SDU_SIZE 1024
+// MTU of the incoming direction (only stream requests)
+#define BTSVC_STREAM_RX_MTU 64
+
+// Two buffers per connection, one is being sent while the next is filled
+NET_BUF_POOL_FIXED_DEFINE(stream_pool, 2 * CONFIG_BT_MAX_CONN,
+                          BT_L2CAP_SDU_BUF_SIZE(BTSVC_STREAM_SDU_SIZE),
+                          CONFIG_BT_CONN_TX_USER_DATA_SIZE, NULL);
+
+// Sends the stream data while there are free buffers
+// (credit-based flow control is done by the stack, the work is
+// resubmitted when an SDU has been sent)
+static void stream_work_handler(workq_work_t *work)
+{
+    btjp_session_t *session = CONTAINER_OF(work, btjp_session_t, stream.work);
+    struct bt_l2cap_le_chan *chan = &session->stream.chan;
+
+    while (session->stream.id >= 0) {
+        struct net_buf *buf = net_buf_alloc(&stream_pool, K_NO_WAIT);
+        if (buf == NULL) {
+            // All buffers are in flight
+            return;
+        }
+
+        net_buf_reserve(buf, BT_L2CAP_SDU_CHAN_SEND_RESERVE);
+
+        btjp_stream_hdr_t *hdr = net_buf_add(buf, sizeof(btjp_stream_hdr_t));
+        hdr->stream = session->stream.id;
+        hdr->flags = 0;
+
+        size_t size = MIN(net_buf_tailroom(buf), chan->tx.mtu) - sizeof(btjp_stream_hdr_t);
+        size_t len = 0;
+
+        switch (session->stream.id) {
+        case BTJP_STREAM_REPORT_CAPTURE:
+            len = devmgr_read_capture(&session->stream.capture_cursor, net_buf_tail(buf), size);
+            break;
+        }
+
+        net_buf_add(buf, len);
+
+        if (len == 0) {
+            // All data sent
+            hdr->flags |= BTJP_STREAM_FLAG_END;
+            session->stream.id = -1;
+        }
+
+        int err = bt_l2cap_chan_send(&chan->chan, buf);
+        if (err < 0) {
+            LOG_ERR("Failed to send stream data {err: %d}", err);
+            net_buf_unref(buf);
+            session->stream.id = -1;
+        }
+    }
+}
+
+static void stream_connected(struct bt_l2cap_chan *chan)
+{
+    btjp_session_t *session = CONTAINER_OF(chan, btjp_session_t, stream.chan.chan);
+
+    // Reports are recorded only while a stream channel is connected
+    devmgr_open_capture(&session->stream.capture_cursor);
+    session->stream.capturing = true;
+
+    LOG_INF("Stream channel connected {tx_mtu: %d}", session->stream.chan.tx.mtu);
+}
+
+static void stream_disconnected(struct bt_l2cap_chan *chan)
+{
+    btjp_session_t *session = CONTAINER_OF(chan, btjp_session_t, stream.chan.chan);
+
+    session->stream.id = -1;
+    session->stream.open = false;
+    workq_cancel(&session->stream.work);
+
+    if (session->stream.capturing) {
+        session->stream.capturing = false;
+        devmgr_close_capture();
+    }
+
+    LOG_INF("Stream channel disconnected");
+}
+
+static int stream_recv(struct bt_l2cap_chan *chan, struct net_buf *buf)
+{
+    btjp_session_t *session = CONTAINER_OF(chan, btjp_session_t, stream.chan.chan);
+
+    if (buf->len != 1 || buf->data[0] != BTJP_STREAM_REPORT_CAPTURE) {
+        LOG_ERR("Invalid stream request");
+        return 0;
+    }
+
+    session->stream.id = buf->data[0];
+    workq_submit(&session->stream.work);
+
+    return 0;
+}
+
+static void stream_sent(struct bt_l2cap_chan *chan)
+{
+    btjp_session_t *session = CONTAINER_OF(chan, btjp_session_t, stream.chan.chan);
+
+    workq_submit(&session->stream.work);
+}
+
+static const struct bt_l2cap_chan_ops stream_ops = {
+    .connected = stream_connected,
+    .disconnected = stream_disconnected,
+    .recv = stream_recv,
+    .sent = stream_sent,
+};
+
+static int stream_accept(struct bt_conn *conn, struct bt_l2cap_server *server,
+                         struct bt_l2cap_chan **chan)
+{
+    btjp_session_t *session = &g_btsvc.session[bt_conn_index(conn)];
+
+    if (session->conn != conn) {
+        // Only for the configuration clients
+        return -EACCES;
     }
+
+    if (session->stream.open) {
+        return -ENOMEM;
+    }
+
+    memset(&session->stream, 0, sizeof(session->stream));
+    session->stream.chan.chan.ops = &stream_ops;
+    session->stream.chan.rx.mtu = BTSVC_STREAM_RX_MTU;
+    session->stream.open = true;
+    session->stream.id = -1;
+    workq_init_work(&session->stream.work, WORKQ_PROTOCOL, stream_work_handler);
+
+    *chan = &session->stream.chan.chan;
+
+    return 0;
 }
 
+// The report capture may contain keystrokes, the channel is opened only
+// on an encrypted link (the stack asks the client to pair first)
+static struct bt_l2cap_server stream_server = {
+    .psm = BTJP_STREAM_PSM,
+    .sec_level = BT_SECURITY_L2,
+    .accept = stream_accept,
+};
+
+#endif // CONFIG_BT_L2CAP_DYNAMIC_CHANNEL
+
 // ------------------------------------------------------------------
 // Connection management
 // ------------------------------------------------------------------
@@ -295,8 +472,8 @@ static void connected(struct bt_conn *conn, uint8_t err)
     memset(session, 0, sizeof(btjp_session_t));
     session->conn = bt_conn_ref(conn);
 
-    k_work_init(&session->request_work, request_work_handler);
-    k_work_init_delayable(&session->event_work, event_work_handler);
+    workq_init_work(&session->request_work, WORKQ_PROTOCOL, request_work_handler);
+    workq_init_work(&session->event_work, WORKQ_PROTOCOL, event_work_handler);
 
     if (event_queue_init(&session->evq) != 0) {
         LOG_ERR("Failed to create event queue");
@@ -351,8 +528,8 @@ static void disconnected(struct bt_conn *conn, uint8_t reason)
 
     event_bus_unsubscribe(event_callback, session);
 
-    k_work_cancel(&session->request_work);         // !@# sync???
-    k_work_cancel_delayable(&session->event_work); // !@# sync???
+    workq_cancel(&session->request_work);
+    workq_cancel(&session->event_work);
 
     bt_conn_unref(session->conn);
     memset(session, 0, sizeof(btjp_session_t));
@@ -413,7 +590,7 @@ int btsvc_start_advertising(void)
             btsvc_publish_change_event();
 
             // Start timer to stop advertising after timeout
-            k_work_reschedule(&svc->adv_timeout_work, K_SECONDS(15));
+            workq_reschedule(&svc->adv_timeout_work, K_SECONDS(15));
         }
     }
 
@@ -444,7 +621,7 @@ bool btsvc_is_advertising(void)
     return atomic_get(&svc->is_advertising);
 }
 
-static void adv_timeout_handler(struct k_work *work)
+static void adv_timeout_handler(workq_work_t *work)
 {
     LOG_INF("Advertising timeout, stopping advertising");
     btsvc_stop_advertising();
@@ -487,7 +664,15 @@ int btsvc_init(void)
         return err;
     }
 
-    k_work_init_delayable(&svc->adv_timeout_work, adv_timeout_handler);
+    workq_init_work(&svc->adv_timeout_work, WORKQ_PROTOCOL, adv_timeout_handler);
+
+#ifdef CONFIG_BT_L2CAP_DYNAMIC_CHANNEL
+    err = bt_l2cap_server_register(&stream_server);
+    if (err) {
+        LOG_ERR("Failed to register stream channel server {err: %d}", err);
+        return err;
+    }
+#endif
 
     return 0;
 }
@@ -22,6 +22,7 @@
 #include <mapper/mapper.h>
 #include <bthid/bthid.h>
 #include <event/event_bus.h>
+#include <persist/persist.h>
 
 #include "devmgr_internal.h"
 #include "settings.h"
@@ -45,7 +46,14 @@ int devmgr_init(void)
         return err;
     }
 
-    k_work_init_delayable(&devmgr->save_work, devmgr_save_settings);
+    devmgr_adv_list_init();
+    devmgr_capture_init();
+    devmgr_link_stats_init();
+
+    err = devmgr_settings_init();
+    if (err) {
+        return err;
+    }
 
     err = bthid_init(&bthid_callbacks);
     if (err) {
@@ -81,6 +89,9 @@ void devmgr_set_mode(devmgr_mode_t mode, bool restart)
     if (restart) {
         bthid_disconnect(BTHID_DEFAULT_SLOT);
 
+        // The scan type depends on the mode
+        devmgr_stop_scanning();
+
         if (mode != DEVMGR_MODE_MANUAL) {
             int err = devmgr_start_scanning();
             (void)err;
@@ -98,22 +109,52 @@ void devmgr_get_state(devmgr_state_t *state)
     k_mutex_unlock(&devmgr->mutex);
 }
 
+// Stops the passive scan or waiting for the accept list
+static void stop_scan(bool accept_list)
+{
+    if (accept_list) {
+        bthid_auto_connect_stop();
+    } else {
+        bthid_scan_stop();
+    }
+}
+
 int devmgr_start_scanning(void)
 {
     devmgr_t *devmgr = &g_devmgr;
 
+    bt_addr_le_t addrs[DEVMGR_MAX_CONFIG_ENTRIES];
+    size_t count = 0;
+
     k_mutex_lock(&devmgr->mutex, K_FOREVER);
     bool scanning = devmgr->sync.scanning;
     devmgr_clear_adv_list();
+    if (devmgr->sync.mode == DEVMGR_MODE_AUTO) {
+        for (size_t i = 0; i < devmgr->sync.dev.count; i++) {
+            bt_addr_le_copy(&addrs[count++], &devmgr->sync.dev.entry[i].addr);
+        }
+    }
     k_mutex_unlock(&devmgr->mutex);
 
     int err = 0;
 
     if (!scanning) {
-        err = bthid_scan_start();
+        // Known devices are connected by the controller on their first
+        // advertisement, without the host evaluating each one
+        bool accept_list = count > 0;
+
+        if (accept_list) {
+            err = bthid_auto_connect(BTHID_DEFAULT_SLOT, addrs, count);
+        } else {
+            err = bthid_scan_start();
+        }
 
         k_mutex_lock(&devmgr->mutex, K_FOREVER);
         devmgr->sync.scanning = (err == 0);
+        devmgr->sync.accept_list = accept_list && !err;
+        if (!err) {
+            devmgr_stats_scan_started();
+        }
         devmgr_notify(EV_SUBJECT_SYS_STATE, NULL, EV_ACTION_UPDATE);
         k_mutex_unlock(&devmgr->mutex);
     }
@@ -127,13 +168,15 @@ void devmgr_stop_scanning(void)
 
     k_mutex_lock(&devmgr->mutex, K_FOREVER);
     bool scanning = devmgr->sync.scanning;
+    bool accept_list = devmgr->sync.accept_list;
     k_mutex_unlock(&devmgr->mutex);
 
     if (scanning) {
-        bthid_scan_stop();
+        stop_scan(accept_list);
 
         k_mutex_lock(&devmgr->mutex, K_FOREVER);
         devmgr->sync.scanning = false;
+        devmgr->sync.accept_list = false;
         devmgr_notify(EV_SUBJECT_SYS_STATE, NULL, EV_ACTION_UPDATE);
         k_mutex_unlock(&devmgr->mutex);
     }
@@ -145,13 +188,15 @@ int devmgr_connect(const bt_addr_le_t *addr)
 
     k_mutex_lock(&devmgr->mutex, K_FOREVER);
     bool scanning = devmgr->sync.scanning;
+    bool accept_list = devmgr->sync.accept_list;
     k_mutex_unlock(&devmgr->mutex);
 
     if (scanning) {
-        bthid_scan_stop();
+        stop_scan(accept_list);
 
         k_mutex_lock(&devmgr->mutex, K_FOREVER);
         devmgr->sync.scanning = false;
+        devmgr->sync.accept_list = false;
         devmgr_notify(EV_SUBJECT_SYS_STATE, NULL, EV_ACTION_UPDATE);
         k_mutex_unlock(&devmgr->mutex);
     }
@@ -162,6 +207,7 @@ int devmgr_connect(const bt_addr_le_t *addr)
         k_mutex_lock(&devmgr->mutex, K_FOREVER);
         devmgr_entry_t *entry = devmgr_ensure_entry(addr, true);
         entry->state.conn_state = DEVMGR_CONN_CONNECTING;
+        devmgr_stats_conn_started();
         devmgr_notify(EV_SUBJECT_DEV_LIST, &entry->addr, EV_ACTION_UPDATE);
         k_mutex_unlock(&devmgr->mutex);
     } else {
@@ -192,6 +238,8 @@ static void devmgr_update_device_state(bthid_device_t *dev, devmgr_conn_state_t
         devmgr_notify(EV_SUBJECT_DEV_LIST, &addr, EV_ACTION_UPDATE);
     }
 
+    devmgr_stats_conn_state(&addr, state);
+
     if (state == DEVMGR_CONN_ERROR) {
         devmgr_notify(EV_SUBJECT_CONN_ERROR, &addr, EV_ACTION_UPDATE);
     }
@@ -238,10 +286,42 @@ static void on_device_found(const bt_addr_le_t *addr, int8_t rssi, const char *n
     }
 }
 
+// A known device connected by the controller from the accept list
+static void on_auto_connected(bthid_device_t *dev)
+{
+    devmgr_t *devmgr = &g_devmgr;
+
+    k_mutex_lock(&devmgr->mutex, K_FOREVER);
+    devmgr->sync.scanning = false;
+    devmgr->sync.accept_list = false;
+    devmgr_notify(EV_SUBJECT_SYS_STATE, NULL, EV_ACTION_UPDATE);
+    if (dev != NULL) {
+        devmgr_stats_conn_started();
+    }
+    k_mutex_unlock(&devmgr->mutex);
+
+    if (dev != NULL) {
+        devmgr_update_device_state(dev, DEVMGR_CONN_CONNECTING);
+    } else {
+        restart();
+    }
+}
+
 // Connection with the gamepad opened
 static void on_conn_opened(bthid_device_t *dev)
 {
-    int err = bthid_device_discover(dev);
+    bt_addr_le_t addr;
+    bthid_device_get_addr(dev, &addr);
+
+    devmgr_device_config_t config = {0};
+    devmgr_get_device_config(&addr, &config);
+
+    bthid_protocol_t protocol = config.boot_protocol ? BTHID_PROTOCOL_BOOT : BTHID_PROTOCOL_REPORT;
+
+    // Loaded during the discovery, before the first report
+    mapper_prefetch_profile(config.profile);
+
+    int err = bthid_device_discover(dev, protocol);
 
     if (!err) {
         devmgr_update_device_state(dev, DEVMGR_CONN_CONNECTED);
@@ -304,6 +384,21 @@ static void on_conn_error(bthid_device_t *dev)
 // HID service discovery succeeded
 static void on_discovery_completed(bthid_device_t *dev)
 {
+    devmgr_t *devmgr = &g_devmgr;
+
+    bt_addr_le_t addr;
+    bthid_device_get_addr(dev, &addr);
+
+    size_t mem_usage = bthid_device_get_mem_usage(dev);
+    LOG_INF("Device discovered {memory: %zu bytes}", mem_usage);
+
+    k_mutex_lock(&devmgr->mutex, K_FOREVER);
+    devmgr_entry_t *entry = devmgr_find_entry(&addr);
+    if (entry != NULL) {
+        entry->state.mem_usage = mem_usage;
+    }
+    k_mutex_unlock(&devmgr->mutex);
+
     try_subscribe(dev);
 }
 
@@ -318,6 +413,7 @@ static void on_discovery_error(bthid_device_t *dev)
 // HID report subscription succeeded
 static void on_report_subscribe_completed(bthid_device_t *dev)
 {
+    mapper_invalidate_report(bthid_device_get_slot(dev));
     devmgr_update_device_state(dev, DEVMGR_CONN_READY);
 }
 
@@ -329,17 +425,28 @@ static void on_report_subscribe_error(bthid_device_t *dev)
     restart();
 }
 
+// Connection parameters or PHY update
+static void on_link_updating(bthid_device_t *dev)
+{
+    // Flash erase stalls the radio, connection events are missed
+    // and the update instant may be missed as well
+    persist_link_activity();
+}
+
 // HID report received
-static void on_report_received(bthid_device_t *dev, const uint8_t *data, size_t length)
+static void on_report_received(bthid_device_t *dev, uint8_t report_id, const uint8_t *data,
+                               size_t length)
 {
+    const hrm_t *hrm = bthid_device_get_report_map(dev);
+    int slot = bthid_device_get_slot(dev);
+
     if (data != NULL) {
         LOG_HEXDUMP_INF(data, length, "HID report");
+        devmgr_capture_report(slot, report_id, data, length);
     } else {
         LOG_ERR("HID report data is NULL");
     }
 
-    const hrm_t *hrm = bthid_device_get_report_map(dev);
-
     bt_addr_le_t addr;
     bthid_device_get_addr(dev, &addr);
 
@@ -353,19 +460,16 @@ static void on_report_received(bthid_device_t *dev, const uint8_t *data, size_t
         if (hrm->report_count == 0) {
             // Report map is invalid
             LOG_ERR("Report map is empty, no reports to process");
-        } else if (/*hrm->report_count == 1*/ true) {
-            // Report map contains only one report
-            mapper_process_report(config.profile, data, &hrm->reports[0]);
         } else {
-            // The first byte of the report is the report ID, if
-            // the report map contains multiple reports.
-            uint8_t report_id = *data++;
-
-            // Find the report in the report map
+            // Notifications don't carry the report ID, it is given by
+            // the report characteristic
             const hrm_report_t *report = hrm_find_report(hrm, report_id);
 
             if (report != NULL) {
-                mapper_process_report(config.profile, data, report);
+                // Only the mapping is measured, not the logging and capture
+                uint32_t start = k_cycle_get_32();
+                mapper_process_report(slot, config.profile, data, length, report);
+                devmgr_stats_report(k_cycle_get_32() - start);
             } else {
                 LOG_WRN("Report with ID %d not found in report map", report_id);
             }
@@ -375,6 +479,7 @@ static void on_report_received(bthid_device_t *dev, const uint8_t *data, size_t
 
 static const bthid_callbacks_t bthid_callbacks = {
     .device_found = on_device_found,
+    .auto_connected = on_auto_connected,
     .conn_opened = on_conn_opened,
     .conn_secured = on_conn_secured,
     .conn_closed = on_conn_closed,
@@ -384,4 +489,5 @@ static const bthid_callbacks_t bthid_callbacks = {
     .report_subscribe_completed = on_report_subscribe_completed,
     .report_subscribe_error = on_report_subscribe_error,
     .report_received = on_report_received,
+    .link_updating = on_link_updating,
 };
@@ -23,8 +23,20 @@
 
 #include <zephyr/bluetooth/addr.h>
 
+#include <bthid/bthid.h>
+
 #define DEVMGR_MAX_CONFIG_ENTRIES  4
-#define DEVMGR_MAX_ADVLIST_ENTRIES 4
+#define DEVMGR_MAX_ADVLIST_ENTRIES 16
+
+// Size of the HID report capture buffer (bytes)
+#define DEVMGR_CAPTURE_SIZE 4096
+
+// Interval of publishing changes of the scan results (ms)
+// (new devices and large RSSI changes are published immediately)
+#define DEVMGR_ADV_REPORT_INTERVAL 1000
+
+// Interval of publishing link statistics of the connected devices (ms)
+#define DEVMGR_LINK_STATS_INTERVAL 1000
 
 typedef enum {
     // Automatically starts scanning and connects to
@@ -57,19 +69,53 @@ typedef struct {
     devmgr_conn_state_t conn_state;
     int8_t rssi;
     char name[30];
+    // RAM used by the connected device incl. its report map (bytes)
+    uint16_t mem_usage;
 } devmgr_device_state_t;
 
 typedef struct {
     // io mapper profile
     uint8_t profile;
+    // Use HID boot protocol (mice and keyboards only)
+    bool boot_protocol;
 } devmgr_device_config_t;
 
 typedef struct {
     bt_addr_le_t addr;
+    // Smoothed RSSI
     int8_t rssi;
     char name[30 + 1];
 } devmgr_adv_entry_t;
 
+// Running statistics of one measured interval
+typedef struct {
+    // Number of samples
+    uint32_t count;
+    // Last, smallest and largest sample
+    uint32_t last;
+    uint32_t min;
+    uint32_t max;
+    // Sum of all samples (for average)
+    uint64_t sum;
+} devmgr_timing_t;
+
+typedef struct {
+    // Power on -> first device ready (ms, 0 => no device ready yet)
+    uint32_t boot_to_ready;
+    // Scan start -> device ready (ms)
+    devmgr_timing_t scan_to_ready;
+    // Connection request -> device ready (ms)
+    devmgr_timing_t connect_to_ready;
+    // Disconnection -> same device ready again (ms)
+    devmgr_timing_t reconnect;
+    // Mapping time of a HID report (us)
+    devmgr_timing_t report_latency;
+    // Number of mapped HID reports
+    uint32_t reports;
+    // Highest number of reports received within one second
+    uint32_t peak_report_rate;
+} devmgr_stats_t;
+
 // Initializes the device manager
 int devmgr_init(void);
 
@@ -83,6 +129,38 @@ bool devmgr_is_connecting(void);
 // Returns true if any device is ready
 bool devmgr_is_ready(void);
 
+// Retrieves connection and report latency statistics
+void devmgr_get_stats(devmgr_stats_t *stats);
+
+// Clears all statistics
+void devmgr_reset_stats(void);
+
+// Retrieves link statistics of a device
+// Returns -ENOENT if the device was not connected recently
+int devmgr_get_link_stats(const bt_addr_le_t *addr, bthid_link_stats_t *stats);
+
+// Starts recording the received HID reports for a new reader
+// `cursor` is set to the position of the next record
+void devmgr_open_capture(uint32_t *cursor);
+
+// Stops recording when the last reader is closed
+void devmgr_close_capture(void);
+
+// Reads the captured HID reports following `cursor` and advances it
+// (every reader has its own cursor, records are not removed)
+//
+// The capture keeps the last DEVMGR_CAPTURE_SIZE bytes of records:
+// - timestamp (uint32_t LE, us, wraps around)
+// - device slot (uint8_t)
+// - report ID (uint8_t)
+// - report length (uint8_t)
+// - report data
+//
+// Records dropped before they were read are skipped
+// Only whole records are written to buf
+// Returns the number of bytes written
+size_t devmgr_read_capture(uint32_t *cursor, uint8_t *buf, size_t size);
+
 // Start scanning for devices
 int devmgr_start_scanning(void);
 
@@ -91,7 +169,7 @@ void devmgr_stop_scanning(void);
 
 // Retrieves list of all advertising devices
 // Returns the number of devices written to addrs array (up to DEVMGR_MAX_ADVLIST_ENTRIES)
-int devmgr_get_advertising_devices(devmgr_adv_entry_t *list);
+int devmgr_get_advertising_devices(bt_addr_le_t *addrs);
 
 // Retrieves advertising device state
 int devmgr_get_adv_device(const bt_addr_le_t *addr, devmgr_adv_entry_t *entry);
@@ -18,15 +18,91 @@
 
 #include "devmgr_internal.h"
 
+// Devices not advertising for this time are removed from the list (ms)
+#define ADV_MAX_AGE 5000
+
+// RSSI change (dB) published immediately, smaller changes wait
+// for the next DEVMGR_ADV_REPORT_INTERVAL
+#define ADV_RSSI_STEP 10
+
+// Weight of a new RSSI sample in the smoothed value (1/2^n)
+#define ADV_RSSI_SHIFT 2
+
+static int8_t slot_rssi(const devmgr_adv_slot_t *slot)
+{
+    return (int8_t)(slot->rssi_avg / 16);
+}
+
+static void slot_set_name(devmgr_adv_slot_t *slot, const char *name)
+{
+    // Most advertisements don't carry the name, keep the last one
+    if (name == NULL || name[0] == '\0' || strcmp(slot->info.name, name) == 0) {
+        return;
+    }
+
+    strncpy(slot->info.name, name, sizeof(slot->info.name) - 1);
+    slot->info.name[sizeof(slot->info.name) - 1] = '\0';
+    slot->pending = true;
+}
+
+// Publishes the slot change
+static void slot_publish(devmgr_adv_slot_t *slot, event_action_t action)
+{
+    slot->info.rssi = slot_rssi(slot);
+    slot->published_rssi = slot->info.rssi;
+    slot->pending = false;
+    devmgr_notify(EV_SUBJECT_ADV_LIST, &slot->info.addr, action);
+}
+
+// Removes the slot from the list and publishes the deletion
+static void slot_remove(size_t idx)
+{
+    devmgr_t *devmgr = &g_devmgr;
+
+    bt_addr_le_t addr = devmgr->sync.adv.entry[idx].info.addr;
+    devmgr->sync.adv.entry[idx] = devmgr->sync.adv.entry[--devmgr->sync.adv.count];
+    devmgr_notify(EV_SUBJECT_ADV_LIST, &addr, EV_ACTION_DELETE);
+}
+
+static void adv_work_handler(workq_work_t *work)
+{
+    devmgr_t *devmgr = &g_devmgr;
+
+    k_mutex_lock(&devmgr->mutex, K_FOREVER);
+
+    uint32_t now = k_uptime_get_32();
+
+    for (int i = devmgr->sync.adv.count - 1; i >= 0; i--) {
+        devmgr_adv_slot_t *slot = &devmgr->sync.adv.entry[i];
+        if (now - slot->last_seen > ADV_MAX_AGE) {
+            slot_remove(i);
+        } else if (slot->pending) {
+            slot_publish(slot, EV_ACTION_UPDATE);
+        }
+    }
+
+    if (devmgr->sync.adv.count > 0) {
+        workq_schedule(&devmgr->adv_work, K_MSEC(DEVMGR_ADV_REPORT_INTERVAL));
+    }
+
+    k_mutex_unlock(&devmgr->mutex);
+}
+
+void devmgr_adv_list_init(void)
+{
+    devmgr_t *devmgr = &g_devmgr;
+
+    workq_init_work(&devmgr->adv_work, WORKQ_PROTOCOL, adv_work_handler);
+}
+
 void devmgr_clear_adv_list(void)
 {
     devmgr_t *devmgr = &g_devmgr;
 
     k_mutex_lock(&devmgr->mutex, K_FOREVER);
+    workq_cancel(&devmgr->adv_work);
     for (int i = devmgr->sync.adv.count - 1; i >= 0; i--) {
-        devmgr_adv_entry_t *entry = &devmgr->sync.adv.entry[i];
-        --devmgr->sync.adv.count;
-        devmgr_notify(EV_SUBJECT_ADV_LIST, &entry->addr, EV_ACTION_DELETE);
+        slot_remove(i);
     }
     k_mutex_unlock(&devmgr->mutex);
 }
@@ -37,60 +113,82 @@ void devmgr_add_to_adv_list(const bt_addr_le_t *addr, int8_t rssi, const char *n
 
     k_mutex_lock(&devmgr->mutex, K_FOREVER);
 
+    uint32_t now = k_uptime_get_32();
+
     // Check if already in the scan list
     for (size_t i = 0; i < devmgr->sync.adv.count; i++) {
-        devmgr_adv_entry_t *entry = &devmgr->sync.adv.entry[i];
-        if (bt_addr_le_eq(&entry->addr, addr)) {
-            // Update RSSI and name
-            entry->rssi = rssi;
-            if (name != NULL) {
-                strncpy(entry->name, name, sizeof(entry->name) - 1);
-                entry->name[sizeof(entry->name) - 1] = '\0';
+        devmgr_adv_slot_t *slot = &devmgr->sync.adv.entry[i];
+        if (bt_addr_le_eq(&slot->info.addr, addr)) {
+            slot->last_seen = now;
+            slot->rssi_avg += (rssi * 16 - slot->rssi_avg) >> ADV_RSSI_SHIFT;
+            slot_set_name(slot, name);
+
+            int8_t delta = slot_rssi(slot) - slot->published_rssi;
+            if (delta >= ADV_RSSI_STEP || delta <= -ADV_RSSI_STEP) {
+                // Large change (device moved closer or was switched on)
+                slot_publish(slot, EV_ACTION_UPDATE);
+            } else if (delta != 0) {
+                // Published by adv_work_handler()
+                slot->pending = true;
             }
-            devmgr_notify(EV_SUBJECT_ADV_LIST, addr, EV_ACTION_UPDATE);
             k_mutex_unlock(&devmgr->mutex);
             return;
         }
     }
 
-    // Add new entry if there's space
-    if (devmgr->sync.adv.count < DEVMGR_MAX_CONFIG_ENTRIES) {
-        devmgr_adv_entry_t *entry = &devmgr->sync.adv.entry[devmgr->sync.adv.count++];
-        memset(entry, 0, sizeof(devmgr_adv_entry_t));
-        bt_addr_le_copy(&entry->addr, addr);
-        entry->rssi = rssi;
-        if (name != NULL) {
-            strncpy(entry->name, name, sizeof(entry->name) - 1);
-            entry->name[sizeof(entry->name) - 1] = '\0';
+    if (devmgr->sync.adv.count >= DEVMGR_MAX_ADVLIST_ENTRIES) {
+        // Replace the weakest device if the new one is stronger
+        size_t weakest = 0;
+        for (size_t i = 1; i < devmgr->sync.adv.count; i++) {
+            if (devmgr->sync.adv.entry[i].rssi_avg < devmgr->sync.adv.entry[weakest].rssi_avg) {
+                weakest = i;
+            }
         }
-        devmgr_notify(EV_SUBJECT_ADV_LIST, addr, EV_ACTION_CREATE);
+        if (slot_rssi(&devmgr->sync.adv.entry[weakest]) >= rssi) {
+            k_mutex_unlock(&devmgr->mutex);
+            return;
+        }
+        slot_remove(weakest);
     }
 
+    devmgr_adv_slot_t *slot = &devmgr->sync.adv.entry[devmgr->sync.adv.count++];
+    memset(slot, 0, sizeof(devmgr_adv_slot_t));
+    bt_addr_le_copy(&slot->info.addr, addr);
+    slot->rssi_avg = rssi * 16;
+    slot->last_seen = now;
+    slot_set_name(slot, name);
+    slot_publish(slot, EV_ACTION_CREATE);
+
+    // Keep the periodic publishing running while the list is not empty
+    workq_schedule(&devmgr->adv_work, K_MSEC(DEVMGR_ADV_REPORT_INTERVAL));
+
     k_mutex_unlock(&devmgr->mutex);
 }
 
-int devmgr_get_advertising_devices(devmgr_adv_entry_t *list)
+int devmgr_get_advertising_devices(bt_addr_le_t *addrs)
 {
     devmgr_t *devmgr = &g_devmgr;
 
     k_mutex_lock(&devmgr->mutex, K_FOREVER);
     size_t count = devmgr->sync.adv.count;
-    memcpy(list, devmgr->sync.adv.entry, sizeof(devmgr_adv_entry_t) * count);
+    for (size_t i = 0; i < count; i++) {
+        bt_addr_le_copy(&addrs[i], &devmgr->sync.adv.entry[i].info.addr);
+    }
     k_mutex_unlock(&devmgr->mutex);
 
     return count;
 }
 
-int devmgr_get_adv_device(const bt_addr_le_t *addr, devmgr_adv_entry_t *entry_)
+int devmgr_get_adv_device(const bt_addr_le_t *addr, devmgr_adv_entry_t *entry)
 {
     devmgr_t *devmgr = &g_devmgr;
 
     k_mutex_lock(&devmgr->mutex, K_FOREVER);
 
     for (size_t i = 0; i < devmgr->sync.adv.count; i++) {
-        devmgr_adv_entry_t *entry = &devmgr->sync.adv.entry[i];
-        if (bt_addr_le_eq(&entry->addr, addr)) {
-            *entry_ = *entry;
+        devmgr_adv_slot_t *slot = &devmgr->sync.adv.entry[i];
+        if (bt_addr_le_eq(&slot->info.addr, addr)) {
+            *entry = slot->info;
             k_mutex_unlock(&devmgr->mutex);
             return 0;
         }
@@ -0,0 +1,148 @@
+/*
+ * This file is part of the Blue2Joy project
+ * (https://github.com/cepetr/blue2joy).
+ * Copyright (c) 2025
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/byteorder.h>
+
+#include "devmgr_internal.h"
+
+// Record header (timestamp + slot + report ID + report length)
+#define CAPTURE_HDR_SIZE 7
+
+BUILD_ASSERT(IS_POWER_OF_TWO(DEVMGR_CAPTURE_SIZE), "Capture size must be a power of two");
+
+void devmgr_capture_init(void)
+{
+    devmgr_t *devmgr = &g_devmgr;
+
+    k_mutex_init(&devmgr->capture.mutex);
+}
+
+// Copies data to the capture at the position (wraps around)
+// Must be called with devmgr->capture.mutex locked
+static void capture_write(uint32_t pos, const uint8_t *src, size_t len)
+{
+    uint8_t *data = g_devmgr.capture.data;
+    size_t offset = pos % DEVMGR_CAPTURE_SIZE;
+    size_t first = MIN(len, DEVMGR_CAPTURE_SIZE - offset);
+
+    memcpy(&data[offset], src, first);
+    memcpy(data, &src[first], len - first);
+}
+
+// Copies data from the capture at the position (wraps around)
+// Must be called with devmgr->capture.mutex locked
+static void capture_read(uint32_t pos, uint8_t *dst, size_t len)
+{
+    const uint8_t *data = g_devmgr.capture.data;
+    size_t offset = pos % DEVMGR_CAPTURE_SIZE;
+    size_t first = MIN(len, DEVMGR_CAPTURE_SIZE - offset);
+
+    memcpy(dst, &data[offset], first);
+    memcpy(&dst[first], data, len - first);
+}
+
+// Returns the size of the record at the position
+// Must be called with devmgr->capture.mutex locked
+static size_t capture_record_size(uint32_t pos)
+{
+    uint8_t hdr[CAPTURE_HDR_SIZE];
+
+    capture_read(pos, hdr, sizeof(hdr));
+
+    return sizeof(hdr) + hdr[6];
+}
+
+void devmgr_capture_report(int slot, uint8_t report_id, const uint8_t *data, size_t length)
+{
+    devmgr_t *devmgr = &g_devmgr;
+
+    if (atomic_get(&devmgr->capture.readers) == 0) {
+        // Nobody reads the capture
+        return;
+    }
+
+    uint8_t hdr[CAPTURE_HDR_SIZE];
+
+    length = MIN(length, UINT8_MAX);
+    sys_put_le32((uint32_t)k_ticks_to_us_floor64(k_uptime_ticks()), hdr);
+    hdr[4] = slot;
+    hdr[5] = report_id;
+    hdr[6] = length;
+
+    k_mutex_lock(&devmgr->capture.mutex, K_FOREVER);
+
+    // Drop the oldest records to make room
+    while (devmgr->capture.head - devmgr->capture.tail + sizeof(hdr) + length >
+           DEVMGR_CAPTURE_SIZE) {
+        devmgr->capture.tail += capture_record_size(devmgr->capture.tail);
+    }
+
+    capture_write(devmgr->capture.head, hdr, sizeof(hdr));
+    capture_write(devmgr->capture.head + sizeof(hdr), data, length);
+    devmgr->capture.head += sizeof(hdr) + length;
+
+    k_mutex_unlock(&devmgr->capture.mutex);
+}
+
+void devmgr_open_capture(uint32_t *cursor)
+{
+    devmgr_t *devmgr = &g_devmgr;
+
+    k_mutex_lock(&devmgr->capture.mutex, K_FOREVER);
+    *cursor = devmgr->capture.head;
+    atomic_inc(&devmgr->capture.readers);
+    k_mutex_unlock(&devmgr->capture.mutex);
+}
+
+void devmgr_close_capture(void)
+{
+    devmgr_t *devmgr = &g_devmgr;
+
+    atomic_dec(&devmgr->capture.readers);
+}
+
+size_t devmgr_read_capture(uint32_t *cursor, uint8_t *buf, size_t size)
+{
+    devmgr_t *devmgr = &g_devmgr;
+
+    size_t len = 0;
+
+    k_mutex_lock(&devmgr->capture.mutex, K_FOREVER);
+
+    if ((int32_t)(*cursor - devmgr->capture.tail) < 0) {
+        // The unread records were dropped
+        *cursor = devmgr->capture.tail;
+    }
+
+    while (*cursor != devmgr->capture.head) {
+        size_t record = capture_record_size(*cursor);
+        if (len + record > size) {
+            break;
+        }
+        capture_read(*cursor, &buf[len], record);
+        *cursor += record;
+        len += record;
+    }
+
+    k_mutex_unlock(&devmgr->capture.mutex);
+
+    return len;
+}
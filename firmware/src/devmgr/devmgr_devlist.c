@@ -17,6 +17,8 @@
  */
 
 #include <bthid/bthid.h>
+#include <mapper/mapper.h>
+#include <persist/persist.h>
 
 #include "devmgr_internal.h"
 
@@ -135,8 +137,7 @@ devmgr_entry_t *devmgr_ensure_entry(const bt_addr_le_t *addr, bool save)
     }
 
     if (changed && save) {
-        LOG_INF("Scheduling devmgr settings save");
-        k_work_reschedule(&devmgr->save_work, K_SECONDS(3));
+        persist_mark_all_dirty(PERSIST_GROUP_DEVICE);
     }
 
     return first;
@@ -179,8 +180,7 @@ int devmgr_delete_device(const bt_addr_le_t *addr)
 
     if (entry != NULL) {
         // bthid_bonds_delete(); !@# TODO
-        LOG_INF("Scheduling devmgr settings save");
-        k_work_reschedule(&devmgr->save_work, K_SECONDS(3));
+        persist_mark_all_dirty(PERSIST_GROUP_DEVICE);
     }
 
     return entry != NULL ? 0 : -ENOENT;
@@ -226,6 +226,7 @@ int devmgr_set_device_config(const bt_addr_le_t *addr, const devmgr_device_confi
     devmgr_t *devmgr = &g_devmgr;
 
     bool changed = false;
+    bool profile_changed = false;
 
     k_mutex_lock(&devmgr->mutex, K_FOREVER);
 
@@ -234,6 +235,7 @@ int devmgr_set_device_config(const bt_addr_le_t *addr, const devmgr_device_confi
     if (entry != NULL) {
         if (memcmp(&entry->config, config, sizeof(*config)) != 0) {
             changed = true;
+            profile_changed = entry->config.profile != config->profile;
             entry->config = *config;
         }
     }
@@ -244,9 +246,13 @@ int devmgr_set_device_config(const bt_addr_le_t *addr, const devmgr_device_confi
 
     k_mutex_unlock(&devmgr->mutex);
 
+    if (profile_changed) {
+        // Loaded before the next report of the device
+        mapper_prefetch_profile(config->profile);
+    }
+
     if (changed && save) {
-        LOG_INF("Scheduling devmgr settings save");
-        k_work_reschedule(&devmgr->save_work, K_SECONDS(3));
+        persist_mark_all_dirty(PERSIST_GROUP_DEVICE);
     }
 
     return entry != NULL ? 0 : -ENOENT;
@@ -21,6 +21,7 @@
 #include <zephyr/logging/log.h>
 
 #include <event/event.h>
+#include <workq/workq.h>
 
 #include "devmgr.h"
 
@@ -34,10 +35,42 @@ typedef struct {
     devmgr_device_config_t config;
 } devmgr_entry_t;
 
+// Advertising device tracked by the scanner
+typedef struct {
+    // Published state
+    devmgr_adv_entry_t info;
+    // Smoothed RSSI (Q4 format)
+    int16_t rssi_avg;
+    // RSSI when last published
+    int8_t published_rssi;
+    // Changed since last published
+    bool pending;
+    // Uptime of the last advertisement (ms)
+    uint32_t last_seen;
+} devmgr_adv_slot_t;
+
 typedef struct {
-    struct k_work_delayable save_work;
     struct k_mutex mutex;
 
+    // Publishes the scan result changes and ages out silent devices
+    workq_work_t adv_work;
+
+    // Publishes link statistics of the connected devices
+    workq_work_t link_work;
+
+    // Recently received HID reports
+    // (recorded only while a reader is open, see devmgr_open_capture())
+    struct {
+        struct k_mutex mutex;
+        // Number of open readers
+        atomic_t readers;
+        // Positions of the oldest record and of the end of the newest one
+        // (byte counters, the data index is pos % DEVMGR_CAPTURE_SIZE)
+        uint32_t tail;
+        uint32_t head;
+        uint8_t data[DEVMGR_CAPTURE_SIZE];
+    } capture;
+
     struct {
         devmgr_mode_t mode;
 
@@ -48,11 +81,27 @@ typedef struct {
         } dev;
 
         bool scanning;
+        // Scanning is done by the controller for the accept list
+        // of known devices (AUTO mode)
+        bool accept_list;
+
+        // Connection and report latency statistics
+        struct {
+            devmgr_stats_t data;
+            // Uptime (ms) of the last scan start, connection request and disconnection
+            uint32_t scan_start;
+            uint32_t conn_start;
+            uint32_t closed_at;
+            bt_addr_le_t closed_addr;
+            // Report rate measurement window
+            uint32_t window_start;
+            uint32_t window_reports;
+        } stats;
 
         // Currently advertising devices
         struct {
             size_t count;
-            devmgr_adv_entry_t entry[DEVMGR_MAX_ADVLIST_ENTRIES];
+            devmgr_adv_slot_t entry[DEVMGR_MAX_ADVLIST_ENTRIES];
         } adv;
 
     } sync;
@@ -64,12 +113,41 @@ extern devmgr_t g_devmgr;
 // Notifies all registered listeners about an event
 void devmgr_notify(event_subject_t subject, const bt_addr_le_t *addr, event_action_t action);
 
+// Initializes the advertising device list
+void devmgr_adv_list_init(void);
+
 // Adds or updates an advertising device in the list
+// (changes are published in batches, see DEVMGR_ADV_REPORT_INTERVAL)
 void devmgr_add_to_adv_list(const bt_addr_le_t *addr, int8_t rssi, const char *name);
 
 // Clears the advertising device list
 void devmgr_clear_adv_list(void);
 
+// Records the start of scanning
+// Must be called with devmgr->mutex locked
+void devmgr_stats_scan_started(void);
+
+// Records a connection request
+// Must be called with devmgr->mutex locked
+void devmgr_stats_conn_started(void);
+
+// Records a device state change and updates connection timings
+// Must be called with devmgr->mutex locked
+void devmgr_stats_conn_state(const bt_addr_le_t *addr, devmgr_conn_state_t state);
+
+// Records a processed HID report and its processing time in cycles
+void devmgr_stats_report(uint32_t cycles);
+
+// Starts publishing link statistics of the connected devices
+void devmgr_link_stats_init(void);
+
+// Initializes the HID report capture
+void devmgr_capture_init(void);
+
+// Appends a received HID report to the capture if a reader is open
+// (the oldest records are dropped if the capture is full)
+void devmgr_capture_report(int slot, uint8_t report_id, const uint8_t *data, size_t length);
+
 // Find device entry by address
 // Returns NULL if not found
 // Must be called with devmgr->mutex locked
@@ -0,0 +1,183 @@
+/*
+ * This file is part of the Blue2Joy project
+ * (https://github.com/cepetr/blue2joy).
+ * Copyright (c) 2025
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <zephyr/kernel.h>
+
+#include "devmgr_internal.h"
+
+// Length of the report rate measurement window (ms)
+#define REPORT_RATE_WINDOW 1000
+
+static void timing_add(devmgr_timing_t *timing, uint32_t value)
+{
+    if (timing->count == 0 || value < timing->min) {
+        timing->min = value;
+    }
+
+    if (value > timing->max) {
+        timing->max = value;
+    }
+
+    timing->last = value;
+    timing->sum += value;
+    timing->count++;
+}
+
+void devmgr_stats_scan_started(void)
+{
+    devmgr_t *devmgr = &g_devmgr;
+
+    devmgr->sync.stats.scan_start = MAX(k_uptime_get_32(), 1);
+}
+
+void devmgr_stats_conn_started(void)
+{
+    devmgr_t *devmgr = &g_devmgr;
+
+    devmgr->sync.stats.conn_start = MAX(k_uptime_get_32(), 1);
+}
+
+void devmgr_stats_conn_state(const bt_addr_le_t *addr, devmgr_conn_state_t state)
+{
+    devmgr_t *devmgr = &g_devmgr;
+    uint32_t now = k_uptime_get_32();
+
+    switch (state) {
+    case DEVMGR_CONN_READY:
+        if (devmgr->sync.stats.data.boot_to_ready == 0) {
+            devmgr->sync.stats.data.boot_to_ready = MAX(now, 1);
+            LOG_INF("First device ready {uptime: %u ms}", now);
+        }
+
+        if (devmgr->sync.stats.scan_start != 0) {
+            timing_add(&devmgr->sync.stats.data.scan_to_ready,
+                       now - devmgr->sync.stats.scan_start);
+            devmgr->sync.stats.scan_start = 0;
+        }
+
+        if (devmgr->sync.stats.conn_start != 0) {
+            timing_add(&devmgr->sync.stats.data.connect_to_ready,
+                       now - devmgr->sync.stats.conn_start);
+            devmgr->sync.stats.conn_start = 0;
+        }
+
+        if (devmgr->sync.stats.closed_at != 0 &&
+            bt_addr_le_eq(&devmgr->sync.stats.closed_addr, addr)) {
+            timing_add(&devmgr->sync.stats.data.reconnect, now - devmgr->sync.stats.closed_at);
+        }
+        devmgr->sync.stats.closed_at = 0;
+
+        LOG_INF("Device ready {scan: %u ms, connect: %u ms}",
+                devmgr->sync.stats.data.scan_to_ready.last,
+                devmgr->sync.stats.data.connect_to_ready.last);
+        break;
+
+    case DEVMGR_CONN_CLOSED:
+    case DEVMGR_CONN_ERROR:
+        // Last statistics with the disconnection reason
+        devmgr_notify(EV_SUBJECT_LINK_STATS, addr, EV_ACTION_UPDATE);
+
+        // Only a drop of a working connection starts the reconnect timer
+        if (devmgr->sync.stats.closed_at == 0 && devmgr->sync.stats.conn_start == 0) {
+            devmgr->sync.stats.closed_at = MAX(now, 1);
+            bt_addr_le_copy(&devmgr->sync.stats.closed_addr, addr);
+        }
+        devmgr->sync.stats.conn_start = 0;
+        break;
+
+    default:
+        break;
+    }
+}
+
+void devmgr_stats_report(uint32_t cycles)
+{
+    devmgr_t *devmgr = &g_devmgr;
+    uint32_t now = k_uptime_get_32();
+
+    k_mutex_lock(&devmgr->mutex, K_FOREVER);
+
+    devmgr_stats_t *stats = &devmgr->sync.stats.data;
+
+    timing_add(&stats->report_latency, k_cyc_to_us_floor32(cycles));
+    stats->reports++;
+
+    if (now - devmgr->sync.stats.window_start >= REPORT_RATE_WINDOW) {
+        devmgr->sync.stats.window_start = now;
+        devmgr->sync.stats.window_reports = 0;
+    }
+
+    if (++devmgr->sync.stats.window_reports > stats->peak_report_rate) {
+        stats->peak_report_rate = devmgr->sync.stats.window_reports;
+    }
+
+    k_mutex_unlock(&devmgr->mutex);
+}
+
+void devmgr_get_stats(devmgr_stats_t *stats)
+{
+    devmgr_t *devmgr = &g_devmgr;
+
+    k_mutex_lock(&devmgr->mutex, K_FOREVER);
+    *stats = devmgr->sync.stats.data;
+    k_mutex_unlock(&devmgr->mutex);
+}
+
+void devmgr_reset_stats(void)
+{
+    devmgr_t *devmgr = &g_devmgr;
+
+    k_mutex_lock(&devmgr->mutex, K_FOREVER);
+    // Measured only once after power on
+    uint32_t boot_to_ready = devmgr->sync.stats.data.boot_to_ready;
+    memset(&devmgr->sync.stats.data, 0, sizeof(devmgr->sync.stats.data));
+    devmgr->sync.stats.data.boot_to_ready = boot_to_ready;
+    k_mutex_unlock(&devmgr->mutex);
+}
+
+static void link_work_handler(workq_work_t *work)
+{
+    devmgr_t *devmgr = &g_devmgr;
+
+    k_mutex_lock(&devmgr->mutex, K_FOREVER);
+
+    for (size_t i = 0; i < devmgr->sync.dev.count; i++) {
+        devmgr_entry_t *entry = &devmgr->sync.dev.entry[i];
+        if (entry->state.conn_state == DEVMGR_CONN_CONNECTED ||
+            entry->state.conn_state == DEVMGR_CONN_READY) {
+            devmgr_notify(EV_SUBJECT_LINK_STATS, &entry->addr, EV_ACTION_UPDATE);
+        }
+    }
+
+    k_mutex_unlock(&devmgr->mutex);
+
+    workq_schedule(work, K_MSEC(DEVMGR_LINK_STATS_INTERVAL));
+}
+
+void devmgr_link_stats_init(void)
+{
+    devmgr_t *devmgr = &g_devmgr;
+
+    workq_init_work(&devmgr->link_work, WORKQ_PROTOCOL, link_work_handler);
+    workq_schedule(&devmgr->link_work, K_MSEC(DEVMGR_LINK_STATS_INTERVAL));
+}
+
+int devmgr_get_link_stats(const bt_addr_le_t *addr, bthid_link_stats_t *stats)
+{
+    return bthid_get_link_stats(addr, stats);
+}
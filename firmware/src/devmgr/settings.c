@@ -23,6 +23,9 @@
 #include <zephyr/settings/settings.h>
 
 #include <devmgr/devmgr.h>
+#include <persist/persist.h>
+
+#include "settings.h"
 
 #define SETTINGS_KEY_PREFIX "blue2joy/dev"
 
@@ -33,9 +36,20 @@ typedef struct {
     uint8_t profile;
 } dev_config_dto_v1_t;
 
+#define DEV_CONFIG_FLAG_BOOT_PROTOCOL 0x01
+
+typedef struct {
+    uint8_t addr[7];
+    uint8_t profile;
+    uint8_t flags;
+} dev_config_dto_v2_t;
+
 typedef struct {
     uint8_t version;
-    dev_config_dto_v1_t v1;
+    union {
+        dev_config_dto_v1_t v1;
+        dev_config_dto_v2_t v2;
+    };
 } dev_config_dto_t;
 
 static void dev_config_dto_v1_parse(const dev_config_dto_v1_t *dto, bt_addr_le_t *addr,
@@ -46,6 +60,15 @@ static void dev_config_dto_v1_parse(const dev_config_dto_v1_t *dto, bt_addr_le_t
     config->profile = dto->profile;
 }
 
+static void dev_config_dto_v2_parse(const dev_config_dto_v2_t *dto, bt_addr_le_t *addr,
+                                    devmgr_device_config_t *config)
+{
+    _Static_assert(sizeof(dto->addr) == sizeof(*addr), "Invalid address size");
+    memcpy(addr, dto->addr, sizeof(*addr));
+    config->profile = dto->profile;
+    config->boot_protocol = (dto->flags & DEV_CONFIG_FLAG_BOOT_PROTOCOL) != 0;
+}
+
 static int dev_config_dto_parse(const void *data, size_t data_size, bt_addr_le_t *addr,
                                 devmgr_device_config_t *config)
 {
@@ -65,32 +88,66 @@ static int dev_config_dto_parse(const void *data, size_t data_size, bt_addr_le_t
         dev_config_dto_v1_parse(&dto->v1, addr, config);
         return 0;
 
+    case 2:
+        if (data_size != sizeof(dto->version) + sizeof(dto->v2)) {
+            return -1;
+        }
+
+        dev_config_dto_v2_parse(&dto->v2, addr, config);
+        return 0;
+
     default:
         return -1;
     }
 }
 
-static void dev_config_dto_v1_build(const bt_addr_le_t *addr, const devmgr_device_config_t *config,
-                                    dev_config_dto_v1_t *dto)
+static void dev_config_dto_v2_build(const bt_addr_le_t *addr, const devmgr_device_config_t *config,
+                                    dev_config_dto_v2_t *dto)
 {
     _Static_assert(sizeof(dto->addr) == sizeof(*addr), "Invalid address size");
     memcpy(dto->addr, addr, sizeof(dto->addr));
     dto->profile = config->profile;
+    dto->flags = config->boot_protocol ? DEV_CONFIG_FLAG_BOOT_PROTOCOL : 0;
 }
 
 static ssize_t dev_config_dto_build(const bt_addr_le_t *addr, const devmgr_device_config_t *config,
                                     dev_config_dto_t *dto)
 {
-    dto->version = 1;
-    dev_config_dto_v1_build(addr, config, &dto->v1);
+    dto->version = 2;
+    dev_config_dto_v2_build(addr, config, &dto->v2);
 
-    return sizeof(dto->version) + sizeof(dto->v1);
+    return sizeof(dto->version) + sizeof(dto->v2);
 }
 
-void devmgr_save_settings(struct k_work *work)
+static ssize_t _settings_build(int idx, void *buf, size_t buf_size)
 {
-    LOG_INF("Saving devmgr settings");
-    settings_save_subtree(SETTINGS_KEY_PREFIX);
+    bt_addr_le_t addrs[DEVMGR_MAX_CONFIG_ENTRIES];
+    int addr_count = devmgr_get_devices(addrs);
+
+    if (idx >= addr_count) {
+        // No device at this position, delete the key
+        return 0;
+    }
+
+    devmgr_device_config_t dev_config;
+    if (devmgr_get_device_config(&addrs[idx], &dev_config) != 0) {
+        return 0;
+    }
+
+    dev_config_dto_t dto;
+    ssize_t dto_size = dev_config_dto_build(&addrs[idx], &dev_config, &dto);
+    if (dto_size < 0 || dto_size > buf_size) {
+        return -ENOMEM;
+    }
+
+    memcpy(buf, &dto, dto_size);
+    return dto_size;
+}
+
+int devmgr_settings_init(void)
+{
+    return persist_register(PERSIST_GROUP_DEVICE, SETTINGS_KEY_PREFIX, DEVMGR_MAX_CONFIG_ENTRIES,
+                            _settings_build);
 }
 
 static int _settings_set(const char *key, size_t len, settings_read_cb read_cb, void *cb_arg)
@@ -115,7 +172,7 @@ static int _settings_set(const char *key, size_t len, settings_read_cb read_cb,
 
     dev_config_dto_t dto;
 
-    if (read_cb(cb_arg, &dto, len) != len) {
+    if (len > sizeof(dto) || read_cb(cb_arg, &dto, len) != len) {
         LOG_ERR("Failed to read setting value");
         return -EINVAL;
     }
@@ -139,37 +196,9 @@ static int _settings_set(const char *key, size_t len, settings_read_cb read_cb,
         return -EINVAL;
     }
 
-    return 0;
-}
-
-static int _settings_export(int (*export_func)(const char *name, const void *val, size_t val_len))
-{
-    LOG_INF("Exporting devmgr settings");
-
-    bt_addr_le_t addrs[DEVMGR_MAX_CONFIG_ENTRIES];
-    int addr_count = devmgr_get_devices(addrs);
-
-    for (int i = 0; i < addr_count; i++) {
-        bt_addr_le_t *addr = &addrs[i];
-
-        char key[32];
-        snprintf(key, sizeof(key), SETTINGS_KEY_PREFIX "/%d", i);
-
-        devmgr_device_config_t dev_config;
-        if (devmgr_get_device_config(addr, &dev_config) != 0) {
-            LOG_ERR("Failed to get device configuration {idx=%d}", i);
-            continue;
-        }
-
-        dev_config_dto_t dto;
-        ssize_t dto_size = dev_config_dto_build(addr, &dev_config, &dto);
-        if (dto_size >= 0) {
-            export_func(key, &dto, dto_size);
-        }
-    }
+    persist_loaded(PERSIST_GROUP_DEVICE, idx, &dto, len);
 
     return 0;
 }
 
-SETTINGS_STATIC_HANDLER_DEFINE(devmgr, SETTINGS_KEY_PREFIX, NULL, _settings_set, NULL,
-                               _settings_export);
+SETTINGS_STATIC_HANDLER_DEFINE(devmgr, SETTINGS_KEY_PREFIX, NULL, _settings_set, NULL, NULL);
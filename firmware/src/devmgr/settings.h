@@ -18,4 +18,7 @@
 
 #pragma once
 
-void devmgr_save_settings(struct k_work *work);
\ No newline at end of file
+// Registers the device configurations with the persistence layer
+//
+// Returns 0 on success, error code otherwise
+int devmgr_settings_init(void);
\ No newline at end of file
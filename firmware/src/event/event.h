@@ -31,13 +31,17 @@ typedef enum {
 // Describes what changed or what happened.
 // Used to route events to interested parts of the system.
 typedef enum {
-    EV_SUBJECT_SYS_STATE,   // System state changed
-    EV_SUBJECT_ADV_LIST,    // Scan results list changed
-    EV_SUBJECT_DEV_LIST,    // Manager HID devices
-    EV_SUBJECT_PROFILE,     // Mapping/profile changed
-    EV_SUBJECT_IO_STATE,    // Joystick/paddle output state changed
-    EV_SUBJECT_BTSVC_STATE, // BT service state changed
-    EV_SUBJECT_CONN_ERROR,  // A connection-related error occurred
+    EV_SUBJECT_SYS_STATE,      // System state changed
+    EV_SUBJECT_ADV_LIST,       // Scan results list changed
+    EV_SUBJECT_DEV_LIST,       // Manager HID devices
+    EV_SUBJECT_PROFILE,        // Mapping/profile changed
+    EV_SUBJECT_IO_STATE,       // Joystick/paddle output state changed
+    EV_SUBJECT_BTSVC_STATE,    // BT service state changed
+    EV_SUBJECT_CONN_ERROR,     // A connection-related error occurred
+    EV_SUBJECT_ACTIVE_PROFILE, // Profile used for mapping changed
+    EV_SUBJECT_PROFILE_LIST,   // Listing of the profile library from the index
+    EV_SUBJECT_SYS_STATS,      // Periodic system statistics (see sysmon)
+    EV_SUBJECT_LINK_STATS,     // Periodic link statistics of a connected HID device
 } event_subject_t;
 
 // State of an IO port (pins and pots)
@@ -52,8 +56,8 @@ typedef struct {
     // How it changed (CREATE/DELETE only for subjects that support lifecycle; otherwise UPDATE)
     event_action_t action;
     // Identifier of the affected entity:
-    // - use addr for ADV_LIST, DEV_LIST, CONN_ERROR
-    // - use idx for PROFILE, IO_STATE
+    // - use addr for ADV_LIST, DEV_LIST, CONN_ERROR, LINK_STATS
+    // - use idx for PROFILE, IO_STATE, ACTIVE_PROFILE, PROFILE_LIST
     union {
         bt_addr_le_t addr;
         uint8_t idx;
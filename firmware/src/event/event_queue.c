@@ -21,6 +21,28 @@
 
 #include "event_queue.h"
 
+static struct k_spinlock g_evq_stats_lock;
+static event_queue_stats_t g_evq_stats;
+
+static void event_queue_update_stats(event_queue_t *q, bool overflow)
+{
+    size_t count = (q->tail + EVQ_CAPACITY - q->head) % EVQ_CAPACITY;
+
+    k_spinlock_key_t key = k_spin_lock(&g_evq_stats_lock);
+    g_evq_stats.peak = MAX(g_evq_stats.peak, count);
+    if (overflow) {
+        g_evq_stats.overflows++;
+    }
+    k_spin_unlock(&g_evq_stats_lock, key);
+}
+
+void event_queue_get_stats(event_queue_stats_t *stats)
+{
+    k_spinlock_key_t key = k_spin_lock(&g_evq_stats_lock);
+    *stats = g_evq_stats;
+    k_spin_unlock(&g_evq_stats_lock, key);
+}
+
 int event_queue_init(event_queue_t *q)
 {
     memset(q, 0, sizeof(event_queue_t));
@@ -51,6 +73,7 @@ static bool events_matches(const event_t *a, const event_t *b)
     case EV_SUBJECT_ADV_LIST:
     case EV_SUBJECT_DEV_LIST:
     case EV_SUBJECT_CONN_ERROR:
+    case EV_SUBJECT_LINK_STATS:
         return bt_addr_le_cmp(&a->addr, &b->addr) == 0;
     case EV_SUBJECT_PROFILE:
         return a->idx == b->idx;
@@ -61,10 +84,40 @@ static bool events_matches(const event_t *a, const event_t *b)
     return false;
 }
 
+// Returns true if the event can't be recreated by pushing the current state
+static bool event_is_transient(const event_t *ev)
+{
+    return ev->action == EV_ACTION_DELETE || ev->subject == EV_SUBJECT_CONN_ERROR;
+}
+
+// Drops all events that can be recreated by pushing the current state
+static void event_queue_compact(event_queue_t *q)
+{
+    size_t read_pos = q->head;
+    size_t write_pos = q->head;
+
+    while (read_pos != q->tail) {
+        if (event_is_transient(&q->items[read_pos])) {
+            q->items[write_pos] = q->items[read_pos];
+            write_pos = (write_pos + 1) % EVQ_CAPACITY;
+        }
+        read_pos = (read_pos + 1) % EVQ_CAPACITY;
+    }
+
+    q->tail = write_pos;
+    q->resync = true;
+}
+
 int event_queue_push(event_queue_t *q, const event_t *ev)
 {
     k_mutex_lock(&q->mutex, K_FOREVER);
 
+    if ((BIT(ev->subject) & EVQ_OPT_IN_SUBJECTS & ~q->subscribed) != 0) {
+        // Nobody asked for it
+        k_mutex_unlock(&q->mutex);
+        return 0;
+    }
+
     // Check for existing event with the same id
     size_t pos = q->head;
     while (pos != q->tail) {
@@ -94,16 +147,28 @@ int event_queue_push(event_queue_t *q, const event_t *ev)
     }
 
     // No existing event found, add new event
+    bool overflow = false;
     size_t next_tail = (q->tail + 1) % EVQ_CAPACITY;
     if (next_tail == q->head) {
-        // Queue full
-        k_mutex_unlock(&q->mutex);
-        return -ENOMEM;
+        // Queue full, the dropped events are recreated on resync
+        event_queue_compact(q);
+        next_tail = (q->tail + 1) % EVQ_CAPACITY;
+        overflow = true;
+    }
+
+    if (next_tail == q->head) {
+        // Queue full of transient events, drop them too
+        // (the receiver clears its lists, so no deletion is lost)
+        q->tail = q->head;
+        q->reset = true;
+        next_tail = (q->tail + 1) % EVQ_CAPACITY;
     }
 
     q->items[q->tail] = *ev;
     q->tail = next_tail;
 
+    event_queue_update_stats(q, overflow);
+
     k_mutex_unlock(&q->mutex);
     return 0;
 }
@@ -131,6 +196,31 @@ void event_queue_remove(event_queue_t *q, const event_t *ev)
     k_mutex_unlock(&q->mutex);
 }
 
+void event_queue_subscribe(event_queue_t *q, uint32_t subjects)
+{
+    k_mutex_lock(&q->mutex, K_FOREVER);
+    q->subscribed = subjects & EVQ_OPT_IN_SUBJECTS;
+    k_mutex_unlock(&q->mutex);
+}
+
+bool event_queue_take_resync(event_queue_t *q)
+{
+    k_mutex_lock(&q->mutex, K_FOREVER);
+    bool resync = q->resync;
+    q->resync = false;
+    k_mutex_unlock(&q->mutex);
+    return resync;
+}
+
+bool event_queue_take_reset(event_queue_t *q)
+{
+    k_mutex_lock(&q->mutex, K_FOREVER);
+    bool reset = q->reset;
+    q->reset = false;
+    k_mutex_unlock(&q->mutex);
+    return reset;
+}
+
 bool event_queue_pop(event_queue_t *q, event_t *ev)
 {
     k_mutex_lock(&q->mutex, K_FOREVER);
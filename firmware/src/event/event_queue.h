@@ -25,6 +25,10 @@
 // Effective capacity of the event queue is EVQ_CAPACITY - 1
 #define EVQ_CAPACITY 32
 
+// Subjects queued only if the receiver subscribed to them
+// (periodic events, see event_queue_subscribe())
+#define EVQ_OPT_IN_SUBJECTS BIT(EV_SUBJECT_LINK_STATS)
+
 typedef struct {
     // Mutex to protect access to the queue
     struct k_mutex mutex;
@@ -33,8 +37,26 @@ typedef struct {
     size_t tail;
     event_t items[EVQ_CAPACITY];
 
+    // Events were dropped on overflow, the receiver needs
+    // the complete state again
+    bool resync;
+    // Transient events (deletions) were dropped as well, the receiver
+    // has to clear its lists before the complete state is pushed
+    bool reset;
+
+    // Opt-in subjects the receiver subscribed to (BIT(subject))
+    uint32_t subscribed;
+
 } event_queue_t;
 
+// Statistics of all event queues
+typedef struct {
+    // Highest number of pending events in a queue
+    uint32_t peak;
+    // Number of overflows (resynchronizations)
+    uint32_t overflows;
+} event_queue_stats_t;
+
 // Initializes the event queue structure
 // Returns 0 on success, error code otherwise
 int event_queue_init(event_queue_t *q);
@@ -43,10 +65,26 @@ int event_queue_init(event_queue_t *q);
 //
 // - If there's no event with the same id, a new event is added
 // - If there's a event with the same id, it is updated or deleted
+// - If the queue is full, events that can be recreated from the current
+//   state are dropped and the resync flag is set
+// - If the queue is full of transient events, all of them are dropped
+//   and the reset flag is set as well
+// - Events of opt-in subjects the receiver didn't subscribe to are ignored
 //
-// Returns 0 on success, -ENOMEM if the queue is full
+// Returns 0 (the event is never refused)
 int event_queue_push(event_queue_t *q, const event_t *ev);
 
+// Sets the opt-in subjects the receiver wants (BIT(subject), 0 => none)
+void event_queue_subscribe(event_queue_t *q, uint32_t subjects);
+
+// Returns true (and clears the flag) if events were dropped and
+// the complete state has to be pushed again
+bool event_queue_take_resync(event_queue_t *q);
+
+// Returns true (and clears the flag) if deletions were dropped and
+// the receiver has to clear its lists before the resync
+bool event_queue_take_reset(event_queue_t *q);
+
 // Retrieves the oldest event from the queue
 //
 // Returns true if an event was popped, false if the queue is empty
@@ -58,3 +96,6 @@ void event_queue_remove(event_queue_t *q, const event_t *ev);
 
 // Checks if the event queue is empty
 bool event_queue_is_empty(event_queue_t *q);
+
+// Retrieves statistics of all event queues
+void event_queue_get_stats(event_queue_stats_t *stats);
@@ -22,6 +22,7 @@
 
 #include <devmgr/devmgr.h>
 #include <btsvc/btsvc.h>
+#include <mapper/mapper.h>
 
 LOG_MODULE_DECLARE(blue2joy, CONFIG_LOG_DEFAULT_LEVEL);
 
@@ -56,7 +57,12 @@ static void input_cb(struct input_event *evt, void *user_data)
         }
     } else if (pressed && keycode == INPUT_KEY_B) {
         // Switch profiles if connected
-        // !@# TODO
+        if (devmgr_is_ready()) {
+            int err = mapper_cycle_profile();
+            if (err < 0) {
+                LOG_WRN("Profile switch failed {err: %d}", err);
+            }
+        }
     }
 }
 
@@ -43,6 +43,21 @@ typedef struct {
     uint8_t state;
 } io_pin_encoder_t;
 
+typedef struct {
+    // Pin is held by the mapper
+    bool held;
+    // Current output state
+    bool active;
+    // Frames left until the next toggle
+    uint8_t frames;
+} io_pin_autofire_t;
+
+// Time without a frame edge after which the autofire engine
+// falls back to the timer (e.g. the VBI doesn't read the pots)
+#define FRAME_TIMEOUT_MS 50
+// Frame period used by the timer fallback (PAL)
+#define FRAME_FALLBACK_MS 20
+
 typedef struct {
     nrfx_timer_t timer;
 
@@ -51,6 +66,11 @@ typedef struct {
     // Quadrature encoders state
     io_pin_encoder_t enc[IO_ENC_COUNT];
 
+    // Autofire state
+    io_pin_autofire_t autofire[IO_PIN_COUNT];
+    // Milliseconds since the last frame edge
+    uint16_t frame_ms;
+
 } io_pin_driver_t;
 
 static io_pin_driver_t g_io_pin_drv;
@@ -107,10 +127,11 @@ void io_pin_configure(io_pin_t pin, const io_pin_config_t *config)
 
     unsigned int key = irq_lock();
     drv->config[pin] = *config;
+    drv->autofire[pin] = (io_pin_autofire_t){0};
     irq_unlock(key);
 }
 
-void io_pin_set(io_pin_t pin, bool active)
+static void set_output(io_pin_t pin, bool active)
 {
     switch (pin) {
     case IO_PIN_UP:
@@ -133,6 +154,67 @@ void io_pin_set(io_pin_t pin, bool active)
     }
 }
 
+void io_pin_set(io_pin_t pin, bool active)
+{
+    io_pin_driver_t *drv = &g_io_pin_drv;
+
+    if (pin >= IO_PIN_COUNT) {
+        return;
+    }
+
+    unsigned int key = irq_lock();
+    if (drv->config[pin].mode == IO_PIN_MODE_AUTOFIRE) {
+        // The output follows on the next frame edge
+        drv->autofire[pin].held = active;
+    } else {
+        set_output(pin, active);
+    }
+    irq_unlock(key);
+}
+
+static void autofire_step(io_pin_driver_t *drv)
+{
+    for (int i = 0; i < IO_PIN_COUNT; i++) {
+        const io_pin_config_t *cfg = &drv->config[i];
+        io_pin_autofire_t *af = &drv->autofire[i];
+
+        if (cfg->mode != IO_PIN_MODE_AUTOFIRE) {
+            continue;
+        }
+
+        uint8_t frames = MAX(cfg->autofire_frames, 1);
+        bool active;
+
+        if (!af->held) {
+            active = false;
+            af->frames = 0;
+        } else if (af->frames == 0) {
+            // The first press starts on the frame edge after the pin is held
+            active = true;
+            af->frames = frames;
+        } else if (--af->frames == 0) {
+            active = !af->active;
+            af->frames = frames;
+        } else {
+            continue;
+        }
+
+        if (active != af->active) {
+            af->active = active;
+            set_output(i, active);
+        }
+    }
+}
+
+void io_pin_frame_sync(void)
+{
+    io_pin_driver_t *drv = &g_io_pin_drv;
+
+    // Runs at the same interrupt priority as the timer handler
+    drv->frame_ms = 0;
+    autofire_step(drv);
+}
+
 static void timer_handler(nrf_timer_event_t event_type, void *p_context)
 {
     io_pin_driver_t *drv = &g_io_pin_drv;
@@ -141,6 +223,12 @@ static void timer_handler(nrf_timer_event_t event_type, void *p_context)
         return;
     }
 
+    // Keep autofire running if there are no frame edges
+    if (++drv->frame_ms >= FRAME_TIMEOUT_MS) {
+        drv->frame_ms = FRAME_TIMEOUT_MS - FRAME_FALLBACK_MS;
+        autofire_step(drv);
+    }
+
     // Read & update encoders
 
     for (int enc_idx = 0; enc_idx < IO_ENC_COUNT; enc_idx++) {
@@ -166,7 +254,7 @@ static void timer_handler(nrf_timer_event_t event_type, void *p_context)
             const io_pin_config_t *cfg = &drv->config[i];
             if (cfg->mode == IO_PIN_MODE_ENCODER && cfg->enc_idx == enc_idx) {
                 const uint8_t map[4] = {0, 2, 3, 1};
-                io_pin_set(i, map[state] & (1 << cfg->enc_phase) ? false : true);
+                set_output(i, map[state] & (1 << cfg->enc_phase) ? false : true);
             }
         }
     }
@@ -29,6 +29,7 @@
 typedef enum {
     IO_PIN_MODE_NORMAL,
     IO_PIN_MODE_ENCODER,
+    IO_PIN_MODE_AUTOFIRE,
 } io_pin_mode_t;
 
 typedef struct {
@@ -38,6 +39,9 @@ typedef struct {
     uint8_t enc_idx;
     // Encoder phase (0 => A, 1 => B)
     uint8_t enc_phase;
+    // Number of frames the pin stays active and inactive
+    // while held (if mode == IO_PIN_MODE_AUTOFIRE)
+    uint8_t autofire_frames;
 } io_pin_config_t;
 
 // Initializes joystick digital pin outputs
@@ -52,8 +56,16 @@ typedef enum {
 } io_pin_t;
 
 // Sets joystick direction buttons
+//
+// In IO_PIN_MODE_AUTOFIRE the pin is held and toggled on frame edges
 void io_pin_set(io_pin_t pin, bool active);
 
+// Advances the autofire engine by one Atari frame
+//
+// Called from the io_pot comparator interrupt on the POKEY frame edge,
+// so all toggles land at the same point relative to the VBI
+void io_pin_frame_sync(void);
+
 // Sets pin configuration
 void io_pin_configure(io_pin_t pin, const io_pin_config_t *config);
 
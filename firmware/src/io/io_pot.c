@@ -28,6 +28,7 @@
 
 #include <zephyr/drivers/pwm.h>
 
+#include "io_pin.h"
 #include "io_pot.h"
 
 LOG_MODULE_DECLARE(blue2joy, CONFIG_LOG_DEFAULT_LEVEL);
@@ -85,6 +86,10 @@ static void comparator_handler(nrf_comp_event_t event)
     atomic_set(&drv->period, (drv->filter.sum / ARRAY_SIZE(drv->filter.buf)));
 
     drv->filter.time = now;
+
+    // POKEY starts the pot scan when the VBI writes POTGO,
+    // the frame edge drives the autofire engine
+    io_pin_frame_sync();
 }
 
 static void timer_handler(nrf_timer_event_t event_type, void *p_context)
@@ -16,7 +16,7 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
-#include <math.h>
+#include <stdlib.h>
 
 #include <zephyr/kernel.h>
 #include <zephyr/logging/log.h>
@@ -30,9 +30,17 @@ LOG_MODULE_DECLARE(blue2joy, CONFIG_LOG_DEFAULT_LEVEL);
 
 K_THREAD_STACK_DEFINE(g_rgbled_drv_stack, 2048);
 
+// Interval between LED updates during transitions (ms)
+#define RGBLED_FRAME_MS 20
+
+// Sleep forever (until woken up by a state change)
+#define RGBLED_TIME_FOREVER INT64_MAX
+
 typedef struct {
     struct k_thread thread;
     struct k_mutex mutex;
+    // Signalled when the sequence or brightness changes
+    struct k_sem wakeup;
 
     struct {
         const rgbled_seq_t *state_seq;
@@ -62,6 +70,9 @@ int rgbled_init(void)
 
     memset(drv, 0, sizeof(rgbled_drv_t));
 
+    k_mutex_init(&drv->mutex);
+    k_sem_init(&drv->wakeup, 0, 1);
+
     drv->sync.brightness = 5; // Default brightness
 
     k_thread_create(&drv->thread, g_rgbled_drv_stack, K_THREAD_STACK_SIZEOF(g_rgbled_drv_stack),
@@ -78,52 +89,120 @@ void rgbled_set_brightness(uint8_t brightness)
     k_mutex_lock(&drv->mutex, K_FOREVER);
     drv->sync.brightness = brightness;
     k_mutex_unlock(&drv->mutex);
+
+    k_sem_give(&drv->wakeup);
+}
+
+// Gamma decoding table (linear color -> perceptual value)
+// Generated as round((i / 255) ^ (1 / 2.2) * 255)
+// clang-format off
+static const uint8_t g_gamma_decode[256] = {
+      0,  21,  28,  34,  39,  43,  46,  50,  53,  56,  59,  61,  64,  66,  68,  70,
+     72,  74,  76,  78,  80,  82,  84,  85,  87,  89,  90,  92,  93,  95,  96,  98,
+     99, 101, 102, 103, 105, 106, 107, 109, 110, 111, 112, 114, 115, 116, 117, 118,
+    119, 120, 122, 123, 124, 125, 126, 127, 128, 129, 130, 131, 132, 133, 134, 135,
+    136, 137, 138, 139, 140, 141, 142, 143, 144, 144, 145, 146, 147, 148, 149, 150,
+    151, 151, 152, 153, 154, 155, 156, 156, 157, 158, 159, 160, 160, 161, 162, 163,
+    164, 164, 165, 166, 167, 167, 168, 169, 170, 170, 171, 172, 173, 173, 174, 175,
+    175, 176, 177, 178, 178, 179, 180, 180, 181, 182, 182, 183, 184, 184, 185, 186,
+    186, 187, 188, 188, 189, 190, 190, 191, 192, 192, 193, 194, 194, 195, 195, 196,
+    197, 197, 198, 199, 199, 200, 200, 201, 202, 202, 203, 203, 204, 205, 205, 206,
+    206, 207, 207, 208, 209, 209, 210, 210, 211, 212, 212, 213, 213, 214, 214, 215,
+    215, 216, 217, 217, 218, 218, 219, 219, 220, 220, 221, 221, 222, 223, 223, 224,
+    224, 225, 225, 226, 226, 227, 227, 228, 228, 229, 229, 230, 230, 231, 231, 232,
+    232, 233, 233, 234, 234, 235, 235, 236, 236, 237, 237, 238, 238, 239, 239, 240,
+    240, 241, 241, 242, 242, 243, 243, 244, 244, 245, 245, 246, 246, 247, 247, 248,
+    248, 249, 249, 249, 250, 250, 251, 251, 252, 252, 253, 253, 254, 254, 255, 255,
+};
+
+// Gamma encoding table (perceptual value -> linear color)
+// Generated as round((i / 255) ^ 2.2 * 255)
+static const uint8_t g_gamma_encode[256] = {
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   1,
+      1,   1,   1,   1,   1,   1,   1,   1,   1,   2,   2,   2,   2,   2,   2,   2,
+      3,   3,   3,   3,   3,   4,   4,   4,   4,   5,   5,   5,   5,   6,   6,   6,
+      6,   7,   7,   7,   8,   8,   8,   9,   9,   9,  10,  10,  11,  11,  11,  12,
+     12,  13,  13,  13,  14,  14,  15,  15,  16,  16,  17,  17,  18,  18,  19,  19,
+     20,  20,  21,  22,  22,  23,  23,  24,  25,  25,  26,  26,  27,  28,  28,  29,
+     30,  30,  31,  32,  33,  33,  34,  35,  35,  36,  37,  38,  39,  39,  40,  41,
+     42,  43,  43,  44,  45,  46,  47,  48,  49,  49,  50,  51,  52,  53,  54,  55,
+     56,  57,  58,  59,  60,  61,  62,  63,  64,  65,  66,  67,  68,  69,  70,  71,
+     73,  74,  75,  76,  77,  78,  79,  81,  82,  83,  84,  85,  87,  88,  89,  90,
+     91,  93,  94,  95,  97,  98,  99, 100, 102, 103, 105, 106, 107, 109, 110, 111,
+    113, 114, 116, 117, 119, 120, 121, 123, 124, 126, 127, 129, 130, 132, 133, 135,
+    137, 138, 140, 141, 143, 145, 146, 148, 149, 151, 153, 154, 156, 158, 159, 161,
+    163, 165, 166, 168, 170, 172, 173, 175, 177, 179, 181, 182, 184, 186, 188, 190,
+    192, 194, 196, 197, 199, 201, 203, 205, 207, 209, 211, 213, 215, 217, 219, 221,
+    223, 225, 227, 229, 231, 234, 236, 238, 240, 242, 244, 246, 248, 251, 253, 255,
+};
+// clang-format on
+
+// Eases the transition progress (0..256)
+static inline uint32_t ease_in_out_quad(uint32_t t)
+{
+    return (t < 128) ? (2 * t * t) >> 8 : 256 - ((2 * (256 - t) * (256 - t)) >> 8);
 }
 
-static inline float ease_in_out_quad(float t)
+static inline uint8_t blend_channel(uint8_t c0, uint8_t c1, uint32_t gain, uint32_t scale)
 {
-    return (t < 0.5f) ? 2.0f * t * t : 1.0f - 2.0f * (1.0f - t) * (1.0f - t);
+    int32_t v0 = g_gamma_decode[c0];
+    int32_t v1 = g_gamma_decode[c1];
+
+    // Blend in perceptual space and apply the brightness (both Q8)
+    int32_t v = v0 + (((v1 - v0) * (int32_t)gain) >> 8);
+    v = (v * (int32_t)scale) >> 8;
+
+    return g_gamma_encode[CLAMP(v, 0, 255)];
 }
 
 static struct led_rgb interpolate(const struct led_rgb c0, const struct led_rgb c1, int64_t t0,
                                   int64_t t1, int64_t t, uint8_t brightness)
 {
-    if (t0 == t1) {
-        return c0;
-    }
+    uint32_t scale = (CLAMP(brightness, 0, 10) * 256 + 5) / 10;
 
-    float brightness_factor = (float)CLAMP(brightness, 0, 10) / 10.0f;
-
-    float gain = (float)(t - t0) / (t1 - t0);
-    gain = CLAMP(gain, 0.0f, 1.0f);
+    uint32_t gain = 0;
+    if (t1 > t0 && t > t0) {
+        gain = (t >= t1) ? 256 : (uint32_t)(((t - t0) * 256) / (t1 - t0));
+        gain = ease_in_out_quad(gain);
+    }
 
-    gain = ease_in_out_quad(gain);
+    struct led_rgb color;
+    color.r = blend_channel(c0.r, c1.r, gain, scale);
+    color.g = blend_channel(c0.g, c1.g, gain, scale);
+    color.b = blend_channel(c0.b, c1.b, gain, scale);
 
-    const float gamma = 2.2f;
-    const float inv_gamma = 1.0f / gamma;
+    return color;
+}
 
-    float r0 = powf(c0.r / 255.0f, inv_gamma);
-    float g0 = powf(c0.g / 255.0f, inv_gamma);
-    float b0 = powf(c0.b / 255.0f, inv_gamma);
+// Returns the update interval needed for a smooth transition
+static int64_t transition_interval(const struct led_rgb c0, const struct led_rgb c1,
+                                   int64_t duration)
+{
+    int delta = MAX(abs(g_gamma_decode[c0.r] - g_gamma_decode[c1.r]),
+                    abs(g_gamma_decode[c0.g] - g_gamma_decode[c1.g]));
+    delta = MAX(delta, abs(g_gamma_decode[c0.b] - g_gamma_decode[c1.b]));
 
-    float r1 = powf(c1.r / 255.0f, inv_gamma);
-    float g1 = powf(c1.g / 255.0f, inv_gamma);
-    float b1 = powf(c1.b / 255.0f, inv_gamma);
+    // The eased slope peaks at twice the linear one
+    int64_t interval = (delta > 0) ? duration / (2 * delta) : duration;
 
-    float r = (r0 + gain * (r1 - r0)) * brightness_factor;
-    float g = (g0 + gain * (g1 - g0)) * brightness_factor;
-    float b = (b0 + gain * (b1 - b0)) * brightness_factor;
+    return MAX(interval, RGBLED_FRAME_MS);
+}
 
-    r = powf(r, gamma);
-    g = powf(g, gamma);
-    b = powf(b, gamma);
+// Returns true if the sequence shows a single color forever when repeated
+// (event sequences are not repeated, they return to the state sequence)
+static bool seq_is_constant(const rgbled_seq_t *seq)
+{
+    if (seq->duration == 0) {
+        return true;
+    }
 
-    struct led_rgb color;
-    color.r = (uint8_t)(CLAMP(r, 0.0f, 1.0f) * 255.0f);
-    color.g = (uint8_t)(CLAMP(g, 0.0f, 1.0f) * 255.0f);
-    color.b = (uint8_t)(CLAMP(b, 0.0f, 1.0f) * 255.0f);
+    for (const rgbled_seq_t *item = seq; item->duration != 0; item++) {
+        if (item->duration < 0 || led_rgb_cmp(item->color, seq->color) != 0) {
+            return false;
+        }
+    }
 
-    return color;
+    return true;
 }
 
 static void rgbled_thread(void *p1, void *p2, void *p3)
@@ -138,6 +217,7 @@ static void rgbled_thread(void *p1, void *p2, void *p3)
 
     int64_t start_time = k_uptime_get();
     int64_t end_time = k_uptime_get();
+    int64_t interval = RGBLED_FRAME_MS;
 
     for (;;) {
         int64_t now = k_uptime_get();
@@ -147,23 +227,42 @@ static void rgbled_thread(void *p1, void *p2, void *p3)
         k_mutex_unlock(&drv->mutex);
 
         if (now >= end_time) {
+            // State sequence (re)started from its first step
+            bool state_start = false;
+
             // No sequence or end of sequence reached?
             if (seq == NULL || seq->duration == 0) {
                 k_mutex_lock(&drv->mutex, K_FOREVER);
-                if (drv->sync.ev_seq != NULL) {
+                const rgbled_seq_t *ev_seq = drv->sync.ev_seq;
+                drv->sync.ev_seq = NULL;
+
+                if (ev_seq != NULL && ev_seq->duration != 0) {
                     // If there is an event sequence, use it
-                    seq = drv->sync.ev_seq;
-                    drv->sync.ev_seq = NULL;
+                    // (an empty one just returns to the state sequence)
+                    seq = ev_seq;
                 } else if (drv->sync.state_seq != NULL) {
                     // If there is a state sequence, use it
                     seq = drv->sync.state_seq;
+                    state_start = true;
                 } else {
                     seq = NULL;
                 }
                 k_mutex_unlock(&drv->mutex);
             }
 
-            if (seq != NULL) {
+            if (seq == NULL) {
+                start_color = COLOR_OFF;
+                end_color = COLOR_OFF;
+                start_time = now;
+                end_time = RGBLED_TIME_FOREVER;
+            } else if (state_start && seq_is_constant(seq)) {
+                // Nothing to animate, sleep until the state changes
+                start_color = seq->color;
+                end_color = seq->color;
+                start_time = now;
+                end_time = RGBLED_TIME_FOREVER;
+                seq = NULL;
+            } else {
                 start_color = seq->color;
                 start_time = now;
 
@@ -173,14 +272,10 @@ static void rgbled_thread(void *p1, void *p2, void *p3)
                 } else {
                     end_color = seq[1].color;
                     end_time = start_time - seq->duration;
+                    interval = transition_interval(start_color, end_color, -seq->duration);
                 }
 
                 ++seq;
-            } else {
-                start_color = COLOR_OFF;
-                end_color = COLOR_OFF;
-                start_time = now;
-                end_time = now + 100;
             }
         }
 
@@ -192,7 +287,20 @@ static void rgbled_thread(void *p1, void *p2, void *p3)
             led_strip_update_rgb(strip, &color, 1);
         }
 
-        k_sleep(K_MSEC(MIN(end_time - now, 20)));
+        k_timeout_t timeout;
+        if (end_time == RGBLED_TIME_FOREVER) {
+            timeout = K_FOREVER;
+        } else if (led_rgb_cmp(start_color, end_color) == 0) {
+            // Holding a color, wake up at the next keyframe
+            timeout = K_MSEC(end_time - now);
+        } else {
+            timeout = K_MSEC(MIN(end_time - now, interval));
+        }
+
+        if (k_sem_take(&drv->wakeup, timeout) == 0 && end_time == RGBLED_TIME_FOREVER) {
+            // Woken up while showing a constant color, pick the new sequence
+            end_time = k_uptime_get();
+        }
     }
 }
 
@@ -203,6 +311,8 @@ void rgbled_set_state(const rgbled_seq_t *seq)
     k_mutex_lock(&drv->mutex, K_FOREVER);
     drv->sync.state_seq = seq;
     k_mutex_unlock(&drv->mutex);
+
+    k_sem_give(&drv->wakeup);
 }
 
 void rgbled_set_event(const rgbled_seq_t *seq)
@@ -212,4 +322,6 @@ void rgbled_set_event(const rgbled_seq_t *seq)
     k_mutex_lock(&drv->mutex, K_FOREVER);
     drv->sync.ev_seq = seq;
     k_mutex_unlock(&drv->mutex);
+
+    k_sem_give(&drv->wakeup);
 }
@@ -75,4 +75,51 @@ const rgbled_seq_t led_seq_ready[] = {
 const rgbled_seq_t led_seq_idle[] = {
     {0, COLOR_WHITE},
 };
+
+static const rgbled_seq_t led_seq_profile_1[] = {
+    {200, COLOR_OFF},
+    {150, COLOR_PURPLE},
+    {300, COLOR_OFF},
+    {0},
+};
+
+static const rgbled_seq_t led_seq_profile_2[] = {
+    {200, COLOR_OFF},
+    {150, COLOR_PURPLE},
+    {150, COLOR_OFF},
+    {150, COLOR_PURPLE},
+    {300, COLOR_OFF},
+    {0},
+};
+
+static const rgbled_seq_t led_seq_profile_3[] = {
+    {200, COLOR_OFF},
+    {150, COLOR_PURPLE},
+    {150, COLOR_OFF},
+    {150, COLOR_PURPLE},
+    {150, COLOR_OFF},
+    {150, COLOR_PURPLE},
+    {300, COLOR_OFF},
+    {0},
+};
+
+static const rgbled_seq_t led_seq_profile_4[] = {
+    {200, COLOR_OFF},
+    {150, COLOR_PURPLE},
+    {150, COLOR_OFF},
+    {150, COLOR_PURPLE},
+    {150, COLOR_OFF},
+    {150, COLOR_PURPLE},
+    {150, COLOR_OFF},
+    {150, COLOR_PURPLE},
+    {300, COLOR_OFF},
+    {0},
+};
+
+const rgbled_seq_t *const led_seq_profile[4] = {
+    led_seq_profile_1,
+    led_seq_profile_2,
+    led_seq_profile_3,
+    led_seq_profile_4,
+};
 // clang-format on
@@ -30,3 +30,6 @@ extern const rgbled_seq_t led_seq_pairing[];
 extern const rgbled_seq_t led_seq_connecting[];
 extern const rgbled_seq_t led_seq_ready[];
 extern const rgbled_seq_t led_seq_idle[];
+
+// Blinks the profile number (1..4) after a profile switch
+extern const rgbled_seq_t *const led_seq_profile[4];
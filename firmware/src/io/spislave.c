@@ -15,20 +15,276 @@
  * You should have received a copy of the GNU General Public License
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
+#include <string.h>
 
 #include <zephyr/kernel.h>
 #include <zephyr/device.h>
 #include <zephyr/logging/log.h>
 #include <zephyr/drivers/spi.h>
+#include <zephyr/drivers/gpio.h>
+
+#include <event/event_bus.h>
+#include <event/event_queue.h>
+#include <workq/workq.h>
+#include <btjp/btjp_msg.h>
+#include <btjp/btjp.h>
+
+#include "spislave.h"
 
 LOG_MODULE_DECLARE(blue2joy, CONFIG_LOG_DEFAULT_LEVEL);
 
+// btjp transport for the Atari configuration program (see atari/src/btjp.h
+// for the framing). The Atari is the SPI master and polls the slave; every
+// transaction carries length-prefixed messages in both directions:
+//
+//   master -> slave:  [N][N bytes message] 00 00 ...
+//   slave -> master:  [M1][M1 bytes message][M2][M2 bytes message] ... 00
+//
+// The stream sent to the master is prepared in advance. When a transaction
+// ends, the messages clocked out completely are dropped from it, the received
+// request is processed and the response and pending events are appended.
+// While the stream is being updated the SPIS has no buffer armed and sends
+// the default character (0xFF), the master then repeats its request.
+//
+// Define SPI_SLAVE_LOOPBACK to echo 32-byte blocks instead
+// (used by the Atari spibench.xex).
+
 static const struct device *spi_dev = DEVICE_DT_GET(DT_NODELABEL(spi1));
 
+// MISO is shared with the D3 joystick output
+static const struct gpio_dt_spec joy_d3 = GPIO_DT_SPEC_GET(DT_ALIAS(joy_d3), gpios);
+
+// Maximum size of a single message (incl. header)
+#define SPI_SLAVE_MAX_MSG_SIZE 254
+
+// Maximum number of messages sent in one transaction
+// (must match BTJP_LINK_BATCH on the Atari side)
+#define SPI_SLAVE_BATCH 8
+
+// Size of the stream buffers. The receive buffer has the same size, so
+// the number of received bytes equals the number of bytes clocked out.
+#define SPI_SLAVE_BUF_SIZE 1024
+
+// Size of a single transfer (must match the Atari benchmark block size)
+#define SPI_SLAVE_BLOCK_SIZE 32
+
+typedef struct {
+    // Outgoing stream ([M][message]...) without the terminating zero
+    uint8_t tx_data[SPI_SLAVE_BUF_SIZE];
+    size_t tx_len;
+    // Number of messages in the outgoing stream
+    uint8_t tx_count;
+
+    uint8_t rx_data[SPI_SLAVE_BUF_SIZE];
+
+    // Result of the last transaction (set by the SPI callback)
+    int result;
+
+    workq_work_t work;
+
+    // Event queue of the session (valid once the session is open)
+    event_queue_t evq;
+    bool open;
+
+} spi_slave_t;
+
+static spi_slave_t g_spi_slave;
+
+// Session whose request is processed by the current thread
+// (see the same in btsvc.c)
+static __thread spi_slave_t *request_origin = NULL;
+
 static int spi_slave_continue(void);
 
+static void spi_callback(const struct device *dev, int result, void *data)
+{
+    spi_slave_t *slave = (spi_slave_t *)data;
+
+    // Stream is updated and the SPIS re-armed outside of the ISR
+    slave->result = result;
+    workq_submit(&slave->work);
+}
+
+// Called from when a new event occurs on event bus
+// (invoked from arbitrary thread context)
+static void event_callback(void *context, const event_t *ev)
+{
+    spi_slave_t *slave = (spi_slave_t *)context;
+
+    if (slave == request_origin &&
+        (ev->subject == EV_SUBJECT_PROFILE || ev->subject == EV_SUBJECT_DEV_LIST)) {
+        // Echo of the session's own configuration change
+        return;
+    }
+
+    // Sent after the next transaction
+    event_queue_push(&slave->evq, ev);
+}
+
+// Opens the session or restarts it if the master was restarted
+// (the master always starts with GET_API_VERSION)
+static void session_start(spi_slave_t *slave)
+{
+    if (!slave->open) {
+        if (event_queue_init(&slave->evq) != 0) {
+            LOG_ERR("Failed to create event queue");
+            return;
+        }
+
+        int err = event_bus_subscribe(event_callback, slave);
+        if (err) {
+            LOG_ERR("Failed to subscribe to event bus {err: %d}", err);
+            return;
+        }
+
+        slave->open = true;
+        LOG_INF("SPI session opened");
+    } else {
+        // Drop the state sent to the previous instance
+        event_t ev;
+        while (event_queue_pop(&slave->evq, &ev)) {
+        }
+        event_queue_take_resync(&slave->evq);
+        event_queue_take_reset(&slave->evq);
+    }
+
+    slave->tx_len = 0;
+    slave->tx_count = 0;
+
+    btjp_populate_event_queue(&slave->evq);
+}
+
+// Drops messages the master has completely read
+static void tx_consume(spi_slave_t *slave, size_t clocked)
+{
+    size_t pos = 0;
+    uint8_t count = 0;
+
+    while (pos < slave->tx_len) {
+        size_t end = pos + 1 + slave->tx_data[pos];
+        if (end > clocked) {
+            break;
+        }
+        pos = end;
+        count++;
+    }
+
+    memmove(slave->tx_data, &slave->tx_data[pos], slave->tx_len - pos);
+    slave->tx_len -= pos;
+    slave->tx_count -= count;
+}
+
+// Returns a pointer to the space for a new message
+// or NULL if the stream is full
+static uint8_t *tx_reserve(spi_slave_t *slave)
+{
+    // Leave room for the length byte and the terminating zero
+    if (slave->tx_count >= SPI_SLAVE_BATCH ||
+        slave->tx_len + 2 + SPI_SLAVE_MAX_MSG_SIZE > SPI_SLAVE_BUF_SIZE) {
+        return NULL;
+    }
+
+    return &slave->tx_data[slave->tx_len + 1];
+}
+
+static void tx_commit(spi_slave_t *slave, size_t size)
+{
+    if (size == 0) {
+        return;
+    }
+
+    slave->tx_data[slave->tx_len] = size;
+    slave->tx_len += 1 + size;
+    slave->tx_count++;
+}
+
+// Processes the request received in the last transaction
+static void handle_request(spi_slave_t *slave, size_t received)
+{
+    if (received < 1 + sizeof(btjp_msg_header_t)) {
+        // Poll without a request
+        return;
+    }
+
+    size_t msg_size = slave->rx_data[0];
+    const btjp_msg_header_t *hdr = (const btjp_msg_header_t *)&slave->rx_data[1];
+
+    if (msg_size < sizeof(btjp_msg_header_t) || msg_size > SPI_SLAVE_MAX_MSG_SIZE ||
+        1 + msg_size > received || sizeof(*hdr) + hdr->size != msg_size) {
+        // Not a request (e.g. zeros clocked while reading events)
+        return;
+    }
+
+    if (hdr->msg_id == BTJP_MSG_GET_API_VERSION) {
+        session_start(slave);
+    }
+
+    uint8_t *tx_buf = tx_reserve(slave);
+    if (tx_buf == NULL) {
+        // Cannot happen with an empty stream after the session start,
+        // the master gets a timeout otherwise
+        LOG_WRN("SPI stream full, request dropped {msg_id: %d}", hdr->msg_id);
+        return;
+    }
+
+    request_origin = (hdr->flags & BTJP_MSG_FLAG_ECHO) ? NULL : slave;
+
+    size_t tx_size =
+        btjp_handle_message(hdr, msg_size, tx_buf, SPI_SLAVE_MAX_MSG_SIZE, &slave->evq);
+
+    request_origin = NULL;
+
+    tx_commit(slave, tx_size);
+}
+
+// Appends pending events to the outgoing stream
+static void append_events(spi_slave_t *slave)
+{
+    if (!slave->open) {
+        return;
+    }
+
+    uint8_t *tx_buf;
+
+    while ((tx_buf = tx_reserve(slave)) != NULL) {
+        size_t tx_size = btjp_build_evt_message(tx_buf, SPI_SLAVE_MAX_MSG_SIZE, &slave->evq);
+        if (tx_size == 0) {
+            // Nothing to send
+            break;
+        }
+        tx_commit(slave, tx_size);
+    }
+}
+
+static void work_handler(workq_work_t *work)
+{
+    spi_slave_t *slave = CONTAINER_OF(work, spi_slave_t, work);
+
+    if (slave->result < 0) {
+        LOG_ERR("SPI transfer failed {err: %d}", slave->result);
+    } else {
+#ifdef SPI_SLAVE_LOOPBACK
+        // Echo the received block back in the next transfer
+        memcpy(slave->tx_data, slave->rx_data, SPI_SLAVE_BLOCK_SIZE);
+#else
+        size_t received = slave->result;
+        tx_consume(slave, received);
+        handle_request(slave, received);
+        append_events(slave);
+#endif
+    }
+
+    spi_slave_continue();
+}
+
 int spi_slave_init(void)
 {
+    spi_slave_t *slave = &g_spi_slave;
+
+    memset(slave, 0, sizeof(spi_slave_t));
+
+    workq_init_work(&slave->work, WORKQ_PROTOCOL, work_handler);
+
     if (device_is_ready(spi_dev)) {
         // Device was already initialized
     } else {
@@ -39,6 +295,11 @@ int spi_slave_init(void)
         } else {
             LOG_INF("SPI slave initialized successfully");
         }
+
+        // The pinctrl state turns MISO into an input. The SPIS drives the pin
+        // only while CS is asserted, so the D3 output must stay configured
+        // (the output value is kept).
+        gpio_pin_configure_dt(&joy_d3, GPIO_OUTPUT);
     }
 
     return spi_slave_continue();
@@ -48,20 +309,11 @@ void spi_slave_deinit(void)
 {
 }
 
-static void spi_callback(const struct device *dev, int result, void *data)
-{
-    if (result < 0) {
-        LOG_ERR("SPI transfer failed with error: %d", result);
-    } else {
-        LOG_INF("SPI transfer completed %02x %02x %02x %02x", ((uint8_t *)data)[0],
-                ((uint8_t *)data)[1], ((uint8_t *)data)[2], ((uint8_t *)data)[3]);
-    }
-
-    spi_slave_continue();
-}
-
+// Arms the SPIS with the current outgoing stream
 static int spi_slave_continue(void)
 {
+    spi_slave_t *slave = &g_spi_slave;
+
     static const struct spi_config config = {
         .operation =
             SPI_OP_MODE_SLAVE | SPI_WORD_SET(8) | SPI_TRANSFER_MSB | SPI_MODE_CPHA | SPI_MODE_CPOL,
@@ -69,35 +321,37 @@ static int spi_slave_continue(void)
         .slave = 0,
     };
 
-    static uint8_t tx_data[4] = {0x10, 0x21, 0x32, 0x43};
-    static uint8_t rx_data[4] = {0};
-
-    tx_data[0] = 0x55;
-    tx_data[1] = 0x55;
-    tx_data[2] = 0x55;
-    tx_data[3] = 0x00;
+#ifdef SPI_SLAVE_LOOPBACK
+    size_t tx_len = SPI_SLAVE_BLOCK_SIZE;
+    size_t rx_len = SPI_SLAVE_BLOCK_SIZE;
+#else
+    // Zero length terminates the stream
+    slave->tx_data[slave->tx_len] = 0;
+    size_t tx_len = slave->tx_len + 1;
+    size_t rx_len = sizeof(slave->rx_data);
+#endif
 
-    static const struct spi_buf tx_buf = {
-        .buf = tx_data,
-        .len = sizeof(tx_data),
+    const struct spi_buf tx_buf = {
+        .buf = slave->tx_data,
+        .len = tx_len,
     };
 
-    static const struct spi_buf rx_buf = {
-        .buf = rx_data,
-        .len = sizeof(rx_data),
+    const struct spi_buf rx_buf = {
+        .buf = slave->rx_data,
+        .len = rx_len,
     };
 
-    static const struct spi_buf_set tx_bufs = {
+    const struct spi_buf_set tx_bufs = {
         .buffers = &tx_buf,
         .count = 1,
     };
 
-    static const struct spi_buf_set rx_bufs = {
+    const struct spi_buf_set rx_bufs = {
         .buffers = &rx_buf,
         .count = 1,
     };
 
-    int err = spi_transceive_cb(spi_dev, &config, &tx_bufs, &rx_bufs, spi_callback, rx_data);
+    int err = spi_transceive_cb(spi_dev, &config, &tx_bufs, &rx_bufs, spi_callback, slave);
 
     if (err < 0) {
         LOG_ERR("SPI transceive failed {err: %d}", err);
@@ -19,4 +19,6 @@
 
 #pragma once
 
+// Initializes the btjp transport on the joystick port SPI slave
+// (used by the Atari configuration program)
 int spi_slave_init(void);
@@ -25,6 +25,7 @@
 
 #include <bthid/bthid.h>
 #include <btsvc/btsvc.h>
+#include <usbsvc/usbsvc.h>
 #include <io/buttons.h>
 #include <io/rgbled_seq.h>
 #include <io/io_pin.h>
@@ -34,6 +35,9 @@
 #include <mapper/profiles.h>
 #include <devmgr/devmgr.h>
 #include <event/event_bus.h>
+#include <persist/persist.h>
+#include <workq/workq.h>
+#include <sysmon/sysmon.h>
 
 LOG_MODULE_REGISTER(blue2joy);
 
@@ -75,6 +79,10 @@ static void event_callback(void *context, const event_t *ev)
         }
     } else if (ev->subject == EV_SUBJECT_CONN_ERROR) {
         rgbled_set_event(led_seq_error);
+    } else if (ev->subject == EV_SUBJECT_ACTIVE_PROFILE && ev->action == EV_ACTION_UPDATE) {
+        if (ev->idx < ARRAY_SIZE(led_seq_profile)) {
+            rgbled_set_event(led_seq_profile[ev->idx]);
+        }
     }
 }
 
@@ -108,6 +116,12 @@ int main(void)
         return 0;
     }
 
+    err = workq_init();
+    if (err) {
+        LOG_ERR("Work queues init failed {err: %d}", err);
+        return 0;
+    }
+
     err = event_bus_subscribe(event_callback, NULL);
     if (err) {
         LOG_ERR("Event bus subscribe failed {err: %d}", err);
@@ -126,6 +140,12 @@ int main(void)
         return 0;
     }
 
+    err = persist_init();
+    if (err) {
+        LOG_ERR("Persistence layer init failed {err: %d}", err);
+        return 0;
+    }
+
     err = mapper_init();
     if (err) {
         LOG_ERR("I/O mapper init failed {err: %d}", err);
@@ -158,6 +178,23 @@ int main(void)
         return 0;
     }
 
+    err = usbsvc_init();
+    if (err) {
+        // Configuration over BLE still works
+        LOG_ERR("USB service init failed {err: %d}", err);
+    }
+
+    err = spi_slave_init();
+    if (err) {
+        // Configuration over BLE still works
+        LOG_ERR("SPI slave init failed {err: %d}", err);
+    }
+
+    err = sysmon_init();
+    if (err) {
+        LOG_ERR("System monitor init failed {err: %d}", err);
+    }
+
     devmgr_set_mode(DEVMGR_MODE_AUTO, true);
 
     return 0;
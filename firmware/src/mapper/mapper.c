@@ -20,8 +20,11 @@
 #include <zephyr/logging/log.h>
 
 #include <event/event_bus.h>
+#include <persist/persist.h>
+#include <workq/workq.h>
 
 #include "mapper.h"
+#include "program.h"
 #include "settings.h"
 
 #include <stdlib.h>
@@ -29,14 +32,22 @@
 
 LOG_MODULE_DECLARE(blue2joy, CONFIG_LOG_DEFAULT_LEVEL);
 
+// Number of steps of a normalized input value
+// (lookup tables have one more entry for the end of the range)
+#define MAPPER_LUT_STEPS MAPPER_NORM_STEPS
+
 typedef struct {
     // Last pin value
     bool value;
+    // Normalization of the source field
+    mapper_norm_t norm;
 } mapper_pin_state_t;
 
 typedef struct {
     // Last pot value (IO_POT_MIN_VAL .. IO_POT_MAX_VAL)
     uint8_t value;
+    // Normalization of the source field or integrator position
+    mapper_norm_t norm;
 } mapper_pot_state_t;
 
 typedef struct {
@@ -45,6 +56,8 @@ typedef struct {
     int32_t delta;
     // Accumulated position (Q17.14 format)
     int32_t pos;
+    // Normalization of the source field
+    mapper_norm_t norm;
 } mapper_intg_state_t;
 
 // Mapper state
@@ -52,31 +65,112 @@ typedef struct {
     mapper_pin_state_t pin[IO_PIN_COUNT];
     mapper_pot_state_t pot[IO_POT_COUNT];
     mapper_intg_state_t intg[IO_ENC_COUNT];
+    // Normalization of the fields loaded by mapping programs
+    mapper_norm_cache_t program_norms;
 } mapper_state_t;
 
+// Lookup tables compiled from the active profile,
+// indexed by the normalized input value
+typedef struct {
+    // Pin thresholds
+    int16_t pin_up[IO_PIN_COUNT];
+    int16_t pin_down[IO_PIN_COUNT];
+    // Pot values (IO_POT_MIN_VAL .. IO_POT_MAX_VAL)
+    uint8_t pot[IO_POT_COUNT][MAPPER_LUT_STEPS + 1];
+    // Integrator deltas in ABS mode (Q1.14 format, dead zone applied)
+    int16_t intg[IO_ENC_COUNT][MAPPER_LUT_STEPS + 1];
+    // Start of the mapping program expressions (-1 if not present)
+    int8_t expr[MAPPER_PROGRAM_MAX_EXPRS];
+} mapper_lut_t;
+
+// Largest report kept for change detection
+// (longer reports are always fully evaluated)
+#define MAPPER_MAX_REPORT_SIZE 64
+
+// Number of (device, report ID) pairs kept for change detection
+#define MAPPER_PREV_REPORTS 4
+
+// Last processed report of a device with a given report ID
+typedef struct {
+    // Device slot and report ID (slot -1 => free entry)
+    int slot;
+    uint8_t report_id;
+    // Value of the use counter at the last use
+    // (the least recently used entry is reused first)
+    uint32_t last_use;
+    // Report definition and profile the data were evaluated with
+    // (NULL if there is no valid previous report)
+    const hrm_report_t *report;
+    int profile_idx;
+    // Report data
+    uint8_t data[MAPPER_MAX_REPORT_SIZE];
+    size_t size;
+} mapper_prev_report_t;
+
+// Profile resident in RAM
+typedef struct {
+    // Profile index (-1 => free entry)
+    int idx;
+    // Value of the use counter at the last use
+    // (the least recently used entry is evicted first)
+    uint32_t last_use;
+    // Changed and not yet written to the flash
+    // (written before eviction by the load work, never by the report path)
+    bool dirty;
+    // Not backed by the flash (set without saving), never evicted
+    bool pinned;
+    mapper_profile_t profile;
+} mapper_cache_entry_t;
+
 typedef struct {
     struct k_mutex mutex;
 
     struct k_timer timer;
-    struct k_work tick_work;
-
-    struct k_work_delayable save_work;
+    workq_work_t tick_work;
+    // Loads prefetched profiles from the flash
+    workq_work_t load_work;
 
     struct {
-        // Stored profiles
-        mapper_profile_t profiles[MAPPER_MAX_PROFILES];
-        // Profile used for periodic updates
+        // Quick profiles and recently used ones, the rest is prefetched
+        // from the flash by the load work
+        mapper_cache_entry_t cache[MAPPER_PROFILE_CACHE_SIZE];
+        uint32_t use_counter;
+        // Profiles to be loaded by the load work
+        uint64_t prefetch;
+        // Configured profiles (stored in the flash or set since boot)
+        uint64_t configured;
+        // Profile used for periodic updates (always resident)
         int active_profile;
+        // Profile selected by a chord or button B (-1 => device profile)
+        int switched_profile;
+        // Profile of the device the switch applies to
+        int device_profile;
     } sync;
 
     // Current state
     mapper_state_t state;
+    // Lookup tables of the active profile
+    mapper_lut_t lut;
+    // Previous reports used for change detection
+    mapper_prev_report_t prev[MAPPER_PREV_REPORTS];
+    uint32_t prev_use_counter;
+    // Chord that switched the profile, reports of the device are not mapped
+    // until its button and the hat switch are released (slot -1 => none)
+    struct {
+        int slot;
+        hrm_usage_t button;
+    } chord;
+    // Report processing statistics
+    mapper_stats_t stats;
 } mapper_t;
 
 static mapper_t g_mapper;
 
-static void mapper_tick_cb(struct k_work *work);
+static void mapper_tick_cb(workq_work_t *work);
+static void mapper_load_cb(workq_work_t *work);
 static void mapper_timer_cb(struct k_timer *timer_id);
+static void mapper_compile_lut(const mapper_profile_t *profile);
+static void prev_invalidate(int slot);
 
 int mapper_init(void)
 {
@@ -86,6 +180,18 @@ int mapper_init(void)
     memset(mapper, 0, sizeof(mapper_t));
 
     mapper->sync.active_profile = -1;
+    mapper->sync.switched_profile = -1;
+    mapper->sync.device_profile = -1;
+
+    for (int i = 0; i < ARRAY_SIZE(mapper->sync.cache); i++) {
+        mapper->sync.cache[i].idx = -1;
+    }
+
+    for (int i = 0; i < ARRAY_SIZE(mapper->prev); i++) {
+        mapper->prev[i].slot = -1;
+    }
+
+    mapper->chord.slot = -1;
 
     // Initialize mutex
     int err = k_mutex_init(&mapper->mutex);
@@ -94,18 +200,268 @@ int mapper_init(void)
         return err;
     }
 
-    k_work_init(&mapper->tick_work, mapper_tick_cb);
+    workq_init_work(&mapper->tick_work, WORKQ_INPUT, mapper_tick_cb);
+    workq_init_work(&mapper->load_work, WORKQ_PERSIST, mapper_load_cb);
 
     k_timer_init(&mapper->timer, mapper_timer_cb, NULL);
     k_timer_start(&mapper->timer, K_MSEC(10), K_MSEC(10));
 
-    k_work_init_delayable(&mapper->save_work, mapper_save_settings);
+    err = mapper_settings_init();
+    if (err) {
+        LOG_ERR("Failed to register settings {err: %d}", err);
+        return err;
+    }
+
+    // Quick profiles are selected by buttons and chords,
+    // they stay resident so that the switch never waits for the flash
+    mapper->sync.prefetch = BIT64_MASK(MAPPER_QUICK_PROFILES);
+    workq_submit(&mapper->load_work);
 
     LOG_INF("Mapper initialized");
 
     return 0;
 }
 
+static bool profile_is_empty(const mapper_profile_t *profile)
+{
+    static const mapper_profile_t empty = {0};
+    return memcmp(profile, &empty, sizeof(empty)) == 0;
+}
+
+// Reads a profile from the flash, profiles never stored are empty
+static int load_profile(int idx, mapper_profile_t *profile)
+{
+    int err = mapper_settings_load(idx, profile);
+
+    if (err == -ENOENT) {
+        memset(profile, 0, sizeof(*profile));
+        return 0;
+    }
+
+    return err;
+}
+
+// Returns the resident profile or NULL if it is not in RAM
+// (or `idx` is negative, e.g. no active profile yet)
+// Requires mapper->mutex to be locked
+static mapper_cache_entry_t *cache_find(int idx)
+{
+    mapper_t *mapper = &g_mapper;
+
+    if (idx < 0) {
+        return NULL;
+    }
+
+    for (int i = 0; i < ARRAY_SIZE(mapper->sync.cache); i++) {
+        mapper_cache_entry_t *entry = &mapper->sync.cache[i];
+        if (entry->idx == idx) {
+            entry->last_use = ++mapper->sync.use_counter;
+            return entry;
+        }
+    }
+
+    return NULL;
+}
+
+// Frees the entry and clears the stale profile data
+// Requires mapper->mutex to be locked
+static void cache_free(mapper_cache_entry_t *entry)
+{
+    memset(entry, 0, sizeof(*entry));
+    entry->idx = -1;
+}
+
+// Returns true if `a` should be evicted rather than `b`
+static bool cache_evict_first(const mapper_cache_entry_t *a, const mapper_cache_entry_t *b)
+{
+    if (a->dirty != b->dirty) {
+        return !a->dirty;
+    }
+
+    return (int32_t)(a->last_use - b->last_use) < 0;
+}
+
+// Returns the entry to be reused next or NULL if there is none
+// (quick profiles, the active profile and pinned profiles are never evicted)
+// Requires mapper->mutex to be locked
+static mapper_cache_entry_t *cache_victim(void)
+{
+    mapper_t *mapper = &g_mapper;
+    mapper_cache_entry_t *victim = NULL;
+
+    for (int i = 0; i < ARRAY_SIZE(mapper->sync.cache); i++) {
+        mapper_cache_entry_t *entry = &mapper->sync.cache[i];
+        if (entry->idx < 0) {
+            return entry;
+        }
+        if (entry->idx < MAPPER_QUICK_PROFILES || entry->idx == mapper->sync.active_profile ||
+            entry->pinned) {
+            continue;
+        }
+        if (victim == NULL || cache_evict_first(entry, victim)) {
+            victim = entry;
+        }
+    }
+
+    return victim;
+}
+
+// Allocates an entry for the profile, evicting the least recently used one
+//
+// Never writes to the flash, returns NULL if only dirty profiles
+// can be evicted (see cache_flush_victim())
+// Requires mapper->mutex to be locked
+static mapper_cache_entry_t *cache_alloc(int idx)
+{
+    mapper_t *mapper = &g_mapper;
+
+    mapper_cache_entry_t *victim = cache_victim();
+
+    if (victim == NULL || (victim->idx >= 0 && victim->dirty)) {
+        return NULL;
+    }
+
+    victim->idx = idx;
+    victim->last_use = ++mapper->sync.use_counter;
+    victim->dirty = false;
+    victim->pinned = false;
+
+    return victim;
+}
+
+// Writes the dirty profile to be evicted next, so that cache_alloc()
+// can reuse its entry
+// Called from the persist or protocol work queue with mapper->mutex unlocked
+//
+// Returns 0 on success, error code otherwise
+static int cache_flush_victim(void)
+{
+    mapper_t *mapper = &g_mapper;
+
+    k_mutex_lock(&mapper->mutex, K_FOREVER);
+    mapper_cache_entry_t *victim = cache_victim();
+    int idx = (victim != NULL && victim->dirty) ? victim->idx : -1;
+    k_mutex_unlock(&mapper->mutex);
+
+    if (victim == NULL) {
+        return -ENOMEM;
+    }
+
+    if (idx < 0) {
+        return 0;
+    }
+
+    // More profiles were changed within the flush delay than fit
+    // in the cache, write the evicted one right away
+    // (the export clears the dirty flag)
+    int err = persist_save_entry(PERSIST_GROUP_PROFILE, idx);
+    if (err) {
+        LOG_ERR("Failed to save evicted profile {idx: %d, err: %d}", idx, err);
+    }
+
+    return err;
+}
+
+// Makes the profile resident, reading it from the flash if needed
+// Called from the persist or protocol work queue with mapper->mutex unlocked,
+// the report path only uses resident profiles
+//
+// Returns 0 on success, error code otherwise
+static int cache_fetch(int idx)
+{
+    mapper_t *mapper = &g_mapper;
+
+    k_mutex_lock(&mapper->mutex, K_FOREVER);
+    bool resident = cache_find(idx) != NULL;
+    k_mutex_unlock(&mapper->mutex);
+
+    if (resident) {
+        return 0;
+    }
+
+    // Read without the mutex, reports are mapped in the meantime
+    mapper_profile_t profile;
+
+    int err = load_profile(idx, &profile);
+    if (err) {
+        LOG_ERR("Failed to load profile {idx: %d, err: %d}", idx, err);
+        return err;
+    }
+
+    for (int attempt = 0; attempt < 2; attempt++) {
+        k_mutex_lock(&mapper->mutex, K_FOREVER);
+
+        // Set by another thread while reading from the flash
+        mapper_cache_entry_t *entry = cache_find(idx);
+
+        if (entry == NULL) {
+            entry = cache_alloc(idx);
+            if (entry != NULL) {
+                entry->profile = profile;
+                mapper->stats.cache_loads++;
+            }
+        }
+
+        k_mutex_unlock(&mapper->mutex);
+
+        if (entry != NULL) {
+            return 0;
+        }
+
+        err = cache_flush_victim();
+        if (err) {
+            break;
+        }
+    }
+
+    LOG_ERR("No evictable profile in the cache {idx: %d}", idx);
+    return -ENOMEM;
+}
+
+// Requests loading of the profile by the load work
+// Requires mapper->mutex to be locked
+static void prefetch_locked(int idx)
+{
+    mapper_t *mapper = &g_mapper;
+
+    if ((mapper->sync.prefetch & BIT64(idx)) == 0) {
+        mapper->sync.prefetch |= BIT64(idx);
+        workq_submit(&mapper->load_work);
+    }
+}
+
+void mapper_prefetch_profile(int idx)
+{
+    mapper_t *mapper = &g_mapper;
+
+    if (idx < 0 || idx >= MAPPER_MAX_PROFILES) {
+        return;
+    }
+
+    k_mutex_lock(&mapper->mutex, K_FOREVER);
+    if (cache_find(idx) == NULL) {
+        prefetch_locked(idx);
+    }
+    k_mutex_unlock(&mapper->mutex);
+}
+
+static void mapper_load_cb(workq_work_t *work)
+{
+    mapper_t *mapper = &g_mapper;
+
+    k_mutex_lock(&mapper->mutex, K_FOREVER);
+    uint64_t pending = mapper->sync.prefetch;
+    mapper->sync.prefetch = 0;
+    k_mutex_unlock(&mapper->mutex);
+
+    for (int idx = 0; idx < MAPPER_MAX_PROFILES; idx++) {
+        if ((pending & BIT64(idx)) != 0) {
+            // A failed load is requested again by the next report
+            cache_fetch(idx);
+        }
+    }
+}
+
 int mapper_get_profile(int idx, mapper_profile_t *profile)
 {
     mapper_t *mapper = &g_mapper;
@@ -115,13 +471,79 @@ int mapper_get_profile(int idx, mapper_profile_t *profile)
     }
 
     k_mutex_lock(&mapper->mutex, K_FOREVER);
-    *profile = mapper->sync.profiles[idx];
+    mapper_cache_entry_t *entry = cache_find(idx);
+    if (entry != NULL) {
+        *profile = entry->profile;
+    }
     k_mutex_unlock(&mapper->mutex);
 
-    return 0;
+    // Not cached, so that listing the library doesn't evict
+    // the recently used profiles
+    return entry != NULL ? 0 : load_profile(idx, profile);
 }
 
-static void mapper_publish_io_state(void)
+int mapper_export_profile(int idx, mapper_profile_t *profile)
+{
+    mapper_t *mapper = &g_mapper;
+
+    k_mutex_lock(&mapper->mutex, K_FOREVER);
+    mapper_cache_entry_t *entry = cache_find(idx);
+    if (entry != NULL) {
+        *profile = entry->profile;
+        entry->dirty = false;
+    }
+    k_mutex_unlock(&mapper->mutex);
+
+    return entry != NULL ? 0 : load_profile(idx, profile);
+}
+
+void mapper_profile_stored(int idx)
+{
+    mapper_t *mapper = &g_mapper;
+
+    k_mutex_lock(&mapper->mutex, K_FOREVER);
+
+    mapper->sync.configured |= BIT64(idx);
+
+    // The stored profile replaces the one set without saving
+    mapper_cache_entry_t *entry = cache_find(idx);
+    if (entry != NULL && !entry->dirty && idx != mapper->sync.active_profile) {
+        cache_free(entry);
+        if (idx < MAPPER_QUICK_PROFILES) {
+            prefetch_locked(idx);
+        }
+    }
+
+    k_mutex_unlock(&mapper->mutex);
+}
+
+bool mapper_profile_exists(int idx)
+{
+    mapper_t *mapper = &g_mapper;
+
+    if (idx < 0 || idx >= MAPPER_MAX_PROFILES) {
+        return false;
+    }
+
+    k_mutex_lock(&mapper->mutex, K_FOREVER);
+    bool exists = idx < MAPPER_QUICK_PROFILES || (mapper->sync.configured & BIT64(idx)) != 0;
+    k_mutex_unlock(&mapper->mutex);
+
+    return exists;
+}
+
+int mapper_next_profile(int idx)
+{
+    for (; idx >= 0 && idx < MAPPER_MAX_PROFILES; idx++) {
+        if (mapper_profile_exists(idx)) {
+            return idx;
+        }
+    }
+
+    return -ENOENT;
+}
+
+void mapper_get_io_state(event_io_t *io)
 {
     mapper_t *mapper = &g_mapper;
 
@@ -129,24 +551,31 @@ static void mapper_publish_io_state(void)
 
     mapper_state_t *state = &mapper->state;
 
-    event_t ev = {
-        .subject = EV_SUBJECT_IO_STATE,
-        .action = EV_ACTION_UPDATE,
-    };
+    memset(io, 0, sizeof(event_io_t));
 
     // Gather pin states
     for (int i = 0; i < IO_PIN_COUNT; i++) {
         if (state->pin[i].value) {
-            ev.io.pins |= (1 << i);
+            io->pins |= (1 << i);
         }
     }
 
     // Gather pot states
     for (int i = 0; i < IO_POT_COUNT; i++) {
-        ev.io.pots[i] = state->pot[i].value;
+        io->pots[i] = state->pot[i].value;
     }
 
     k_mutex_unlock(&mapper->mutex);
+}
+
+static void mapper_publish_io_state(void)
+{
+    event_t ev = {
+        .subject = EV_SUBJECT_IO_STATE,
+        .action = EV_ACTION_UPDATE,
+    };
+
+    mapper_get_io_state(&ev.io);
 
     event_bus_publish(&ev);
 }
@@ -164,6 +593,9 @@ static void reconfigure_io_pins(const mapper_profile_t *profile)
             io_config.mode = IO_PIN_MODE_ENCODER;
             io_config.enc_idx = HRM_USAGE_GET_INTG_IDX(pin_config->source);
             io_config.enc_phase = HRM_USAGE_GET_INTG_PHASE(pin_config->source);
+        } else if (pin_config->autofire > 0) {
+            io_config.mode = IO_PIN_MODE_AUTOFIRE;
+            io_config.autofire_frames = pin_config->autofire;
         };
         io_pin_configure(i, &io_config);
     }
@@ -177,21 +609,56 @@ int mapper_set_profile(int idx, const mapper_profile_t *profile, bool save)
         return -EINVAL;
     }
 
+    if (mapper_program_validate(&profile->program) < 0) {
+        LOG_ERR("Invalid mapping program in profile #%d", idx);
+        return -EINVAL;
+    }
+
     bool changed = false;
 
+    // Loaded for the comparison below, outside the mutex
+    int err = cache_fetch(idx);
+    if (err) {
+        return err;
+    }
+
     k_mutex_lock(&mapper->mutex, K_FOREVER);
 
-    mapper_profile_t *stored_profile = &mapper->sync.profiles[idx];
-    if (memcmp(stored_profile, profile, sizeof(*profile)) != 0) {
-        *stored_profile = *profile;
+    mapper_cache_entry_t *entry = cache_find(idx);
+    if (entry == NULL) {
+        // Evicted in the meantime
+        k_mutex_unlock(&mapper->mutex);
+        return -EAGAIN;
+    }
+
+    if (memcmp(&entry->profile, profile, sizeof(*profile)) != 0) {
+        entry->profile = *profile;
         changed = true;
     }
 
+    // Profiles set without saving stay in RAM
+    if (save) {
+        entry->dirty |= changed;
+        entry->pinned = false;
+    } else {
+        entry->pinned = true;
+    }
+
+    if (profile_is_empty(profile)) {
+        mapper->sync.configured &= ~BIT64(idx);
+    } else {
+        mapper->sync.configured |= BIT64(idx);
+    }
+
     if (changed) {
         if (idx == mapper->sync.active_profile) {
             reconfigure_io_pins(profile);
+            mapper_compile_lut(profile);
         }
 
+        // Force full evaluation of the next reports
+        prev_invalidate(-1);
+
         event_t ev = {
             .subject = EV_SUBJECT_PROFILE,
             .action = EV_ACTION_UPDATE,
@@ -203,8 +670,7 @@ int mapper_set_profile(int idx, const mapper_profile_t *profile, bool save)
     k_mutex_unlock(&mapper->mutex);
 
     if (save && changed) {
-        LOG_INF("Scheduling profile settings save");
-        k_work_reschedule(&mapper->save_work, K_SECONDS(3));
+        persist_mark_dirty(PERSIST_GROUP_PROFILE, idx);
     }
 
     return 0;
@@ -220,15 +686,92 @@ static int32_t map_linear(int32_t value, int32_t in_min, int32_t in_max, int32_t
     return out_min + (value - in_min) * (out_max - out_min) / (in_max - in_min);
 }
 
-static bool update_pin_state(mapper_pin_state_t *state, const mapper_pin_config_t *config,
-                             const hrm_report_t *report, const uint8_t *data)
+// Evaluates the response curve for the deflection `t` (0..16384, Q1.14 format)
+//
+// Returns the output deflection in Q1.14 format
+static int32_t curve_eval(const mapper_curve_t *curve, int32_t t)
 {
-    const hrm_field_t *field = hrm_report_find_field(report, config->source);
+    // Parameters are validated when the profile is set,
+    // clamped here so that the result always fits the LUT
+    int32_t amount = MIN(curve->amount, MAPPER_CURVE_MAX);
+
+    switch (curve->type) {
+    case MAPPER_CURVE_EXPO: {
+        // Blend of t and t^3
+        int32_t t3 = (((t * t) >> 14) * t) >> 14;
+        return t + (t3 - t) * amount / 100;
+    }
 
-    if (field == NULL) {
-        return false;
+    case MAPPER_CURVE_S: {
+        // Blend of t and 1 - (1 - t)^3
+        int32_t u = 16384 - t;
+        int32_t u3 = (((u * u) >> 14) * u) >> 14;
+        return t + (16384 - u3 - t) * amount / 100;
+    }
+
+    case MAPPER_CURVE_CUSTOM: {
+        // Segments of 25 % deflection, the first one starts at 0
+        int seg = MIN(t >> 12, MAPPER_CURVE_POINTS - 1);
+        int32_t y0 = seg > 0 ? MIN(curve->points[seg - 1], MAPPER_CURVE_MAX) : 0;
+        int32_t y1 = MIN(curve->points[seg], MAPPER_CURVE_MAX);
+        int32_t frac = t - (seg << 12);
+        return (y0 * 4096 + (y1 - y0) * frac) * 4 / 100;
+    }
+
+    default:
+        return t;
+    }
+}
+
+// Deflection from the center (-16384..16384, Q1.14 format)
+// for the normalized input value
+static int32_t lut_deflection(int step)
+{
+    return (step - MAPPER_LUT_STEPS / 2) * (32768 / MAPPER_LUT_STEPS);
+}
+
+// Compiles the lookup tables used by the report processing
+// Requires mapper->mutex to be locked
+static void mapper_compile_lut(const mapper_profile_t *profile)
+{
+    mapper_lut_t *lut = &g_mapper.lut;
+
+    for (int i = 0; i < IO_PIN_COUNT; i++) {
+        const mapper_pin_config_t *config = &profile->pin[i];
+        lut->pin_up[i] = (config->threshold + config->hysteresis) * MAPPER_LUT_STEPS / 100;
+        lut->pin_down[i] = (config->threshold - config->hysteresis) * MAPPER_LUT_STEPS / 100;
+    }
+
+    for (int i = 0; i < IO_POT_COUNT; i++) {
+        const mapper_pot_config_t *config = &profile->pot[i];
+        for (int step = 0; step <= MAPPER_LUT_STEPS; step++) {
+            int32_t x = lut_deflection(step);
+            int32_t y = curve_eval(&config->curve, abs(x));
+            int32_t out = map_linear(x < 0 ? -y : y, -16384, 16384, config->low, config->high);
+            lut->pot[i][step] = CLAMP(out, IO_POT_MIN_VAL, IO_POT_MAX_VAL);
+        }
     }
 
+    for (int i = 0; i < IO_ENC_COUNT; i++) {
+        const mapper_intg_config_t *config = &profile->intg[i];
+        int32_t dead_zone = (config->dead_zone * 16384) / 100;
+        for (int step = 0; step <= MAPPER_LUT_STEPS; step++) {
+            int32_t x = lut_deflection(step);
+            int32_t y = abs(x) <= dead_zone ? 0 : curve_eval(&config->curve, abs(x));
+            lut->intg[i][step] = x < 0 ? -y : y;
+        }
+    }
+
+    for (int i = 0; i < MAPPER_PROGRAM_MAX_EXPRS; i++) {
+        int start = mapper_program_find_expr(&profile->program, i);
+        lut->expr[i] = start >= 0 ? start : -1;
+    }
+}
+
+static bool update_pin_state(mapper_pin_state_t *state, const mapper_pin_config_t *config,
+                             int16_t threshold_up, int16_t threshold_down,
+                             const hrm_field_t *field, const uint8_t *data)
+{
     int32_t in = hrm_field_extract(field, data);
     bool out = config->invert ? !state->value : state->value;
 
@@ -237,32 +780,12 @@ static bool update_pin_state(mapper_pin_state_t *state, const mapper_pin_config_
         out = in != 0;
     } else if (field->usage == HRM_USAGE_HAT_SWITCH) {
         // Hat switch field, with logical min 0 and max 8
-        static const uint8_t hat_lookup[8] = {
-            [0] = HAT_SWITCH_UP,    [1] = HAT_SWITCH_UP | HAT_SWITCH_RIGHT,
-            [2] = HAT_SWITCH_RIGHT, [3] = HAT_SWITCH_DOWN | HAT_SWITCH_RIGHT,
-            [4] = HAT_SWITCH_DOWN,  [5] = HAT_SWITCH_DOWN | HAT_SWITCH_LEFT,
-            [6] = HAT_SWITCH_LEFT,  [7] = HAT_SWITCH_UP | HAT_SWITCH_LEFT,
-        };
-
-        in -= field->logical_min;
-        if (in < sizeof(hat_lookup)) {
-            // Hat switch value is in range 0-7
-            // Check if the bitmask matches the configured hat switch
-            out = (hat_lookup[in] & config->hat_switch) != 0;
-        } else {
-            // Out of range, treat as inactive
-            out = false;
-        }
+        // Check if the bitmask matches the configured hat switch
+        out = (mapper_hat_mask(in - field->logical_min) & config->hat_switch) != 0;
     } else {
-        // Numeric field
+        // Numeric field, thresholds are precomputed in normalized units
         // TODO: negative values handling
-        in = CLAMP(in, field->logical_min, field->logical_max);
-
-        int32_t threshold_up = map_linear(config->threshold + config->hysteresis, 0, 100,
-                                          field->logical_min, field->logical_max);
-
-        int32_t threshold_down = map_linear(config->threshold - config->hysteresis, 0, 100,
-                                            field->logical_min, field->logical_max);
+        in = mapper_normalize(&state->norm, field->logical_min, field->logical_max, in);
 
         if (in > threshold_up) {
             out = true;
@@ -277,23 +800,40 @@ static bool update_pin_state(mapper_pin_state_t *state, const mapper_pin_config_
     return prev_value != state->value;
 }
 
-static bool update_pot_state(mapper_pot_state_t *state, const mapper_pot_config_t *config,
-                             const hrm_report_t *report, const uint8_t *data)
+// Updates pin state from a usage selected by an array field (e.g. a key)
+static bool update_pin_state_direct(mapper_pin_state_t *state, const mapper_pin_config_t *config,
+                                    bool active)
+{
+    bool prev_value = state->value;
+    state->value = config->invert ? !active : active;
+
+    return prev_value != state->value;
+}
+
+// Updates pin state from a mapping program expression
+static bool update_pin_state_expr(mapper_pin_state_t *state, const mapper_pin_config_t *config,
+                                  const uint8_t *code, mapper_program_env_t *env)
 {
-    const hrm_field_t *field = hrm_report_find_field(report, config->source);
+    bool prev_out = config->invert ? !state->value : state->value;
 
-    if (field == NULL) {
+    int result = mapper_program_eval(code, env, prev_out);
+    if (result < 0) {
+        // None of the expression sources is in this report
         return false;
     }
 
-    int32_t in = hrm_field_extract(field, data);
+    return update_pin_state_direct(state, config, result != 0);
+}
 
-    in = CLAMP(in, field->logical_min, field->logical_max);
+static bool update_pot_state(mapper_pot_state_t *state, const uint8_t *lut,
+                             const hrm_field_t *field, const uint8_t *data)
+{
+    int32_t in = hrm_field_extract(field, data);
 
-    int32_t out = map_linear(in, field->logical_min, field->logical_max, config->low, config->high);
+    uint32_t step = mapper_normalize(&state->norm, field->logical_min, field->logical_max, in);
 
     uint8_t prev_value = state->value;
-    state->value = CLAMP(out, IO_POT_MIN_VAL, IO_POT_MAX_VAL);
+    state->value = lut[step];
 
     return prev_value != state->value;
 }
@@ -305,13 +845,14 @@ static bool mapper_integrate_delta(uint8_t intg_idx, int32_t delta)
 
     assert(intg_idx < ARRAY_SIZE(mapper->state.intg));
 
-    if (mapper->sync.active_profile < 0 || mapper->sync.active_profile >= MAPPER_MAX_PROFILES) {
+    mapper_cache_entry_t *entry = cache_find(mapper->sync.active_profile);
+    if (entry == NULL) {
         return false;
     }
 
     bool state_changed = false;
 
-    const mapper_profile_t *profile = &mapper->sync.profiles[mapper->sync.active_profile];
+    const mapper_profile_t *profile = &entry->profile;
     const mapper_intg_config_t *intg_config = &profile->intg[intg_idx];
     mapper_intg_state_t *intg_state = &mapper->state.intg[intg_idx];
 
@@ -332,10 +873,10 @@ static bool mapper_integrate_delta(uint8_t intg_idx, int32_t delta)
         if (HRM_USAGE_IS_INTG_ABS(source)) {
             mapper_pot_state_t *pot_state = &mapper->state.pot[pot_idx];
 
-            int32_t out = map_linear(intg_state->pos, -intg_config->max << 14,
-                                     intg_config->max << 14, pot_config->low, pot_config->high);
+            uint32_t step = mapper_normalize(&pot_state->norm, -intg_config->max << 14,
+                                             intg_config->max << 14, intg_state->pos);
 
-            int32_t new_value = CLAMP(out, IO_POT_MIN_VAL, IO_POT_MAX_VAL);
+            int32_t new_value = mapper->lut.pot[pot_idx][step];
 
             if (new_value != pot_state->value) {
                 pot_state->value = new_value;
@@ -352,14 +893,9 @@ static bool mapper_integrate_delta(uint8_t intg_idx, int32_t delta)
 }
 
 static int32_t update_intg_state(mapper_intg_state_t *state, const mapper_intg_config_t *config,
-                                 const hrm_report_t *report, const uint8_t *data)
+                                 const int16_t *lut, const hrm_field_t *field,
+                                 const uint8_t *data)
 {
-    const hrm_field_t *field = hrm_report_find_field(report, config->source);
-
-    if (field == NULL) {
-        return 0;
-    }
-
     int32_t in = hrm_field_extract(field, data);
     in = CLAMP(in, field->logical_min, field->logical_max);
 
@@ -381,13 +917,10 @@ static int32_t update_intg_state(mapper_intg_state_t *state, const mapper_intg_c
     } else if (config->mode == MAPPER_INTG_MODE_ABS) {
         // Input is a new absolute value (deviation from center)
 
-        // Convert the value to Q1.14 format first
-        int32_t delta = map_linear(in, field->logical_min, field->logical_max, -16384, 16384);
-
-        // Apply dead zone
-        if (abs(delta) <= (config->dead_zone * 16384) / 100) {
-            delta = 0;
-        }
+        // Look up the value in Q1.14 format (response curve and dead zone applied)
+        uint32_t step =
+            mapper_normalize(&state->norm, field->logical_min, field->logical_max, in);
+        int32_t delta = lut[step];
 
         // Apply gain Q8.7 format, result in Q17.14
         delta = (delta * config->gain) >> 8;
@@ -403,7 +936,7 @@ static int32_t update_intg_state(mapper_intg_state_t *state, const mapper_intg_c
 }
 
 // Routine called every 10ms from thread context
-static void mapper_tick_cb(struct k_work *work)
+static void mapper_tick_cb(workq_work_t *work)
 {
     mapper_t *mapper = &g_mapper;
 
@@ -430,26 +963,293 @@ static void mapper_tick_cb(struct k_work *work)
 static void mapper_timer_cb(struct k_timer *timer_id)
 {
     ARG_UNUSED(timer_id);
-    k_work_submit(&g_mapper.tick_work);
+    workq_submit(&g_mapper.tick_work);
 }
 
 // Sets the active profile used during timer ticks
-static void mapper_set_active_profile(int profile_idx)
+// Requires mapper->mutex to be locked
+//
+// Called from the report path, which never accesses the flash.
+// A profile that is not resident is prefetched and the switch is deferred.
+//
+// Returns 0 on success, -EAGAIN if the profile is being loaded
+static int mapper_set_active_profile(int profile_idx)
+{
+    mapper_t *mapper = &g_mapper;
+
+    if (mapper->sync.active_profile == profile_idx) {
+        return 0;
+    }
+
+    mapper_cache_entry_t *entry = cache_find(profile_idx);
+    if (entry == NULL) {
+        prefetch_locked(profile_idx);
+        return -EAGAIN;
+    }
+
+    mapper->stats.cache_hits++;
+
+    bool switched = mapper->sync.active_profile >= 0;
+
+    mapper->sync.active_profile = profile_idx;
+    reconfigure_io_pins(&entry->profile);
+    mapper_compile_lut(&entry->profile);
+
+    if (switched) {
+        mapper_state_t *state = &mapper->state;
+
+        // Release pins held by the previous profile and stop
+        // its integrators, the new profile takes over on the next
+        // (fully evaluated) report
+        for (int i = 0; i < ARRAY_SIZE(state->pin); i++) {
+            if (state->pin[i].value) {
+                state->pin[i].value = false;
+                io_pin_set(i, false);
+            }
+        }
+        for (int i = 0; i < ARRAY_SIZE(state->intg); i++) {
+            state->intg[i].delta = 0;
+        }
+        prev_invalidate(-1);
+    }
+
+    LOG_INF("Active profile changed {profile: %d}", profile_idx);
+
+    // CREATE for the first profile, UPDATE for a switch
+    event_t ev = {
+        .subject = EV_SUBJECT_ACTIVE_PROFILE,
+        .action = switched ? EV_ACTION_UPDATE : EV_ACTION_CREATE,
+        .idx = profile_idx,
+    };
+    event_bus_publish(&ev);
+
+    return 0;
+}
+
+int mapper_cycle_profile(void)
+{
+    mapper_t *mapper = &g_mapper;
+
+    k_mutex_lock(&mapper->mutex, K_FOREVER);
+
+    int current = mapper->sync.active_profile;
+
+    if (current < 0) {
+        k_mutex_unlock(&mapper->mutex);
+        return -ENODEV;
+    }
+
+    // Cycle through the quick profiles, skip the ones never configured
+    int start = current < MAPPER_QUICK_PROFILES ? current : MAPPER_QUICK_PROFILES - 1;
+    int next = current;
+    for (int i = 1; i <= MAPPER_QUICK_PROFILES; i++) {
+        int idx = (start + i) % MAPPER_QUICK_PROFILES;
+        if (idx != current && (mapper->sync.configured & BIT64(idx)) != 0) {
+            next = idx;
+            break;
+        }
+    }
+
+    int err = mapper_set_active_profile(next);
+    if (!err) {
+        mapper->sync.switched_profile = next;
+    }
+
+    k_mutex_unlock(&mapper->mutex);
+
+    if (err) {
+        return err;
+    }
+
+    mapper_publish_io_state();
+
+    return next;
+}
+
+int mapper_get_active_profile(void)
 {
     mapper_t *mapper = &g_mapper;
 
     k_mutex_lock(&mapper->mutex, K_FOREVER);
+    int idx = mapper->sync.active_profile;
+    k_mutex_unlock(&mapper->mutex);
+
+    return idx;
+}
+
+// Quick profiles selected by the hat switch directions while the chord button is held
+BUILD_ASSERT(MAPPER_QUICK_PROFILES <= 4, "Not enough hat switch directions");
+
+// Checks the chord button of the profile
+//
+// Returns -ENOENT if the button is not held, the profile index selected
+// by the hat switch or -EAGAIN if the hat switch doesn't select any
+static int chord_profile(const mapper_profile_t *profile, mapper_program_env_t *env)
+{
+    bool found = false;
+
+    if (mapper_program_load(env, profile->chord, &found) <= MAPPER_LUT_STEPS / 2) {
+        return -ENOENT;
+    }
+
+    hrm_field_t field;
+    if (!hrm_report_find_field(env->report, HRM_USAGE_HAT_SWITCH, &field)) {
+        return -EAGAIN;
+    }
+
+    switch (mapper_hat_mask(hrm_field_extract(&field, env->data) - field.logical_min)) {
+    case HAT_SWITCH_UP:
+        return 0;
+    case HAT_SWITCH_RIGHT:
+        return 1;
+    case HAT_SWITCH_DOWN:
+        return 2;
+    case HAT_SWITCH_LEFT:
+        return 3;
+    default:
+        return -EAGAIN;
+    }
+}
+
+// Checks the inputs of a chord that switched the profile
+//
+// Returns 1 while the chord button or the hat switch is held, 0 if both
+// are released or -ENOENT if neither of them is in the report
+static int chord_held(hrm_usage_t button, mapper_program_env_t *env)
+{
+    bool found = false;
+
+    if (mapper_program_load(env, button, &found) > MAPPER_LUT_STEPS / 2) {
+        return 1;
+    }
+
+    hrm_field_t field;
+    if (hrm_report_find_field(env->report, HRM_USAGE_HAT_SWITCH, &field)) {
+        int32_t in = hrm_field_extract(&field, env->data) - field.logical_min;
+        return mapper_hat_mask(in) != 0 ? 1 : 0;
+    }
+
+    return found ? 0 : -ENOENT;
+}
+
+// Invalidates the previous reports of a device (-1 => all devices)
+static void prev_invalidate(int slot)
+{
+    mapper_t *mapper = &g_mapper;
+
+    for (int i = 0; i < ARRAY_SIZE(mapper->prev); i++) {
+        if (slot < 0 || mapper->prev[i].slot == slot) {
+            mapper->prev[i].report = NULL;
+        }
+    }
+}
 
-    if (mapper->sync.active_profile != profile_idx) {
-        mapper->sync.active_profile = profile_idx;
-        reconfigure_io_pins(&mapper->sync.profiles[profile_idx]);
+// Finds the previous report of a device with the given ID,
+// reuses the least recently used entry if there's none
+static mapper_prev_report_t *prev_find(int slot, uint8_t report_id)
+{
+    mapper_t *mapper = &g_mapper;
+    mapper_prev_report_t *lru = &mapper->prev[0];
+
+    for (int i = 0; i < ARRAY_SIZE(mapper->prev); i++) {
+        mapper_prev_report_t *prev = &mapper->prev[i];
+        if (prev->slot == slot && prev->report_id == report_id) {
+            lru = prev;
+            break;
+        }
+        if (prev->last_use < lru->last_use) {
+            lru = prev;
+        }
+    }
+
+    if (lru->slot != slot || lru->report_id != report_id) {
+        lru->slot = slot;
+        lru->report_id = report_id;
+        lru->report = NULL;
     }
 
+    lru->last_use = ++mapper->prev_use_counter;
+    return lru;
+}
+
+void mapper_invalidate_report(int slot)
+{
+    mapper_t *mapper = &g_mapper;
+
+    k_mutex_lock(&mapper->mutex, K_FOREVER);
+    prev_invalidate(slot);
+    if (slot < 0 || mapper->chord.slot == slot) {
+        mapper->chord.slot = -1;
+    }
     k_mutex_unlock(&mapper->mutex);
 }
 
+void mapper_get_stats(mapper_stats_t *stats)
+{
+    mapper_t *mapper = &g_mapper;
+
+    k_mutex_lock(&mapper->mutex, K_FOREVER);
+    *stats = mapper->stats;
+    k_mutex_unlock(&mapper->mutex);
+}
+
+// Returns true if any bit of the given range is set in the diff
+// (XOR of the previous and the current report)
+static bool bits_changed(size_t bit_offset, size_t bit_size, const uint8_t *diff, size_t size)
+{
+    size_t first = bit_offset;
+    size_t last = bit_offset + bit_size - 1;
+
+    if (bit_size == 0 || (last >> 3) >= size) {
+        // Range not covered by the stored report, evaluate it always
+        return true;
+    }
+
+    for (size_t i = first >> 3; i <= (last >> 3); i++) {
+        uint8_t mask = 0xFF;
+        if (i == (first >> 3)) {
+            mask &= 0xFF << (first & 7);
+        }
+        if (i == (last >> 3)) {
+            mask &= 0xFF >> (7 - (last & 7));
+        }
+        if (diff[i] & mask) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Decides whether the mapping reading the given bit range needs to be evaluated
+static bool mapping_dirty(size_t bit_offset, size_t bit_size, const uint8_t *diff, size_t size)
+{
+    mapper_t *mapper = &g_mapper;
+
+    bool dirty = (diff == NULL) || bits_changed(bit_offset, bit_size, diff, size);
+
+    if (dirty) {
+        mapper->stats.evaluated++;
+    } else {
+        mapper->stats.skipped++;
+    }
+
+    return dirty;
+}
+
+static bool field_dirty(const hrm_field_t *field, const uint8_t *diff, size_t size)
+{
+    return mapping_dirty(field->bit_offset, field->bit_size, diff, size);
+}
+
+static bool array_dirty(const hrm_array_t *array, const uint8_t *diff, size_t size)
+{
+    return mapping_dirty(array->bit_offset, array->bit_size * array->count, diff, size);
+}
+
 // Callback invoked from bt layer when a report is received
-void mapper_process_report(int profile_idx, const uint8_t *data, const hrm_report_t *report)
+void mapper_process_report(int slot, int profile_idx, const uint8_t *data, size_t size,
+                           const hrm_report_t *report)
 {
     mapper_t *mapper = &g_mapper;
 
@@ -457,42 +1257,202 @@ void mapper_process_report(int profile_idx, const uint8_t *data, const hrm_repor
         return;
     }
 
+    // Zero-pad short reports to the size declared by the report map,
+    // so that field extraction never reads past the received data
+    uint8_t padded[MAPPER_MAX_REPORT_SIZE];
+    size_t declared_size = DIV_ROUND_UP(report->bit_size, 8);
+
+    if (size < declared_size) {
+        if (declared_size > sizeof(padded)) {
+            LOG_WRN("Short report dropped {size: %zu, expected: %zu}", size, declared_size);
+            return;
+        }
+        memcpy(padded, data, size);
+        memset(&padded[size], 0, declared_size - size);
+        data = padded;
+        size = declared_size;
+    }
+
     bool state_changed = false;
 
+    k_mutex_lock(&mapper->mutex, K_FOREVER);
+
+    // Assigning another profile to the device cancels the switch
+    if (mapper->sync.device_profile != profile_idx) {
+        mapper->sync.device_profile = profile_idx;
+        mapper->sync.switched_profile = -1;
+    }
+
+    if (mapper->sync.switched_profile >= 0) {
+        profile_idx = mapper->sync.switched_profile;
+    }
+
+    // Keeps the previous profile until the new one is loaded
     mapper_set_active_profile(profile_idx);
 
+    profile_idx = mapper->sync.active_profile;
+    mapper_cache_entry_t *entry = cache_find(profile_idx);
+    if (entry == NULL) {
+        k_mutex_unlock(&mapper->mutex);
+        return;
+    }
+
     mapper_state_t *state = &mapper->state;
-    mapper_profile_t *profile = &mapper->sync.profiles[profile_idx];
+    mapper_profile_t *profile = &entry->profile;
+    mapper_prev_report_t *prev = prev_find(slot, report->id);
 
-    k_mutex_lock(&mapper->mutex, K_FOREVER);
+    mapper->stats.reports++;
 
-    for (int i = 0; i < ARRAY_SIZE(state->pin); i++) {
-        mapper_pin_state_t *pin_state = &state->pin[i];
-        const mapper_pin_config_t *pin_config = &profile->pin[i];
-        if (update_pin_state(pin_state, pin_config, report, data)) {
-            io_pin_set(i, pin_state->value);
-            state_changed = true;
+    // Inputs of pin mappings, usages selected by array fields
+    // (e.g. pressed keys) are decoded on first use
+    mapper_program_env_t env = {
+        .report = report,
+        .data = data,
+        .norms = &state->program_norms,
+    };
+
+    if (mapper->chord.slot == slot) {
+        int held = chord_held(mapper->chord.button, &env);
+        if (held > 0) {
+            // The chord inputs are not mapped under the new profile,
+            // outputs are kept until they are released
+            prev->report = NULL;
+            k_mutex_unlock(&mapper->mutex);
+            return;
+        }
+        if (held == 0) {
+            mapper->chord.slot = -1;
         }
     }
 
-    for (int i = 0; i < ARRAY_SIZE(state->pot); i++) {
-        mapper_pot_state_t *pot_state = &state->pot[i];
-        const mapper_pot_config_t *pot_config = &profile->pot[i];
-        if (update_pot_state(pot_state, pot_config, report, data)) {
-            io_pot_set(i, pot_state->value);
-            state_changed = true;
+    if (profile->chord != 0) {
+        int chord = chord_profile(profile, &env);
+        if (chord != -ENOENT) {
+            // Outputs are kept while the chord button is held,
+            // the report after the release is fully evaluated
+            // (quick profiles never configured are skipped as by mapper_cycle_profile())
+            if (chord >= 0 && chord != profile_idx &&
+                (mapper->sync.configured & BIT64(chord)) != 0) {
+                hrm_usage_t button = profile->chord;
+                if (mapper_set_active_profile(chord) == 0) {
+                    mapper->sync.switched_profile = chord;
+                    mapper->chord.slot = slot;
+                    mapper->chord.button = button;
+                    state_changed = true;
+                }
+            }
+            prev->report = NULL;
+            k_mutex_unlock(&mapper->mutex);
+            if (state_changed) {
+                mapper_publish_io_state();
+            }
+            return;
+        }
+    }
+
+    // XOR the report against the previous one.
+    // `diff` stays NULL if all mappings have to be evaluated.
+    uint8_t diff_buf[MAPPER_MAX_REPORT_SIZE];
+    uint8_t *diff = NULL;
+    bool identical = false;
+
+    if (prev->report == report && prev->profile_idx == profile_idx && prev->size == size) {
+        if (memcmp(prev->data, data, size) == 0) {
+            identical = true;
+            mapper->stats.identical++;
+        } else {
+            for (size_t i = 0; i < size; i++) {
+                diff_buf[i] = prev->data[i] ^ data[i];
+            }
+            diff = diff_buf;
+        }
+    }
+
+    if (!identical) {
+        for (int i = 0; i < ARRAY_SIZE(state->pin); i++) {
+            mapper_pin_state_t *pin_state = &state->pin[i];
+            const mapper_pin_config_t *pin_config = &profile->pin[i];
+            hrm_field_t field;
+            bool changed;
+
+            if (HRM_USAGE_IS_EXPR(pin_config->source)) {
+                // Expressions combine multiple sources, always evaluated
+                int expr_idx = HRM_USAGE_GET_EXPR_IDX(pin_config->source);
+                if (expr_idx >= MAPPER_PROGRAM_MAX_EXPRS || mapper->lut.expr[expr_idx] < 0) {
+                    continue;
+                }
+                const uint8_t *code = &profile->program.code[mapper->lut.expr[expr_idx]];
+                mapper->stats.expressions++;
+                changed = update_pin_state_expr(pin_state, pin_config, code, &env);
+            } else if (hrm_report_find_field(report, pin_config->source, &field)) {
+                if (!field_dirty(&field, diff, size)) {
+                    continue;
+                }
+                changed = update_pin_state(pin_state, pin_config, mapper->lut.pin_up[i],
+                                           mapper->lut.pin_down[i], &field, data);
+            } else {
+                uint16_t bit;
+                int array = hrm_report_find_array(report, pin_config->source, &bit);
+                if (array < 0 || !array_dirty(&report->arrays[array], diff, size)) {
+                    continue;
+                }
+                bool active = hrm_usage_set_test(mapper_program_usage_set(&env), array, bit);
+                changed = update_pin_state_direct(pin_state, pin_config, active);
+            }
+
+            if (changed) {
+                io_pin_set(i, pin_state->value);
+                state_changed = true;
+            }
+        }
+
+        for (int i = 0; i < ARRAY_SIZE(state->pot); i++) {
+            mapper_pot_state_t *pot_state = &state->pot[i];
+            const mapper_pot_config_t *pot_config = &profile->pot[i];
+            hrm_field_t field;
+            if (!hrm_report_find_field(report, pot_config->source, &field) ||
+                !field_dirty(&field, diff, size)) {
+                continue;
+            }
+            if (update_pot_state(pot_state, mapper->lut.pot[i], &field, data)) {
+                io_pot_set(i, pot_state->value);
+                state_changed = true;
+            }
         }
     }
 
     for (int i = 0; i < ARRAY_SIZE(state->intg); i++) {
         mapper_intg_state_t *intg_state = &state->intg[i];
         const mapper_intg_config_t *intg_config = &profile->intg[i];
-        int32_t delta = update_intg_state(intg_state, intg_config, report, data);
+        hrm_field_t field;
+        if (!hrm_report_find_field(report, intg_config->source, &field)) {
+            continue;
+        }
+        // Relative values are accumulated on every report, even if repeated.
+        // Absolute ones keep their stored delta for the periodic tick.
+        if (intg_config->mode != MAPPER_INTG_MODE_REL &&
+            (identical || !field_dirty(&field, diff, size))) {
+            continue;
+        }
+        int32_t delta =
+            update_intg_state(intg_state, intg_config, mapper->lut.intg[i], &field, data);
         if (mapper_integrate_delta(i, delta)) {
             state_changed = true;
         }
     }
 
+    // Remember the report for the next comparison
+    if (size <= sizeof(prev->data)) {
+        if (!identical) {
+            memcpy(prev->data, data, size);
+        }
+        prev->report = report;
+        prev->profile_idx = profile_idx;
+        prev->size = size;
+    } else {
+        prev->report = NULL;
+    }
+
     k_mutex_unlock(&mapper->mutex);
 
     if (state_changed) {
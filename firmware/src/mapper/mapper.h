@@ -21,6 +21,7 @@
 #include <stdbool.h>
 
 #include <bthid/report_map.h>
+#include <event/event.h>
 
 #include <io/io_pin.h>
 #include <io/io_pot.h>
@@ -43,8 +44,59 @@ typedef struct {
     uint8_t threshold;
     // Hysteresis in percent
     uint8_t hysteresis;
+    // Autofire period in frames per press and per release (0 => off)
+    uint8_t autofire;
 } mapper_pin_config_t;
 
+// Response curve shapes
+typedef enum {
+    // Output follows the input linearly
+    MAPPER_CURVE_LINEAR = 0,
+    // Finer control around the center, coarser towards the ends
+    MAPPER_CURVE_EXPO = 1,
+    // Coarser control around the center, finer towards the ends
+    MAPPER_CURVE_S = 2,
+    // Piecewise linear through the configured points
+    MAPPER_CURVE_CUSTOM = 3,
+} mapper_curve_type_t;
+
+#define MAPPER_CURVE_POINTS 4
+
+// Response curve of an analog input
+// (applied symmetrically to the deflection from the center of the input range)
+typedef struct {
+    mapper_curve_type_t type;
+    // Curve strength in percent (EXPO and S only)
+    uint8_t amount;
+    // Output deflection in percent at 25, 50, 75 and 100 % input deflection
+    // (CUSTOM only)
+    uint8_t points[MAPPER_CURVE_POINTS];
+} mapper_curve_t;
+
+// Maximum curve amount and point value (percent)
+#define MAPPER_CURVE_MAX 100
+
+// Returns true if the curve type and parameters are in range
+static inline bool mapper_curve_valid(const mapper_curve_t *curve)
+{
+    switch (curve->type) {
+    case MAPPER_CURVE_LINEAR:
+        return true;
+    case MAPPER_CURVE_EXPO:
+    case MAPPER_CURVE_S:
+        return curve->amount <= MAPPER_CURVE_MAX;
+    case MAPPER_CURVE_CUSTOM:
+        for (int i = 0; i < MAPPER_CURVE_POINTS; i++) {
+            if (curve->points[i] > MAPPER_CURVE_MAX) {
+                return false;
+            }
+        }
+        return true;
+    default:
+        return false;
+    }
+}
+
 // Configuration of analog inputs (potentiometers)
 typedef struct {
     // Source field
@@ -53,6 +105,8 @@ typedef struct {
     int16_t low;
     // Pot value for logical max (IO_POT_MIN_VAL .. IO_POT_MAX_VAL)
     int16_t high;
+    // Response curve between `low` and `high`
+    mapper_curve_t curve;
 } mapper_pot_config_t;
 
 typedef enum {
@@ -76,16 +130,68 @@ typedef struct {
     int16_t gain;
     // Maximum accumulated delta in steps
     int16_t max;
+    // Response curve (only applied in ABS mode)
+    mapper_curve_t curve;
 } mapper_intg_config_t;
 
+// Size of the mapping program code
+#define MAPPER_PROGRAM_SIZE 64
+
+// Maximum number of expressions in the mapping program
+// (HRM_USAGE_EXPR0 .. HRM_USAGE_EXPR4)
+#define MAPPER_PROGRAM_MAX_EXPRS IO_PIN_COUNT
+
+// Mapping program combining multiple sources (see program.h)
+typedef struct {
+    // Bytecode of all expressions
+    uint8_t code[MAPPER_PROGRAM_SIZE];
+    // Size of the bytecode (0 if there is no program)
+    uint8_t size;
+} mapper_program_t;
+
+// Maximum length of a profile name (without the terminating zero)
+#define MAPPER_PROFILE_NAME_LEN 15
+
 // Configuration for all inputs of joystick port
 typedef struct {
+    // Profile name (zero terminated, empty if unnamed)
+    char name[MAPPER_PROFILE_NAME_LEN + 1];
     mapper_pin_config_t pin[IO_PIN_COUNT];
     mapper_pot_config_t pot[IO_POT_COUNT];
     mapper_intg_config_t intg[IO_ENC_COUNT];
+    mapper_program_t program;
+    // Button that selects a quick profile by the hat switch direction while held
+    // (up, right, down, left => profile 0..3), 0 => disabled
+    hrm_usage_t chord;
 } mapper_profile_t;
 
-#define MAPPER_MAX_PROFILES 4
+// Number of profiles in the library stored in the flash
+#define MAPPER_MAX_PROFILES 64
+
+// Profiles selectable by the chord button and the device button
+// (always listed, even if not configured)
+#define MAPPER_QUICK_PROFILES 4
+
+// Number of decoded profiles kept in RAM
+// (the quick profiles stay resident, the rest is shared by the active
+// profile and the prefetched ones)
+#define MAPPER_PROFILE_CACHE_SIZE (MAPPER_QUICK_PROFILES + 2)
+
+// Report processing statistics
+typedef struct {
+    // Processed reports
+    uint32_t reports;
+    // Reports identical to the previous one
+    uint32_t identical;
+    // Mappings evaluated and skipped because their fields did not change
+    uint32_t evaluated;
+    uint32_t skipped;
+    // Mapping program expressions evaluated
+    uint32_t expressions;
+    // Profile switches served from RAM and profiles loaded from the flash
+    uint32_t cache_hits;
+    uint32_t cache_loads;
+} mapper_stats_t;
 
 // Initialize the HID mapper
 //
@@ -94,13 +200,59 @@ int mapper_init(void);
 
 // Get profile at index
 //
+// Profiles not resident in RAM are read from the flash
+// without being cached.
+//
 // Returns 0 on success, error code otherwise
 int mapper_get_profile(int idx, mapper_profile_t *profile);
 
 // Set profile at index
 //
+// Profiles set without saving stay resident in RAM until
+// they are replaced by a stored one.
+//
 // Returns 0 on success, error code otherwise
 int mapper_set_profile(int idx, const mapper_profile_t *profile, bool save);
 
-// Processes a report received from a HID device
-void mapper_process_report(int profile_idx, const uint8_t *data, const hrm_report_t *report);
+// Loads the profile into RAM on the persist work queue
+//
+// Called when a profile is selected for a device, reports are mapped
+// only with resident profiles and keep the previous one until the load
+// completes.
+void mapper_prefetch_profile(int idx);
+
+// Returns true if the profile is configured
+// (quick profiles are always listed, the others only if configured)
+bool mapper_profile_exists(int idx);
+
+// Finds the first configured profile at `idx` or above
+//
+// Returns the profile index or -ENOENT if there is none
+int mapper_next_profile(int idx);
+
+// Switches to the next configured quick profile without saving it
+// (the device profile applies again once it is changed)
+//
+// Returns the new profile index or -ENODEV if no report was mapped yet
+int mapper_cycle_profile(void);
+
+// Returns the profile used for mapping or -1 if there is none yet
+int mapper_get_active_profile(void);
+
+// Processes a report received from a HID device at the specified slot
+// (never accesses the flash, see mapper_prefetch_profile())
+//
+// Only mappings whose source fields changed since the previous report
+// with the same ID from the same device are re-evaluated
+void mapper_process_report(int slot, int profile_idx, const uint8_t *data, size_t size,
+                           const hrm_report_t *report);
+
+// Forces full evaluation of the next reports of the device at the specified slot
+// (e.g. after the device has connected)
+void mapper_invalidate_report(int slot);
+
+// Retrieves the current state of the joystick port outputs
+void mapper_get_io_state(event_io_t *io);
+
+// Retrieves report processing statistics
+void mapper_get_stats(mapper_stats_t *stats);
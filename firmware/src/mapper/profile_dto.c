@@ -0,0 +1,499 @@
+/*
+ * This file is part of the Blue2Joy project - an interface converter
+ * between a Bluetooth gamepad and a retro console joystick
+ * (https://github.com/cepetr/blue2joy).
+ * Copyright (c) 2025
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <errno.h>
+#include <string.h>
+
+#include <zephyr/sys/util.h>
+
+#include "profile_dto.h"
+#include "program.h"
+
+// ---------------------------------------------------------------------------
+// Version 1
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    uint32_t source;
+    bool invert;
+    uint8_t hat_switch;
+    uint8_t threshold;
+    uint8_t hysteresis;
+} mapper_pin_config_dto_v1_t;
+
+typedef struct {
+    uint32_t source;
+    int16_t low;
+    int16_t high;
+} mapper_pot_config_dto_v1_t;
+
+typedef struct {
+    uint32_t source;
+    uint8_t mode;
+    uint8_t dead_zone;
+    int16_t gain;
+    int16_t max;
+} mapper_intg_config_dto_v1_t;
+
+typedef struct {
+    mapper_pin_config_dto_v1_t pin[5];
+    mapper_pot_config_dto_v1_t pot[2];
+    mapper_intg_config_dto_v1_t intg[2];
+} mapper_profile_dto_v1_t;
+
+typedef struct {
+    uint8_t version;
+    mapper_profile_dto_v1_t v1;
+} mapper_profile_dto_t;
+
+BUILD_ASSERT(sizeof(mapper_profile_dto_t) <= PROFILE_DTO_MAX_SIZE, "PROFILE_DTO_MAX_SIZE too small");
+
+static void pin_config_dto_v1_parse(const mapper_pin_config_dto_v1_t *dto,
+                                    mapper_pin_config_t *config)
+{
+    config->source = (hrm_usage_t)dto->source;
+    config->invert = dto->invert;
+    config->hat_switch = dto->hat_switch;
+    config->threshold = dto->threshold;
+    config->hysteresis = dto->hysteresis;
+}
+
+static void pot_config_dto_v1_parse(const mapper_pot_config_dto_v1_t *dto,
+                                    mapper_pot_config_t *config)
+{
+    config->source = (hrm_usage_t)dto->source;
+    config->low = dto->low;
+    config->high = dto->high;
+}
+
+static void intg_config_dto_v1_parse(const mapper_intg_config_dto_v1_t *dto,
+                                     mapper_intg_config_t *config)
+{
+    config->source = (hrm_usage_t)dto->source;
+    config->mode = (mapper_intr_mode_t)dto->mode;
+    config->dead_zone = dto->dead_zone;
+    config->gain = dto->gain;
+    config->max = dto->max;
+}
+
+static void profile_dto_v1_parse(const mapper_profile_dto_v1_t *dto, mapper_profile_t *profile)
+{
+    for (int i = 0; i < ARRAY_SIZE(dto->pin); i++) {
+        pin_config_dto_v1_parse(&dto->pin[i], &profile->pin[i]);
+    }
+
+    for (int i = 0; i < ARRAY_SIZE(dto->pot); i++) {
+        pot_config_dto_v1_parse(&dto->pot[i], &profile->pot[i]);
+    }
+
+    for (int i = 0; i < ARRAY_SIZE(dto->intg); i++) {
+        intg_config_dto_v1_parse(&dto->intg[i], &profile->intg[i]);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Version 2
+// ---------------------------------------------------------------------------
+
+#define V2_SLOT_PIN(i)  (i)
+#define V2_SLOT_POT(i)  (IO_PIN_COUNT + (i))
+#define V2_SLOT_INTG(i) (IO_PIN_COUNT + IO_POT_COUNT + (i))
+#define V2_SLOT_PROGRAM V2_SLOT_INTG(IO_ENC_COUNT)
+#define V2_SLOT_CHORD   (V2_SLOT_PROGRAM + 1)
+#define V2_SLOT_NAME    (V2_SLOT_CHORD + 1)
+
+#define V2_PIN_FLAG_INVERT      0x01
+#define V2_PIN_FLAG_AUTOFIRE    0x02
+#define V2_PIN_HAT_SWITCH_SHIFT 4
+
+BUILD_ASSERT(V2_SLOT_NAME < 16, "Presence bitmap too small");
+
+typedef struct {
+    uint8_t *ptr;
+    uint8_t *end;
+    bool error;
+} dto_writer_t;
+
+typedef struct {
+    const uint8_t *ptr;
+    const uint8_t *end;
+    bool error;
+} dto_reader_t;
+
+static void put_u8(dto_writer_t *w, uint8_t value)
+{
+    if (w->ptr < w->end) {
+        *w->ptr++ = value;
+    } else {
+        w->error = true;
+    }
+}
+
+static void put_varint(dto_writer_t *w, uint32_t value)
+{
+    do {
+        uint8_t byte = value & 0x7F;
+        value >>= 7;
+        put_u8(w, value != 0 ? byte | 0x80 : byte);
+    } while (value != 0);
+}
+
+static void put_svarint(dto_writer_t *w, int32_t value)
+{
+    // Zigzag encoding keeps small negative values short
+    put_varint(w, ((uint32_t)value << 1) ^ (uint32_t)(value >> 31));
+}
+
+static uint8_t get_u8(dto_reader_t *r)
+{
+    if (r->ptr < r->end) {
+        return *r->ptr++;
+    }
+
+    r->error = true;
+    return 0;
+}
+
+static uint32_t get_varint(dto_reader_t *r)
+{
+    uint32_t value = 0;
+
+    for (int shift = 0; shift < 35; shift += 7) {
+        uint8_t byte = get_u8(r);
+        value |= (uint32_t)(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return value;
+        }
+    }
+
+    r->error = true;
+    return 0;
+}
+
+static int32_t get_svarint(dto_reader_t *r)
+{
+    uint32_t value = get_varint(r);
+    return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+static bool pin_config_is_empty(const mapper_pin_config_t *config)
+{
+    return config->source == 0 && !config->invert && config->hat_switch == 0 &&
+           config->threshold == 0 && config->hysteresis == 0 && config->autofire == 0;
+}
+
+// Linear curves are encoded by the type only
+static bool curve_is_empty(const mapper_curve_t *curve)
+{
+    return curve->type == MAPPER_CURVE_LINEAR;
+}
+
+static bool pot_config_is_empty(const mapper_pot_config_t *config)
+{
+    return config->source == 0 && config->low == 0 && config->high == 0 &&
+           curve_is_empty(&config->curve);
+}
+
+static bool intg_config_is_empty(const mapper_intg_config_t *config)
+{
+    return config->source == 0 && config->mode == 0 && config->dead_zone == 0 &&
+           config->gain == 0 && config->max == 0 && curve_is_empty(&config->curve);
+}
+
+static void put_curve(dto_writer_t *w, const mapper_curve_t *curve)
+{
+    put_u8(w, (uint8_t)curve->type);
+
+    switch (curve->type) {
+    case MAPPER_CURVE_EXPO:
+    case MAPPER_CURVE_S:
+        put_u8(w, curve->amount);
+        break;
+    case MAPPER_CURVE_CUSTOM:
+        for (int i = 0; i < MAPPER_CURVE_POINTS; i++) {
+            put_u8(w, curve->points[i]);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+static void get_curve(dto_reader_t *r, mapper_curve_t *curve)
+{
+    curve->type = (mapper_curve_type_t)get_u8(r);
+
+    switch (curve->type) {
+    case MAPPER_CURVE_LINEAR:
+        break;
+    case MAPPER_CURVE_EXPO:
+    case MAPPER_CURVE_S:
+        curve->amount = get_u8(r);
+        break;
+    case MAPPER_CURVE_CUSTOM:
+        for (int i = 0; i < MAPPER_CURVE_POINTS; i++) {
+            curve->points[i] = get_u8(r);
+        }
+        break;
+    default:
+        // Unknown curve type
+        r->error = true;
+        return;
+    }
+
+    if (!mapper_curve_valid(curve)) {
+        r->error = true;
+    }
+}
+
+static void profile_dto_v2_build(const mapper_profile_t *profile, dto_writer_t *w)
+{
+    uint16_t present = 0;
+
+    for (int i = 0; i < IO_PIN_COUNT; i++) {
+        if (!pin_config_is_empty(&profile->pin[i])) {
+            present |= BIT(V2_SLOT_PIN(i));
+        }
+    }
+
+    for (int i = 0; i < IO_POT_COUNT; i++) {
+        if (!pot_config_is_empty(&profile->pot[i])) {
+            present |= BIT(V2_SLOT_POT(i));
+        }
+    }
+
+    for (int i = 0; i < IO_ENC_COUNT; i++) {
+        if (!intg_config_is_empty(&profile->intg[i])) {
+            present |= BIT(V2_SLOT_INTG(i));
+        }
+    }
+
+    if (profile->program.size > 0) {
+        present |= BIT(V2_SLOT_PROGRAM);
+    }
+
+    if (profile->chord != 0) {
+        present |= BIT(V2_SLOT_CHORD);
+    }
+
+    size_t name_len = strnlen(profile->name, MAPPER_PROFILE_NAME_LEN);
+    if (name_len > 0) {
+        present |= BIT(V2_SLOT_NAME);
+    }
+
+    put_u8(w, present & 0xFF);
+    put_u8(w, present >> 8);
+
+    for (int i = 0; i < IO_PIN_COUNT; i++) {
+        if (present & BIT(V2_SLOT_PIN(i))) {
+            const mapper_pin_config_t *config = &profile->pin[i];
+            put_varint(w, (uint32_t)config->source);
+            put_u8(w, (config->invert ? V2_PIN_FLAG_INVERT : 0) |
+                          (config->autofire > 0 ? V2_PIN_FLAG_AUTOFIRE : 0) |
+                          (config->hat_switch << V2_PIN_HAT_SWITCH_SHIFT));
+            put_u8(w, config->threshold);
+            put_u8(w, config->hysteresis);
+            if (config->autofire > 0) {
+                put_u8(w, config->autofire);
+            }
+        }
+    }
+
+    for (int i = 0; i < IO_POT_COUNT; i++) {
+        if (present & BIT(V2_SLOT_POT(i))) {
+            const mapper_pot_config_t *config = &profile->pot[i];
+            put_varint(w, (uint32_t)config->source);
+            put_svarint(w, config->low);
+            put_svarint(w, config->high);
+            put_curve(w, &config->curve);
+        }
+    }
+
+    for (int i = 0; i < IO_ENC_COUNT; i++) {
+        if (present & BIT(V2_SLOT_INTG(i))) {
+            const mapper_intg_config_t *config = &profile->intg[i];
+            put_varint(w, (uint32_t)config->source);
+            put_u8(w, (uint8_t)config->mode);
+            put_u8(w, config->dead_zone);
+            put_svarint(w, config->gain);
+            put_svarint(w, config->max);
+            put_curve(w, &config->curve);
+        }
+    }
+
+    if (present & BIT(V2_SLOT_PROGRAM)) {
+        put_u8(w, profile->program.size);
+        for (int i = 0; i < profile->program.size; i++) {
+            put_u8(w, profile->program.code[i]);
+        }
+    }
+
+    if (present & BIT(V2_SLOT_CHORD)) {
+        put_varint(w, (uint32_t)profile->chord);
+    }
+
+    if (present & BIT(V2_SLOT_NAME)) {
+        put_u8(w, name_len);
+        for (int i = 0; i < name_len; i++) {
+            put_u8(w, profile->name[i]);
+        }
+    }
+}
+
+static void profile_dto_v2_parse(dto_reader_t *r, mapper_profile_t *profile)
+{
+    uint16_t present = get_u8(r);
+    present |= get_u8(r) << 8;
+
+    if (present >= BIT(V2_SLOT_NAME + 1)) {
+        // Unknown slots
+        r->error = true;
+        return;
+    }
+
+    for (int i = 0; i < IO_PIN_COUNT; i++) {
+        if (present & BIT(V2_SLOT_PIN(i))) {
+            mapper_pin_config_t *config = &profile->pin[i];
+            config->source = (hrm_usage_t)get_varint(r);
+            uint8_t flags = get_u8(r);
+            config->invert = (flags & V2_PIN_FLAG_INVERT) != 0;
+            config->hat_switch = flags >> V2_PIN_HAT_SWITCH_SHIFT;
+            config->threshold = get_u8(r);
+            config->hysteresis = get_u8(r);
+            if (flags & V2_PIN_FLAG_AUTOFIRE) {
+                config->autofire = get_u8(r);
+            }
+        }
+    }
+
+    for (int i = 0; i < IO_POT_COUNT; i++) {
+        if (present & BIT(V2_SLOT_POT(i))) {
+            mapper_pot_config_t *config = &profile->pot[i];
+            config->source = (hrm_usage_t)get_varint(r);
+            config->low = (int16_t)get_svarint(r);
+            config->high = (int16_t)get_svarint(r);
+            get_curve(r, &config->curve);
+        }
+    }
+
+    for (int i = 0; i < IO_ENC_COUNT; i++) {
+        if (present & BIT(V2_SLOT_INTG(i))) {
+            mapper_intg_config_t *config = &profile->intg[i];
+            config->source = (hrm_usage_t)get_varint(r);
+            config->mode = (mapper_intr_mode_t)get_u8(r);
+            config->dead_zone = get_u8(r);
+            config->gain = (int16_t)get_svarint(r);
+            config->max = (int16_t)get_svarint(r);
+            get_curve(r, &config->curve);
+        }
+    }
+
+    if (present & BIT(V2_SLOT_PROGRAM)) {
+        mapper_program_t *program = &profile->program;
+        program->size = get_u8(r);
+        if (program->size > sizeof(program->code)) {
+            r->error = true;
+            return;
+        }
+        for (int i = 0; i < program->size; i++) {
+            program->code[i] = get_u8(r);
+        }
+        if (mapper_program_validate(program) < 0) {
+            r->error = true;
+        }
+    }
+
+    if (present & BIT(V2_SLOT_CHORD)) {
+        profile->chord = (hrm_usage_t)get_varint(r);
+    }
+
+    if (present & BIT(V2_SLOT_NAME)) {
+        uint8_t name_len = get_u8(r);
+        if (name_len > MAPPER_PROFILE_NAME_LEN) {
+            r->error = true;
+            return;
+        }
+        for (int i = 0; i < name_len; i++) {
+            char c = (char)get_u8(r);
+            if (c == '\0') {
+                r->error = true;
+                return;
+            }
+            profile->name[i] = c;
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+
+int profile_dto_parse(const void *data, size_t data_size, mapper_profile_t *profile)
+{
+    memset(profile, 0, sizeof(*profile));
+
+    const mapper_profile_dto_t *dto = (const mapper_profile_dto_t *)data;
+    if (data_size < sizeof(dto->version)) {
+        return -EINVAL;
+    }
+
+    switch (dto->version) {
+    case 1:
+        if (data_size != offsetof(mapper_profile_dto_t, v1) + sizeof(dto->v1)) {
+            return -EINVAL;
+        }
+
+        profile_dto_v1_parse(&dto->v1, profile);
+        return 1;
+
+    case 2: {
+        dto_reader_t r = {
+            .ptr = (const uint8_t *)data + 1,
+            .end = (const uint8_t *)data + data_size,
+        };
+
+        profile_dto_v2_parse(&r, profile);
+
+        if (r.error || r.ptr != r.end) {
+            memset(profile, 0, sizeof(*profile));
+            return -EINVAL;
+        }
+
+        return dto->version;
+    }
+
+    default:
+        return -EINVAL;
+    }
+}
+
+ssize_t profile_dto_build(const mapper_profile_t *profile, void *buf, size_t buf_size)
+{
+    dto_writer_t w = {
+        .ptr = buf,
+        .end = (uint8_t *)buf + buf_size,
+    };
+
+    put_u8(&w, PROFILE_DTO_VERSION);
+    profile_dto_v2_build(profile, &w);
+
+    if (w.error) {
+        return -ENOMEM;
+    }
+
+    return w.ptr - (uint8_t *)buf;
+}
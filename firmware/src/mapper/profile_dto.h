@@ -0,0 +1,59 @@
+/*
+ * This file is part of the Blue2Joy project - an interface converter
+ * between a Bluetooth gamepad and a retro console joystick
+ * (https://github.com/cepetr/blue2joy).
+ * Copyright (c) 2025
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <sys/types.h>
+
+#include "mapper.h"
+
+// Binary encoding of a profile shared by the settings and btjp
+//
+// The first byte is the version of the encoding:
+//
+// v1 - all fields of all slots, fixed layout (settings only, migrated on load)
+// v2 - presence bitmap (u16, bit per slot: pins, pots, integrators, program,
+//      chord, name) followed by the present slots only, sources as varints,
+//      signed values as zigzag varints:
+//        pin:     source, flags (bit 0 invert, bit 1 autofire, bits 4..7
+//                 hat switch), threshold, hysteresis, autofire period
+//                 (only with the autofire flag)
+//        pot:     source, low, high, curve
+//        intg:    source, mode, dead_zone, gain, max, curve
+//        program: size, code
+//        chord:   source
+//        name:    length, characters (without the terminating zero)
+//      curve: type, then amount (EXPO, S) or the points (CUSTOM)
+
+// Version written by profile_dto_build()
+#define PROFILE_DTO_VERSION 2
+
+// Maximum size of an encoded profile (any version)
+#define PROFILE_DTO_MAX_SIZE 208
+
+// Parses an encoded profile of any supported version
+//
+// Returns the version of the parsed data or -EINVAL if the data is invalid
+int profile_dto_parse(const void *data, size_t data_size, mapper_profile_t *profile);
+
+// Encodes a profile using the current version
+//
+// Returns the encoded size or -ENOMEM if the buffer is too small
+ssize_t profile_dto_build(const mapper_profile_t *profile, void *buf, size_t buf_size);
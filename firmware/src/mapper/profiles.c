@@ -84,3 +84,14 @@ const mapper_profile_t profile_mouse = {
     .pot[0] = {.source = HRM_USAGE_X, .low = -1710, .high = 1938},
     .pot[1] = {.source = HRM_USAGE_Y, .low = -1710, .high = 1938},
 };
+
+// Joystick emulation with a keyboard
+// Cursor keys -> up/down/left/right inputs
+// Space -> trigger input
+const mapper_profile_t profile_keyboard = {
+    .pin[IO_PIN_UP] = {.source = HRM_USAGE_KEY_UP},
+    .pin[IO_PIN_DOWN] = {.source = HRM_USAGE_KEY_DOWN},
+    .pin[IO_PIN_LEFT] = {.source = HRM_USAGE_KEY_LEFT},
+    .pin[IO_PIN_RIGHT] = {.source = HRM_USAGE_KEY_RIGHT},
+    .pin[IO_PIN_TRIG] = {.source = HRM_USAGE_KEY_SPACE},
+};
@@ -25,3 +25,4 @@ extern const mapper_profile_t profile_joy_hatswitch;
 extern const mapper_profile_t profile_arkanoid;
 extern const mapper_profile_t profile_cx77;
 extern const mapper_profile_t profile_mouse;
+extern const mapper_profile_t profile_keyboard;
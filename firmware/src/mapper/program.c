@@ -0,0 +1,293 @@
+/*
+ * This file is part of the Blue2Joy project
+ * (https://github.com/cepetr/blue2joy).
+ * Copyright (c) 2025
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <errno.h>
+
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/util.h>
+
+#include "program.h"
+
+// Value of a true condition and of a fully deflected source
+#define VALUE_MAX MAPPER_NORM_STEPS
+
+// Operand size and stack effect of an opcode
+typedef struct {
+    uint8_t operands;
+    uint8_t pops;
+    uint8_t pushes;
+} op_info_t;
+
+static const op_info_t g_op_info[] = {
+    [MAPPER_OP_END] = {0, 1, 0},   [MAPPER_OP_LOAD] = {4, 0, 1}, [MAPPER_OP_HAT] = {1, 0, 1},
+    [MAPPER_OP_CONST] = {1, 0, 1}, [MAPPER_OP_GT] = {0, 2, 1},   [MAPPER_OP_LT] = {0, 2, 1},
+    [MAPPER_OP_AND] = {0, 2, 1},   [MAPPER_OP_OR] = {0, 2, 1},   [MAPPER_OP_NOT] = {0, 1, 1},
+    [MAPPER_OP_HYST] = {2, 1, 1},  [MAPPER_OP_SELECT] = {0, 3, 1},
+};
+
+int mapper_program_validate(const mapper_program_t *program)
+{
+    if (program->size > sizeof(program->code)) {
+        return -EINVAL;
+    }
+
+    int exprs = 0;
+    int depth = 0;
+    bool open = false;
+
+    for (size_t pos = 0; pos < program->size;) {
+        uint8_t op = program->code[pos++];
+
+        if (op >= ARRAY_SIZE(g_op_info)) {
+            // Unknown opcode
+            return -EINVAL;
+        }
+
+        const op_info_t *info = &g_op_info[op];
+
+        if (pos + info->operands > program->size || depth < info->pops) {
+            // Truncated operands or stack underflow
+            return -EINVAL;
+        }
+
+        pos += info->operands;
+        depth += info->pushes - info->pops;
+
+        if (depth > MAPPER_PROGRAM_STACK_SIZE) {
+            return -EINVAL;
+        }
+
+        if (op == MAPPER_OP_END) {
+            if (depth != 0 || ++exprs > MAPPER_PROGRAM_MAX_EXPRS) {
+                // Leftover values or too many expressions
+                return -EINVAL;
+            }
+            open = false;
+        } else {
+            open = true;
+        }
+    }
+
+    if (open) {
+        // Last expression is not terminated
+        return -EINVAL;
+    }
+
+    return exprs;
+}
+
+int mapper_program_find_expr(const mapper_program_t *program, int expr_idx)
+{
+    size_t start = 0;
+
+    for (size_t pos = 0; pos < program->size;) {
+        uint8_t op = program->code[pos++];
+
+        if (op >= ARRAY_SIZE(g_op_info)) {
+            break;
+        }
+
+        pos += g_op_info[op].operands;
+
+        if (op == MAPPER_OP_END) {
+            if (expr_idx-- == 0) {
+                return start;
+            }
+            start = pos;
+        }
+    }
+
+    return -ENOENT;
+}
+
+const hrm_usage_set_t *mapper_program_usage_set(mapper_program_env_t *env)
+{
+    if (!env->usage_set_valid) {
+        hrm_report_decode_arrays(env->report, env->data, &env->usage_set);
+        env->usage_set_valid = true;
+    }
+
+    return &env->usage_set;
+}
+
+uint8_t mapper_hat_mask(int32_t value)
+{
+    static const uint8_t hat_lookup[8] = {
+        [0] = HAT_SWITCH_UP,    [1] = HAT_SWITCH_UP | HAT_SWITCH_RIGHT,
+        [2] = HAT_SWITCH_RIGHT, [3] = HAT_SWITCH_DOWN | HAT_SWITCH_RIGHT,
+        [4] = HAT_SWITCH_DOWN,  [5] = HAT_SWITCH_DOWN | HAT_SWITCH_LEFT,
+        [6] = HAT_SWITCH_LEFT,  [7] = HAT_SWITCH_UP | HAT_SWITCH_LEFT,
+    };
+
+    // Values out of range mean the hat switch is released
+    return (value >= 0 && value < ARRAY_SIZE(hat_lookup)) ? hat_lookup[value] : 0;
+}
+
+uint32_t mapper_normalize(mapper_norm_t *norm, int32_t min, int32_t max, int32_t value)
+{
+    if (norm->min != min || norm->max != max) {
+        // Range of the source changed, the only place with a division
+        uint32_t range = (uint32_t)max - (uint32_t)min;
+        norm->min = min;
+        norm->max = max;
+        norm->scale = max > min ? (((uint64_t)MAPPER_NORM_STEPS << 32) + range - 1) / range : 0;
+    }
+
+    value = CLAMP(value, min, max);
+
+    // (value - min) <= range, so the product fits into 64 bits
+    uint32_t step = ((uint32_t)value - (uint32_t)min) * norm->scale >> 32;
+    return MIN(step, MAPPER_NORM_STEPS);
+}
+
+// Returns the cached scale of the range or the entry to be replaced
+static mapper_norm_t *norm_lookup(mapper_norm_cache_t *cache, int32_t min, int32_t max)
+{
+    for (int i = 0; i < MAPPER_PROGRAM_NORMS; i++) {
+        mapper_norm_t *norm = &cache->entry[i];
+        if (norm->min == min && norm->max == max) {
+            return norm;
+        }
+    }
+
+    mapper_norm_t *norm = &cache->entry[cache->next];
+    cache->next = (cache->next + 1) % MAPPER_PROGRAM_NORMS;
+    return norm;
+}
+
+int32_t mapper_program_load(mapper_program_env_t *env, hrm_usage_t usage, bool *found)
+{
+    hrm_field_t field;
+
+    if (hrm_report_find_field(env->report, usage, &field)) {
+        *found = true;
+
+        if (field.logical_max <= field.logical_min) {
+            return 0;
+        }
+
+        int32_t in = hrm_field_extract(&field, env->data);
+        mapper_norm_t *norm = norm_lookup(env->norms, field.logical_min, field.logical_max);
+
+        return mapper_normalize(norm, field.logical_min, field.logical_max, in);
+    }
+
+    uint16_t bit;
+    int array = hrm_report_find_array(env->report, usage, &bit);
+    if (array >= 0) {
+        *found = true;
+        return hrm_usage_set_test(mapper_program_usage_set(env), array, bit) ? VALUE_MAX : 0;
+    }
+
+    return 0;
+}
+
+static int32_t load_hat(mapper_program_env_t *env, uint8_t directions, bool *found)
+{
+    hrm_field_t field;
+
+    if (!hrm_report_find_field(env->report, HRM_USAGE_HAT_SWITCH, &field)) {
+        return 0;
+    }
+
+    *found = true;
+
+    int32_t in = hrm_field_extract(&field, env->data) - field.logical_min;
+    return (mapper_hat_mask(in) & directions) != 0 ? VALUE_MAX : 0;
+}
+
+static int32_t percent_value(uint8_t percent)
+{
+    return percent * VALUE_MAX / 100;
+}
+
+int mapper_program_eval(const uint8_t *code, mapper_program_env_t *env, bool prev)
+{
+    int32_t stack[MAPPER_PROGRAM_STACK_SIZE];
+    int sp = 0;
+    bool found = false;
+
+    // The program was validated, so the stack can't overflow
+    // and every expression ends with MAPPER_OP_END
+    for (;;) {
+        uint8_t op = *code++;
+
+        switch (op) {
+        case MAPPER_OP_END:
+            return found ? (stack[sp - 1] != 0) : -ENOENT;
+
+        case MAPPER_OP_LOAD:
+            stack[sp++] = mapper_program_load(env, (hrm_usage_t)sys_get_le32(code), &found);
+            code += 4;
+            break;
+
+        case MAPPER_OP_HAT:
+            stack[sp++] = load_hat(env, *code++, &found);
+            break;
+
+        case MAPPER_OP_CONST:
+            stack[sp++] = percent_value(*code++);
+            break;
+
+        case MAPPER_OP_GT:
+            sp--;
+            stack[sp - 1] = stack[sp - 1] > stack[sp] ? VALUE_MAX : 0;
+            break;
+
+        case MAPPER_OP_LT:
+            sp--;
+            stack[sp - 1] = stack[sp - 1] < stack[sp] ? VALUE_MAX : 0;
+            break;
+
+        case MAPPER_OP_AND:
+            sp--;
+            stack[sp - 1] = (stack[sp - 1] && stack[sp]) ? VALUE_MAX : 0;
+            break;
+
+        case MAPPER_OP_OR:
+            sp--;
+            stack[sp - 1] = (stack[sp - 1] || stack[sp]) ? VALUE_MAX : 0;
+            break;
+
+        case MAPPER_OP_NOT:
+            stack[sp - 1] = stack[sp - 1] ? 0 : VALUE_MAX;
+            break;
+
+        case MAPPER_OP_HYST: {
+            int32_t low = percent_value(*code++);
+            int32_t high = percent_value(*code++);
+            int32_t value = stack[sp - 1];
+            if (value > high) {
+                stack[sp - 1] = VALUE_MAX;
+            } else if (value < low) {
+                stack[sp - 1] = 0;
+            } else {
+                stack[sp - 1] = prev ? VALUE_MAX : 0;
+            }
+        } break;
+
+        case MAPPER_OP_SELECT:
+            sp -= 2;
+            stack[sp - 1] = stack[sp - 1] ? stack[sp] : stack[sp + 1];
+            break;
+
+        default:
+            return -EINVAL;
+        }
+    }
+}
@@ -0,0 +1,135 @@
+/*
+ * This file is part of the Blue2Joy project
+ * (https://github.com/cepetr/blue2joy).
+ * Copyright (c) 2025
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <bthid/report_map.h>
+
+#include "mapper.h"
+
+// Mapping program
+//
+// A program is a sequence of expressions, each terminated by OP_END.
+// Pins select an expression by the HRM_USAGE_EXPRn source.
+//
+// Expressions run on a small stack of values normalized to 0..256
+// (0 is false, anything else is true). There are no jumps, so the
+// evaluation time is bounded by the program size.
+//
+// The cost is dominated by the field lookups of MAPPER_OP_LOAD and
+// MAPPER_OP_HAT, each scanning the fields of the report. An expression
+// does at most 25 of them (MAPPER_OP_HAT pairs reduced by MAPPER_OP_SELECT
+// filling MAPPER_PROGRAM_SIZE), every pin evaluates its expression, so a
+// report costs at most 5 x 25 scans of at most 123 fields (the arena
+// limit), 15375 field compares. See tests/host/mapper/prog_bench.c.
+
+// Ends the expression, its value is the top of the stack
+#define MAPPER_OP_END 0x00
+// Pushes the normalized value of the usage (u32 operand),
+// 256 if it's a usage selected by an array field (e.g. a key)
+#define MAPPER_OP_LOAD 0x01
+// Pushes 256 if the hat switch points to any of the directions (u8 operand, HAT_SWITCH_xxx)
+#define MAPPER_OP_HAT 0x02
+// Pushes a constant given in percent (u8 operand, 0..100)
+#define MAPPER_OP_CONST 0x03
+// Pops b, a and pushes a > b
+#define MAPPER_OP_GT 0x04
+// Pops b, a and pushes a < b
+#define MAPPER_OP_LT 0x05
+// Pops b, a and pushes a && b
+#define MAPPER_OP_AND 0x06
+// Pops b, a and pushes a || b
+#define MAPPER_OP_OR 0x07
+// Pops a and pushes !a
+#define MAPPER_OP_NOT 0x08
+// Pops a and pushes true above `high`, false below `low`
+// and the previous pin value in between (u8 operands low, high in percent)
+#define MAPPER_OP_HYST 0x09
+// Pops c, b, a and pushes a ? b : c
+#define MAPPER_OP_SELECT 0x0A
+
+// Maximum stack depth of an expression
+#define MAPPER_PROGRAM_STACK_SIZE 8
+
+// Number of steps of a normalized input value
+#define MAPPER_NORM_STEPS 256
+
+// Scale used to normalize a logical range to 0..MAPPER_NORM_STEPS
+// (recalculated only when the range changes)
+typedef struct {
+    int32_t min;
+    int32_t max;
+    // MAPPER_NORM_STEPS / (max - min) in Q32 format, rounded up
+    uint64_t scale;
+} mapper_norm_t;
+
+// Number of logical ranges the program loads keep the scale of
+#define MAPPER_PROGRAM_NORMS 4
+
+// Scales of the logical ranges loaded by the programs
+// (kept across reports, the least recently added one is replaced)
+typedef struct {
+    mapper_norm_t entry[MAPPER_PROGRAM_NORMS];
+    uint8_t next;
+} mapper_norm_cache_t;
+
+// Inputs of the program evaluation
+typedef struct {
+    const hrm_report_t *report;
+    const uint8_t *data;
+    // Usages selected by array fields (valid if `usage_set_valid`)
+    hrm_usage_set_t usage_set;
+    bool usage_set_valid;
+    // Scales of the loaded fields
+    mapper_norm_cache_t *norms;
+} mapper_program_env_t;
+
+// Maps the value from the logical range to 0..MAPPER_NORM_STEPS
+// (divides only if the range differs from the last one of `norm`)
+uint32_t mapper_normalize(mapper_norm_t *norm, int32_t min, int32_t max, int32_t value);
+
+// Checks the program for unknown opcodes, truncated operands
+// and stack underflows or overflows
+//
+// Returns the number of expressions or -EINVAL if the program is invalid
+int mapper_program_validate(const mapper_program_t *program);
+
+// Finds the start of the expression with index `expr_idx`
+//
+// Returns the offset in the program code or -ENOENT
+int mapper_program_find_expr(const mapper_program_t *program, int expr_idx);
+
+// Evaluates a validated expression starting at `code`
+// `prev` is the previous pin value used by MAPPER_OP_HYST
+//
+// Returns 1 or 0, or -ENOENT if none of the loaded usages is in the report
+int mapper_program_eval(const uint8_t *code, mapper_program_env_t *env, bool prev);
+
+// Returns the normalized value (0..256) of the usage, sets `found`
+// if the usage is in the report
+int32_t mapper_program_load(mapper_program_env_t *env, hrm_usage_t usage, bool *found);
+
+// Returns the usages selected by array fields of the report (decoded on first use)
+const hrm_usage_set_t *mapper_program_usage_set(mapper_program_env_t *env);
+
+// Converts a hat switch value (relative to its logical minimum)
+// to the mask of HAT_SWITCH_xxx directions
+uint8_t mapper_hat_mask(int32_t value);
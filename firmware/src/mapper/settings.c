@@ -16,168 +16,86 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <zephyr/kernel.h>
 #include <zephyr/logging/log.h>
 #include <zephyr/settings/settings.h>
 
 #include <mapper/mapper.h>
+#include <persist/persist.h>
+
+#include "profile_dto.h"
+#include "settings.h"
 
 #define SETTINGS_KEY_PREFIX "blue2joy/profile"
 
 LOG_MODULE_DECLARE(blue2joy, CONFIG_LOG_DEFAULT_LEVEL);
 
-typedef struct {
-    uint32_t source;
-    bool invert;
-    uint8_t hat_switch;
-    uint8_t threshold;
-    uint8_t hysteresis;
-} mapper_pin_config_dto_v1_t;
-
-typedef struct {
-    uint32_t source;
-    int16_t low;
-    int16_t high;
-} mapper_pot_config_dto_v1_t;
-
-typedef struct {
-    uint32_t source;
-    uint8_t mode;
-    uint8_t dead_zone;
-    int16_t gain;
-    int16_t max;
-} mapper_intg_config_dto_v1_t;
-
-typedef struct {
-    mapper_pin_config_dto_v1_t pin[5];
-    mapper_pot_config_dto_v1_t pot[2];
-    mapper_intg_config_dto_v1_t intg[2];
-} mapper_profile_dto_v1_t;
-
-typedef struct {
-    uint8_t version;
-    mapper_profile_dto_v1_t v1;
-} mapper_profile_dto_t;
-
-static void pin_config_dto_v1_parse(const mapper_pin_config_dto_v1_t *dto,
-                                    mapper_pin_config_t *config)
-{
-    config->source = (hrm_usage_t)dto->source;
-    config->invert = dto->invert;
-    config->hat_switch = dto->hat_switch;
-    config->threshold = dto->threshold;
-    config->hysteresis = dto->hysteresis;
-}
-
-static void pot_config_dto_v1_parse(const mapper_pot_config_dto_v1_t *dto,
-                                    mapper_pot_config_t *config)
-{
-    config->source = (hrm_usage_t)dto->source;
-    config->low = dto->low;
-    config->high = dto->high;
-}
-
-static void intg_config_dto_v1_parse(const mapper_intg_config_dto_v1_t *dto,
-                                     mapper_intg_config_t *config)
-{
-    config->source = (hrm_usage_t)dto->source;
-    config->mode = (mapper_intr_mode_t)dto->mode;
-    config->dead_zone = dto->dead_zone;
-    config->gain = dto->gain;
-    config->max = dto->max;
-}
-
-static void profile_dto_v1_parse(const mapper_profile_dto_v1_t *dto, mapper_profile_t *profile)
+static ssize_t _settings_build(int idx, void *buf, size_t buf_size)
 {
-    for (int i = 0; i < ARRAY_SIZE(dto->pin); i++) {
-        pin_config_dto_v1_parse(&dto->pin[i], &profile->pin[i]);
-    }
-
-    for (int i = 0; i < ARRAY_SIZE(dto->pot); i++) {
-        pot_config_dto_v1_parse(&dto->pot[i], &profile->pot[i]);
-    }
-
-    for (int i = 0; i < ARRAY_SIZE(dto->intg); i++) {
-        intg_config_dto_v1_parse(&dto->intg[i], &profile->intg[i]);
-    }
-}
-
-static int profile_dto_parse(const void *data, size_t data_size, mapper_profile_t *profile)
-{
-    memset(profile, 0, sizeof(*profile));
+    mapper_profile_t profile;
 
-    const mapper_profile_dto_t *dto = (const mapper_profile_dto_t *)data;
-    if (data_size < sizeof(dto->version)) {
-        return -1;
+    int err = mapper_export_profile(idx, &profile);
+    if (err) {
+        return err;
     }
 
-    switch (dto->version) {
-    case 1:
-        if (data_size != offsetof(mapper_profile_dto_t, v1) + sizeof(dto->v1)) {
-            return -1;
-        }
-
-        profile_dto_v1_parse(&dto->v1, profile);
+    static const mapper_profile_t empty = {0};
+    if (memcmp(&profile, &empty, sizeof(empty)) == 0) {
+        // Deleted from the library
         return 0;
-
-    default:
-        return -1;
     }
-}
 
-static void pin_config_dto_v1_build(const mapper_pin_config_t *config,
-                                    mapper_pin_config_dto_v1_t *dto)
-{
-    dto->source = (uint32_t)config->source;
-    dto->invert = config->invert;
-    dto->hat_switch = config->hat_switch;
-    dto->threshold = config->threshold;
-    dto->hysteresis = config->hysteresis;
+    return profile_dto_build(&profile, buf, buf_size);
 }
 
-static void pot_config_dto_v1_build(const mapper_pot_config_t *config,
-                                    mapper_pot_config_dto_v1_t *dto)
-{
-    dto->source = (uint32_t)config->source;
-    dto->low = config->low;
-    dto->high = config->high;
-}
+typedef struct {
+    mapper_profile_t *profile;
+    int err;
+} settings_load_ctx_t;
 
-static void intg_config_dto_v1_build(const mapper_intg_config_t *config,
-                                     mapper_intg_config_dto_v1_t *dto)
+static int _settings_load_direct(const char *key, size_t len, settings_read_cb read_cb,
+                                 void *cb_arg, void *param)
 {
-    dto->source = (uint32_t)config->source;
-    dto->mode = (uint8_t)config->mode;
-    dto->dead_zone = config->dead_zone;
-    dto->gain = config->gain;
-    dto->max = config->max;
+    settings_load_ctx_t *ctx = param;
+    uint8_t dto[PROFILE_DTO_MAX_SIZE];
+
+    if (len > sizeof(dto) || read_cb(cb_arg, dto, len) != len) {
+        ctx->err = -EIO;
+    } else if (profile_dto_parse(dto, len, ctx->profile) < 0) {
+        ctx->err = -EINVAL;
+    } else {
+        ctx->err = 0;
+    }
+
+    return 0;
 }
 
-static ssize_t profile_dto_build(const mapper_profile_t *profile, mapper_profile_dto_t *dto)
+int mapper_settings_load(int idx, mapper_profile_t *profile)
 {
-    dto->version = 1;
+    char key[32];
+    snprintf(key, sizeof(key), SETTINGS_KEY_PREFIX "/%d", idx);
 
-    for (int i = 0; i < ARRAY_SIZE(dto->v1.pin); i++) {
-        pin_config_dto_v1_build(&profile->pin[i], &dto->v1.pin[i]);
-    }
-
-    for (int i = 0; i < ARRAY_SIZE(dto->v1.pot); i++) {
-        pot_config_dto_v1_build(&profile->pot[i], &dto->v1.pot[i]);
-    }
+    settings_load_ctx_t ctx = {
+        .profile = profile,
+        .err = -ENOENT,
+    };
 
-    for (int i = 0; i < ARRAY_SIZE(dto->v1.intg); i++) {
-        intg_config_dto_v1_build(&profile->intg[i], &dto->v1.intg[i]);
+    int err = settings_load_subtree_direct(key, _settings_load_direct, &ctx);
+    if (err) {
+        return err;
     }
 
-    return offsetof(mapper_profile_dto_t, v1) + sizeof(dto->v1);
+    return ctx.err;
 }
 
-void mapper_save_settings(struct k_work *work)
+int mapper_settings_init(void)
 {
-    LOG_INF("Saving mapper settings");
-    settings_save_subtree(SETTINGS_KEY_PREFIX);
+    return persist_register(PERSIST_GROUP_PROFILE, SETTINGS_KEY_PREFIX, MAPPER_MAX_PROFILES,
+                            _settings_build);
 }
 
 static int _settings_set(const char *key, size_t len, settings_read_cb read_cb, void *cb_arg)
@@ -198,52 +116,33 @@ static int _settings_set(const char *key, size_t len, settings_read_cb read_cb,
         return -EINVAL;
     }
 
-    mapper_profile_dto_t dto;
+    uint8_t dto[PROFILE_DTO_MAX_SIZE];
 
-    if (read_cb(cb_arg, &dto, len) != len) {
+    if (len > sizeof(dto) || read_cb(cb_arg, dto, len) != len) {
         LOG_ERR("Failed to read setting value");
         return -EINVAL;
     }
 
     mapper_profile_t profile;
 
-    if (profile_dto_parse(&dto, len, &profile) != 0) {
+    int version = profile_dto_parse(dto, len, &profile);
+    if (version < 0) {
         LOG_ERR("Failed to parse profile configuration");
         return -EINVAL;
     }
 
-    if (mapper_set_profile(idx, &profile, false) != 0) {
-        LOG_ERR("Failed to set profile");
-        return -EINVAL;
-    }
-
-    return 0;
-}
-
-static int _settings_export(int (*export_func)(const char *name, const void *val, size_t val_len))
-{
-    LOG_INF("Exporting profile settings");
-
-    for (int i = 0; i < MAPPER_MAX_PROFILES; i++) {
-        char key[32];
-        snprintf(key, sizeof(key), SETTINGS_KEY_PREFIX "/%d", i);
-
-        mapper_profile_t profile;
+    // Only the index is kept, the profile is loaded when selected
+    mapper_profile_stored(idx);
 
-        if (mapper_get_profile(i, &profile) != 0) {
-            LOG_ERR("Failed to get profile {idx=%d}", i);
-            continue;
-        }
+    persist_loaded(PERSIST_GROUP_PROFILE, idx, dto, len);
 
-        mapper_profile_dto_t dto;
-        ssize_t dto_size = profile_dto_build(&profile, &dto);
-        if (dto_size >= 0) {
-            export_func(key, &dto, dto_size);
-        }
+    if (version != PROFILE_DTO_VERSION) {
+        // Rewrite in the current format
+        LOG_INF("Migrating profile settings {idx=%d, version=%d}", idx, version);
+        persist_mark_dirty(PERSIST_GROUP_PROFILE, idx);
     }
 
     return 0;
 }
 
-SETTINGS_STATIC_HANDLER_DEFINE(mapper, SETTINGS_KEY_PREFIX, NULL, _settings_set, NULL,
-                               _settings_export);
+SETTINGS_STATIC_HANDLER_DEFINE(mapper, SETTINGS_KEY_PREFIX, NULL, _settings_set, NULL, NULL);
@@ -18,6 +18,25 @@
 
 #pragma once
 
-#include <zephyr/kernel.h>
+#include "mapper.h"
 
-void mapper_save_settings(struct k_work *work);
+// Registers the profiles with the persistence layer
+//
+// Returns 0 on success, error code otherwise
+int mapper_settings_init(void);
+
+// Reads a single profile from the flash
+//
+// Returns 0 on success, -ENOENT if the profile is not stored,
+// error code otherwise
+int mapper_settings_load(int idx, mapper_profile_t *profile);
+
+// Gets the profile to be written to the flash
+// (implemented by the mapper, the profile may be evicted from RAM afterwards)
+//
+// Returns 0 on success, error code otherwise
+int mapper_export_profile(int idx, mapper_profile_t *profile);
+
+// Records a profile found in the flash while loading the settings
+// (implemented by the mapper, the profile itself is loaded on demand)
+void mapper_profile_stored(int idx);
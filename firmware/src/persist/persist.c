@@ -0,0 +1,360 @@
+/*
+ * This file is part of the Blue2Joy project - an interface converter
+ * between a Bluetooth gamepad and a retro console joystick
+ * (https://github.com/cepetr/blue2joy).
+ * Copyright (c) 2025
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/settings/settings.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/crc.h>
+
+#include <devmgr/devmgr.h>
+#include <workq/workq.h>
+
+#include "persist.h"
+
+LOG_MODULE_DECLARE(blue2joy, CONFIG_LOG_DEFAULT_LEVEL);
+
+// Delay after the last change before the dirty keys are written
+#define PERSIST_FLUSH_DELAY K_SECONDS(3)
+
+// Delay before retrying a postponed flush
+#define PERSIST_RETRY_DELAY K_SECONDS(1)
+
+// Link is considered settled this long after the last parameters
+// or PHY update (ms)
+#define PERSIST_LINK_SETTLE_TIME 1000
+
+// Flush is never postponed for longer than this (ms)
+//
+// Flushes are postponed only while a device connects (connection,
+// security, discovery and subscription) or updates its link, streaming
+// reports don't postpone them. The worst case is a device that keeps
+// failing to connect.
+#define PERSIST_MAX_DEFER_TIME 60000
+
+// Maximum size of a stored value
+#define PERSIST_MAX_VALUE_SIZE 208
+
+typedef struct {
+    // Key prefix (NULL if the group is not registered)
+    const char *prefix;
+    // Number of entries
+    int count;
+    // Value builder
+    persist_build_cb_t build;
+    // Entries changed since the last flush
+    uint64_t dirty;
+    // Entries present in the flash
+    uint64_t stored;
+    // CRC of the values present in the flash
+    uint32_t crc[PERSIST_MAX_ENTRIES];
+} persist_group_state_t;
+
+typedef struct {
+    workq_work_t flush_work;
+    struct k_mutex mutex;
+
+    // Uptime of the last link update (ms)
+    atomic_t link_time;
+
+    struct {
+        persist_group_state_t group[PERSIST_GROUP_COUNT];
+        // Uptime of the oldest unsaved change (ms)
+        int64_t dirty_time;
+        persist_stats_t stats;
+    } sync;
+
+} persist_t;
+
+static persist_t g_persist;
+
+static void persist_flush_work(workq_work_t *work);
+
+int persist_init(void)
+{
+    persist_t *persist = &g_persist;
+
+    memset(persist, 0, sizeof(persist_t));
+
+    int err = k_mutex_init(&persist->mutex);
+    if (err) {
+        return err;
+    }
+
+    workq_init_work(&persist->flush_work, WORKQ_PERSIST, persist_flush_work);
+
+    return 0;
+}
+
+int persist_register(persist_group_t group, const char *prefix, int count,
+                     persist_build_cb_t build)
+{
+    persist_t *persist = &g_persist;
+
+    if (group >= PERSIST_GROUP_COUNT || count > PERSIST_MAX_ENTRIES) {
+        return -EINVAL;
+    }
+
+    k_mutex_lock(&persist->mutex, K_FOREVER);
+    persist_group_state_t *gs = &persist->sync.group[group];
+    gs->prefix = prefix;
+    gs->count = count;
+    gs->build = build;
+    k_mutex_unlock(&persist->mutex);
+
+    return 0;
+}
+
+static void mark_dirty(persist_group_t group, uint64_t mask)
+{
+    persist_t *persist = &g_persist;
+
+    if (group >= PERSIST_GROUP_COUNT) {
+        return;
+    }
+
+    k_mutex_lock(&persist->mutex, K_FOREVER);
+    persist_group_state_t *gs = &persist->sync.group[group];
+    bool was_clean = true;
+    for (int i = 0; i < PERSIST_GROUP_COUNT; i++) {
+        was_clean &= (persist->sync.group[i].dirty == 0);
+    }
+    if (was_clean) {
+        persist->sync.dirty_time = k_uptime_get();
+    }
+    gs->dirty |= mask;
+    k_mutex_unlock(&persist->mutex);
+
+    LOG_INF("Scheduling settings save");
+    workq_reschedule(&persist->flush_work, PERSIST_FLUSH_DELAY);
+}
+
+void persist_mark_dirty(persist_group_t group, int idx)
+{
+    if (idx < 0 || idx >= PERSIST_MAX_ENTRIES) {
+        return;
+    }
+
+    mark_dirty(group, BIT64(idx));
+}
+
+void persist_mark_all_dirty(persist_group_t group)
+{
+    mark_dirty(group, UINT64_MAX);
+}
+
+void persist_loaded(persist_group_t group, int idx, const void *data, size_t size)
+{
+    persist_t *persist = &g_persist;
+
+    if (group >= PERSIST_GROUP_COUNT || idx < 0 || idx >= PERSIST_MAX_ENTRIES) {
+        return;
+    }
+
+    k_mutex_lock(&persist->mutex, K_FOREVER);
+    persist_group_state_t *gs = &persist->sync.group[group];
+    gs->stored |= BIT64(idx);
+    gs->crc[idx] = crc32_ieee(data, size);
+    k_mutex_unlock(&persist->mutex);
+}
+
+void persist_link_activity(void)
+{
+    atomic_set(&g_persist.link_time, (atomic_val_t)k_uptime_get_32());
+}
+
+void persist_get_stats(persist_stats_t *stats)
+{
+    persist_t *persist = &g_persist;
+
+    k_mutex_lock(&persist->mutex, K_FOREVER);
+    *stats = persist->sync.stats;
+    k_mutex_unlock(&persist->mutex);
+}
+
+// Returns true if a HID link is in a latency-critical phase where
+// a flash write could break it (connecting or updating the link)
+static bool link_is_busy(void)
+{
+    uint32_t settled = k_uptime_get_32() - (uint32_t)atomic_get(&g_persist.link_time);
+
+    return devmgr_is_connecting() || settled < PERSIST_LINK_SETTLE_TIME;
+}
+
+// Writes a single entry if its value differs from the stored one
+static int flush_entry(persist_group_t group, int idx, persist_stats_t *stats)
+{
+    persist_t *persist = &g_persist;
+
+    k_mutex_lock(&persist->mutex, K_FOREVER);
+    persist_group_state_t gs = persist->sync.group[group];
+    k_mutex_unlock(&persist->mutex);
+
+    char key[32];
+    snprintf(key, sizeof(key), "%s/%d", gs.prefix, idx);
+
+    uint8_t buf[PERSIST_MAX_VALUE_SIZE];
+    ssize_t size = (idx < gs.count) ? gs.build(idx, buf, sizeof(buf)) : 0;
+
+    if (size < 0) {
+        return size;
+    }
+
+    bool stored = (gs.stored & BIT64(idx)) != 0;
+    int err = 0;
+
+    if (size > 0) {
+        uint32_t crc = crc32_ieee(buf, size);
+
+        if (stored && crc == gs.crc[idx]) {
+            stats->skipped++;
+            return 0;
+        }
+
+        err = settings_save_one(key, buf, size);
+        if (!err) {
+            stats->writes++;
+            stats->bytes += size;
+
+            k_mutex_lock(&persist->mutex, K_FOREVER);
+            persist->sync.group[group].stored |= BIT64(idx);
+            persist->sync.group[group].crc[idx] = crc;
+            k_mutex_unlock(&persist->mutex);
+        }
+    } else if (stored) {
+        err = settings_delete(key);
+        if (!err) {
+            stats->deletes++;
+
+            k_mutex_lock(&persist->mutex, K_FOREVER);
+            persist->sync.group[group].stored &= ~BIT64(idx);
+            k_mutex_unlock(&persist->mutex);
+        }
+    }
+
+    if (err) {
+        LOG_ERR("Failed to save setting {key: %s, err: %d}", key, err);
+    }
+
+    return err;
+}
+
+static void add_stats(const persist_stats_t *stats)
+{
+    persist_t *persist = &g_persist;
+
+    k_mutex_lock(&persist->mutex, K_FOREVER);
+    persist_stats_t *total = &persist->sync.stats;
+    total->writes += stats->writes;
+    total->bytes += stats->bytes;
+    total->deletes += stats->deletes;
+    total->skipped += stats->skipped;
+    total->errors += stats->errors;
+    k_mutex_unlock(&persist->mutex);
+}
+
+int persist_save_entry(persist_group_t group, int idx)
+{
+    persist_t *persist = &g_persist;
+
+    if (group >= PERSIST_GROUP_COUNT || idx < 0 || idx >= PERSIST_MAX_ENTRIES) {
+        return -EINVAL;
+    }
+
+    k_mutex_lock(&persist->mutex, K_FOREVER);
+    persist_group_state_t *gs = &persist->sync.group[group];
+    bool registered = gs->prefix != NULL;
+    // Written even if a running flush has already taken the dirty bit
+    // (unchanged values are skipped by their CRC)
+    gs->dirty &= ~BIT64(idx);
+    k_mutex_unlock(&persist->mutex);
+
+    if (!registered) {
+        return -EINVAL;
+    }
+
+    persist_stats_t stats = {0};
+
+    int err = flush_entry(group, idx, &stats);
+    if (err) {
+        stats.errors++;
+        // Try again later
+        mark_dirty(group, BIT64(idx));
+    }
+
+    add_stats(&stats);
+
+    return err;
+}
+
+static void persist_flush_work(workq_work_t *work)
+{
+    persist_t *persist = &g_persist;
+
+    uint64_t dirty[PERSIST_GROUP_COUNT];
+
+    // Evaluated before locking (devmgr locks its own mutex)
+    bool busy = link_is_busy();
+
+    k_mutex_lock(&persist->mutex, K_FOREVER);
+
+    if (busy && k_uptime_get() - persist->sync.dirty_time < PERSIST_MAX_DEFER_TIME) {
+        // Keep the flash erase stalls away from the link procedures
+        persist->sync.stats.deferred++;
+        k_mutex_unlock(&persist->mutex);
+        workq_reschedule(&persist->flush_work, PERSIST_RETRY_DELAY);
+        return;
+    }
+
+    for (int i = 0; i < PERSIST_GROUP_COUNT; i++) {
+        dirty[i] = persist->sync.group[i].prefix != NULL ? persist->sync.group[i].dirty : 0;
+        persist->sync.group[i].dirty &= ~dirty[i];
+    }
+
+    k_mutex_unlock(&persist->mutex);
+
+    persist_stats_t stats = {0};
+    uint64_t failed[PERSIST_GROUP_COUNT] = {0};
+
+    for (int i = 0; i < PERSIST_GROUP_COUNT; i++) {
+        for (int idx = 0; idx < PERSIST_MAX_ENTRIES && dirty[i] != 0; idx++) {
+            if ((dirty[i] & BIT64(idx)) != 0) {
+                dirty[i] &= ~BIT64(idx);
+                if (flush_entry(i, idx, &stats) != 0) {
+                    failed[i] |= BIT64(idx);
+                    stats.errors++;
+                }
+            }
+        }
+    }
+
+    add_stats(&stats);
+
+    LOG_INF("Settings saved {writes: %u, bytes: %u, deletes: %u, skipped: %u}", stats.writes,
+            stats.bytes, stats.deletes, stats.skipped);
+
+    for (int i = 0; i < PERSIST_GROUP_COUNT; i++) {
+        if (failed[i] != 0) {
+            // Try again later
+            mark_dirty(i, failed[i]);
+        }
+    }
+}
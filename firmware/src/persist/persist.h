@@ -0,0 +1,91 @@
+/*
+ * This file is part of the Blue2Joy project - an interface converter
+ * between a Bluetooth gamepad and a retro console joystick
+ * (https://github.com/cepetr/blue2joy).
+ * Copyright (c) 2025
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+// Maximum number of entries in a group
+#define PERSIST_MAX_ENTRIES 64
+
+// Groups of persistent settings
+typedef enum {
+    // Mapper profiles
+    PERSIST_GROUP_PROFILE = 0,
+    // Device configurations
+    PERSIST_GROUP_DEVICE = 1,
+
+    PERSIST_GROUP_COUNT,
+} persist_group_t;
+
+// Builds the stored value of an entry
+//
+// Returns the value size, 0 if the entry does not exist
+// (its key is deleted) or a negative error code
+typedef ssize_t (*persist_build_cb_t)(int idx, void *buf, size_t buf_size);
+
+// Flash write statistics
+typedef struct {
+    // Number of keys written
+    uint32_t writes;
+    // Number of bytes written
+    uint32_t bytes;
+    // Number of keys deleted
+    uint32_t deletes;
+    // Number of dirty keys skipped because the value did not change
+    uint32_t skipped;
+    // Number of times a flush was postponed due to a link procedure
+    uint32_t deferred;
+    // Number of failed writes or deletes
+    uint32_t errors;
+} persist_stats_t;
+
+// Initializes the persistence layer
+//
+// Returns 0 on success, error code otherwise
+int persist_init(void);
+
+// Registers a group of settings stored under `prefix/<idx>`
+//
+// Returns 0 on success, error code otherwise
+int persist_register(persist_group_t group, const char *prefix, int count,
+                     persist_build_cb_t build);
+
+// Marks an entry as changed and schedules a flush
+void persist_mark_dirty(persist_group_t group, int idx);
+
+// Writes an entry right away (e.g. before its value is dropped from RAM)
+//
+// Returns 0 on success, error code otherwise
+int persist_save_entry(persist_group_t group, int idx);
+
+// Marks all entries of a group as changed and schedules a flush
+void persist_mark_all_dirty(persist_group_t group);
+
+// Records a value loaded from the flash so it is not rewritten unchanged
+void persist_loaded(persist_group_t group, int idx, const void *data, size_t size);
+
+// Signals a connection parameters or PHY update of a HID device
+// (flushes are postponed until the link settles)
+void persist_link_activity(void);
+
+// Returns the flash write statistics
+void persist_get_stats(persist_stats_t *stats);
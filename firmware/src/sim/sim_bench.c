@@ -0,0 +1,101 @@
+/*
+ * This file is part of the Blue2Joy project
+ * (https://github.com/cepetr/blue2joy).
+ * Copyright (c) 2025
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/init.h>
+#include <zephyr/logging/log.h>
+
+#include <btsvc/btsvc.h>
+#include <devmgr/devmgr.h>
+
+LOG_MODULE_DECLARE(blue2joy, CONFIG_LOG_DEFAULT_LEVEL);
+
+// BabbleSim bench support (see tests/bsim/README.md)
+//
+// Starts pairing if there's no known device and advertising for btjp
+// clients (there are no buttons to press in the simulation) and
+// periodically prints the devmgr and link statistics in
+// a `bench: key=value ...` line parsed by the test scripts.
+
+// Delay after boot before the bench starts (ms)
+#define SIM_BENCH_START_DELAY 500
+
+// Statistics printing interval (ms)
+#define SIM_BENCH_PRINT_INTERVAL 1000
+
+static struct k_work_delayable g_sim_bench_work;
+
+static uint32_t timing_avg(const devmgr_timing_t *timing)
+{
+    return timing->count > 0 ? (uint32_t)(timing->sum / timing->count) : 0;
+}
+
+static void print_stats(void)
+{
+    devmgr_stats_t stats;
+    devmgr_get_stats(&stats);
+
+    bthid_link_stats_t link = {0};
+    bt_addr_le_t addrs[DEVMGR_MAX_CONFIG_ENTRIES];
+    if (devmgr_get_devices(addrs) > 0) {
+        devmgr_get_link_stats(&addrs[0], &link);
+    }
+
+    LOG_INF("bench: boot_to_ready=%u scan_to_ready=%u connect_to_ready=%u", stats.boot_to_ready,
+            stats.scan_to_ready.last, stats.connect_to_ready.last);
+
+    LOG_INF("bench: reconnects=%u reconnect_avg=%u reconnect_max=%u", stats.reconnect.count,
+            timing_avg(&stats.reconnect), stats.reconnect.max);
+
+    LOG_INF("bench: reports=%u peak_rate=%u rate=%u missed=%u latency_avg_us=%u "
+            "latency_max_us=%u conn_interval=%u",
+            stats.reports, stats.peak_report_rate, link.report_rate, link.missed,
+            timing_avg(&stats.report_latency), stats.report_latency.max, link.conn_interval);
+}
+
+static void sim_bench_work_handler(struct k_work *work)
+{
+    static bool started = false;
+
+    if (!started) {
+        started = true;
+
+        bt_addr_le_t addrs[DEVMGR_MAX_CONFIG_ENTRIES];
+        if (devmgr_get_devices(addrs) == 0) {
+            LOG_INF("bench: pairing");
+            devmgr_set_mode(DEVMGR_MODE_PAIRING, true);
+        }
+
+        // For the btjp client of the stream scenario
+        btsvc_start_advertising();
+    } else {
+        print_stats();
+    }
+
+    k_work_schedule(&g_sim_bench_work, K_MSEC(SIM_BENCH_PRINT_INTERVAL));
+}
+
+static int sim_bench_init(void)
+{
+    k_work_init_delayable(&g_sim_bench_work, sim_bench_work_handler);
+    k_work_schedule(&g_sim_bench_work, K_MSEC(SIM_BENCH_START_DELAY));
+
+    return 0;
+}
+
+SYS_INIT(sim_bench_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
@@ -0,0 +1,68 @@
+/*
+ * This file is part of the Blue2Joy project
+ * (https://github.com/cepetr/blue2joy).
+ * Copyright (c) 2025
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <zephyr/kernel.h>
+
+#include <io/io_pot.h>
+#include <io/rgbled.h>
+#include <io/spislave.h>
+#include <usbsvc/usbsvc.h>
+
+// Stubs of the drivers using peripherals without a BabbleSim model
+// (COMP, SPIM, SPIS and USB). The joystick pins (io_pin) run on the
+// simulated GPIO, the autofire engine uses its timer fallback.
+
+int io_pot_init(void)
+{
+    return 0;
+}
+
+void io_pot_set(uint8_t pot_idx, int value)
+{
+}
+
+void io_pot_update_encoder(uint8_t pot_idx, int32_t delta, int32_t max)
+{
+}
+
+int rgbled_init(void)
+{
+    return 0;
+}
+
+void rgbled_set_brightness(uint8_t brightness)
+{
+}
+
+void rgbled_set_state(const rgbled_seq_t *seq)
+{
+}
+
+void rgbled_set_event(const rgbled_seq_t *seq)
+{
+}
+
+int spi_slave_init(void)
+{
+    return 0;
+}
+
+int usbsvc_init(void)
+{
+    return 0;
+}
@@ -0,0 +1,143 @@
+/*
+ * This file is part of the Blue2Joy project - an interface converter
+ * between a Bluetooth gamepad and a retro console joystick
+ * (https://github.com/cepetr/blue2joy).
+ * Copyright (c) 2025
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/logging/log_ctrl.h>
+#include <zephyr/net_buf.h>
+
+#include <event/event_bus.h>
+#include <event/event_queue.h>
+
+#include "sysmon.h"
+
+LOG_MODULE_DECLARE(blue2joy, CONFIG_LOG_DEFAULT_LEVEL);
+
+static workq_work_t g_sysmon_work;
+
+typedef struct {
+    sysmon_stats_t *stats;
+    uint64_t total_cycles;
+} thread_scan_t;
+
+static void scan_thread(const struct k_thread *cthread, void *user_data)
+{
+    thread_scan_t *scan = (thread_scan_t *)user_data;
+    sysmon_stats_t *stats = scan->stats;
+    struct k_thread *thread = (struct k_thread *)cthread;
+
+    if (stats->thread_count >= ARRAY_SIZE(stats->thread)) {
+        return;
+    }
+
+    sysmon_thread_stats_t *ts = &stats->thread[stats->thread_count++];
+
+    const char *name = k_thread_name_get(thread);
+    if (name != NULL) {
+        strncpy(ts->name, name, sizeof(ts->name));
+    } else {
+        memset(ts->name, 0, sizeof(ts->name));
+    }
+
+    ts->stack_size = thread->stack_info.size;
+
+    size_t unused = 0;
+    if (k_thread_stack_space_get(thread, &unused) == 0) {
+        ts->stack_unused = unused;
+    } else {
+        ts->stack_unused = ts->stack_size;
+    }
+
+    k_thread_runtime_stats_t rt;
+    if (scan->total_cycles > 0 && k_thread_runtime_stats_get(thread, &rt) == 0) {
+        ts->cpu = (uint16_t)MIN(rt.execution_cycles * 1000 / scan->total_cycles, 1000);
+    } else {
+        ts->cpu = 0;
+    }
+}
+
+void sysmon_get_stats(sysmon_stats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+
+    stats->uptime = k_uptime_get_32();
+
+    // Log buffer
+    uint32_t usage;
+    if (log_mem_get_usage(&stats->log_buf_size, &usage) == 0) {
+        log_mem_get_max_usage(&stats->log_buf_peak);
+    }
+
+    // Event queues
+    event_queue_stats_t evq_stats;
+    event_queue_get_stats(&evq_stats);
+    stats->evq_peak = evq_stats.peak;
+    stats->evq_overflows = evq_stats.overflows;
+
+    // Network buffer pools
+    STRUCT_SECTION_FOREACH(net_buf_pool, pool) {
+        stats->bt_buf_total += pool->buf_count;
+        stats->bt_buf_used += pool->buf_count - atomic_get(&pool->avail_count);
+    }
+
+    // Work queues
+    for (int i = 0; i < WORKQ_COUNT; i++) {
+        workq_stats_t wq_stats;
+        workq_get_stats((workq_id_t)i, &wq_stats);
+        stats->workq_latency_max[i] = wq_stats.latency_max;
+    }
+
+    // Threads
+    // (not locked, stack scanning takes too long to keep the interrupts off)
+    thread_scan_t scan = {
+        .stats = stats,
+    };
+
+    k_thread_runtime_stats_t all;
+    if (k_thread_runtime_stats_all_get(&all) == 0) {
+        scan.total_cycles = all.execution_cycles;
+    }
+
+    k_thread_foreach_unlocked(scan_thread, &scan);
+}
+
+static void sysmon_work_handler(workq_work_t *work)
+{
+    event_t ev = {
+        .subject = EV_SUBJECT_SYS_STATS,
+        .action = EV_ACTION_UPDATE,
+    };
+
+    event_bus_publish(&ev);
+
+    workq_schedule(work, K_MSEC(SYSMON_EVENT_INTERVAL));
+}
+
+int sysmon_init(void)
+{
+    workq_init_work(&g_sysmon_work, WORKQ_PROTOCOL, sysmon_work_handler);
+
+    if (SYSMON_EVENT_INTERVAL > 0) {
+        workq_schedule(&g_sysmon_work, K_MSEC(SYSMON_EVENT_INTERVAL));
+    }
+
+    return 0;
+}
@@ -0,0 +1,76 @@
+/*
+ * This file is part of the Blue2Joy project - an interface converter
+ * between a Bluetooth gamepad and a retro console joystick
+ * (https://github.com/cepetr/blue2joy).
+ * Copyright (c) 2025
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <workq/workq.h>
+
+// Maximum number of threads reported
+#define SYSMON_MAX_THREADS 12
+
+// Length of the reported thread name (not terminated if it's full)
+#define SYSMON_THREAD_NAME_LEN 8
+
+// Period of the EV_SUBJECT_SYS_STATS event in ms (0 => disabled)
+// (off by default, clients request GET_SYS_STATS when they show
+// the statistics, the event is for debugging builds)
+#ifndef SYSMON_EVENT_INTERVAL
+#define SYSMON_EVENT_INTERVAL 0
+#endif
+
+typedef struct {
+    char name[SYSMON_THREAD_NAME_LEN];
+    // Stack size and the part that was never used (bytes)
+    uint32_t stack_size;
+    uint32_t stack_unused;
+    // Share of the CPU time since boot (0.1 %)
+    uint16_t cpu;
+} sysmon_thread_stats_t;
+
+typedef struct {
+    // Time since boot (ms)
+    uint32_t uptime;
+    // Deferred log buffer size and its peak usage (bytes),
+    // messages are dropped when the peak reaches the size
+    uint32_t log_buf_size;
+    uint32_t log_buf_peak;
+    // Highest number of pending events in an event queue
+    uint32_t evq_peak;
+    // Number of event queue overflows (resynchronizations)
+    uint32_t evq_overflows;
+    // Network buffers (BT host and L2CAP streams) in use
+    uint32_t bt_buf_used;
+    uint32_t bt_buf_total;
+    // Longest work item latency of each work queue (us)
+    uint32_t workq_latency_max[WORKQ_COUNT];
+
+    size_t thread_count;
+    sysmon_thread_stats_t thread[SYSMON_MAX_THREADS];
+} sysmon_stats_t;
+
+// Starts publishing the periodic statistics event
+// Returns 0 on success, error code otherwise
+int sysmon_init(void);
+
+// Collects the current system statistics
+// (scans the thread stacks, don't call it from time critical code)
+void sysmon_get_stats(sysmon_stats_t *stats);
@@ -0,0 +1,404 @@
+/*
+ * This file is part of the Blue2Joy project
+ * (https://github.com/cepetr/blue2joy).
+ * Copyright (c) 2025
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/uart.h>
+#include <zephyr/sys/ring_buffer.h>
+#include <zephyr/usb/usb_device.h>
+
+#include <event/event_bus.h>
+#include <event/event_queue.h>
+#include <workq/workq.h>
+#include <btjp/btjp_msg.h>
+#include <btjp/btjp.h>
+
+#include "usbsvc.h"
+
+LOG_MODULE_DECLARE(blue2joy, CONFIG_LOG_DEFAULT_LEVEL);
+
+// btjp messages are sent over the serial port in the same format as
+// over BLE. The message header carries the payload size, so messages
+// are simply concatenated in the byte stream. The session is open
+// while the host keeps DTR asserted.
+
+#if DT_HAS_CHOSEN(blue2joy_btjp_uart)
+
+#define USBSVC_RX_BUF_SIZE 512
+#define USBSVC_TX_BUF_SIZE 2048
+
+// Largest btjp message (8-bit payload size)
+#define USBSVC_MAX_MSG_SIZE (sizeof(btjp_msg_header_t) + UINT8_MAX)
+
+// Line state polling interval (ms)
+#define USBSVC_POLL_INTERVAL 100
+
+// Incomplete request is dropped if no byte arrives within (ms)
+#define USBSVC_RX_TIMEOUT 100
+
+// ------------------------------------------------------------------
+// btjp connection context
+// ------------------------------------------------------------------
+
+typedef struct {
+    const struct device *dev;
+
+    // Host has the port open
+    bool open;
+
+    workq_work_t request_work;
+    workq_work_t event_work;
+
+    // Received bytes (written by the UART ISR)
+    struct ring_buf rx_ring;
+    uint8_t rx_ring_buf[USBSVC_RX_BUF_SIZE];
+    // Uptime of the last received byte (ms)
+    uint32_t rx_time;
+
+    // Bytes to send (read by the UART ISR)
+    struct ring_buf tx_ring;
+    uint8_t tx_ring_buf[USBSVC_TX_BUF_SIZE];
+
+    event_queue_t evq;
+
+} usbsvc_session_t;
+
+typedef struct {
+    usbsvc_session_t session;
+    // Work item polling the line state (DTR)
+    workq_work_t poll_work;
+} usbsvc_t;
+
+static usbsvc_t g_usbsvc;
+
+// Session whose request is processed by the current thread
+// (see the same in btsvc.c)
+static __thread usbsvc_session_t *request_origin = NULL;
+
+static void uart_isr(const struct device *dev, void *user_data)
+{
+    usbsvc_session_t *session = (usbsvc_session_t *)user_data;
+
+    while (uart_irq_update(dev) && uart_irq_is_pending(dev)) {
+        if (uart_irq_rx_ready(dev)) {
+            uint8_t *data;
+            uint32_t size = ring_buf_put_claim(&session->rx_ring, &data, USBSVC_RX_BUF_SIZE);
+            if (size == 0) {
+                // Re-enabled when the request work makes room
+                uart_irq_rx_disable(dev);
+            } else {
+                int len = uart_fifo_read(dev, data, size);
+                ring_buf_put_finish(&session->rx_ring, MAX(len, 0));
+                session->rx_time = k_uptime_get_32();
+            }
+            workq_reschedule(&session->request_work, K_NO_WAIT);
+        }
+
+        if (uart_irq_tx_ready(dev)) {
+            uint8_t *data;
+            uint32_t size = ring_buf_get_claim(&session->tx_ring, &data, USBSVC_TX_BUF_SIZE);
+            if (size == 0) {
+                uart_irq_tx_disable(dev);
+            } else {
+                int len = uart_fifo_fill(dev, data, size);
+                ring_buf_get_finish(&session->tx_ring, MAX(len, 0));
+            }
+
+            if (session->open && ring_buf_space_get(&session->tx_ring) >= USBSVC_MAX_MSG_SIZE) {
+                // Room for the next event
+                workq_reschedule(&session->event_work, K_NO_WAIT);
+            }
+        }
+    }
+}
+
+// Queues a message for sending
+// (the caller checks there's room for USBSVC_MAX_MSG_SIZE bytes)
+static void usbsvc_send(usbsvc_session_t *session, const uint8_t *data, size_t len)
+{
+    if (len == 0) {
+        return;
+    }
+
+    uint32_t written = ring_buf_put(&session->tx_ring, data, len);
+    if (written != len) {
+        LOG_ERR("USB TX buffer overflow {len: %d, written: %d}", (int)len, (int)written);
+    }
+
+    uart_irq_tx_enable(session->dev);
+}
+
+static void session_open(usbsvc_session_t *session);
+static bool port_is_open(const struct device *dev);
+
+// Drops all received bytes
+// (consumer side only, safe against the UART ISR)
+static void rx_discard(usbsvc_session_t *session)
+{
+    ring_buf_get(&session->rx_ring, NULL, ring_buf_size_get(&session->rx_ring));
+}
+
+// Drops an incomplete request once the host stopped sending
+// (e.g. a request cut off by closing the port)
+//
+// Returns true if the request was dropped
+static bool rx_check_timeout(usbsvc_session_t *session)
+{
+    uint32_t idle = k_uptime_get_32() - session->rx_time;
+
+    if (idle < USBSVC_RX_TIMEOUT) {
+        // Rest of the request is on the way
+        // (replaced by the ISR when the next byte arrives)
+        workq_reschedule(&session->request_work, K_MSEC(USBSVC_RX_TIMEOUT - idle));
+        return false;
+    }
+
+    LOG_WRN("Incomplete request dropped {size: %d}", (int)ring_buf_size_get(&session->rx_ring));
+    rx_discard(session);
+    return true;
+}
+
+// Processes all complete requests received so far
+static void request_work_handler(workq_work_t *work)
+{
+    usbsvc_session_t *session = CONTAINER_OF(work, usbsvc_session_t, request_work);
+
+    uint8_t rx_buf[USBSVC_MAX_MSG_SIZE];
+    uint8_t tx_buf[USBSVC_MAX_MSG_SIZE];
+
+    if (!session->open) {
+        if (port_is_open(session->dev)) {
+            // Request sent right after DTR was asserted,
+            // before the line state poll noticed
+            session_open(session);
+        } else {
+            // Nobody to respond to
+            rx_discard(session);
+        }
+    }
+
+    while (session->open) {
+        btjp_msg_header_t hdr;
+
+        if (ring_buf_peek(&session->rx_ring, (uint8_t *)&hdr, sizeof(hdr)) < sizeof(hdr)) {
+            if (!ring_buf_is_empty(&session->rx_ring)) {
+                rx_check_timeout(session);
+            }
+            break;
+        }
+
+        if ((hdr.flags & BTJP_MSG_TYPE_MASK) != BTJP_MSG_TYPE_REQUEST) {
+            // Not a btjp request (e.g. "AT" probe of a modem manager),
+            // the stream is in sync again once the host waits for a response
+            LOG_WRN("Invalid request header, input dropped {flags: 0x%02x}", hdr.flags);
+            rx_discard(session);
+            break;
+        }
+
+        size_t msg_size = sizeof(hdr) + hdr.size;
+        if (ring_buf_size_get(&session->rx_ring) < msg_size) {
+            // Incomplete message
+            rx_check_timeout(session);
+            break;
+        }
+
+        if (ring_buf_space_get(&session->tx_ring) < USBSVC_MAX_MSG_SIZE) {
+            // Wait until the host reads the previous responses
+            workq_reschedule(&session->request_work, K_MSEC(1));
+            break;
+        }
+
+        ring_buf_get(&session->rx_ring, rx_buf, msg_size);
+
+        request_origin = (hdr.flags & BTJP_MSG_FLAG_ECHO) ? NULL : session;
+
+        size_t tx_size =
+            btjp_handle_message(rx_buf, msg_size, tx_buf, sizeof(tx_buf), &session->evq);
+
+        request_origin = NULL;
+
+        usbsvc_send(session, tx_buf, tx_size);
+    }
+
+    uart_irq_rx_enable(session->dev);
+}
+
+// Sends queued events while there's room in the TX buffer
+static void event_work_handler(workq_work_t *work)
+{
+    usbsvc_session_t *session = CONTAINER_OF(work, usbsvc_session_t, event_work);
+
+    uint8_t tx_buf[USBSVC_MAX_MSG_SIZE];
+
+    while (session->open && ring_buf_space_get(&session->tx_ring) >= USBSVC_MAX_MSG_SIZE) {
+        size_t tx_size = btjp_build_evt_message(tx_buf, sizeof(tx_buf), &session->evq);
+        if (tx_size == 0) {
+            // Nothing to send
+            break;
+        }
+        usbsvc_send(session, tx_buf, tx_size);
+    }
+}
+
+// Called from when a new event occurs on event bus
+// (invoked from arbitrary thread context)
+static void event_callback(void *context, const event_t *ev)
+{
+    usbsvc_session_t *session = (usbsvc_session_t *)context;
+
+    if (session == request_origin &&
+        (ev->subject == EV_SUBJECT_PROFILE || ev->subject == EV_SUBJECT_DEV_LIST)) {
+        // Echo of the session's own configuration change
+        return;
+    }
+
+    event_queue_push(&session->evq, ev);
+
+    workq_reschedule(&session->event_work, K_NO_WAIT);
+}
+
+// ------------------------------------------------------------------
+// Session management
+// ------------------------------------------------------------------
+
+static void session_open(usbsvc_session_t *session)
+{
+    if (event_queue_init(&session->evq) != 0) {
+        LOG_ERR("Failed to create event queue");
+        return;
+    }
+
+    btjp_populate_event_queue(&session->evq);
+
+    int err = event_bus_subscribe(event_callback, session);
+    if (err) {
+        LOG_ERR("Failed to subscribe to event bus {err: %d}", err);
+        return;
+    }
+
+    session->open = true;
+    workq_reschedule(&session->event_work, K_NO_WAIT);
+
+    LOG_INF("USB session opened");
+}
+
+static void session_close(usbsvc_session_t *session)
+{
+    event_bus_unsubscribe(event_callback, session);
+
+    session->open = false;
+    workq_cancel(&session->event_work);
+    workq_cancel(&session->request_work);
+
+    // Drop the data nobody is going to read
+    uart_irq_tx_disable(session->dev);
+    ring_buf_reset(&session->tx_ring);
+
+    // and the rest of the last request
+    rx_discard(session);
+    uart_irq_rx_enable(session->dev);
+
+    LOG_INF("USB session closed");
+}
+
+// Returns true if the host has the port open
+static bool port_is_open(const struct device *dev)
+{
+    uint32_t dtr = 0;
+
+    int err = uart_line_ctrl_get(dev, UART_LINE_CTRL_DTR, &dtr);
+    if (err) {
+        // Ports without line control (e.g. pty on native_sim)
+        // are always open
+        return true;
+    }
+
+    return dtr != 0;
+}
+
+static void poll_work_handler(workq_work_t *work)
+{
+    usbsvc_t *svc = &g_usbsvc;
+    usbsvc_session_t *session = &svc->session;
+
+    bool open = port_is_open(session->dev);
+
+    if (open && !session->open) {
+        // Bytes received before DTR was asserted belong to the previous client
+        // (a request sent after it opens the session in the request work)
+        rx_discard(session);
+        uart_irq_rx_enable(session->dev);
+        session_open(session);
+    } else if (!open && session->open) {
+        session_close(session);
+    }
+
+    workq_schedule(&svc->poll_work, K_MSEC(USBSVC_POLL_INTERVAL));
+}
+
+int usbsvc_init(void)
+{
+    usbsvc_t *svc = &g_usbsvc;
+    usbsvc_session_t *session = &svc->session;
+
+    memset(svc, 0, sizeof(usbsvc_t));
+
+    session->dev = DEVICE_DT_GET(DT_CHOSEN(blue2joy_btjp_uart));
+    if (!device_is_ready(session->dev)) {
+        LOG_ERR("USB btjp port not ready");
+        return -ENODEV;
+    }
+
+    ring_buf_init(&session->rx_ring, sizeof(session->rx_ring_buf), session->rx_ring_buf);
+    ring_buf_init(&session->tx_ring, sizeof(session->tx_ring_buf), session->tx_ring_buf);
+
+    workq_init_work(&session->request_work, WORKQ_PROTOCOL, request_work_handler);
+    workq_init_work(&session->event_work, WORKQ_PROTOCOL, event_work_handler);
+    workq_init_work(&svc->poll_work, WORKQ_PROTOCOL, poll_work_handler);
+
+    int err = uart_irq_callback_user_data_set(session->dev, uart_isr, session);
+    if (err) {
+        LOG_ERR("Failed to set UART callback {err: %d}", err);
+        return err;
+    }
+
+    uart_irq_rx_enable(session->dev);
+
+#ifdef CONFIG_USB_DEVICE_STACK
+    err = usb_enable(NULL);
+    if (err && err != -EALREADY) {
+        LOG_ERR("USB device stack init failed {err: %d}", err);
+        return err;
+    }
+#endif
+
+    workq_schedule(&svc->poll_work, K_NO_WAIT);
+
+    return 0;
+}
+
+#else
+
+int usbsvc_init(void)
+{
+    // No port configured
+    return 0;
+}
+
+#endif
@@ -0,0 +1,184 @@
+/*
+ * This file is part of the Blue2Joy project - an interface converter
+ * between a Bluetooth gamepad and a retro console joystick
+ * (https://github.com/cepetr/blue2joy).
+ * Copyright (c) 2025
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+#include "workq.h"
+
+LOG_MODULE_DECLARE(blue2joy, CONFIG_LOG_DEFAULT_LEVEL);
+
+#define WORKQ_INPUT_STACK_SIZE    2048
+#define WORKQ_PROTOCOL_STACK_SIZE 4096
+#define WORKQ_PERSIST_STACK_SIZE  3072
+
+K_THREAD_STACK_DEFINE(workq_input_stack, WORKQ_INPUT_STACK_SIZE);
+K_THREAD_STACK_DEFINE(workq_protocol_stack, WORKQ_PROTOCOL_STACK_SIZE);
+K_THREAD_STACK_DEFINE(workq_persist_stack, WORKQ_PERSIST_STACK_SIZE);
+
+typedef struct {
+    struct k_work_q q;
+    // Number of scheduled items not started yet
+    atomic_t backlog;
+    // Protects stats
+    struct k_spinlock lock;
+    workq_stats_t stats;
+} workq_queue_t;
+
+typedef struct {
+    workq_queue_t queue[WORKQ_COUNT];
+} workq_t;
+
+static workq_t g_workq;
+
+static void workq_start(workq_id_t id, k_thread_stack_t *stack, size_t stack_size, int prio,
+                        const char *name)
+{
+    workq_queue_t *queue = &g_workq.queue[id];
+
+    const struct k_work_queue_config cfg = {
+        .name = name,
+    };
+
+    k_work_queue_init(&queue->q);
+    k_work_queue_start(&queue->q, stack, stack_size, prio, &cfg);
+}
+
+int workq_init(void)
+{
+    workq_t *workq = &g_workq;
+
+    memset(workq, 0, sizeof(workq_t));
+
+    workq_start(WORKQ_INPUT, workq_input_stack, K_THREAD_STACK_SIZEOF(workq_input_stack),
+                WORKQ_INPUT_PRIORITY, "workq_input");
+    workq_start(WORKQ_PROTOCOL, workq_protocol_stack,
+                K_THREAD_STACK_SIZEOF(workq_protocol_stack), WORKQ_PROTOCOL_PRIORITY,
+                "workq_protocol");
+    workq_start(WORKQ_PERSIST, workq_persist_stack, K_THREAD_STACK_SIZEOF(workq_persist_stack),
+                WORKQ_PERSIST_PRIORITY, "workq_persist");
+
+    return 0;
+}
+
+// Runs the work handler and measures its latency
+static void workq_handler(struct k_work *work_)
+{
+    struct k_work_delayable *dwork = k_work_delayable_from_work(work_);
+    workq_work_t *work = CONTAINER_OF(dwork, workq_work_t, dwork);
+    workq_queue_t *queue = &g_workq.queue[work->queue];
+
+    uint32_t start = k_cycle_get_32();
+    uint32_t latency = k_cyc_to_us_floor32(start - work->due);
+
+    atomic_dec(&queue->backlog);
+
+    work->handler(work);
+
+    uint32_t exec = k_cyc_to_us_floor32(k_cycle_get_32() - start);
+
+    k_spinlock_key_t key = k_spin_lock(&queue->lock);
+    workq_stats_t *stats = &queue->stats;
+    stats->count++;
+    stats->latency_last = latency;
+    stats->latency_max = MAX(stats->latency_max, latency);
+    stats->latency_sum += latency;
+    stats->exec_max = MAX(stats->exec_max, exec);
+    k_spin_unlock(&queue->lock, key);
+}
+
+void workq_init_work(workq_work_t *work, workq_id_t queue, workq_handler_t handler)
+{
+    memset(work, 0, sizeof(workq_work_t));
+    k_work_init_delayable(&work->dwork, workq_handler);
+    work->handler = handler;
+    work->queue = queue;
+}
+
+// Returns true if the work waits for its delay or in the queue
+// (a running work can be scheduled again)
+static bool workq_is_scheduled(workq_work_t *work)
+{
+    return (k_work_delayable_busy_get(&work->dwork) & (K_WORK_DELAYED | K_WORK_QUEUED)) != 0;
+}
+
+// Counts a newly scheduled work item
+static void workq_add_backlog(workq_queue_t *queue)
+{
+    uint32_t backlog = atomic_inc(&queue->backlog) + 1;
+
+    k_spinlock_key_t key = k_spin_lock(&queue->lock);
+    queue->stats.backlog_peak = MAX(queue->stats.backlog_peak, backlog);
+    k_spin_unlock(&queue->lock, key);
+}
+
+void workq_schedule(workq_work_t *work, k_timeout_t delay)
+{
+    workq_queue_t *queue = &g_workq.queue[work->queue];
+
+    if (workq_is_scheduled(work)) {
+        return;
+    }
+
+    work->due = k_cycle_get_32() + k_ticks_to_cyc_floor32(delay.ticks);
+
+    if (k_work_schedule_for_queue(&queue->q, &work->dwork, delay) > 0) {
+        workq_add_backlog(queue);
+    }
+}
+
+void workq_reschedule(workq_work_t *work, k_timeout_t delay)
+{
+    workq_queue_t *queue = &g_workq.queue[work->queue];
+
+    bool scheduled = workq_is_scheduled(work);
+
+    work->due = k_cycle_get_32() + k_ticks_to_cyc_floor32(delay.ticks);
+
+    if (k_work_reschedule_for_queue(&queue->q, &work->dwork, delay) > 0 && !scheduled) {
+        workq_add_backlog(queue);
+    }
+}
+
+void workq_cancel(workq_work_t *work)
+{
+    workq_queue_t *queue = &g_workq.queue[work->queue];
+
+    if (workq_is_scheduled(work)) {
+        // Removed before it started
+        k_work_cancel_delayable(&work->dwork);
+        atomic_dec(&queue->backlog);
+    }
+}
+
+bool workq_is_busy(workq_work_t *work)
+{
+    return k_work_delayable_busy_get(&work->dwork) != 0;
+}
+
+void workq_get_stats(workq_id_t queue, workq_stats_t *stats)
+{
+    workq_queue_t *q = &g_workq.queue[queue];
+
+    k_spinlock_key_t key = k_spin_lock(&q->lock);
+    *stats = q->stats;
+    k_spin_unlock(&q->lock, key);
+
+    stats->backlog = atomic_get(&q->backlog);
+}
@@ -0,0 +1,105 @@
+/*
+ * This file is part of the Blue2Joy project - an interface converter
+ * between a Bluetooth gamepad and a retro console joystick
+ * (https://github.com/cepetr/blue2joy).
+ * Copyright (c) 2025
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <zephyr/kernel.h>
+
+// Thread priorities of the work queues
+// (can be overridden from the build, lower value is more urgent)
+#ifndef WORKQ_INPUT_PRIORITY
+#define WORKQ_INPUT_PRIORITY K_PRIO_COOP(2)
+#endif
+#ifndef WORKQ_PROTOCOL_PRIORITY
+#define WORKQ_PROTOCOL_PRIORITY K_PRIO_PREEMPT(4)
+#endif
+#ifndef WORKQ_PERSIST_PRIORITY
+#define WORKQ_PERSIST_PRIORITY K_PRIO_PREEMPT(10)
+#endif
+
+// Application work queues
+typedef enum {
+    // HID input processing and joystick port updates
+    WORKQ_INPUT = 0,
+    // btjp requests and events, advertising
+    WORKQ_PROTOCOL = 1,
+    // Flash writes
+    WORKQ_PERSIST = 2,
+
+    WORKQ_COUNT,
+} workq_id_t;
+
+typedef struct workq_work workq_work_t;
+
+typedef void (*workq_handler_t)(workq_work_t *work);
+
+// Work item bound to one of the work queues
+struct workq_work {
+    struct k_work_delayable dwork;
+    workq_handler_t handler;
+    workq_id_t queue;
+    // Cycle counter value when the work is due
+    uint32_t due;
+};
+
+// Work queue statistics
+typedef struct {
+    // Number of executed work items
+    uint32_t count;
+    // Due -> handler started (us)
+    uint32_t latency_last;
+    uint32_t latency_max;
+    uint64_t latency_sum;
+    // Longest handler run time (us)
+    uint32_t exec_max;
+    // Work items scheduled and not started yet
+    uint32_t backlog;
+    uint32_t backlog_peak;
+} workq_stats_t;
+
+// Starts the work queue threads
+int workq_init(void);
+
+// Initializes a work item
+void workq_init_work(workq_work_t *work, workq_id_t queue, workq_handler_t handler);
+
+// Schedules the work after the delay, does nothing if it's already scheduled
+// (K_NO_WAIT submits the work immediately)
+void workq_schedule(workq_work_t *work, k_timeout_t delay);
+
+// Schedules the work after the delay, replaces the previous delay
+void workq_reschedule(workq_work_t *work, k_timeout_t delay);
+
+// Submits the work immediately
+static inline void workq_submit(workq_work_t *work)
+{
+    workq_schedule(work, K_NO_WAIT);
+}
+
+// Cancels the scheduled work (doesn't wait for a running handler)
+void workq_cancel(workq_work_t *work);
+
+// Returns true if the work is scheduled or running
+bool workq_is_busy(workq_work_t *work);
+
+// Retrieves statistics of the work queue
+void workq_get_stats(workq_id_t queue, workq_stats_t *stats);
@@ -0,0 +1,419 @@
+/*
+ * This file is part of the Blue2Joy project
+ * (https://github.com/cepetr/blue2joy).
+ * Copyright (c) 2025
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/printk.h>
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/bluetooth/conn.h>
+#include <zephyr/bluetooth/l2cap.h>
+#include <zephyr/bluetooth/uuid.h>
+#include <zephyr/bluetooth/hci.h>
+
+#include "bs_tracing.h"
+#include "bs_types.h"
+#include "bstests.h"
+
+#include <btjp/btjp_msg.h>
+
+// Stand-in btjp client for the blue2joy BabbleSim bench
+// (see ../../README.md)
+//
+// Connects to blue2joy, opens the stream channel and requests the HID
+// report capture repeatedly. The channel must only open on an encrypted
+// link, the client doesn't ask for security itself (the stack pairs when
+// the firmware refuses the channel).
+//
+// Test arguments (after -argstest):
+//
+//   streams=<n>   capture streams to receive before the test passes
+//                 (default 5)
+//   pause=<ms>    delay between the end of a stream and the next request,
+//                 the capture fills up in the meantime (default 1000)
+
+extern enum bst_result_t bst_result;
+
+#define FAIL(...)                                                                                  \
+    do {                                                                                           \
+        bst_result = Failed;                                                                       \
+        bs_trace_error_time_line(__VA_ARGS__);                                                     \
+    } while (0)
+
+#define PASS(...)                                                                                  \
+    do {                                                                                           \
+        bst_result = Passed;                                                                       \
+        bs_trace_info_time(1, __VA_ARGS__);                                                        \
+    } while (0)
+
+// Simulated time after which the test fails if it didn't pass (us)
+#define BTJP_TEST_TIMEOUT (55 * 1000 * 1000)
+
+// Largest SDU accepted (the firmware sends up to 1024 bytes)
+#define BTJP_STREAM_RX_MTU 1024
+
+// 7.5 ms connection interval
+#define BTJP_CONN_INTERVAL 6
+
+NET_BUF_POOL_FIXED_DEFINE(rx_pool, 2, BT_L2CAP_SDU_BUF_SIZE(BTJP_STREAM_RX_MTU), 8, NULL);
+NET_BUF_POOL_FIXED_DEFINE(tx_pool, 1, BT_L2CAP_SDU_BUF_SIZE(1), CONFIG_BT_CONN_TX_USER_DATA_SIZE,
+                          NULL);
+
+typedef struct {
+    uint32_t streams;
+    uint32_t pause;
+} btjp_args_t;
+
+typedef struct {
+    btjp_args_t args;
+
+    struct bt_conn *conn;
+    struct bt_l2cap_le_chan chan;
+
+    // Current stream
+    uint32_t start;
+    uint32_t bytes;
+    uint32_t sdus;
+
+    // Completed streams
+    uint32_t streams;
+    uint32_t total_sdus;
+    uint64_t total_bytes;
+    uint64_t total_us;
+
+    struct k_work_delayable request_work;
+
+} btjp_t;
+
+static btjp_t g_btjp = {
+    .args =
+        {
+            .streams = 5,
+            .pause = 1000,
+        },
+};
+
+static const uint8_t btjp_svc_uuid[] = {
+    BT_UUID_128_ENCODE(0x1C3B0000, 0x03F0, 0x5B46, 0x7A5A, 0x10A4D8EB5964)};
+
+// ------------------------------------------------------------------
+// Stream channel
+// ------------------------------------------------------------------
+
+static void print_stats(btjp_t *btjp)
+{
+    uint32_t kbps = btjp->total_us > 0 ? (uint32_t)(btjp->total_bytes * 8000 / btjp->total_us) : 0;
+
+    printk("btjp: streams=%u stream_bytes=%u stream_sdus=%u stream_us=%u stream_kbps=%u\n",
+           btjp->streams, (uint32_t)btjp->total_bytes, btjp->total_sdus,
+           (uint32_t)btjp->total_us, kbps);
+}
+
+static void request_work_handler(struct k_work *work)
+{
+    btjp_t *btjp = &g_btjp;
+
+    struct net_buf *buf = net_buf_alloc(&tx_pool, K_NO_WAIT);
+    if (buf == NULL) {
+        FAIL("No buffer for the stream request\n");
+        return;
+    }
+
+    net_buf_reserve(buf, BT_L2CAP_SDU_CHAN_SEND_RESERVE);
+    net_buf_add_u8(buf, BTJP_STREAM_REPORT_CAPTURE);
+
+    btjp->bytes = 0;
+    btjp->sdus = 0;
+    btjp->start = k_cycle_get_32();
+
+    int err = bt_l2cap_chan_send(&btjp->chan.chan, buf);
+    if (err < 0) {
+        net_buf_unref(buf);
+        FAIL("Failed to send the stream request (err %d)\n", err);
+    }
+}
+
+static void chan_connected(struct bt_l2cap_chan *chan)
+{
+    btjp_t *btjp = &g_btjp;
+
+    bt_security_t level = bt_conn_get_security(chan->conn);
+
+    printk("btjp: stream channel connected (security level %u, tx_mtu %u)\n", level,
+           btjp->chan.tx.mtu);
+
+    if (level < BT_SECURITY_L2) {
+        FAIL("Stream channel opened on an unencrypted link\n");
+        return;
+    }
+
+    k_work_schedule(&btjp->request_work, K_NO_WAIT);
+}
+
+static void chan_disconnected(struct bt_l2cap_chan *chan)
+{
+    printk("btjp: stream channel disconnected\n");
+}
+
+static struct net_buf *chan_alloc_buf(struct bt_l2cap_chan *chan)
+{
+    return net_buf_alloc(&rx_pool, K_NO_WAIT);
+}
+
+static int chan_recv(struct bt_l2cap_chan *chan, struct net_buf *buf)
+{
+    btjp_t *btjp = &g_btjp;
+
+    if (buf->len < sizeof(btjp_stream_hdr_t)) {
+        FAIL("Stream SDU too short\n");
+        return 0;
+    }
+
+    const btjp_stream_hdr_t *hdr = net_buf_pull_mem(buf, sizeof(btjp_stream_hdr_t));
+
+    if (hdr->stream != BTJP_STREAM_REPORT_CAPTURE) {
+        FAIL("Unexpected stream %u\n", hdr->stream);
+        return 0;
+    }
+
+    btjp->bytes += buf->len;
+    btjp->sdus++;
+
+    if ((hdr->flags & BTJP_STREAM_FLAG_END) == 0) {
+        return 0;
+    }
+
+    uint32_t duration = k_cyc_to_us_floor32(k_cycle_get_32() - btjp->start);
+
+    btjp->streams++;
+    btjp->total_sdus += btjp->sdus;
+    btjp->total_bytes += btjp->bytes;
+    btjp->total_us += duration;
+
+    printk("btjp: stream %u done (bytes %u, sdus %u, us %u)\n", btjp->streams, btjp->bytes,
+           btjp->sdus, duration);
+    print_stats(btjp);
+
+    if (btjp->streams >= btjp->args.streams) {
+        if (btjp->total_bytes == 0) {
+            FAIL("No captured reports received\n");
+        } else {
+            PASS("btjp client done\n");
+        }
+        return 0;
+    }
+
+    k_work_schedule(&btjp->request_work, K_MSEC(btjp->args.pause));
+
+    return 0;
+}
+
+static const struct bt_l2cap_chan_ops chan_ops = {
+    .connected = chan_connected,
+    .disconnected = chan_disconnected,
+    .alloc_buf = chan_alloc_buf,
+    .recv = chan_recv,
+};
+
+// ------------------------------------------------------------------
+// Connection handling
+// ------------------------------------------------------------------
+
+static bool ad_has_btjp_uuid(struct bt_data *data, void *user_data)
+{
+    bool *found = user_data;
+
+    if (data->type == BT_DATA_UUID128_ALL && data->data_len == sizeof(btjp_svc_uuid) &&
+        memcmp(data->data, btjp_svc_uuid, sizeof(btjp_svc_uuid)) == 0) {
+        *found = true;
+        return false;
+    }
+
+    return true;
+}
+
+static void device_found(const bt_addr_le_t *addr, int8_t rssi, uint8_t type,
+                         struct net_buf_simple *ad)
+{
+    btjp_t *btjp = &g_btjp;
+    bool found = false;
+
+    if (btjp->conn != NULL) {
+        return;
+    }
+
+    bt_data_parse(ad, ad_has_btjp_uuid, &found);
+    if (!found) {
+        return;
+    }
+
+    int err = bt_le_scan_stop();
+    if (err) {
+        FAIL("Failed to stop scanning (err %d)\n", err);
+        return;
+    }
+
+    struct bt_le_conn_param *param =
+        BT_LE_CONN_PARAM(BTJP_CONN_INTERVAL, BTJP_CONN_INTERVAL, 0, 400);
+
+    err = bt_conn_le_create(addr, BT_CONN_LE_CREATE_CONN, param, &btjp->conn);
+    if (err) {
+        FAIL("Failed to connect (err %d)\n", err);
+        return;
+    }
+
+    printk("btjp: connecting\n");
+}
+
+static void connected(struct bt_conn *conn, uint8_t err)
+{
+    btjp_t *btjp = &g_btjp;
+
+    if (err) {
+        FAIL("Connection failed (err 0x%02x)\n", err);
+        return;
+    }
+
+    printk("btjp: connected\n");
+
+    memset(&btjp->chan, 0, sizeof(btjp->chan));
+    btjp->chan.chan.ops = &chan_ops;
+    btjp->chan.rx.mtu = BTJP_STREAM_RX_MTU;
+
+    // No security requested, the firmware has to ask for it
+    btjp->chan.required_sec_level = BT_SECURITY_L1;
+
+    int ret = bt_l2cap_chan_connect(conn, &btjp->chan.chan, BTJP_STREAM_PSM);
+    if (ret) {
+        FAIL("Failed to connect the stream channel (err %d)\n", ret);
+    }
+}
+
+static void disconnected(struct bt_conn *conn, uint8_t reason)
+{
+    btjp_t *btjp = &g_btjp;
+
+    printk("btjp: disconnected (reason 0x%02x)\n", reason);
+
+    if (btjp->conn == conn) {
+        bt_conn_unref(btjp->conn);
+        btjp->conn = NULL;
+    }
+
+    if (bst_result != Passed) {
+        FAIL("Disconnected before the streams were received\n");
+    }
+}
+
+static void security_changed(struct bt_conn *conn, bt_security_t level, enum bt_security_err err)
+{
+    printk("btjp: security level %u (err %d)\n", level, err);
+}
+
+BT_CONN_CB_DEFINE(conn_callbacks) = {
+    .connected = connected,
+    .disconnected = disconnected,
+    .security_changed = security_changed,
+};
+
+// ------------------------------------------------------------------
+// Test
+// ------------------------------------------------------------------
+
+static void test_args(int argc, char *argv[])
+{
+    btjp_args_t *args = &g_btjp.args;
+
+    for (int i = 0; i < argc; i++) {
+        char *value = strchr(argv[i], '=');
+        if (value == NULL) {
+            FAIL("Invalid argument %s\n", argv[i]);
+            return;
+        }
+        *value++ = '\0';
+
+        if (strcmp(argv[i], "streams") == 0) {
+            args->streams = strtoul(value, NULL, 0);
+        } else if (strcmp(argv[i], "pause") == 0) {
+            args->pause = strtoul(value, NULL, 0);
+        } else {
+            FAIL("Unknown argument %s\n", argv[i]);
+        }
+    }
+}
+
+static void test_init(void)
+{
+    bst_ticker_set_next_tick_absolute(BTJP_TEST_TIMEOUT);
+    bst_result = In_progress;
+}
+
+static void test_tick(bs_time_t HW_device_time)
+{
+    if (bst_result != Passed) {
+        print_stats(&g_btjp);
+        FAIL("Test timed out\n");
+    }
+}
+
+static void test_main(void)
+{
+    btjp_t *btjp = &g_btjp;
+
+    k_work_init_delayable(&btjp->request_work, request_work_handler);
+
+    int err = bt_enable(NULL);
+    if (err) {
+        FAIL("Bluetooth init failed (err %d)\n", err);
+        return;
+    }
+
+    err = bt_le_scan_start(BT_LE_SCAN_PASSIVE, device_found);
+    if (err) {
+        FAIL("Scanning failed to start (err %d)\n", err);
+        return;
+    }
+
+    printk("btjp: scanning\n");
+}
+
+static const struct bst_test_instance test_def[] = {
+    {
+        .test_id = "btjp",
+        .test_descr = "Stand-in btjp client measuring the report capture stream throughput",
+        .test_args_f = test_args,
+        .test_pre_init_f = test_init,
+        .test_tick_f = test_tick,
+        .test_main_f = test_main,
+    },
+    BSTEST_END_MARKER,
+};
+
+static struct bst_test_list *test_btjp_install(struct bst_test_list *tests)
+{
+    return bst_add_tests(tests, test_def);
+}
+
+bst_test_install_t test_installers[] = {test_btjp_install, NULL};
+
+int main(void)
+{
+    bst_main();
+    return 0;
+}
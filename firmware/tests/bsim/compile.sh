@@ -0,0 +1,23 @@
+#!/usr/bin/env bash
+# Builds the blue2joy firmware, the HOGP peripheral and the btjp client for
+# the nrf52_bsim board and installs them into ${BSIM_OUT_PATH}/bin
+set -ue
+
+: "${BSIM_OUT_PATH:?BSIM_OUT_PATH must be defined}"
+: "${ZEPHYR_BASE:?ZEPHYR_BASE must be defined}"
+
+bench_dir="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+firmware_dir="$(cd "${bench_dir}/../.." && pwd)"
+build_dir="${BUILD_DIR:-${bench_dir}/build}"
+
+function compile() {
+  local app_dir=$1
+  local exe_name=$2
+
+  west build -p auto -b nrf52_bsim --no-sysbuild -d "${build_dir}/${exe_name}" "${app_dir}"
+  cp "${build_dir}/${exe_name}/zephyr/zephyr.exe" "${BSIM_OUT_PATH}/bin/${exe_name}"
+}
+
+compile "${firmware_dir}" bs_nrf52_bsim_blue2joy
+compile "${bench_dir}/hogp" bs_nrf52_bsim_blue2joy_hogp
+compile "${bench_dir}/btjp" bs_nrf52_bsim_blue2joy_btjp
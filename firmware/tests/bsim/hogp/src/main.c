@@ -0,0 +1,514 @@
+/*
+ * This file is part of the Blue2Joy project
+ * (https://github.com/cepetr/blue2joy).
+ * Copyright (c) 2025
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/printk.h>
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/bluetooth/conn.h>
+#include <zephyr/bluetooth/gatt.h>
+#include <zephyr/bluetooth/uuid.h>
+#include <zephyr/bluetooth/hci.h>
+
+#include "bs_tracing.h"
+#include "bs_types.h"
+#include "bstests.h"
+
+#include "report_maps.h"
+
+// Stand-in HOGP peripheral for the blue2joy BabbleSim bench
+// (see ../../README.md)
+//
+// Test arguments (after -argstest):
+//
+//   map=<gamepad|xbox|mouse>  report map (default gamepad)
+//   rate=<ms>                 report interval, 0 => as fast as the link
+//                             allows (default 10)
+//   interval=<n>              connection interval requested after the
+//                             subscription (1.25 ms units, 0 => keep)
+//   bond=<keep|none|forget>   keep the bond, don't bond at all, or forget
+//                             the bond after each disconnection (default keep)
+//   drop=<s>                  disconnect <s> seconds after the subscription
+//                             (0 => never, default 0)
+//   drops=<n>                 number of disconnections (default 1)
+//   reports=<n>               reports to send before the test passes
+//                             (default 1000)
+
+extern enum bst_result_t bst_result;
+
+#define FAIL(...)                                                                                  \
+    do {                                                                                           \
+        bst_result = Failed;                                                                       \
+        bs_trace_error_time_line(__VA_ARGS__);                                                     \
+    } while (0)
+
+#define PASS(...)                                                                                  \
+    do {                                                                                           \
+        bst_result = Passed;                                                                       \
+        bs_trace_info_time(1, __VA_ARGS__);                                                        \
+    } while (0)
+
+// Simulated time after which the test fails if it didn't pass (us)
+#define HOGP_TEST_TIMEOUT (55 * 1000 * 1000)
+
+// Notifications in flight (see CONFIG_BT_CONN_TX_MAX)
+#define HOGP_TX_MAX 4
+
+// Largest input report (incl. the report ID)
+#define HOGP_MAX_REPORT_SIZE 16
+
+typedef enum {
+    BOND_KEEP,
+    BOND_NONE,
+    BOND_FORGET,
+} bond_mode_t;
+
+typedef struct {
+    const report_map_t *map;
+    uint32_t rate;
+    uint16_t interval;
+    bond_mode_t bond;
+    uint32_t drop;
+    uint32_t drops;
+    uint32_t reports;
+} hogp_args_t;
+
+typedef struct {
+    hogp_args_t args;
+
+    struct bt_conn *conn;
+    bool subscribed;
+    // Uptime of the subscription (ms)
+    int64_t subscribed_at;
+
+    uint32_t seq;
+    uint32_t sent;
+    uint32_t skipped;
+    uint32_t drops;
+
+    // Free notification slots
+    struct k_sem tx_sem;
+    // Submit times of the notifications in flight (FIFO)
+    uint32_t tx_time[HOGP_TX_MAX];
+    uint8_t tx_head;
+    uint8_t tx_tail;
+    // Submit -> sent (link layer acknowledged) time (us)
+    uint32_t tx_latency_max;
+    uint64_t tx_latency_sum;
+
+    struct k_work adv_work;
+    struct k_work unpair_work;
+    bt_addr_le_t peer;
+
+} hogp_t;
+
+static hogp_t g_hogp = {
+    .args =
+        {
+            .rate = 10,
+            .drops = 1,
+            .reports = 1000,
+        },
+};
+
+// ------------------------------------------------------------------
+// HID service
+// ------------------------------------------------------------------
+
+static const uint8_t hids_info[] = {
+    0x11, 0x01, // bcdHID 1.11
+    0x00,       // country code
+    0x02,       // flags (normally connectable)
+};
+
+static uint8_t report_ref[2];
+
+static ssize_t read_info(struct bt_conn *conn, const struct bt_gatt_attr *attr, void *buf,
+                         uint16_t len, uint16_t offset)
+{
+    return bt_gatt_attr_read(conn, attr, buf, len, offset, hids_info, sizeof(hids_info));
+}
+
+static ssize_t read_report_map(struct bt_conn *conn, const struct bt_gatt_attr *attr, void *buf,
+                               uint16_t len, uint16_t offset)
+{
+    const report_map_t *map = g_hogp.args.map;
+    return bt_gatt_attr_read(conn, attr, buf, len, offset, map->map, map->map_size);
+}
+
+static ssize_t read_report(struct bt_conn *conn, const struct bt_gatt_attr *attr, void *buf,
+                           uint16_t len, uint16_t offset)
+{
+    uint8_t report[HOGP_MAX_REPORT_SIZE] = {0};
+    return bt_gatt_attr_read(conn, attr, buf, len, offset, report, g_hogp.args.map->report_size);
+}
+
+static ssize_t read_report_ref(struct bt_conn *conn, const struct bt_gatt_attr *attr, void *buf,
+                               uint16_t len, uint16_t offset)
+{
+    return bt_gatt_attr_read(conn, attr, buf, len, offset, report_ref, sizeof(report_ref));
+}
+
+static ssize_t write_ctrl_point(struct bt_conn *conn, const struct bt_gatt_attr *attr,
+                                const void *buf, uint16_t len, uint16_t offset, uint8_t flags)
+{
+    return len;
+}
+
+static void report_ccc_changed(const struct bt_gatt_attr *attr, uint16_t value)
+{
+    hogp_t *hogp = &g_hogp;
+
+    hogp->subscribed = (value == BT_GATT_CCC_NOTIFY);
+    hogp->subscribed_at = k_uptime_get();
+
+    printk("hogp: %s\n", hogp->subscribed ? "subscribed" : "unsubscribed");
+}
+
+BT_GATT_SERVICE_DEFINE(hids_svc, BT_GATT_PRIMARY_SERVICE(BT_UUID_HIDS),
+                       BT_GATT_CHARACTERISTIC(BT_UUID_HIDS_INFO, BT_GATT_CHRC_READ,
+                                              BT_GATT_PERM_READ, read_info, NULL, NULL),
+                       BT_GATT_CHARACTERISTIC(BT_UUID_HIDS_REPORT_MAP, BT_GATT_CHRC_READ,
+                                              BT_GATT_PERM_READ_ENCRYPT, read_report_map, NULL,
+                                              NULL),
+                       BT_GATT_CHARACTERISTIC(BT_UUID_HIDS_REPORT,
+                                              BT_GATT_CHRC_READ | BT_GATT_CHRC_NOTIFY,
+                                              BT_GATT_PERM_READ_ENCRYPT, read_report, NULL, NULL),
+                       BT_GATT_CCC(report_ccc_changed,
+                                   BT_GATT_PERM_READ | BT_GATT_PERM_WRITE_ENCRYPT),
+                       BT_GATT_DESCRIPTOR(BT_UUID_HIDS_REPORT_REF, BT_GATT_PERM_READ,
+                                          read_report_ref, NULL, NULL),
+                       BT_GATT_CHARACTERISTIC(BT_UUID_HIDS_CTRL_POINT,
+                                              BT_GATT_CHRC_WRITE_WITHOUT_RESP,
+                                              BT_GATT_PERM_WRITE, NULL, write_ctrl_point, NULL));
+
+// Value attribute of the input report characteristic
+#define HOGP_REPORT_ATTR (&hids_svc.attrs[6])
+
+// ------------------------------------------------------------------
+// Connection handling
+// ------------------------------------------------------------------
+
+static const struct bt_data ad[] = {
+    BT_DATA_BYTES(BT_DATA_FLAGS, (BT_LE_AD_GENERAL | BT_LE_AD_NO_BREDR)),
+    BT_DATA_BYTES(BT_DATA_GAP_APPEARANCE, (CONFIG_BT_DEVICE_APPEARANCE & 0xFF),
+                  (CONFIG_BT_DEVICE_APPEARANCE >> 8)),
+    BT_DATA_BYTES(BT_DATA_UUID16_ALL, BT_UUID_16_ENCODE(BT_UUID_HIDS_VAL)),
+};
+
+static const struct bt_data sd[] = {
+    BT_DATA(BT_DATA_NAME_COMPLETE, CONFIG_BT_DEVICE_NAME, sizeof(CONFIG_BT_DEVICE_NAME) - 1),
+};
+
+static void adv_work_handler(struct k_work *work)
+{
+    int err = bt_le_adv_start(BT_LE_ADV_CONN_FAST_1, ad, ARRAY_SIZE(ad), sd, ARRAY_SIZE(sd));
+    if (err) {
+        FAIL("Advertising failed to start (err %d)\n", err);
+        return;
+    }
+
+    printk("hogp: advertising\n");
+}
+
+static void unpair_work_handler(struct k_work *work)
+{
+    hogp_t *hogp = CONTAINER_OF(work, hogp_t, unpair_work);
+
+    int err = bt_unpair(BT_ID_DEFAULT, &hogp->peer);
+    if (err) {
+        FAIL("Failed to forget the bond (err %d)\n", err);
+    }
+
+    printk("hogp: bond forgotten\n");
+}
+
+static void connected(struct bt_conn *conn, uint8_t err)
+{
+    hogp_t *hogp = &g_hogp;
+
+    if (err) {
+        printk("hogp: connection failed (err 0x%02x)\n", err);
+        return;
+    }
+
+    hogp->conn = bt_conn_ref(conn);
+    bt_addr_le_copy(&hogp->peer, bt_conn_get_dst(conn));
+
+    printk("hogp: connected\n");
+}
+
+static void disconnected(struct bt_conn *conn, uint8_t reason)
+{
+    hogp_t *hogp = &g_hogp;
+
+    printk("hogp: disconnected (reason 0x%02x)\n", reason);
+
+    if (hogp->conn == conn) {
+        bt_conn_unref(hogp->conn);
+        hogp->conn = NULL;
+    }
+
+    hogp->subscribed = false;
+
+    if (hogp->args.bond == BOND_FORGET) {
+        k_work_submit(&hogp->unpair_work);
+    }
+}
+
+static void recycled(void)
+{
+    // Connection object is free again
+    k_work_submit(&g_hogp.adv_work);
+}
+
+static void security_changed(struct bt_conn *conn, bt_security_t level, enum bt_security_err err)
+{
+    printk("hogp: security level %u (err %d)\n", level, err);
+}
+
+BT_CONN_CB_DEFINE(conn_callbacks) = {
+    .connected = connected,
+    .disconnected = disconnected,
+    .recycled = recycled,
+    .security_changed = security_changed,
+};
+
+// ------------------------------------------------------------------
+// Report stream
+// ------------------------------------------------------------------
+
+static void notify_sent(struct bt_conn *conn, void *user_data)
+{
+    hogp_t *hogp = &g_hogp;
+
+    uint32_t latency = k_cyc_to_us_floor32(k_cycle_get_32() - hogp->tx_time[hogp->tx_tail]);
+    hogp->tx_tail = (hogp->tx_tail + 1) % HOGP_TX_MAX;
+
+    hogp->tx_latency_max = MAX(hogp->tx_latency_max, latency);
+    hogp->tx_latency_sum += latency;
+    hogp->sent++;
+
+    k_sem_give(&hogp->tx_sem);
+}
+
+// Sends the next report, returns false if no notification slot was free
+static bool send_report(hogp_t *hogp, k_timeout_t timeout)
+{
+    const report_map_t *map = hogp->args.map;
+
+    if (k_sem_take(&hogp->tx_sem, timeout) != 0) {
+        return false;
+    }
+
+    uint8_t report[HOGP_MAX_REPORT_SIZE];
+    map->fill(report, hogp->seq++);
+
+    struct bt_gatt_notify_params params = {
+        .attr = HOGP_REPORT_ATTR,
+        .data = report,
+        .len = map->report_size,
+        .func = notify_sent,
+    };
+
+    hogp->tx_time[hogp->tx_head] = k_cycle_get_32();
+    hogp->tx_head = (hogp->tx_head + 1) % HOGP_TX_MAX;
+
+    int err = bt_gatt_notify_cb(hogp->conn, &params);
+    if (err) {
+        // Disconnected in the meantime
+        hogp->tx_head = (hogp->tx_head + HOGP_TX_MAX - 1) % HOGP_TX_MAX;
+        k_sem_give(&hogp->tx_sem);
+    }
+
+    return true;
+}
+
+static void print_stats(hogp_t *hogp)
+{
+    uint32_t avg = hogp->sent > 0 ? (uint32_t)(hogp->tx_latency_sum / hogp->sent) : 0;
+
+    printk("hogp: sent=%u skipped=%u drops=%u tx_latency_avg_us=%u tx_latency_max_us=%u\n",
+           hogp->sent, hogp->skipped, hogp->drops, avg, hogp->tx_latency_max);
+}
+
+// ------------------------------------------------------------------
+// Test
+// ------------------------------------------------------------------
+
+static void test_args(int argc, char *argv[])
+{
+    hogp_args_t *args = &g_hogp.args;
+
+    for (int i = 0; i < argc; i++) {
+        char *value = strchr(argv[i], '=');
+        if (value == NULL) {
+            FAIL("Invalid argument %s\n", argv[i]);
+            return;
+        }
+        *value++ = '\0';
+
+        if (strcmp(argv[i], "map") == 0) {
+            args->map = report_map_find(value);
+            if (args->map == NULL) {
+                FAIL("Unknown report map %s\n", value);
+            }
+        } else if (strcmp(argv[i], "rate") == 0) {
+            args->rate = strtoul(value, NULL, 0);
+        } else if (strcmp(argv[i], "interval") == 0) {
+            args->interval = strtoul(value, NULL, 0);
+        } else if (strcmp(argv[i], "bond") == 0) {
+            if (strcmp(value, "keep") == 0) {
+                args->bond = BOND_KEEP;
+            } else if (strcmp(value, "none") == 0) {
+                args->bond = BOND_NONE;
+            } else if (strcmp(value, "forget") == 0) {
+                args->bond = BOND_FORGET;
+            } else {
+                FAIL("Unknown bond mode %s\n", value);
+            }
+        } else if (strcmp(argv[i], "drop") == 0) {
+            args->drop = strtoul(value, NULL, 0);
+        } else if (strcmp(argv[i], "drops") == 0) {
+            args->drops = strtoul(value, NULL, 0);
+        } else if (strcmp(argv[i], "reports") == 0) {
+            args->reports = strtoul(value, NULL, 0);
+        } else {
+            FAIL("Unknown argument %s\n", argv[i]);
+        }
+    }
+}
+
+static void test_init(void)
+{
+    bst_ticker_set_next_tick_absolute(HOGP_TEST_TIMEOUT);
+    bst_result = In_progress;
+}
+
+static void test_tick(bs_time_t HW_device_time)
+{
+    if (bst_result != Passed) {
+        print_stats(&g_hogp);
+        FAIL("Test timed out\n");
+    }
+}
+
+static void test_main(void)
+{
+    hogp_t *hogp = &g_hogp;
+    hogp_args_t *args = &hogp->args;
+
+    if (args->map == NULL) {
+        args->map = report_map_find("gamepad");
+    }
+
+    report_ref[0] = args->map->report_id;
+    report_ref[1] = 0x01; // Input report
+
+    k_sem_init(&hogp->tx_sem, HOGP_TX_MAX, HOGP_TX_MAX);
+    k_work_init(&hogp->adv_work, adv_work_handler);
+    k_work_init(&hogp->unpair_work, unpair_work_handler);
+
+    int err = bt_enable(NULL);
+    if (err) {
+        FAIL("Bluetooth init failed (err %d)\n", err);
+        return;
+    }
+
+    bt_set_bondable(args->bond != BOND_NONE);
+
+    k_work_submit(&hogp->adv_work);
+
+    // Disconnections to go through before passing
+    uint32_t drops = args->drop != 0 ? args->drops : 0;
+    bool param_requested = false;
+    int64_t last_print = k_uptime_get();
+
+    for (;;) {
+        if (hogp->conn == NULL || !hogp->subscribed) {
+            param_requested = false;
+            k_sleep(K_MSEC(10));
+            continue;
+        }
+
+        if (args->interval != 0 && !param_requested) {
+            struct bt_le_conn_param param =
+                BT_LE_CONN_PARAM_INIT(args->interval, args->interval, 0, 400);
+            bt_conn_le_param_update(hogp->conn, &param);
+            param_requested = true;
+        }
+
+        if (args->drop != 0 && hogp->drops < args->drops &&
+            k_uptime_get() - hogp->subscribed_at >= args->drop * 1000) {
+            hogp->drops++;
+            printk("hogp: dropping the connection (%u)\n", hogp->drops);
+            bt_conn_disconnect(hogp->conn, BT_HCI_ERR_REMOTE_USER_TERM_CONN);
+            hogp->subscribed = false;
+            continue;
+        }
+
+        if (args->rate == 0) {
+            // Throughput ceiling: keep all notification slots busy
+            send_report(hogp, K_MSEC(100));
+        } else {
+            if (!send_report(hogp, K_NO_WAIT)) {
+                // Link can't keep up with the report rate
+                hogp->skipped++;
+            }
+            k_sleep(K_MSEC(args->rate));
+        }
+
+        if (k_uptime_get() - last_print >= 1000) {
+            last_print = k_uptime_get();
+            print_stats(hogp);
+        }
+
+        if (bst_result != Passed && hogp->sent >= args->reports && hogp->drops >= drops) {
+            print_stats(hogp);
+            PASS("HOGP peripheral done\n");
+        }
+    }
+}
+
+static const struct bst_test_instance test_def[] = {
+    {
+        .test_id = "hogp",
+        .test_descr = "Stand-in HOGP peripheral with a configurable report map, report rate "
+                      "and bond behaviour",
+        .test_args_f = test_args,
+        .test_pre_init_f = test_init,
+        .test_tick_f = test_tick,
+        .test_main_f = test_main,
+    },
+    BSTEST_END_MARKER,
+};
+
+static struct bst_test_list *test_hogp_install(struct bst_test_list *tests)
+{
+    return bst_add_tests(tests, test_def);
+}
+
+bst_test_install_t test_installers[] = {test_hogp_install, NULL};
+
+int main(void)
+{
+    bst_main();
+    return 0;
+}
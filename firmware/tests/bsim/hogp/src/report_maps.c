@@ -0,0 +1,207 @@
+/*
+ * This file is part of the Blue2Joy project
+ * (https://github.com/cepetr/blue2joy).
+ * Copyright (c) 2025
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include <zephyr/sys/util.h>
+#include <zephyr/sys/byteorder.h>
+
+#include "report_maps.h"
+
+// Generic gamepad: 16 buttons, hat switch, 4 x 8-bit axes
+// clang-format off
+static const uint8_t gamepad_map[] = {
+    0x05, 0x01,       // Usage Page (Generic Desktop)
+    0x09, 0x05,       // Usage (Game Pad)
+    0xA1, 0x01,       // Collection (Application)
+    0x85, 0x01,       //   Report ID (1)
+    0x05, 0x09,       //   Usage Page (Button)
+    0x19, 0x01,       //   Usage Minimum (1)
+    0x29, 0x10,       //   Usage Maximum (16)
+    0x15, 0x00,       //   Logical Minimum (0)
+    0x25, 0x01,       //   Logical Maximum (1)
+    0x75, 0x01,       //   Report Size (1)
+    0x95, 0x10,       //   Report Count (16)
+    0x81, 0x02,       //   Input (Data, Var, Abs)
+    0x05, 0x01,       //   Usage Page (Generic Desktop)
+    0x09, 0x39,       //   Usage (Hat Switch)
+    0x15, 0x00,       //   Logical Minimum (0)
+    0x25, 0x07,       //   Logical Maximum (7)
+    0x35, 0x00,       //   Physical Minimum (0)
+    0x46, 0x3B, 0x01, //   Physical Maximum (315)
+    0x65, 0x14,       //   Unit (Degrees)
+    0x75, 0x04,       //   Report Size (4)
+    0x95, 0x01,       //   Report Count (1)
+    0x81, 0x42,       //   Input (Data, Var, Abs, Null)
+    0x65, 0x00,       //   Unit (None)
+    0x81, 0x03,       //   Input (Const)
+    0x09, 0x30,       //   Usage (X)
+    0x09, 0x31,       //   Usage (Y)
+    0x09, 0x32,       //   Usage (Z)
+    0x09, 0x35,       //   Usage (Rz)
+    0x15, 0x00,       //   Logical Minimum (0)
+    0x26, 0xFF, 0x00, //   Logical Maximum (255)
+    0x75, 0x08,       //   Report Size (8)
+    0x95, 0x04,       //   Report Count (4)
+    0x81, 0x02,       //   Input (Data, Var, Abs)
+    0xC0,             // End Collection
+};
+
+// Xbox-like controller: 2 x 2 16-bit sticks, 10-bit triggers,
+// hat switch (1-based) and 15 buttons
+static const uint8_t xbox_map[] = {
+    0x05, 0x01,                   // Usage Page (Generic Desktop)
+    0x09, 0x05,                   // Usage (Game Pad)
+    0xA1, 0x01,                   // Collection (Application)
+    0x85, 0x01,                   //   Report ID (1)
+    0x09, 0x01,                   //   Usage (Pointer)
+    0xA1, 0x00,                   //   Collection (Physical)
+    0x09, 0x30,                   //     Usage (X)
+    0x09, 0x31,                   //     Usage (Y)
+    0x15, 0x00,                   //     Logical Minimum (0)
+    0x27, 0xFF, 0xFF, 0x00, 0x00, //     Logical Maximum (65535)
+    0x75, 0x10,                   //     Report Size (16)
+    0x95, 0x02,                   //     Report Count (2)
+    0x81, 0x02,                   //     Input (Data, Var, Abs)
+    0xC0,                         //   End Collection
+    0x09, 0x01,                   //   Usage (Pointer)
+    0xA1, 0x00,                   //   Collection (Physical)
+    0x09, 0x32,                   //     Usage (Z)
+    0x09, 0x35,                   //     Usage (Rz)
+    0x15, 0x00,                   //     Logical Minimum (0)
+    0x27, 0xFF, 0xFF, 0x00, 0x00, //     Logical Maximum (65535)
+    0x75, 0x10,                   //     Report Size (16)
+    0x95, 0x02,                   //     Report Count (2)
+    0x81, 0x02,                   //     Input (Data, Var, Abs)
+    0xC0,                         //   End Collection
+    0x05, 0x02,                   //   Usage Page (Simulation Controls)
+    0x09, 0xC5,                   //   Usage (Brake)
+    0x15, 0x00,                   //   Logical Minimum (0)
+    0x26, 0xFF, 0x03,             //   Logical Maximum (1023)
+    0x75, 0x0A,                   //   Report Size (10)
+    0x95, 0x01,                   //   Report Count (1)
+    0x81, 0x02,                   //   Input (Data, Var, Abs)
+    0x75, 0x06,                   //   Report Size (6)
+    0x81, 0x03,                   //   Input (Const)
+    0x09, 0xC4,                   //   Usage (Accelerator)
+    0x75, 0x0A,                   //   Report Size (10)
+    0x81, 0x02,                   //   Input (Data, Var, Abs)
+    0x75, 0x06,                   //   Report Size (6)
+    0x81, 0x03,                   //   Input (Const)
+    0x05, 0x01,                   //   Usage Page (Generic Desktop)
+    0x09, 0x39,                   //   Usage (Hat Switch)
+    0x15, 0x01,                   //   Logical Minimum (1)
+    0x25, 0x08,                   //   Logical Maximum (8)
+    0x35, 0x00,                   //   Physical Minimum (0)
+    0x46, 0x3B, 0x01,             //   Physical Maximum (315)
+    0x65, 0x14,                   //   Unit (Degrees)
+    0x75, 0x04,                   //   Report Size (4)
+    0x81, 0x42,                   //   Input (Data, Var, Abs, Null)
+    0x65, 0x00,                   //   Unit (None)
+    0x81, 0x03,                   //   Input (Const)
+    0x05, 0x09,                   //   Usage Page (Button)
+    0x19, 0x01,                   //   Usage Minimum (1)
+    0x29, 0x0F,                   //   Usage Maximum (15)
+    0x15, 0x00,                   //   Logical Minimum (0)
+    0x25, 0x01,                   //   Logical Maximum (1)
+    0x75, 0x01,                   //   Report Size (1)
+    0x95, 0x0F,                   //   Report Count (15)
+    0x81, 0x02,                   //   Input (Data, Var, Abs)
+    0x95, 0x01,                   //   Report Count (1)
+    0x81, 0x03,                   //   Input (Const)
+    0xC0,                         // End Collection
+};
+
+// Mouse: 3 buttons, relative X, Y and wheel, no report ID
+static const uint8_t mouse_map[] = {
+    0x05, 0x01, // Usage Page (Generic Desktop)
+    0x09, 0x02, // Usage (Mouse)
+    0xA1, 0x01, // Collection (Application)
+    0x09, 0x01, //   Usage (Pointer)
+    0xA1, 0x00, //   Collection (Physical)
+    0x05, 0x09, //     Usage Page (Button)
+    0x19, 0x01, //     Usage Minimum (1)
+    0x29, 0x03, //     Usage Maximum (3)
+    0x15, 0x00, //     Logical Minimum (0)
+    0x25, 0x01, //     Logical Maximum (1)
+    0x75, 0x01, //     Report Size (1)
+    0x95, 0x03, //     Report Count (3)
+    0x81, 0x02, //     Input (Data, Var, Abs)
+    0x75, 0x05, //     Report Size (5)
+    0x95, 0x01, //     Report Count (1)
+    0x81, 0x03, //     Input (Const)
+    0x05, 0x01, //     Usage Page (Generic Desktop)
+    0x09, 0x30, //     Usage (X)
+    0x09, 0x31, //     Usage (Y)
+    0x09, 0x38, //     Usage (Wheel)
+    0x15, 0x81, //     Logical Minimum (-127)
+    0x25, 0x7F, //     Logical Maximum (127)
+    0x75, 0x08, //     Report Size (8)
+    0x95, 0x03, //     Report Count (3)
+    0x81, 0x06, //     Input (Data, Var, Rel)
+    0xC0,       //   End Collection
+    0xC0,       // End Collection
+};
+// clang-format on
+
+static void gamepad_fill(uint8_t *report, uint32_t seq)
+{
+    sys_put_le16(seq & 0xFFFF, &report[0]);
+    // Hat cycles through the directions and the null state
+    report[2] = seq % 9;
+    for (int i = 0; i < 4; i++) {
+        report[3 + i] = (uint8_t)(seq * (i + 1));
+    }
+}
+
+static void xbox_fill(uint8_t *report, uint32_t seq)
+{
+    for (int i = 0; i < 4; i++) {
+        sys_put_le16((uint16_t)(seq * 257 * (i + 1)), &report[2 * i]);
+    }
+    sys_put_le16(seq & 0x3FF, &report[8]);
+    sys_put_le16((seq * 3) & 0x3FF, &report[10]);
+    report[12] = seq % 9;
+    sys_put_le16(seq & 0x7FFF, &report[13]);
+}
+
+static void mouse_fill(uint8_t *report, uint32_t seq)
+{
+    report[0] = seq & 0x07;
+    // Small circle
+    report[1] = (seq & 4) ? 3 : -3;
+    report[2] = (seq & 8) ? 3 : -3;
+    report[3] = 0;
+}
+
+static const report_map_t g_report_maps[] = {
+    {"gamepad", gamepad_map, sizeof(gamepad_map), 1, 7, gamepad_fill},
+    {"xbox", xbox_map, sizeof(xbox_map), 1, 15, xbox_fill},
+    {"mouse", mouse_map, sizeof(mouse_map), 0, 4, mouse_fill},
+};
+
+const report_map_t *report_map_find(const char *name)
+{
+    for (int i = 0; i < ARRAY_SIZE(g_report_maps); i++) {
+        if (strcmp(g_report_maps[i].name, name) == 0) {
+            return &g_report_maps[i];
+        }
+    }
+
+    return NULL;
+}
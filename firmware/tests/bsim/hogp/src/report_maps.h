@@ -0,0 +1,40 @@
+/*
+ * This file is part of the Blue2Joy project
+ * (https://github.com/cepetr/blue2joy).
+ * Copyright (c) 2025
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Report map of the simulated HID device
+typedef struct {
+    // Name used on the command line
+    const char *name;
+    // HID report descriptor
+    const uint8_t *map;
+    size_t map_size;
+    // Input report ID (0 => the map has no report IDs)
+    uint8_t report_id;
+    // Input report size (without the report ID)
+    uint8_t report_size;
+    // Fills the `seq`-th input report (button 1 toggles in every report)
+    void (*fill)(uint8_t *report, uint32_t seq);
+} report_map_t;
+
+// Returns the report map with the specified name or NULL
+const report_map_t *report_map_find(const char *name);
@@ -0,0 +1,16 @@
+#!/usr/bin/env bash
+# Runs all bench scenarios, the binaries must be built with compile.sh first
+set -u
+
+scripts_dir="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)/tests_scripts"
+failed=0
+
+for script in "${scripts_dir}"/*.sh; do
+  echo "=== $(basename "${script}")"
+  if ! "${script}"; then
+    failed=$((failed + 1))
+  fi
+done
+
+echo "=== ${failed} scenario(s) failed"
+exit $((failed > 0))
@@ -0,0 +1,20 @@
+#!/usr/bin/env bash
+# Notification -> mapper latency at a steady 100 Hz report rate
+#
+# BabbleSim doesn't model CPU time, the firmware side figure only covers
+# queueing (work queue backlog, mutex contention) between the HID
+# notification and the mapper. The air side is covered by the peripheral's
+# submit -> sent time.
+set -ue
+source "$(dirname "${BASH_SOURCE[0]}")/../_common.source"
+
+sim_id=latency
+
+run_bench ${sim_id} map=xbox rate=10 interval=6 reports=2000
+
+check ${sim_id} latency_avg_us "$(bench_value ${sim_id} latency_avg_us)" \
+  -le "${BENCH_LATENCY_AVG_MAX:-500}"
+check ${sim_id} latency_max_us "$(bench_value ${sim_id} latency_max_us)" \
+  -le "${BENCH_LATENCY_MAX:-2000}"
+check ${sim_id} tx_latency_max_us "$(hogp_value ${sim_id} tx_latency_max_us)" \
+  -le "${BENCH_TX_LATENCY_MAX:-15000}"
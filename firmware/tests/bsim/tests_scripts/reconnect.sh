@@ -0,0 +1,15 @@
+#!/usr/bin/env bash
+# Bonded gamepad dropping the link: disconnection -> same device ready again
+set -ue
+source "$(dirname "${BASH_SOURCE[0]}")/../_common.source"
+
+sim_id=reconnect
+drops=${BENCH_RECONNECT_DROPS:-5}
+
+run_bench ${sim_id} map=xbox rate=10 bond=keep drop=3 drops=${drops} reports=500
+
+check ${sim_id} reconnects "$(bench_value ${sim_id} reconnects)" -ge "${drops}"
+check ${sim_id} reconnect_avg_ms "$(bench_value ${sim_id} reconnect_avg)" \
+  -le "${BENCH_RECONNECT_AVG_MAX:-1000}"
+check ${sim_id} reconnect_max_ms "$(bench_value ${sim_id} reconnect_max)" \
+  -le "${BENCH_RECONNECT_MAX:-2000}"
@@ -0,0 +1,13 @@
+#!/usr/bin/env bash
+# Pairing with a new gamepad: scan start -> device ready
+set -ue
+source "$(dirname "${BASH_SOURCE[0]}")/../_common.source"
+
+sim_id=scan_to_ready
+
+run_bench ${sim_id} map=gamepad rate=10 reports=200
+
+check ${sim_id} scan_to_ready_ms "$(bench_value ${sim_id} scan_to_ready)" \
+  -le "${BENCH_SCAN_TO_READY_MAX:-3000}"
+check ${sim_id} boot_to_ready_ms "$(bench_value ${sim_id} boot_to_ready)" \
+  -le "${BENCH_BOOT_TO_READY_MAX:-4000}"
@@ -0,0 +1,17 @@
+#!/usr/bin/env bash
+# Report capture stream throughput over the L2CAP channel
+#
+# The btjp client connects while the peripheral keeps the report path busy
+# and requests the capture repeatedly. It fails if the channel opens on an
+# unencrypted link (the firmware requires security level 2).
+set -ue
+source "$(dirname "${BASH_SOURCE[0]}")/../_common.source"
+
+sim_id=stream
+
+BTJP_ARGS="streams=5 pause=1000" run_bench ${sim_id} map=gamepad rate=0 interval=6 reports=5000
+
+check ${sim_id} streams "$(btjp_value ${sim_id} streams)" -ge 5
+check ${sim_id} stream_kbps "$(btjp_value ${sim_id} stream_kbps)" \
+  -ge "${BENCH_STREAM_KBPS_MIN:-64}"
+check ${sim_id} missed "$(bench_value ${sim_id} missed)" -le "${BENCH_STREAM_MISSED_MAX:-0}"
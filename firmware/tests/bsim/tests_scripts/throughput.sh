@@ -0,0 +1,12 @@
+#!/usr/bin/env bash
+# Report throughput ceiling: the peripheral keeps all notification slots busy
+set -ue
+source "$(dirname "${BASH_SOURCE[0]}")/../_common.source"
+
+sim_id=throughput
+
+run_bench ${sim_id} map=gamepad rate=0 interval=6 reports=5000
+
+check ${sim_id} peak_rate "$(bench_value ${sim_id} peak_rate)" \
+  -ge "${BENCH_PEAK_RATE_MIN:-250}"
+check ${sim_id} missed "$(bench_value ${sim_id} missed)" -le "${BENCH_MISSED_MAX:-0}"
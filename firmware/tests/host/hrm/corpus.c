@@ -0,0 +1,69 @@
+/*
+ * This file is part of the Blue2Joy project
+ * (https://github.com/cepetr/blue2joy).
+ * Copyright (c) 2025
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "corpus.h"
+
+int corpus_read(const char *path, uint8_t *buf, size_t size)
+{
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        fprintf(stderr, "%s: cannot open\n", path);
+        return -1;
+    }
+
+    size_t len = 0;
+    char line[256];
+    int line_no = 0;
+
+    while (fgets(line, sizeof(line), f) != NULL) {
+        line_no++;
+
+        char *p = line;
+        while (*p != '\0' && *p != '#') {
+            if (isspace((unsigned char)*p) || *p == ',') {
+                p++;
+                continue;
+            }
+
+            char *end;
+            unsigned long value = strtoul(p, &end, 16);
+            if (end == p || value > 0xFF || (*end != '\0' && !isspace((unsigned char)*end) &&
+                                             *end != ',' && *end != '#')) {
+                fprintf(stderr, "%s:%d: invalid byte\n", path, line_no);
+                fclose(f);
+                return -1;
+            }
+
+            if (len >= size) {
+                fprintf(stderr, "%s: descriptor too large\n", path);
+                fclose(f);
+                return -1;
+            }
+
+            buf[len++] = value;
+            p = end;
+        }
+    }
+
+    fclose(f);
+    return len;
+}
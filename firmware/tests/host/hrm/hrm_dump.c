@@ -0,0 +1,296 @@
+/*
+ * This file is part of the Blue2Joy project
+ * (https://github.com/cepetr/blue2joy).
+ * Copyright (c) 2025
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <bthid/report_map.h>
+
+#include "corpus.h"
+
+// Report map corpus tool
+//
+//   hrm_dump FILE...               prints the parsed report maps
+//   hrm_dump --check FILE...       compares them with the golden dumps (FILE.golden)
+//   hrm_dump --update FILE...      rewrites the golden dumps
+//   hrm_dump --bench FILE...       measures the parse time of each descriptor
+//   hrm_dump --export DIR FILE...  writes the descriptors as binary files
+//                                  (seed corpus for libFuzzer)
+
+// Parses per descriptor in the benchmark
+#define BENCH_ITERATIONS 20000
+
+static hrm_t g_hrm;
+
+static void dump(FILE *out, const char *name, const uint8_t *data, size_t size)
+{
+    hrm_t *hrm = &g_hrm;
+
+    // Parse from the raw buffer like the firmware does
+    memcpy(hrm_raw_buffer(hrm), data, size);
+    hrm_parse(hrm, hrm_raw_buffer(hrm), size);
+
+    fprintf(out, "# %s (%zu bytes)\n", name, size);
+    fprintf(out, "reports %zu, fields %u, pages %u, ranges %u, memory %zu bytes\n",
+            hrm->report_count, hrm->field_count, hrm->page_count, hrm->range_count,
+            hrm_mem_usage(hrm));
+
+    for (size_t i = 0; i < hrm->report_count; i++) {
+        const hrm_report_t *report = &hrm->reports[i];
+
+        fprintf(out, "report %u: %u bits, %u fields, %zu arrays\n", report->id, report->bit_size,
+                report->field_count, report->array_count);
+
+        for (size_t j = 0; j < report->field_count; j++) {
+            const hrm_packed_field_t *field = &report->fields[j];
+            const hrm_range_t *range = &hrm->ranges[field->range];
+
+            fprintf(out, "  field @%u size %u usage 0x%02X%04X range %d..%d\n", field->bit_offset,
+                    field->bit_size, hrm->pages[field->page], field->usage, range->min,
+                    range->max);
+        }
+
+        for (size_t j = 0; j < report->array_count; j++) {
+            const hrm_array_t *array = &report->arrays[j];
+
+            fprintf(out, "  array @%u size %u count %u page 0x%02X usages 0x%02X..0x%02X min %d\n",
+                    array->bit_offset, array->bit_size, array->count, array->usage_page,
+                    array->usage_min, array->usage_max, array->logical_min);
+        }
+    }
+}
+
+static char *golden_path(const char *path)
+{
+    static char buf[1024];
+    snprintf(buf, sizeof(buf), "%s.golden", path);
+    return buf;
+}
+
+static char *read_file(const char *path, size_t *size)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        return NULL;
+    }
+
+    char *buf = NULL;
+    size_t len = 0;
+    FILE *mem = open_memstream(&buf, &len);
+
+    char chunk[1024];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0) {
+        fwrite(chunk, 1, n, mem);
+    }
+
+    fclose(f);
+    fclose(mem);
+
+    *size = len;
+    return buf;
+}
+
+static const char *base_name(const char *path)
+{
+    const char *slash = strrchr(path, '/');
+    return slash != NULL ? slash + 1 : path;
+}
+
+// Returns 0 if the dump matches the golden one
+static int check(const char *path, const uint8_t *data, size_t size, bool update)
+{
+    char *actual = NULL;
+    size_t actual_size = 0;
+    FILE *mem = open_memstream(&actual, &actual_size);
+    dump(mem, base_name(path), data, size);
+    fclose(mem);
+
+    int result = 0;
+
+    if (update) {
+        FILE *f = fopen(golden_path(path), "w");
+        if (f == NULL || fwrite(actual, 1, actual_size, f) != actual_size) {
+            fprintf(stderr, "%s: cannot write\n", golden_path(path));
+            result = -1;
+        }
+        if (f != NULL) {
+            fclose(f);
+        }
+    } else {
+        size_t expected_size = 0;
+        char *expected = read_file(golden_path(path), &expected_size);
+
+        if (expected == NULL) {
+            fprintf(stderr, "%s: missing golden dump\n", path);
+            result = -1;
+        } else if (expected_size != actual_size || memcmp(expected, actual, actual_size) != 0) {
+            fprintf(stderr, "%s: dump differs from the golden one, got:\n%s", path, actual);
+            result = -1;
+        } else {
+            printf("%s: ok\n", base_name(path));
+        }
+
+        free(expected);
+    }
+
+    free(actual);
+    return result;
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void bench(const char *name, const uint8_t *data, size_t size)
+{
+    hrm_t *hrm = &g_hrm;
+    uint64_t best = UINT64_MAX;
+    uint64_t total = 0;
+
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        memcpy(hrm_raw_buffer(hrm), data, size);
+
+        uint64_t start = now_ns();
+        hrm_parse(hrm, hrm_raw_buffer(hrm), size);
+        uint64_t elapsed = now_ns() - start;
+
+        total += elapsed;
+        if (elapsed < best) {
+            best = elapsed;
+        }
+    }
+
+    printf("%-28s %4zu bytes %3u fields  best %6.2f us  avg %6.2f us  %5.1f ns/byte\n", name, size,
+           hrm->field_count, best / 1000.0, total / 1000.0 / BENCH_ITERATIONS,
+           size > 0 ? (double)best / size : 0.0);
+}
+
+// Builds the worst case for the parser's bookkeeping: the largest map,
+// more fields than fit into the arena, fields of the last report
+// interleaved with the first one (longest field sort), full range table
+// and a report lookup for every item
+static size_t build_worst_case(uint8_t *buf)
+{
+    size_t len = 0;
+
+    // Create all reports up front, the last one has the highest index
+    for (int id = 1; id <= 4; id++) {
+        buf[len++] = 0x85; // Report ID
+        buf[len++] = id;
+        buf[len++] = 0x75; // Report Size (1)
+        buf[len++] = 0x01;
+        buf[len++] = 0x95; // Report Count (1)
+        buf[len++] = 0x01;
+        buf[len++] = 0x81; // Input (Data, Var, Abs)
+        buf[len++] = 0x02;
+    }
+
+    for (int i = 0; len + 8 <= HRM_MAX_RAW_SIZE; i++) {
+        buf[len++] = 0x85; // Report ID (4, 1, 4, 1, ...)
+        buf[len++] = (i & 1) ? 1 : 4;
+        buf[len++] = 0x25; // Logical Maximum (all 16 ranges in use)
+        buf[len++] = i & 0x0F;
+        buf[len++] = 0x09; // Usage (X)
+        buf[len++] = 0x30;
+        buf[len++] = 0x81; // Input (Data, Var, Abs)
+        buf[len++] = 0x02;
+    }
+
+    return len;
+}
+
+int main(int argc, char *argv[])
+{
+    enum { MODE_DUMP, MODE_CHECK, MODE_UPDATE, MODE_BENCH, MODE_EXPORT } mode = MODE_DUMP;
+    const char *export_dir = NULL;
+    int arg = 1;
+
+    if (arg < argc && strcmp(argv[arg], "--check") == 0) {
+        mode = MODE_CHECK;
+        arg++;
+    } else if (arg < argc && strcmp(argv[arg], "--update") == 0) {
+        mode = MODE_UPDATE;
+        arg++;
+    } else if (arg < argc && strcmp(argv[arg], "--bench") == 0) {
+        mode = MODE_BENCH;
+        arg++;
+    } else if (arg + 1 < argc && strcmp(argv[arg], "--export") == 0) {
+        mode = MODE_EXPORT;
+        export_dir = argv[arg + 1];
+        arg += 2;
+    }
+
+    if (arg >= argc) {
+        fprintf(stderr, "usage: %s [--check | --update | --bench | --export DIR] FILE...\n",
+                argv[0]);
+        return 2;
+    }
+
+    int failed = 0;
+
+    for (; arg < argc; arg++) {
+        uint8_t data[HRM_MAX_RAW_SIZE];
+        int size = corpus_read(argv[arg], data, sizeof(data));
+        if (size < 0) {
+            failed++;
+            continue;
+        }
+
+        switch (mode) {
+        case MODE_DUMP:
+            dump(stdout, base_name(argv[arg]), data, size);
+            break;
+        case MODE_CHECK:
+        case MODE_UPDATE:
+            if (check(argv[arg], data, size, mode == MODE_UPDATE) != 0) {
+                failed++;
+            }
+            break;
+        case MODE_BENCH:
+            bench(base_name(argv[arg]), data, size);
+            break;
+        case MODE_EXPORT: {
+            char path[1024];
+            snprintf(path, sizeof(path), "%s/%s", export_dir, base_name(argv[arg]));
+            FILE *f = fopen(path, "wb");
+            if (f == NULL || fwrite(data, 1, size, f) != (size_t)size) {
+                fprintf(stderr, "%s: cannot write {errno: %d}\n", path, errno);
+                failed++;
+            }
+            if (f != NULL) {
+                fclose(f);
+            }
+            break;
+        }
+        }
+    }
+
+    if (mode == MODE_BENCH) {
+        uint8_t data[HRM_MAX_RAW_SIZE];
+        bench("(worst case)", data, build_worst_case(data));
+    }
+
+    return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,313 @@
+/*
+ * This file is part of the Blue2Joy project
+ * (https://github.com/cepetr/blue2joy).
+ * Copyright (c) 2025
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <zephyr/sys/util.h>
+
+#include <bthid/report_map.h>
+
+#include "corpus.h"
+
+// Fuzz target of the report map parser
+//
+// Built for libFuzzer with HRM_LIBFUZZER (clang -fsanitize=fuzzer), otherwise
+// with a standalone driver mutating the seed descriptors:
+//
+//   hrm_fuzz [-n ITERATIONS] [-s SEED] FILE...
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+#define CHECK(cond)                                                                                \
+    do {                                                                                           \
+        if (!(cond)) {                                                                             \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond);               \
+            abort();                                                                               \
+        }                                                                                          \
+    } while (0)
+
+static hrm_t g_hrm;
+
+// Checks the structure invariants the mapper relies on
+static void check_report_map(const hrm_t *hrm)
+{
+    CHECK(hrm->report_count <= ARRAY_SIZE(hrm->reports));
+    CHECK(hrm->page_count <= ARRAY_SIZE(hrm->pages));
+    CHECK(hrm->range_count <= ARRAY_SIZE(hrm->ranges));
+    CHECK(hrm->field_count <= ARRAY_SIZE(hrm->fields));
+    CHECK(hrm->raw_size == 0);
+
+    size_t fields = 0;
+
+    for (size_t i = 0; i < hrm->report_count; i++) {
+        const hrm_report_t *report = &hrm->reports[i];
+
+        CHECK(report->map == hrm);
+        CHECK(report->bit_size <= HRM_MAX_REPORT_BITS);
+        CHECK(report->array_count <= ARRAY_SIZE(report->arrays));
+        CHECK(report->fields == &hrm->fields[fields]);
+
+        for (size_t j = 0; j < report->field_count; j++) {
+            const hrm_packed_field_t *field = &report->fields[j];
+            CHECK(field->report == i);
+            CHECK(field->page < hrm->page_count);
+            CHECK(field->range < hrm->range_count);
+            CHECK(field->bit_size > 0 && field->bit_size <= 32);
+            CHECK(field->bit_offset + field->bit_size <= report->bit_size);
+        }
+
+        for (size_t j = 0; j < report->array_count; j++) {
+            const hrm_array_t *array = &report->arrays[j];
+            CHECK(array->bit_size > 0 && array->bit_size <= 16);
+            CHECK(array->bit_offset + array->bit_size * array->count <= report->bit_size);
+            CHECK(array->usage_min <= array->usage_max);
+            CHECK(array->usage_max - array->usage_min < HRM_ARRAY_USAGES);
+        }
+
+        fields += report->field_count;
+    }
+
+    CHECK(fields == hrm->field_count);
+}
+
+// Runs the report accessors the mapper uses on report data
+static void check_reports(const hrm_t *hrm, const uint8_t *data, size_t size)
+{
+    static uint8_t buf[HRM_MAX_REPORT_BITS / 8];
+
+    // Report data derived from the input
+    for (size_t i = 0; i < sizeof(buf); i++) {
+        buf[i] = size > 0 ? data[i % size] ^ (uint8_t)i : 0;
+    }
+
+    for (size_t i = 0; i < hrm->report_count; i++) {
+        const hrm_report_t *report = &hrm->reports[i];
+
+        CHECK(hrm_find_report(hrm, report->id) != NULL);
+
+        for (size_t j = 0; j < report->field_count; j++) {
+            const hrm_packed_field_t *packed = &report->fields[j];
+            hrm_usage_t usage = ((uint32_t)hrm->pages[packed->page] << 16) | packed->usage;
+
+            hrm_field_t field;
+            CHECK(hrm_report_find_field(report, usage, &field));
+
+            int32_t value = hrm_field_extract(&field, buf);
+            (void)value;
+        }
+
+        hrm_usage_set_t set;
+        hrm_report_decode_arrays(report, buf, &set);
+
+        for (size_t j = 0; j < report->array_count; j++) {
+            const hrm_array_t *array = &report->arrays[j];
+            hrm_usage_t usage = ((uint32_t)array->usage_page << 16) | array->usage_max;
+
+            uint16_t bit;
+            int idx = hrm_report_find_array(report, usage, &bit);
+            CHECK(idx >= 0 && idx < (int)report->array_count);
+            (void)hrm_usage_set_test(&set, idx, bit);
+        }
+    }
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    hrm_t *hrm = &g_hrm;
+
+    if (size <= HRM_MAX_RAW_SIZE) {
+        // Parse from the raw buffer like the firmware does
+        memcpy(hrm_raw_buffer(hrm), data, size);
+        hrm_parse(hrm, hrm_raw_buffer(hrm), size);
+    } else {
+        hrm_parse(hrm, data, size);
+    }
+
+    check_report_map(hrm);
+    check_reports(hrm, data, size);
+
+    return 0;
+}
+
+#ifndef HRM_LIBFUZZER
+
+// Default number of mutated inputs
+#define FUZZ_ITERATIONS 100000
+
+// Most seed descriptors
+#define FUZZ_MAX_SEEDS 64
+
+typedef struct {
+    uint8_t data[HRM_MAX_RAW_SIZE];
+    size_t size;
+} fuzz_seed_t;
+
+static fuzz_seed_t g_seeds[FUZZ_MAX_SEEDS];
+static size_t g_seed_count;
+
+// Items that stress the parser's stacks and tables
+static const struct {
+    uint8_t size;
+    uint8_t data[3];
+} g_items[] = {
+    {2, {0xA1, 0x00}},       // Collection (Physical)
+    {1, {0xC0}},             // End Collection
+    {1, {0xA4}},             // Push
+    {1, {0xB4}},             // Pop
+    {2, {0x09, 0x30}},       // Usage (X)
+    {2, {0x19, 0x00}},       // Usage Minimum (0)
+    {3, {0x2A, 0xFF, 0xFF}}, // Usage Maximum (65535)
+    {2, {0x75, 0x21}},       // Report Size (33)
+    {2, {0x95, 0xFF}},       // Report Count (255)
+    {2, {0x85, 0x05}},       // Report ID (5)
+    {2, {0x81, 0x00}},       // Input (Data, Array)
+    {2, {0x81, 0x02}},       // Input (Data, Var, Abs)
+    {3, {0xFE, 0x10, 0x00}}, // Long item (16 bytes, payload follows)
+    {3, {0x17, 0x00, 0x00}}, // Logical Minimum (4 bytes, 2 present)
+};
+
+static size_t mutate(uint8_t *buf, size_t size)
+{
+    int count = 1 + rand() % 8;
+
+    for (int i = 0; i < count; i++) {
+        size_t pos = size > 0 ? rand() % size : 0;
+
+        switch (rand() % 6) {
+        case 0:
+            // Random byte
+            if (size > 0) {
+                buf[pos] = rand();
+            }
+            break;
+        case 1:
+            // Bit flip
+            if (size > 0) {
+                buf[pos] ^= 1 << (rand() % 8);
+            }
+            break;
+        case 2:
+            // Insert a byte
+            if (size < HRM_MAX_RAW_SIZE) {
+                memmove(&buf[pos + 1], &buf[pos], size - pos);
+                buf[pos] = rand();
+                size++;
+            }
+            break;
+        case 3:
+            // Delete a byte
+            if (size > 0) {
+                memmove(&buf[pos], &buf[pos + 1], size - pos - 1);
+                size--;
+            }
+            break;
+        case 4: {
+            // Insert a stress item (possibly repeatedly)
+            int item = rand() % ARRAY_SIZE(g_items);
+            size_t item_size = g_items[item].size;
+            int repeat = 1 + rand() % 12;
+            for (int r = 0; r < repeat && size + item_size <= HRM_MAX_RAW_SIZE; r++) {
+                memmove(&buf[pos + item_size], &buf[pos], size - pos);
+                memcpy(&buf[pos], g_items[item].data, item_size);
+                size += item_size;
+            }
+            break;
+        }
+        case 5: {
+            // Splice with another seed
+            const fuzz_seed_t *other = &g_seeds[rand() % g_seed_count];
+            if (other->size > 0) {
+                size_t from = rand() % other->size;
+                size_t len = MIN(other->size - from, HRM_MAX_RAW_SIZE - pos);
+                memcpy(&buf[pos], &other->data[from], len);
+                size = MAX(size, pos + len);
+            }
+            break;
+        }
+        }
+    }
+
+    return size;
+}
+
+int main(int argc, char *argv[])
+{
+    long iterations = FUZZ_ITERATIONS;
+    unsigned seed = 1;
+    int arg = 1;
+
+    for (; arg + 1 < argc && argv[arg][0] == '-'; arg += 2) {
+        if (strcmp(argv[arg], "-n") == 0) {
+            iterations = atol(argv[arg + 1]);
+        } else if (strcmp(argv[arg], "-s") == 0) {
+            seed = strtoul(argv[arg + 1], NULL, 0);
+        } else {
+            break;
+        }
+    }
+
+    for (; arg < argc && g_seed_count < FUZZ_MAX_SEEDS; arg++) {
+        fuzz_seed_t *s = &g_seeds[g_seed_count];
+        int size = corpus_read(argv[arg], s->data, sizeof(s->data));
+        if (size < 0) {
+            return 1;
+        }
+        s->size = size;
+        g_seed_count++;
+    }
+
+    if (g_seed_count == 0) {
+        fprintf(stderr, "usage: %s [-n ITERATIONS] [-s SEED] FILE...\n", argv[0]);
+        return 2;
+    }
+
+    srand(seed);
+
+    // Seeds as they are
+    for (size_t i = 0; i < g_seed_count; i++) {
+        LLVMFuzzerTestOneInput(g_seeds[i].data, g_seeds[i].size);
+    }
+
+    uint8_t buf[HRM_MAX_RAW_SIZE + 16];
+
+    for (long i = 0; i < iterations; i++) {
+        size_t size;
+
+        if (rand() % 8 == 0) {
+            // Random garbage, sometimes oversized
+            size = rand() % sizeof(buf);
+            for (size_t j = 0; j < size; j++) {
+                buf[j] = rand();
+            }
+        } else {
+            const fuzz_seed_t *s = &g_seeds[rand() % g_seed_count];
+            memcpy(buf, s->data, s->size);
+            size = mutate(buf, s->size);
+        }
+
+        LLVMFuzzerTestOneInput(buf, size);
+    }
+
+    printf("%ld inputs from %zu seeds, seed %u: ok\n", iterations, g_seed_count, seed);
+
+    return 0;
+}
+
+#endif // HRM_LIBFUZZER
@@ -0,0 +1,251 @@
+/*
+ * This file is part of the Blue2Joy project
+ * (https://github.com/cepetr/blue2joy).
+ * Copyright (c) 2025
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/util.h>
+
+#include <mapper/program.h>
+
+// Worst-case benchmark of the mapping program interpreter
+//
+// Finds the largest number of field lookups an expression can do within
+// MAPPER_PROGRAM_SIZE bytes, checks that the benchmarked programs reach it
+// and measures the evaluation of all pins for one report, the way
+// mapper_process_report() does it, against the largest report map.
+//
+//   prog_bench [ITERATIONS]
+
+// Default number of evaluated reports per program
+#define BENCH_ITERATIONS 20000
+
+static hrm_t g_hrm;
+
+typedef struct {
+    const char *name;
+    uint8_t code[MAPPER_PROGRAM_SIZE];
+    size_t size;
+    // Field lookups done by one evaluation
+    int lookups;
+} bench_program_t;
+
+// Report map with as many fields as the arena holds, no hat switch
+// (every MAPPER_OP_HAT scans all fields) and a key array after
+// the fields (a key lookup scans all fields and the array)
+static void build_report_map(hrm_t *hrm)
+{
+    static const uint8_t map[] = {
+        0x05, 0x01, // Usage Page (Generic Desktop)
+        0x09, 0x06, // Usage (Keyboard)
+        0xA1, 0x01, // Collection (Application)
+        0x05, 0x09, //   Usage Page (Button)
+        0x19, 0x01, //   Usage Minimum (1)
+        0x29, 0xFF, //   Usage Maximum (255)
+        0x15, 0x00, //   Logical Minimum (0)
+        0x25, 0x01, //   Logical Maximum (1)
+        0x75, 0x01, //   Report Size (1)
+        0x95, 0xFF, //   Report Count (255)
+        0x81, 0x02, //   Input (Data, Var, Abs)
+        0x05, 0x07, //   Usage Page (Keyboard/Keypad)
+        0x19, 0x00, //   Usage Minimum (0)
+        0x29, 0xFF, //   Usage Maximum (255)
+        0x26, 0xFF, 0x00, // Logical Maximum (255)
+        0x75, 0x08, //   Report Size (8)
+        0x95, 0x06, //   Report Count (6)
+        0x81, 0x00, //   Input (Data, Array)
+        0xC0,       // End Collection
+    };
+
+    memcpy(hrm_raw_buffer(hrm), map, sizeof(map));
+    hrm_parse(hrm, hrm_raw_buffer(hrm), sizeof(map));
+}
+
+// Largest number of lookups (MAPPER_OP_HAT, 2 bytes) an expression can do,
+// reducing the stack by MAPPER_OP_OR (1 byte, -1) or MAPPER_OP_SELECT
+// (1 byte, -2) within the stack limit and ending with MAPPER_OP_END
+static int max_lookups(void)
+{
+    // best[bytes][depth], -1 => unreachable
+    static int best[MAPPER_PROGRAM_SIZE + 1][MAPPER_PROGRAM_STACK_SIZE + 1];
+
+    memset(best, -1, sizeof(best));
+    best[0][0] = 0;
+
+    for (int b = 0; b < MAPPER_PROGRAM_SIZE; b++) {
+        for (int d = 0; d <= MAPPER_PROGRAM_STACK_SIZE; d++) {
+            if (best[b][d] < 0) {
+                continue;
+            }
+            if (b + 2 <= MAPPER_PROGRAM_SIZE && d < MAPPER_PROGRAM_STACK_SIZE) {
+                best[b + 2][d + 1] = MAX(best[b + 2][d + 1], best[b][d] + 1);
+            }
+            if (d >= 2) {
+                best[b + 1][d - 1] = MAX(best[b + 1][d - 1], best[b][d]);
+            }
+            if (d >= 3) {
+                best[b + 1][d - 2] = MAX(best[b + 1][d - 2], best[b][d]);
+            }
+        }
+    }
+
+    int result = 0;
+    for (int b = 0; b < MAPPER_PROGRAM_SIZE; b++) {
+        // MAPPER_OP_END takes the last byte
+        result = MAX(result, best[b][1]);
+    }
+
+    return result;
+}
+
+// HAT (HAT HAT SELECT)... END
+static void build_hat_select(bench_program_t *prog)
+{
+    size_t len = 0;
+
+    prog->name = "hat/select chain";
+    prog->code[len++] = MAPPER_OP_HAT;
+    prog->code[len++] = HAT_SWITCH_UP;
+    prog->lookups = 1;
+
+    while (len + 5 + 1 <= MAPPER_PROGRAM_SIZE) {
+        prog->code[len++] = MAPPER_OP_HAT;
+        prog->code[len++] = HAT_SWITCH_UP;
+        prog->code[len++] = MAPPER_OP_HAT;
+        prog->code[len++] = HAT_SWITCH_DOWN;
+        prog->code[len++] = MAPPER_OP_SELECT;
+        prog->lookups += 2;
+    }
+
+    prog->code[len++] = MAPPER_OP_END;
+    prog->size = len;
+}
+
+// LOAD (LOAD SELECT ...) END, loading a key (all fields and the array
+// are scanned, the array is decoded on first use)
+static void build_load_key(bench_program_t *prog)
+{
+    size_t len = 0;
+
+    prog->name = "key load chain";
+    prog->lookups = 0;
+
+    while (len + 5 + (prog->lookups > 0) + 1 <= MAPPER_PROGRAM_SIZE) {
+        prog->code[len++] = MAPPER_OP_LOAD;
+        sys_put_le32(HRM_USAGE_KEY_SPACE, &prog->code[len]);
+        len += 4;
+        if (prog->lookups++ > 0) {
+            prog->code[len++] = MAPPER_OP_OR;
+        }
+    }
+
+    prog->code[len++] = MAPPER_OP_END;
+    prog->size = len;
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static int bench(const bench_program_t *prog, long iterations)
+{
+    mapper_program_t program = {.size = prog->size};
+    memcpy(program.code, prog->code, prog->size);
+
+    if (mapper_program_validate(&program) != 1) {
+        fprintf(stderr, "%s: invalid program\n", prog->name);
+        return -1;
+    }
+
+    uint8_t data[HRM_MAX_REPORT_BITS / 8] = {0};
+    const hrm_report_t *report = &g_hrm.reports[0];
+    mapper_norm_cache_t norms = {0};
+    uint64_t best = UINT64_MAX;
+    uint64_t total = 0;
+    int sink = 0;
+
+    for (long i = 0; i < iterations; i++) {
+        data[0] = i;
+
+        uint64_t start = now_ns();
+
+        // Every pin evaluates the expression for a new report
+        mapper_program_env_t env = {
+            .report = report,
+            .data = data,
+            .norms = &norms,
+        };
+        for (int pin = 0; pin < IO_PIN_COUNT; pin++) {
+            sink += mapper_program_eval(program.code, &env, false);
+        }
+
+        uint64_t elapsed = now_ns() - start;
+        total += elapsed;
+        best = MIN(best, elapsed);
+    }
+
+    printf("%-18s %2zu bytes  %2d lookups/pin  %5u field compares/report  "
+           "best %6.2f us  avg %6.2f us  (%d)\n",
+           prog->name, prog->size, prog->lookups,
+           IO_PIN_COUNT * prog->lookups * report->field_count, best / 1000.0,
+           total / 1000.0 / iterations, sink != 0);
+
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    long iterations = argc > 1 ? atol(argv[1]) : BENCH_ITERATIONS;
+
+    build_report_map(&g_hrm);
+
+    if (g_hrm.report_count != 1 || g_hrm.reports[0].array_count != 1) {
+        fprintf(stderr, "unexpected report map\n");
+        return 1;
+    }
+
+    int bound = max_lookups();
+
+    printf("report map: %u fields, %zu array\n", g_hrm.reports[0].field_count,
+           g_hrm.reports[0].array_count);
+    printf("bound: %d lookups per expression, %d pins, %d field compares per report\n", bound,
+           IO_PIN_COUNT, bound * IO_PIN_COUNT * g_hrm.reports[0].field_count);
+
+    bench_program_t hat_select;
+    bench_program_t load_key;
+    build_hat_select(&hat_select);
+    build_load_key(&load_key);
+
+    if (hat_select.lookups != bound) {
+        fprintf(stderr, "worst-case program does %d lookups, bound is %d\n", hat_select.lookups,
+                bound);
+        return 1;
+    }
+
+    if (bench(&hat_select, iterations) != 0 || bench(&load_key, iterations) != 0) {
+        return 1;
+    }
+
+    return 0;
+}
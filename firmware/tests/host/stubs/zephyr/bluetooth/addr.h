@@ -0,0 +1,14 @@
+// Host build stub of <zephyr/bluetooth/addr.h>, address types only
+
+#pragma once
+
+#include <stdint.h>
+
+typedef struct {
+    uint8_t val[6];
+} bt_addr_t;
+
+typedef struct {
+    uint8_t type;
+    bt_addr_t a;
+} bt_addr_le_t;
@@ -0,0 +1,11 @@
+// Host build stub of <zephyr/kernel.h>, only the parts used by the
+// tested modules (no threads, the modules run single-threaded)
+
+#pragma once
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <zephyr/sys/util.h>
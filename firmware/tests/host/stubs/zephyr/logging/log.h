@@ -0,0 +1,32 @@
+// Host build stub of <zephyr/logging/log.h>
+//
+// Log messages are printed to stderr if HOST_LOG is defined, otherwise
+// they're only checked against their format strings
+
+#pragma once
+
+#include <stdio.h>
+
+#define LOG_MODULE_DECLARE(...)
+#define LOG_MODULE_REGISTER(...)
+
+#ifdef HOST_LOG
+#define HOST_LOG_ENABLED 1
+#else
+#define HOST_LOG_ENABLED 0
+#endif
+
+#define HOST_LOG_PRINT(level, fmt, ...)                                                            \
+    do {                                                                                           \
+        if (HOST_LOG_ENABLED) {                                                                    \
+            fprintf(stderr, level ": " fmt "\n", ##__VA_ARGS__);                                   \
+        }                                                                                          \
+    } while (0)
+
+#define LOG_ERR(...) HOST_LOG_PRINT("err", __VA_ARGS__)
+#define LOG_WRN(...) HOST_LOG_PRINT("wrn", __VA_ARGS__)
+#define LOG_INF(...) HOST_LOG_PRINT("inf", __VA_ARGS__)
+#define LOG_DBG(...) HOST_LOG_PRINT("dbg", __VA_ARGS__)
+
+#define LOG_HEXDUMP_INF(data, length, str)
+#define LOG_HEXDUMP_DBG(data, length, str)
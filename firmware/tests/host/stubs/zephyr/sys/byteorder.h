@@ -0,0 +1,27 @@
+// Host build stub of <zephyr/sys/byteorder.h>
+
+#pragma once
+
+#include <stdint.h>
+
+static inline uint16_t sys_get_le16(const uint8_t src[2])
+{
+    return ((uint16_t)src[1] << 8) | src[0];
+}
+
+static inline uint32_t sys_get_le32(const uint8_t src[4])
+{
+    return ((uint32_t)sys_get_le16(&src[2]) << 16) | sys_get_le16(&src[0]);
+}
+
+static inline void sys_put_le16(uint16_t val, uint8_t dst[2])
+{
+    dst[0] = val;
+    dst[1] = val >> 8;
+}
+
+static inline void sys_put_le32(uint32_t val, uint8_t dst[4])
+{
+    sys_put_le16(val, dst);
+    sys_put_le16(val >> 16, &dst[2]);
+}
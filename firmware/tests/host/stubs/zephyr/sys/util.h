@@ -0,0 +1,25 @@
+// Host build stub of the Zephyr utility macros used by the tested modules
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define ARRAY_SIZE(array) (sizeof(array) / sizeof((array)[0]))
+
+#ifndef MIN
+#define MIN(a, b) (((a) < (b)) ? (a) : (b))
+#endif
+
+#ifndef MAX
+#define MAX(a, b) (((a) > (b)) ? (a) : (b))
+#endif
+
+#define CLAMP(val, low, high) (((val) <= (low)) ? (low) : MIN(val, high))
+
+#define BIT(n)   (1UL << (n))
+#define BIT64(n) (1ULL << (n))
+
+#define DIV_ROUND_UP(n, d) (((n) + (d) - 1) / (d))
+
+#define CONTAINER_OF(ptr, type, field) ((type *)(((char *)(ptr)) - offsetof(type, field)))
@@ -83,6 +83,18 @@ export class AppRoot extends MobxLitElement {
     btj.disconnect();
   }
 
+  private onNewProfile = async () => {
+    const id = await btj.createProfile('New profile');
+    if (id !== null) {
+      this.onNavLinkClick(this.buildPath(`/profiles/${id}`));
+    }
+  }
+
+  private profileLabel(id: number) {
+    const name = btj.getProfile(id)?.name;
+    return name ? `${id}: ${name}` : `Profile ${id}`;
+  }
+
   private onNavLinkClick = (path: string) => {
     window.location.hash = path;
   }
@@ -177,7 +189,7 @@ export class AppRoot extends MobxLitElement {
   private getNavState() {
     const isDevices = this.isCurrentPath('/') || this.isCurrentPath('/devices');
     const isProfile = (id: number) => this.isCurrentPath(`/profiles/${id}`);
-    const profileIds = Array.from(btj.profiles.keys());
+    const profileIds = Array.from(btj.profiles.keys()).sort((a, b) => a - b);
     const hasProfiles = btj.connected && profileIds.length > 0;
 
     return { isDevices, isProfile, profileIds, hasProfiles };
@@ -211,10 +223,16 @@ export class AppRoot extends MobxLitElement {
                 <a class="dropdown-item ${isProfile(id) ? 'active' : ''}"
                   href="${this.buildPath(`/profiles/${id}`)}"
                 >
-                  Profile ${id}
+                  ${this.profileLabel(id)}
                 </a>
               </li>
             `)}
+            <li><hr class="dropdown-divider"></li>
+            <li>
+              <a class="dropdown-item" href="#" @click=${(e: Event) => { e.preventDefault(); this.onNewProfile(); }}>
+                New profile
+              </a>
+            </li>
           </ul>
         </li>
 
@@ -253,9 +271,16 @@ export class AppRoot extends MobxLitElement {
               data-bs-dismiss="offcanvas"
               @click=${() => this.onNavLinkClick(this.buildPath(`/profiles/${id}`))}
             >
-              Profile ${id}
+              ${this.profileLabel(id)}
             </a>
           `)}
+          <a
+            class="nav-link"
+            data-bs-dismiss="offcanvas"
+            @click=${this.onNewProfile}
+          >
+            New profile
+          </a>
         ` : null}
 
         <div class="mt-3">
@@ -0,0 +1,95 @@
+import { html, LitElement } from 'lit';
+import { customElement, property } from 'lit/decorators.js';
+import { Btj } from '../services/btj-messages.js';
+
+// Editor of a response curve, emits 'curve-change' with the new curve
+@customElement('curve-editor')
+export class CurveEditor extends LitElement {
+  protected override createRenderRoot() {
+    return this;
+  }
+
+  @property({ type: Object })
+  value: Btj.Curve = Btj.Curve.default();
+
+  private emit(curve: Btj.Curve) {
+    this.value = curve;
+    this.dispatchEvent(new CustomEvent('curve-change', {
+      detail: { value: curve },
+      bubbles: true,
+      composed: true
+    }));
+  }
+
+  private onTypeChange = (e: Event) => {
+    const type = Number((e.target as HTMLSelectElement).value);
+    this.emit({ ...this.value, type });
+  }
+
+  private onAmountChange = (e: Event) => {
+    const amount = Number((e.target as HTMLInputElement).value);
+    this.emit({ ...this.value, amount });
+  }
+
+  private onPointChange(idx: number, e: Event) {
+    const v = Math.max(0, Math.min(100, Number((e.target as HTMLInputElement).value)));
+    const points = this.value.points.map((p, i) => i === idx ? v : p);
+    this.emit({ ...this.value, points });
+  }
+
+  private renderAmount() {
+    const cfg = this.value;
+    return html`
+      <label class="form-label">Strength (${cfg.amount}%)</label>
+      <input
+        type="range"
+        class="form-range"
+        min="0"
+        max="100"
+        .value=${String(cfg.amount)}
+        @input=${this.onAmountChange}
+      />
+    `;
+  }
+
+  private renderPoints() {
+    const cfg = this.value;
+    return html`
+      <div class="input-group input-group-sm" title="Output in % at 25/50/75/100 % deflection">
+        ${cfg.points.map((p, i) => html`
+          <input
+            type="number"
+            min="0"
+            max="100"
+            class="form-control"
+            .value=${String(p)}
+            @change=${(e: Event) => this.onPointChange(i, e)}
+          />
+        `)}
+      </div>
+    `;
+  }
+
+  override render() {
+    const cfg = this.value;
+    return html`
+      <div class="mb-2">
+        <label class="form-label">Curve</label>
+        <select class="form-select" .value=${String(cfg.type)} @change=${this.onTypeChange}>
+          <option value="0" ?selected=${cfg.type === Btj.CurveType.LINEAR}>Linear</option>
+          <option value="1" ?selected=${cfg.type === Btj.CurveType.EXPO}>Expo</option>
+          <option value="2" ?selected=${cfg.type === Btj.CurveType.S}>S-curve</option>
+          <option value="3" ?selected=${cfg.type === Btj.CurveType.CUSTOM}>Custom</option>
+        </select>
+      </div>
+      ${cfg.type === Btj.CurveType.EXPO || cfg.type === Btj.CurveType.S ? this.renderAmount() : ''}
+      ${cfg.type === Btj.CurveType.CUSTOM ? this.renderPoints() : ''}
+    `;
+  }
+}
+
+declare global {
+  interface HTMLElementTagNameMap {
+    'curve-editor': CurveEditor;
+  }
+}
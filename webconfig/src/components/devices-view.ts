@@ -12,18 +12,95 @@ export const STATE_ICONS: Record<number, string> = {
   [Btj.ConnState.READY]: 'bi bi-check-circle-fill text-success',
 };
 
+const PHY_NAMES: Record<number, string> = {
+  1: '1M',
+  2: '2M',
+  4: 'Coded',
+};
+
+// Common disconnection reasons (HCI error codes)
+const DISCONNECT_REASONS: Record<number, string> = {
+  0x08: 'supervision timeout',
+  0x13: 'terminated by device',
+  0x16: 'terminated locally',
+  0x22: 'LL response timeout',
+  0x3B: 'unacceptable parameters',
+  0x3D: 'MIC failure',
+  0x3E: 'failed to establish',
+};
+
+// Labels of the report interval histogram buckets
+const INTERVAL_LABELS = Btj.REPORT_INTERVAL_BOUNDS.map((bound, i) =>
+  i === 0 ? `<${bound}` : `${Btj.REPORT_INTERVAL_BOUNDS[i - 1]}-${bound}`
+).concat(`≥${Btj.REPORT_INTERVAL_BOUNDS[Btj.REPORT_INTERVAL_BOUNDS.length - 1]}`);
+
 @customElement("devices-view")
 export class DevicesView extends MobxLitElement {
   protected override createRenderRoot() {
     return this;
   }
 
+  override connectedCallback(): void {
+    super.connectedCallback();
+    btj.subscribeLinkStats(true);
+  }
+
+  override disconnectedCallback(): void {
+    btj.subscribeLinkStats(false);
+    super.disconnectedCallback();
+  }
+
   private onProfileChange(dev: DeviceEntry, e: Event) {
     const profileId = parseInt((e.target as HTMLSelectElement).value);
-    btj.setDeviceProfile(dev.addr, profileId);
+    btj.setDeviceConfig(dev.addr, { ...dev.config, profile: profileId });
+  }
+
+  private onBootProtocolChange(dev: DeviceEntry, e: Event) {
+    const bootProtocol = (e.target as HTMLInputElement).checked;
+    btj.setDeviceConfig(dev.addr, { ...dev.config, bootProtocol });
+  }
+
+  // Profiles of the library, including the assigned one even if not listed yet
+  private profileOptions(current: number): number[] {
+    const ids = new Set(btj.profiles.keys());
+    ids.add(current);
+    return Array.from(ids).sort((a, b) => a - b);
+  }
+
+  private renderLinkStats(stats: Btj.LinkStats) {
+    const total = stats.reportIntervals.reduce((a, b) => a + b, 0);
+    const reasons = stats.disconnectReasons.map(r =>
+      `0x${r.toString(16).padStart(2, '0')}${DISCONNECT_REASONS[r] ? ` ${DISCONNECT_REASONS[r]}` : ''}`);
+
+    return html`
+      <tr>
+        <td colspan="5" class="small text-body-secondary">
+          <div>
+            Interval ${stats.connInterval} ms, latency ${stats.connLatency},
+            timeout ${stats.connTimeout} ms,
+            PHY ${PHY_NAMES[stats.txPhy] ?? stats.txPhy}/${PHY_NAMES[stats.rxPhy] ?? stats.rxPhy},
+            RSSI ${stats.rssi !== null ? `${stats.rssi} dBm` : '-'}
+          </div>
+          <div>
+            ${stats.reportRate} reports/s, ${stats.reports} received, ~${stats.missed} missed,
+            ${stats.disconnects} disconnects${reasons.length > 0 ? ` (${reasons.join(', ')})` : ''}
+          </div>
+          <div class="d-flex gap-2 flex-wrap" title="Report intervals (ms)">
+            ${stats.reportIntervals.map((count, i) => html`
+              <span>
+                ${INTERVAL_LABELS[i]}:
+                ${total > 0 ? Math.round(count * 100 / total) : 0}%
+              </span>
+            `)}
+          </div>
+        </td>
+      </tr>
+    `;
   }
 
   private renderDeviceRow(dev: DeviceEntry) {
+    const stats = btj.linkStats.get(dev.addr.toString());
+
     return html`
       <tr>
         <td>${dev.addr.toString()}</td>
@@ -36,16 +113,25 @@ export class DevicesView extends MobxLitElement {
             class="form-select form-select-sm"
             @change=${(e: Event) => this.onProfileChange(dev, e)}
           >
-            ${[0, 1, 2, 3, 4].map(p => html`
+            ${this.profileOptions(dev.config?.profile ?? 0).map(p => html`
               <option
                 value=${String(p)}
                 ?selected=${p === (dev.config?.profile ?? 0)}
               >
-                ${p}
+                ${btj.getProfile(p)?.name ? `${p}: ${btj.getProfile(p)!.name}` : p}
               </option>
            `)}
           </select>
         </td>
+        <td>
+          <input
+            type="checkbox"
+            class="form-check-input"
+            title="Use HID boot protocol (mice and keyboards)"
+            .checked=${dev.config?.bootProtocol ?? false}
+            @change=${(e: Event) => this.onBootProtocolChange(dev, e)}
+          />
+        </td>
 
         <td class="text-end">
           <button
@@ -59,6 +145,7 @@ export class DevicesView extends MobxLitElement {
           </button>
         </td>
       </tr>
+      ${stats ? this.renderLinkStats(stats) : nothing}
     `;
   }
 
@@ -72,6 +159,7 @@ export class DevicesView extends MobxLitElement {
               <th>MAC Address</th>
               <th>State</th>
               <th>Profile</th>
+              <th>Boot</th>
                <th class="text-end"><span class="d-none d-sm-inline">Actions</span></th>
             </tr>
           </thead>
@@ -79,7 +167,7 @@ export class DevicesView extends MobxLitElement {
           <tbody>
             ${btj.devices.length === 0 ? html`
               <tr>
-                <td colspan="4">No devices found.</td>
+                <td colspan="5">No devices found.</td>
               </tr>
             `: btj.devices.map(dev => this.renderDeviceRow(dev))}
           </tbody>
@@ -4,6 +4,7 @@ import { btj } from '../models/btj-model.js';
 import { Btj } from '../services/btj-messages.js';
 import { HID_USAGE_TYPE } from '../utils/hid-usage.js';
 import './hid-usage-select.js';
+import './curve-editor.js';
 
 @customElement('intg-editor')
 export class IntgEditor extends LitElement {
@@ -139,6 +140,11 @@ export class IntgEditor extends LitElement {
     `;
   }
 
+  private onCurveChange = (e: CustomEvent) => {
+    this._local = { ...this._local, curve: e.detail.value };
+    this.emitEdit();
+  }
+
   override render() {
     const mode = this._local.mode;
     const usageType = HID_USAGE_TYPE[this._local.source];
@@ -172,6 +178,14 @@ export class IntgEditor extends LitElement {
                 <div class="col-12 col-xl-2">
                   ${usageType != '' ? this.renderMax() : ''}
                 </div>
+                <div class="col-12 col-xl-2">
+                  ${usageType != '' && mode === Btj.IntgMode.ABSOLUTE ? html`
+                    <curve-editor
+                      .value=${this._local.curve}
+                      @curve-change=${this.onCurveChange}
+                    ></curve-editor>
+                  ` : ''}
+                </div>
               </div>
             </div>
           </div>
@@ -41,7 +41,7 @@ export class PinEditor extends LitElement {
         <label class="form-label">Source</label>
         <hid-usage-select
           .value=${cfg.source}
-          .filter=${['digital', 'analog', 'hatswitch', 'digital-intg']}
+          .filter=${['digital', 'analog', 'hatswitch', 'digital-intg', 'digital-expr']}
           @change=${this.onSourceChange}
         >
         </hid-usage-select>
@@ -155,6 +155,35 @@ export class PinEditor extends LitElement {
     `;
   }
 
+  private onAutofireChange = (e: Event) => {
+    const v = Number((e.target as HTMLSelectElement).value);
+    this._local = { ...this._local, autofire: v };
+    this.emitEdit();
+  }
+
+  private renderAutofire() {
+    const cfg = this._local;
+    const periods = [0, 1, 2, 3, 4, 6, 8, 12];
+    return html`
+      <div class="mb-2">
+        <label class="form-label">Autofire</label>
+        <select
+          class="form-select"
+          @change=${this.onAutofireChange}
+        >
+          ${!periods.includes(cfg.autofire)
+        ? html`<option value=${String(cfg.autofire)} selected>${cfg.autofire} frames</option>`
+        : ''}
+          ${periods.map(v => html`
+            <option value=${String(v)} ?selected=${v === cfg.autofire}>
+              ${v === 0 ? 'Off' : `${v} ${v === 1 ? 'frame' : 'frames'}`}
+            </option>
+          `)}
+        </select>
+      </div>
+    `;
+  }
+
   override render() {
     const usageType = HID_USAGE_TYPE[this._local.source];
 
@@ -199,6 +228,12 @@ export class PinEditor extends LitElement {
                     ${this.renderHysteresis()}
                   </div>
                   ` : ''}
+
+                  ${usageType != '' && usageType != 'digital-intg' ? html`
+                  <div class="col-6 col-xl-2">
+                    ${this.renderAutofire()}
+                  </div>
+                  ` : ''}
                 </div>
             </div>
 
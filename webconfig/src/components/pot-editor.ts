@@ -4,6 +4,7 @@ import { btj } from '../models/btj-model.js';
 import { Btj } from '../services/btj-messages.js';
 import { HID_USAGE_TYPE } from '../utils/hid-usage.js';
 import './hid-usage-select.js';
+import './curve-editor.js';
 
 @customElement('pot-editor')
 export class PotEditor extends LitElement {
@@ -90,6 +91,11 @@ export class PotEditor extends LitElement {
     `;
   }
 
+  private onCurveChange = (e: CustomEvent) => {
+    this._local = { ...this._local, curve: e.detail.value };
+    this.emitEdit();
+  }
+
   override render() {
     const usageType = HID_USAGE_TYPE[this._local.source];
     return html`
@@ -125,6 +131,12 @@ export class PotEditor extends LitElement {
                   ${usageType != '' ? this.renderMax() : ''}
                 </div>
                 <div class="col-12 col-xl-2">
+                  ${usageType != '' ? html`
+                    <curve-editor
+                      .value=${this._local.curve}
+                      @curve-change=${this.onCurveChange}
+                    ></curve-editor>
+                  ` : ''}
                 </div>
               </div>
             </div>
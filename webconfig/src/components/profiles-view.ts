@@ -3,11 +3,14 @@ import { html } from "lit";
 import { customElement, property } from "lit/decorators.js";
 import { autorun, IReactionDisposer } from "mobx";
 import { btj } from "../models/btj-model.js";
+import { Btj } from "../services/btj-messages.js";
 
 
+import "./hid-usage-select.js";
 import "./intg-editor.js";
 import "./pin-editor.js";
 import "./pot-editor.js";
+import "./program-editor.js";
 
 @customElement("profiles-view")
 export class ProfilesView extends MobxLitElement {
@@ -26,6 +29,7 @@ export class ProfilesView extends MobxLitElement {
     this._disposer = autorun(() => {
       // access profiles to create dependency
       void btj.profiles.size;
+      void btj.activeProfile;
       this.requestUpdate();
     });
   }
@@ -35,11 +39,74 @@ export class ProfilesView extends MobxLitElement {
     super.disconnectedCallback();
   }
 
+  private onChordChange = (e: CustomEvent) => {
+    btj.setChord(this.profileId, e.detail.value);
+  }
+
+  private onNameChange = (e: Event) => {
+    // Names are stored as ASCII
+    btj.setName(this.profileId, (e.target as HTMLInputElement).value.replace(/[^ -~]/g, '').trim());
+  }
+
+  private onDelete = async () => {
+    const quick = this.profileId < Btj.QUICK_PROFILES;
+    if (!confirm(quick ? 'Clear all mappings of this profile?' : 'Delete this profile?')) {
+      return;
+    }
+    await btj.deleteProfile(this.profileId);
+    if (!quick) {
+      window.location.hash = '/devices';
+    }
+  }
+
+  private renderName(name: string) {
+    return html`
+      <div class="card">
+        <div class="card-body">
+          <h6 class="card-title">Name</h6>
+          <div class="input-group input-group-sm">
+            <input
+              type="text"
+              class="form-control"
+              maxlength=${Btj.PROFILE_NAME_LEN}
+              pattern="[ -~]*"
+              .value=${name}
+              @change=${this.onNameChange}
+            />
+            <button type="button" class="btn btn-outline-danger" @click=${this.onDelete}>
+              ${this.profileId < Btj.QUICK_PROFILES ? 'Clear' : 'Delete'}
+            </button>
+          </div>
+        </div>
+      </div>
+    `;
+  }
+
+  private renderChord(chord: number) {
+    return html`
+      <div class="card">
+        <div class="card-body">
+          <h6 class="card-title">Profile switching</h6>
+          <label class="form-label">Chord button (hat switch up/right/down/left selects profile 0-3)</label>
+          <hid-usage-select
+            .value=${chord}
+            .filter=${['digital']}
+            @change=${this.onChordChange}
+          >
+          </hid-usage-select>
+        </div>
+      </div>
+    `;
+  }
+
   override render() {
     const profile = btj.getProfile(this.profileId)!;
 
     return html`
-      <h2 class="mb-4">Profile #${this.profileId}</h2>
+      <h2 class="mb-4">
+        Profile #${this.profileId}${profile?.name ? html`: ${profile.name}` : ''}
+        ${btj.activeProfile === this.profileId ? html`<span class="badge bg-success fs-6 align-middle">Active</span>` : ''}
+      </h2>
       <div class="container-fluid">
         <div class="row">
           <div class="col-12">
@@ -50,6 +117,11 @@ export class ProfilesView extends MobxLitElement {
               ` : html`
               <form>
                 <div class="row g-3">
+                  <div class="row mb-3 g-0">
+                    <div class="col-12 g-0">
+                      ${this.renderName(profile.name)}
+                    </div>
+                  </div>
                   ${Array.from(profile.pins.entries()).map(([pid]) => html`
                     <div class="row mb-3 g-0">
                       <div class="col-12 g-0">
@@ -85,6 +157,16 @@ export class ProfilesView extends MobxLitElement {
                       </div>
                     </div>
                   `)}
+                  <div class="row mb-3 g-0">
+                    <div class="col-12 g-0">
+                      <program-editor .profileId=${this.profileId}></program-editor>
+                    </div>
+                  </div>
+                  <div class="row mb-3 g-0">
+                    <div class="col-12 g-0">
+                      ${this.renderChord(profile.chord)}
+                    </div>
+                  </div>
                 </div>
               </form>
             `}
@@ -0,0 +1,95 @@
+import { html, LitElement } from 'lit';
+import { customElement, property, state } from 'lit/decorators.js';
+import { btj } from '../models/btj-model.js';
+import { Btj } from '../services/btj-messages.js';
+import { compileExpr, decompileProgram } from '../utils/mapping-expr.js';
+
+// Must match MAPPER_PROGRAM_MAX_EXPRS in the firmware
+const EXPR_COUNT = 5;
+
+// Editor of the profile mapping program, one expression per
+// pin source 'Expression n'
+@customElement('program-editor')
+export class ProgramEditor extends LitElement {
+  protected override createRenderRoot() {
+    return this;
+  }
+
+  @property({ type: Number }) profileId!: number;
+
+  @state() private _exprs: string[] = [];
+  @state() private _error: string | null = null;
+
+  override willUpdate(changed: any) {
+    if (changed.has('profileId') && this.profileId !== undefined) {
+      const program = btj.profiles.get(this.profileId)?.program ?? [];
+      try {
+        this._exprs = decompileProgram(program);
+      } catch (err: any) {
+        this._exprs = [];
+        this._error = err.message;
+      }
+    }
+  }
+
+  private onExprChange(idx: number, e: Event) {
+    const exprs = Array.from({ length: EXPR_COUNT }, (_, i) => this._exprs[i] ?? '');
+    exprs[idx] = (e.target as HTMLInputElement).value.trim();
+
+    // Expressions are addressed by their index, so keep the empty
+    // ones in the middle as constant false
+    const last = exprs.reduce((acc, text, i) => text !== '' ? i : acc, -1);
+    const used = exprs.slice(0, last + 1);
+
+    let program: number[] = [];
+    try {
+      used.forEach((text, i) => {
+        try {
+          program = program.concat(compileExpr(text !== '' ? text : '0'));
+        } catch (err: any) {
+          throw new Error(`Expression ${i}: ${err.message}`);
+        }
+      });
+      if (program.length > Btj.PROGRAM_SIZE) {
+        throw new Error(`Program is too long (${program.length}/${Btj.PROGRAM_SIZE} bytes)`);
+      }
+    } catch (err: any) {
+      this._exprs = exprs;
+      this._error = err.message;
+      return;
+    }
+
+    this._exprs = used;
+    this._error = null;
+    btj.setProgram(this.profileId, program);
+  }
+
+  override render() {
+    return html`
+      <div class="card">
+        <div class="card-body">
+          <h6 class="card-title">Expressions</h6>
+          ${Array.from({ length: EXPR_COUNT }, (_, i) => html`
+            <div class="input-group input-group-sm mb-1">
+              <span class="input-group-text">${i}</span>
+              <input
+                type="text"
+                class="form-control font-monospace"
+                placeholder="e.g. BUTTON_1 | Z > 50 | hat(UP)"
+                .value=${this._exprs[i] ?? ''}
+                @change=${(e: Event) => this.onExprChange(i, e)}
+              />
+            </div>
+          `)}
+          ${this._error ? html`<div class="text-danger small">${this._error}</div>` : ''}
+        </div>
+      </div>
+    `;
+  }
+}
+
+declare global {
+  interface HTMLElementTagNameMap {
+    'program-editor': ProgramEditor;
+  }
+}
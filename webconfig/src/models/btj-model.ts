@@ -30,6 +30,9 @@ export interface ProfileEntry {
   pins: Map<number, Btj.PinConfig>;
   pots: Map<number, Btj.PotConfig>;
   intgs: Map<number, Btj.IntgConfig>;
+  program: number[];
+  chord: number;
+  name: string;
 }
 
 export interface ErrorEntry {
@@ -41,6 +44,9 @@ export interface ErrorEntry {
 export class BtjModel {
   private _errorIdCounter = 0;
 
+  // Link statistics are requested while a view shows them
+  private _linkStatsSubscribed = false;
+
   constructor() {
     // Make the instance observable so MobX tracks fields and methods
     // (works regardless of decorator transform settings).
@@ -68,9 +74,17 @@ export class BtjModel {
   @observable
   advDevices: Btj.AdvData[] = [];
 
+  // Link statistics of the connected devices (by address string)
+  @observable
+  linkStats: Map<string, Btj.LinkStats> = new Map();
+
   @observable
   profiles: Map<number, ProfileEntry> = new Map();
 
+  // Profile used for mapping (switched by a chord or the device button)
+  @observable
+  activeProfile: number | null = null;
+
 
   @computed
   get connected(): boolean {
@@ -164,6 +178,7 @@ export class BtjModel {
     } else {
       // Entry removed
       this.devices = this.devices.filter(dev => !dev.addr.equals(evt.addr));
+      this.linkStats.delete(evt.addr.toString());
     }
   }
 
@@ -171,10 +186,39 @@ export class BtjModel {
   private processProfileUpdateEvent(payload: DataView) {
     const evt = new Btj.ProfileUpdateEvent();
     evt.parseMessage(payload);
-    const entry: ProfileEntry = { pins: evt.pins, pots: evt.pots, intgs: evt.intgs };
+    if (evt.empty && evt.profile >= Btj.QUICK_PROFILES) {
+      // Deleted from the library
+      this.profiles.delete(evt.profile);
+      return;
+    }
+    const entry: ProfileEntry = {
+      pins: evt.pins, pots: evt.pots, intgs: evt.intgs, program: evt.program, chord: evt.chord,
+      name: evt.name
+    };
     this.profiles.set(evt.profile, entry);
   }
 
+  @action
+  private processActiveProfileUpdateEvent(payload: DataView) {
+    const evt = new Btj.ActiveProfileUpdateEvent();
+    evt.parseMessage(payload);
+    this.activeProfile = evt.profile;
+  }
+
+  @action
+  private processLinkStatsUpdateEvent(payload: DataView) {
+    const evt = new Btj.LinkStatsUpdateEvent();
+    evt.parseMessage(payload);
+    this.linkStats.set(evt.addr.toString(), evt.data);
+  }
+
+  // Deletions were lost on the device, the complete lists follow
+  @action
+  private processListResetEvent() {
+    this.advDevices = [];
+    this.removeAllDevices();
+  }
+
   @action
   private processIoPortUpdateEvent(payload: DataView) {
     const evt = new Btj.IoPortUpdateEvent();
@@ -202,6 +246,15 @@ export class BtjModel {
         case Btj.MsgId.EVT_IO_PORT_UPDATE:
           this.processIoPortUpdateEvent(payload);
           break;
+        case Btj.MsgId.EVT_ACTIVE_PROFILE_UPDATE:
+          this.processActiveProfileUpdateEvent(payload);
+          break;
+        case Btj.MsgId.EVT_LINK_STATS_UPDATE:
+          this.processLinkStatsUpdateEvent(payload);
+          break;
+        case Btj.MsgId.EVT_LIST_RESET:
+          this.processListResetEvent();
+          break;
       }
     } catch (err) {
       console.error('Failed to handle event', err);
@@ -225,6 +278,9 @@ export class BtjModel {
       // Wait for the connection to be fully initialized
       await this.conn.connect();
       this.sysInfo = (await this.conn.invoke(new Btj.GetSysInfo())).data;
+      if (this._linkStatsSubscribed) {
+        await this.conn.invoke(new Btj.Subscribe(Btj.SUBSCRIBE_LINK_STATS));
+      }
     } catch (err: any) {
       this.logError(err, 'connection');
       this.disconnect();
@@ -241,6 +297,7 @@ export class BtjModel {
     this.conn = null;
     this.sysInfo = null;
     this.sysState = null;
+    this.activeProfile = null;
   }
 
   getProfile(id: number): ProfileEntry | undefined {
@@ -255,6 +312,7 @@ export class BtjModel {
   @action
   removeAllDevices() {
     this.devices.splice(0, this.devices.length);
+    this.linkStats.clear();
   }
 
   @action
@@ -311,6 +369,110 @@ export class BtjModel {
     }
   }
 
+  @action
+  async setProgram(profileId: number, program: number[]) {
+    if (!this.conn) throw new Error('Not connected');
+    const profile = this.profiles.get(profileId)!;
+    const prev = profile.program;
+    // Update local cache
+    profile.program = program;
+    try {
+      // The program is only updated as a part of the whole profile
+      await this.conn.invoke(new Btj.SetProfile(profileId, profile));
+    } catch (err: any) {
+      this.logError(err, 'profile');
+      // Revert local cache change on error
+      profile.program = prev;
+    }
+  }
+
+  @action
+  async setChord(profileId: number, chord: number) {
+    if (!this.conn) throw new Error('Not connected');
+    const profile = this.profiles.get(profileId)!;
+    const prev = profile.chord;
+    // Update local cache
+    profile.chord = chord;
+    try {
+      // The chord is only updated as a part of the whole profile
+      await this.conn.invoke(new Btj.SetProfile(profileId, profile));
+    } catch (err: any) {
+      this.logError(err, 'profile');
+      // Revert local cache change on error
+      profile.chord = prev;
+    }
+  }
+
+  @action
+  async setName(profileId: number, name: string) {
+    if (!this.conn) throw new Error('Not connected');
+    const profile = this.profiles.get(profileId)!;
+    const prev = profile.name;
+    // Update local cache
+    profile.name = name;
+    try {
+      // The name is only updated as a part of the whole profile
+      await this.conn.invoke(new Btj.SetProfile(profileId, profile));
+    } catch (err: any) {
+      this.logError(err, 'profile');
+      // Revert local cache change on error
+      profile.name = prev;
+    }
+  }
+
+  // Adds a named profile to the first free slot of the library
+  //
+  // Returns the profile index or null if the library is full
+  @action
+  async createProfile(name: string): Promise<number | null> {
+    if (!this.conn) throw new Error('Not connected');
+    let profileId = Btj.QUICK_PROFILES;
+    while (profileId < Btj.MAX_PROFILES && this.profiles.has(profileId)) profileId++;
+    if (profileId >= Btj.MAX_PROFILES) {
+      this.logError(new Error('Profile library is full'), 'profile');
+      return null;
+    }
+    const profile: ProfileEntry = { ...Btj.emptyProfile(), name };
+    this.profiles.set(profileId, profile);
+    try {
+      await this.conn.invoke(new Btj.SetProfile(profileId, profile));
+    } catch (err: any) {
+      this.logError(err, 'profile');
+      this.profiles.delete(profileId);
+      return null;
+    }
+    return profileId;
+  }
+
+  // Deletes the profile from the library (quick profiles are only cleared)
+  @action
+  async deleteProfile(profileId: number) {
+    if (!this.conn) throw new Error('Not connected');
+    try {
+      await this.conn.invoke(new Btj.SetProfile(profileId, Btj.emptyProfile()));
+    } catch (err: any) {
+      this.logError(err, 'profile');
+      return;
+    }
+    // The device doesn't echo our own changes back
+    if (profileId >= Btj.QUICK_PROFILES) {
+      this.profiles.delete(profileId);
+    } else {
+      this.profiles.set(profileId, Btj.emptyProfile());
+    }
+  }
+
+  @action
+  async subscribeLinkStats(enable: boolean): Promise<void> {
+    this._linkStatsSubscribed = enable;
+    if (!this.conn) return;
+    try {
+      await this.conn.invoke(new Btj.Subscribe(enable ? Btj.SUBSCRIBE_LINK_STATS : 0));
+    } catch (err: any) {
+      this.logError(err, 'device');
+    }
+  }
+
   @action
   async deleteDevice(addr: Btj.DevAddr): Promise<void> {
     if (!this.conn) throw new Error('Not connected');
@@ -318,16 +480,26 @@ export class BtjModel {
       await this.conn.invoke(new Btj.DeleteDevice(addr));
     } catch (err: any) {
       this.logError(err, 'device');
+      return;
     }
+    // The device doesn't echo our own changes back
+    this.devices = this.devices.filter(dev => !dev.addr.equals(addr));
+    this.linkStats.delete(addr.toString());
   }
 
   @action
-  async setDeviceProfile(addr: Btj.DevAddr, profile: number): Promise<void> {
+  async setDeviceConfig(addr: Btj.DevAddr, config: Btj.DevConfig): Promise<void> {
     if (!this.conn) throw new Error('Not connected');
     try {
-      await this.conn.invoke(new Btj.SetDevConfig(addr, { profile }));
+      await this.conn.invoke(new Btj.SetDevConfig(addr, config));
     } catch (err: any) {
       this.logError(err, 'device');
+      return;
+    }
+    // The device doesn't echo our own changes back
+    const idx = this.devices.findIndex(dev => dev.addr.equals(addr));
+    if (idx >= 0) {
+      this.devices.splice(idx, 1, { ...this.devices[idx], config });
     }
   }
 
@@ -65,12 +65,16 @@ export namespace Btj {
     CONNECT_DEVICE = 10,
     DELETE_DEVICE = 11,
     FACTORY_RESET = 12,
+    SUBSCRIBE = 14,
 
     EVT_SYS_STATE_UPDATE = 64,
     EVT_IO_PORT_UPDATE = 65,
     EVT_ADV_LIST_UPDATE = 66,
     EVT_DEV_LIST_UPDATE = 67,
     EVT_PROFILE_UPDATE = 68,
+    EVT_ACTIVE_PROFILE_UPDATE = 69,
+    EVT_LINK_STATS_UPDATE = 71,
+    EVT_LIST_RESET = 72,
   }
 
   export interface Command {
@@ -217,17 +221,22 @@ export namespace Btj {
 
   export type DevConfig = {
     profile: number;
+    // Use HID boot protocol (mice and keyboards only)
+    bootProtocol: boolean;
   };
 
+  const DEV_FLAG_BOOT_PROTOCOL = 0x01;
+
   export class SetDevConfig implements Command {
     readonly msgId = MsgId.SET_DEV_CONFIG;
 
     constructor(private _addr: DevAddr, private _data: DevConfig) { }
     serializeRequest(): ArrayBuffer {
-      const buf = new ArrayBuffer(DevAddr.LENGTH + 1);
+      const buf = new ArrayBuffer(DevAddr.LENGTH + 2);
       const view = new DataView(buf);
       this._addr.copyTo(0, view);
       view.setUint8(DevAddr.LENGTH, this._data.profile);
+      view.setUint8(DevAddr.LENGTH + 1, this._data.bootProtocol ? DEV_FLAG_BOOT_PROTOCOL : 0);
       return buf;
     }
 
@@ -251,6 +260,8 @@ export namespace Btj {
     hatSwitch: number = 0;
     threshold: number = 0;
     hysteresis: number = 0;
+    // Autofire period in frames (0 => off)
+    autofire: number = 0;
 
     static default(): PinConfig {
       return new PinConfig();
@@ -262,7 +273,7 @@ export namespace Btj {
 
     constructor(private _profile: number, private _id: number, private _data: PinConfig) { }
     serializeRequest(): ArrayBuffer {
-      const buf = new ArrayBuffer(4 + 8);
+      const buf = new ArrayBuffer(4 + 12);
       const view = new DataView(buf);
       view.setUint8(0, this._profile);
       view.setUint8(1, this._id);
@@ -271,6 +282,7 @@ export namespace Btj {
       view.setUint8(9, this._data.hatSwitch);
       view.setUint8(10, this._data.threshold);
       view.setUint8(11, this._data.hysteresis);
+      view.setUint8(12, this._data.autofire);
       return buf;
     }
 
@@ -292,10 +304,35 @@ export namespace Btj {
   }
 
 
+  export enum CurveType {
+    LINEAR = 0,
+    EXPO = 1,
+    S = 2,
+    CUSTOM = 3,
+  }
+
+  // Response curve, applied symmetrically to the deflection from center
+  export class Curve {
+    type: CurveType = CurveType.LINEAR;
+    amount: number = 0;  // percent (EXPO, S)
+    points: number[] = [25, 50, 75, 100];  // percent at 25/50/75/100 % deflection (CUSTOM)
+
+    static default(): Curve {
+      return new Curve();
+    }
+  }
+
+  function writeCurve(view: DataView, offset: number, curve: Curve) {
+    view.setUint8(offset, curve.type);
+    view.setUint8(offset + 1, curve.amount);
+    curve.points.forEach((p, i) => view.setUint8(offset + 2 + i, p));
+  }
+
   export class PotConfig {
     source: number = 0;
     low: number = 0;
     high: number = 0;
+    curve: Curve = Curve.default();
 
     static default(): PotConfig {
       return new PotConfig();
@@ -307,13 +344,14 @@ export namespace Btj {
 
     constructor(private _profile: number, private _id: number, private _data: PotConfig) { }
     serializeRequest(): ArrayBuffer {
-      const buf = new ArrayBuffer(4 + 8);
+      const buf = new ArrayBuffer(4 + 16);
       const view = new DataView(buf);
       view.setUint8(0, this._profile);
       view.setUint8(1, this._id);
       view.setUint32(4, this._data.source, true);
       view.setInt16(8, this._data.low, true);
       view.setInt16(10, this._data.high, true);
+      writeCurve(view, 12, this._data.curve);
       return buf;
     }
 
@@ -345,6 +383,7 @@ export namespace Btj {
     deadZone: number = 0;
     gain: number = 0;
     max: number = 0;
+    curve: Curve = Curve.default();
 
     static default(): IntgConfig {
       return new IntgConfig();
@@ -357,7 +396,7 @@ export namespace Btj {
     constructor(private _profile: number, private _id: number, private _data: IntgConfig) { }
 
     serializeRequest(): ArrayBuffer {
-      const buf = new ArrayBuffer(16);
+      const buf = new ArrayBuffer(20);
       const view = new DataView(buf);
       view.setUint8(0, this._profile);
       view.setUint8(1, this._id);
@@ -367,6 +406,7 @@ export namespace Btj {
       const gainFixed = Math.round(this._data.gain * 256.0); // Convert float to Q7.8
       view.setInt16(10, gainFixed, true);
       view.setInt16(12, this._data.max, true);
+      writeCurve(view, 14, this._data.curve);
       return buf;
     }
 
@@ -493,6 +533,25 @@ export namespace Btj {
     }
   }
 
+  // Periodic events sent only after subscribing to them
+  export const SUBSCRIBE_LINK_STATS = 0x01;
+
+  export class Subscribe implements Command {
+    readonly msgId = MsgId.SUBSCRIBE;
+
+    constructor(private _events: number) { }
+    serializeRequest(): ArrayBuffer {
+      const buf = new ArrayBuffer(1);
+      const view = new DataView(buf);
+      view.setUint8(0, this._events);
+      return buf;
+    }
+
+    parseResponse(view: DataView) {
+      assertPayloadLength(view, 0);
+    }
+  }
+
   export class SysStateUpdateEvent {
     readonly msgId = MsgId.EVT_SYS_STATE_UPDATE;
 
@@ -543,15 +602,16 @@ export namespace Btj {
     private _config?: DevConfig;
 
     parseMessage(view: DataView) {
-      assertPayloadLength(view, 1 + DevAddr.LENGTH + 1 + 1);
+      assertPayloadLength(view, 1 + DevAddr.LENGTH + 1 + 1 + 1);
       const deleted = view.getUint8(0) ? true : false;
       const addr = DevAddr.copyFrom(1, view);
       const connState = view.getInt8(8);
       const profile = view.getUint8(9);
+      const flags = view.getUint8(10);
       this._deleted = deleted;
       this._addr = addr;
       this._state = { connState };
-      this._config = { profile };
+      this._config = { profile, bootProtocol: (flags & DEV_FLAG_BOOT_PROTOCOL) !== 0 };
     }
 
     get deleted(): boolean {
@@ -571,63 +631,375 @@ export namespace Btj {
     }
   }
 
-  export class ProfileUpdateEvent {
-    readonly msgId = MsgId.EVT_PROFILE_UPDATE;
+  // Profile encoding (version 2): presence bitmap followed by the
+  // present slots, sources as varints, signed values as zigzag varints,
+  // pins with the autofire flag end with the period, pot and integrator
+  // slots end with a response curve, the optional mapping program,
+  // chord button and name follow the integrators
+  const PROFILE_DATA_VERSION = 2;
+  const PIN_COUNT = 5;
+  const POT_COUNT = 2;
+  const INTG_COUNT = 2;
+  const SLOT_PROGRAM = PIN_COUNT + POT_COUNT + INTG_COUNT;
+  const SLOT_CHORD = SLOT_PROGRAM + 1;
+  const SLOT_NAME = SLOT_CHORD + 1;
+  export const PROGRAM_SIZE = 64;
 
-    private _profile?: number;
+  // Must match MAPPER_MAX_PROFILES and MAPPER_QUICK_PROFILES in the firmware
+  export const MAX_PROFILES = 64;
+  export const QUICK_PROFILES = 4;
+  export const PROFILE_NAME_LEN = 15;
 
-    private _pins: Map<number, PinConfig> = new Map();
-    private _pots: Map<number, PotConfig> = new Map();
-    private _intgs: Map<number, IntgConfig> = new Map();
+  class ProfileReader {
+    private _offset: number;
 
-    parseMessage(view: DataView) {
-      assertPayloadLength(view, 4 + 5 * 8 + 2 * 8 + 2 * 12);
-      this._profile = view.getUint8(0);
+    constructor(private _view: DataView, offset: number) {
+      this._offset = offset;
+    }
 
-      for (let i = 0; i < 5; i++) {
-        const offset = 4 + i * 8;
-        const source = view.getUint32(offset, true);
-        const invert = Boolean(view.getUint8(offset + 4));
-        const hatSwitch = view.getUint8(offset + 5);
-        const threshold = view.getUint8(offset + 6);
-        const hysteresis = view.getUint8(offset + 7);
-        this._pins.set(i, { source, invert, hatSwitch, threshold, hysteresis });
+    get done(): boolean {
+      return this._offset === this._view.byteLength;
+    }
+
+    u8(): number {
+      if (this._offset >= this._view.byteLength) throw new globalThis.Error('Truncated profile data');
+      return this._view.getUint8(this._offset++);
+    }
+
+    varint(): number {
+      let value = 0;
+      for (let shift = 0; shift < 35; shift += 7) {
+        const byte = this.u8();
+        value += (byte & 0x7f) * 2 ** shift;
+        if ((byte & 0x80) === 0) return value >>> 0;
       }
+      throw new globalThis.Error('Invalid varint');
+    }
+
+    svarint(): number {
+      const value = this.varint();
+      return (value & 1) ? -((value + 1) / 2) : value / 2;
+    }
+  }
+
+  class ProfileWriter {
+    private _bytes: number[] = [];
+
+    u8(value: number) {
+      this._bytes.push(value & 0xff);
+    }
+
+    varint(value: number) {
+      value >>>= 0;
+      do {
+        const byte = value & 0x7f;
+        value = Math.floor(value / 128);
+        this.u8(value !== 0 ? byte | 0x80 : byte);
+      } while (value !== 0);
+    }
+
+    svarint(value: number) {
+      this.varint(value < 0 ? -2 * value - 1 : 2 * value);
+    }
+
+    get bytes(): number[] {
+      return this._bytes;
+    }
+  }
+
+  export type ProfileData = {
+    pins: Map<number, PinConfig>;
+    pots: Map<number, PotConfig>;
+    intgs: Map<number, IntgConfig>;
+    // Mapping program bytecode (see utils/mapping-expr.ts)
+    program: number[];
+    // Button selecting profiles by the hat switch while held (0 => disabled)
+    chord: number;
+    // Profile name (ASCII, empty if unnamed)
+    name: string;
+  };
+
+  // Profile with nothing assigned, setting it deletes the profile from the library
+  export function emptyProfile(): ProfileData {
+    return {
+      pins: new Map(Array.from({ length: PIN_COUNT }, (_, i) => [i, PinConfig.default()])),
+      pots: new Map(Array.from({ length: POT_COUNT }, (_, i) => [i, PotConfig.default()])),
+      intgs: new Map(Array.from({ length: INTG_COUNT }, (_, i) => [i, IntgConfig.default()])),
+      program: [],
+      chord: 0,
+      name: '',
+    };
+  }
+
+  function isEmptyPin(pin: PinConfig): boolean {
+    return !pin.source && !pin.invert && !pin.hatSwitch && !pin.threshold && !pin.hysteresis &&
+      !pin.autofire;
+  }
+
+  function isLinearCurve(curve: Curve): boolean {
+    return curve.type === CurveType.LINEAR;
+  }
+
+  function isEmptyPot(pot: PotConfig): boolean {
+    return !pot.source && !pot.low && !pot.high && isLinearCurve(pot.curve);
+  }
 
-      for (let i = 0; i < 2; i++) {
-        const offset = 4 + 5 * 8 + i * 8;
-        const source = view.getUint32(offset, true);
-        const low = view.getInt16(offset + 4, true);
-        const high = view.getInt16(offset + 6, true);
-        this._pots.set(i, { source, low, high });
+  function isEmptyIntg(intg: IntgConfig): boolean {
+    return !intg.source && !intg.mode && !intg.deadZone && !intg.gain && !intg.max &&
+      isLinearCurve(intg.curve);
+  }
+
+  function readCurve(r: ProfileReader): Curve {
+    const curve = Curve.default();
+    curve.type = r.u8();
+    switch (curve.type) {
+      case CurveType.LINEAR:
+        break;
+      case CurveType.EXPO:
+      case CurveType.S:
+        curve.amount = r.u8();
+        break;
+      case CurveType.CUSTOM:
+        curve.points = curve.points.map(() => r.u8());
+        break;
+      default:
+        throw new globalThis.Error('Unsupported curve type');
+    }
+    return curve;
+  }
+
+  function writeCurveData(w: ProfileWriter, curve: Curve) {
+    w.u8(curve.type);
+    if (curve.type === CurveType.EXPO || curve.type === CurveType.S) {
+      w.u8(curve.amount);
+    } else if (curve.type === CurveType.CUSTOM) {
+      curve.points.forEach(p => w.u8(p));
+    }
+  }
+
+  function decodeProfile(view: DataView, offset: number): ProfileData {
+    const r = new ProfileReader(view, offset);
+    const version = r.u8();
+    if (version !== PROFILE_DATA_VERSION) {
+      throw new globalThis.Error('Unsupported profile version');
+    }
+
+    const present = r.u8() | (r.u8() << 8);
+    const data: ProfileData = {
+      pins: new Map(), pots: new Map(), intgs: new Map(), program: [], chord: 0, name: ''
+    };
+
+    for (let i = 0; i < PIN_COUNT; i++) {
+      const pin = PinConfig.default();
+      if (present & (1 << i)) {
+        pin.source = r.varint();
+        const flags = r.u8();
+        pin.invert = (flags & 0x01) !== 0;
+        pin.hatSwitch = flags >> 4;
+        pin.threshold = r.u8();
+        pin.hysteresis = r.u8();
+        if (flags & 0x02) pin.autofire = r.u8();
       }
+      data.pins.set(i, pin);
+    }
 
-      for (let i = 0; i < 2; i++) {
-        const offset = 4 + 5 * 8 + 2 * 8 + i * 12;
-        const source = view.getUint32(offset, true);
-        const mode = view.getUint8(offset + 4);
-        const deadZone = view.getUint8(offset + 5);
-        const gainFixed = view.getInt16(offset + 6, true);
-        const gain = gainFixed / 256.0; // Convert Q7.8 to float
-        const max = view.getInt16(offset + 8, true);
-        this._intgs.set(i, { source, mode, deadZone, gain: gain, max: max });
+    for (let i = 0; i < POT_COUNT; i++) {
+      const pot = PotConfig.default();
+      if (present & (1 << (PIN_COUNT + i))) {
+        pot.source = r.varint();
+        pot.low = r.svarint();
+        pot.high = r.svarint();
+        pot.curve = readCurve(r);
       }
+      data.pots.set(i, pot);
+    }
+
+    for (let i = 0; i < INTG_COUNT; i++) {
+      const intg = IntgConfig.default();
+      if (present & (1 << (PIN_COUNT + POT_COUNT + i))) {
+        intg.source = r.varint();
+        intg.mode = r.u8();
+        intg.deadZone = r.u8();
+        intg.gain = r.svarint() / 256.0; // Convert Q7.8 to float
+        intg.max = r.svarint();
+        intg.curve = readCurve(r);
+      }
+      data.intgs.set(i, intg);
+    }
+
+    if (present & (1 << SLOT_PROGRAM)) {
+      const size = r.u8();
+      for (let i = 0; i < size; i++) data.program.push(r.u8());
+    }
+
+    if (present & (1 << SLOT_CHORD)) {
+      data.chord = r.varint();
+    }
+
+    if (present & (1 << SLOT_NAME)) {
+      const len = r.u8();
+      for (let i = 0; i < len; i++) data.name += String.fromCharCode(r.u8());
+    }
+
+    if (!r.done) throw new globalThis.Error('Invalid profile data length');
+
+    return data;
+  }
+
+  function encodeProfile(data: ProfileData): number[] {
+    const pins = Array.from({ length: PIN_COUNT }, (_, i) => data.pins.get(i) ?? PinConfig.default());
+    const pots = Array.from({ length: POT_COUNT }, (_, i) => data.pots.get(i) ?? PotConfig.default());
+    const intgs = Array.from({ length: INTG_COUNT }, (_, i) => data.intgs.get(i) ?? IntgConfig.default());
+
+    let present = 0;
+    pins.forEach((pin, i) => { if (!isEmptyPin(pin)) present |= 1 << i; });
+    pots.forEach((pot, i) => { if (!isEmptyPot(pot)) present |= 1 << (PIN_COUNT + i); });
+    intgs.forEach((intg, i) => { if (!isEmptyIntg(intg)) present |= 1 << (PIN_COUNT + POT_COUNT + i); });
+    if (data.program.length > 0) present |= 1 << SLOT_PROGRAM;
+    if (data.chord) present |= 1 << SLOT_CHORD;
+    const name = data.name.slice(0, PROFILE_NAME_LEN);
+    if (name.length > 0) present |= 1 << SLOT_NAME;
+
+    const w = new ProfileWriter();
+    w.u8(PROFILE_DATA_VERSION);
+    w.u8(present & 0xff);
+    w.u8(present >> 8);
+
+    pins.forEach((pin, i) => {
+      if (present & (1 << i)) {
+        w.varint(pin.source);
+        w.u8((pin.invert ? 0x01 : 0) | (pin.autofire ? 0x02 : 0) | (pin.hatSwitch << 4));
+        w.u8(pin.threshold);
+        w.u8(pin.hysteresis);
+        if (pin.autofire) w.u8(pin.autofire);
+      }
+    });
+
+    pots.forEach((pot, i) => {
+      if (present & (1 << (PIN_COUNT + i))) {
+        w.varint(pot.source);
+        w.svarint(pot.low);
+        w.svarint(pot.high);
+        writeCurveData(w, pot.curve);
+      }
+    });
+
+    intgs.forEach((intg, i) => {
+      if (present & (1 << (PIN_COUNT + POT_COUNT + i))) {
+        w.varint(intg.source);
+        w.u8(intg.mode);
+        w.u8(intg.deadZone);
+        w.svarint(Math.round(intg.gain * 256.0)); // Convert float to Q7.8
+        w.svarint(intg.max);
+        writeCurveData(w, intg.curve);
+      }
+    });
+
+    if (present & (1 << SLOT_PROGRAM)) {
+      w.u8(data.program.length);
+      data.program.forEach(b => w.u8(b));
+    }
+
+    if (present & (1 << SLOT_CHORD)) {
+      w.varint(data.chord);
+    }
+
+    if (present & (1 << SLOT_NAME)) {
+      w.u8(name.length);
+      for (let i = 0; i < name.length; i++) w.u8(name.charCodeAt(i));
+    }
+
+    return w.bytes;
+  }
+
+  export class SetProfile implements Command {
+    readonly msgId = MsgId.SET_PROFILE;
+
+    constructor(private _profile: number, private _data: ProfileData) { }
+
+    serializeRequest(): ArrayBuffer {
+      const bytes = [this._profile, ...encodeProfile(this._data)];
+      return new Uint8Array(bytes).buffer;
+    }
+
+    parseResponse(view: DataView) {
+      assertPayloadLength(view, 0);
+    }
+
+    get profile(): number {
+      return this._profile;
+    }
+
+    get data(): ProfileData {
+      return this._data;
+    }
+  }
+
+  export class ProfileUpdateEvent {
+    readonly msgId = MsgId.EVT_PROFILE_UPDATE;
+
+    private _profile?: number;
+    private _data?: ProfileData;
+    private _empty?: boolean;
+
+    parseMessage(view: DataView) {
+      this._profile = view.getUint8(0);
+      this._data = decodeProfile(view, 1);
+      // Nothing present in the bitmap
+      this._empty = view.getUint8(2) === 0 && view.getUint8(3) === 0;
     }
 
     get profile(): number {
       return assertPresent(this._profile);
     }
 
+    // True if the profile is not configured (deleted from the library)
+    get empty(): boolean {
+      return assertPresent(this._empty);
+    }
+
     get pins(): Map<number, PinConfig> {
-      return this._pins;
+      return assertPresent(this._data).pins;
     }
 
     get pots(): Map<number, PotConfig> {
-      return this._pots;
+      return assertPresent(this._data).pots;
     }
 
     get intgs(): Map<number, IntgConfig> {
-      return this._intgs;
+      return assertPresent(this._data).intgs;
+    }
+
+    get program(): number[] {
+      return assertPresent(this._data).program;
+    }
+
+    get chord(): number {
+      return assertPresent(this._data).chord;
+    }
+
+    get name(): string {
+      return assertPresent(this._data).name;
+    }
+  }
+
+  // Value of the active profile if no report was mapped yet
+  export const ACTIVE_PROFILE_NONE = 0xFF;
+
+  export class ActiveProfileUpdateEvent {
+    readonly msgId = MsgId.EVT_ACTIVE_PROFILE_UPDATE;
+
+    private _profile?: number;
+
+    parseMessage(view: DataView) {
+      assertPayloadLength(view, 1);
+      this._profile = view.getUint8(0);
+    }
+
+    // Profile used for mapping, null if there is none yet
+    get profile(): number | null {
+      const profile = assertPresent(this._profile);
+      return profile !== ACTIVE_PROFILE_NONE ? profile : null;
     }
   }
 
@@ -654,4 +1026,78 @@ export namespace Btj {
     }
   }
 
+  // Upper bounds of the report interval histogram buckets (ms),
+  // the last bucket is open
+  export const REPORT_INTERVAL_BOUNDS = [5, 10, 15, 20, 30, 50, 100];
+
+  // RSSI value of a device that is not connected
+  const RSSI_INVALID = 127;
+
+  export type LinkStats = {
+    // Connection RSSI (dBm), null if not connected
+    rssi: number | null;
+    reports: number;
+    // Estimate of missed notifications
+    missed: number;
+    // Report inter-arrival time histogram (see REPORT_INTERVAL_BOUNDS)
+    reportIntervals: number[];
+    // Connection interval and supervision timeout (ms), peripheral latency (events)
+    connInterval: number;
+    connLatency: number;
+    connTimeout: number;
+    // Reports per second
+    reportRate: number;
+    // 1 => 1M, 2 => 2M, 4 => Coded
+    txPhy: number;
+    rxPhy: number;
+    disconnects: number;
+    // HCI error codes, the most recent first
+    disconnectReasons: number[];
+  };
+
+  export class LinkStatsUpdateEvent {
+    readonly msgId = MsgId.EVT_LINK_STATS_UPDATE;
+
+    private _addr?: DevAddr;
+    private _data?: LinkStats;
+
+    parseMessage(view: DataView) {
+      assertPayloadLength(view, 64);
+      const addr = DevAddr.copyFrom(0, view);
+      const rssi = view.getInt8(7);
+      const reports = view.getUint32(8, true);
+      const missed = view.getUint32(12, true);
+      const reportIntervals: number[] = [];
+      for (let i = 0; i <= REPORT_INTERVAL_BOUNDS.length; i++) {
+        reportIntervals.push(view.getUint32(16 + i * 4, true));
+      }
+      const connInterval = view.getUint16(48, true) * 1.25;
+      const connLatency = view.getUint16(50, true);
+      const connTimeout = view.getUint16(52, true) * 10;
+      const reportRate = view.getUint16(54, true);
+      const txPhy = view.getUint8(56);
+      const rxPhy = view.getUint8(57);
+      const disconnects = view.getUint16(58, true);
+      const disconnectReasons: number[] = [];
+      for (let i = 0; i < 4; i++) {
+        const reason = view.getUint8(60 + i);
+        if (reason !== 0) disconnectReasons.push(reason);
+      }
+      this._addr = addr;
+      this._data = {
+        rssi: rssi !== RSSI_INVALID ? rssi : null,
+        reports, missed, reportIntervals, connInterval, connLatency, connTimeout, reportRate,
+        txPhy, rxPhy, disconnects, disconnectReasons,
+      };
+    }
+
+    get addr(): DevAddr {
+      return assertPresent(this._addr);
+    }
+
+    get data(): LinkStats {
+      return assertPresent(this._data);
+    }
+  }
+
 }
@@ -44,6 +44,61 @@ export enum HidUsage {
   BUTTON_31 = 0x09001F,
   BUTTON_32 = 0x090020,
 
+  // Keyboard keys
+  KEY_A = 0x070004,
+  KEY_B = 0x070005,
+  KEY_C = 0x070006,
+  KEY_D = 0x070007,
+  KEY_E = 0x070008,
+  KEY_F = 0x070009,
+  KEY_G = 0x07000A,
+  KEY_H = 0x07000B,
+  KEY_I = 0x07000C,
+  KEY_J = 0x07000D,
+  KEY_K = 0x07000E,
+  KEY_L = 0x07000F,
+  KEY_M = 0x070010,
+  KEY_N = 0x070011,
+  KEY_O = 0x070012,
+  KEY_P = 0x070013,
+  KEY_Q = 0x070014,
+  KEY_R = 0x070015,
+  KEY_S = 0x070016,
+  KEY_T = 0x070017,
+  KEY_U = 0x070018,
+  KEY_V = 0x070019,
+  KEY_W = 0x07001A,
+  KEY_X = 0x07001B,
+  KEY_Y = 0x07001C,
+  KEY_Z = 0x07001D,
+  KEY_1 = 0x07001E,
+  KEY_2 = 0x07001F,
+  KEY_3 = 0x070020,
+  KEY_4 = 0x070021,
+  KEY_5 = 0x070022,
+  KEY_6 = 0x070023,
+  KEY_7 = 0x070024,
+  KEY_8 = 0x070025,
+  KEY_9 = 0x070026,
+  KEY_0 = 0x070027,
+  KEY_ENTER = 0x070028,
+  KEY_ESCAPE = 0x070029,
+  KEY_BACKSPACE = 0x07002A,
+  KEY_TAB = 0x07002B,
+  KEY_SPACE = 0x07002C,
+  KEY_RIGHT = 0x07004F,
+  KEY_LEFT = 0x070050,
+  KEY_DOWN = 0x070051,
+  KEY_UP = 0x070052,
+  KEY_LEFT_CTRL = 0x0700E0,
+  KEY_LEFT_SHIFT = 0x0700E1,
+  KEY_LEFT_ALT = 0x0700E2,
+  KEY_LEFT_GUI = 0x0700E3,
+  KEY_RIGHT_CTRL = 0x0700E4,
+  KEY_RIGHT_SHIFT = 0x0700E5,
+  KEY_RIGHT_ALT = 0x0700E6,
+  KEY_RIGHT_GUI = 0x0700E7,
+
   INTG0_QA = 0xFFF00000, // Encoder 0, quadrature encoder, channel A
   INTG0_QB = 0xFFF00001, // Encoder 0, quadrature encoder, channel B
   INTG0_ABS = 0xFFF00002, // Integrator 0, absolute mode
@@ -52,6 +107,12 @@ export enum HidUsage {
   INTG1_QB = 0xFFF00101, // Encoder 1, quadrature encoder, channel B
   INTG1_ABS = 0xFFF00102, // Integrator 1, absolute mode
   INTG1_ENC = 0xFFF00103, // Integrator 1, encoder mode
+
+  EXPR0 = 0xFFE00000, // Mapping program expression 0
+  EXPR1 = 0xFFE00001, // Mapping program expression 1
+  EXPR2 = 0xFFE00002, // Mapping program expression 2
+  EXPR3 = 0xFFE00003, // Mapping program expression 3
+  EXPR4 = 0xFFE00004, // Mapping program expression 4
 }
 
 export const HID_USAGE_LABELS: Record<number, string> = {
@@ -97,6 +158,59 @@ export const HID_USAGE_LABELS: Record<number, string> = {
   [HidUsage.BUTTON_30]: 'Button 30',
   [HidUsage.BUTTON_31]: 'Button 31',
   [HidUsage.BUTTON_32]: 'Button 32',
+  [HidUsage.KEY_A]: 'Key A',
+  [HidUsage.KEY_B]: 'Key B',
+  [HidUsage.KEY_C]: 'Key C',
+  [HidUsage.KEY_D]: 'Key D',
+  [HidUsage.KEY_E]: 'Key E',
+  [HidUsage.KEY_F]: 'Key F',
+  [HidUsage.KEY_G]: 'Key G',
+  [HidUsage.KEY_H]: 'Key H',
+  [HidUsage.KEY_I]: 'Key I',
+  [HidUsage.KEY_J]: 'Key J',
+  [HidUsage.KEY_K]: 'Key K',
+  [HidUsage.KEY_L]: 'Key L',
+  [HidUsage.KEY_M]: 'Key M',
+  [HidUsage.KEY_N]: 'Key N',
+  [HidUsage.KEY_O]: 'Key O',
+  [HidUsage.KEY_P]: 'Key P',
+  [HidUsage.KEY_Q]: 'Key Q',
+  [HidUsage.KEY_R]: 'Key R',
+  [HidUsage.KEY_S]: 'Key S',
+  [HidUsage.KEY_T]: 'Key T',
+  [HidUsage.KEY_U]: 'Key U',
+  [HidUsage.KEY_V]: 'Key V',
+  [HidUsage.KEY_W]: 'Key W',
+  [HidUsage.KEY_X]: 'Key X',
+  [HidUsage.KEY_Y]: 'Key Y',
+  [HidUsage.KEY_Z]: 'Key Z',
+  [HidUsage.KEY_1]: 'Key 1',
+  [HidUsage.KEY_2]: 'Key 2',
+  [HidUsage.KEY_3]: 'Key 3',
+  [HidUsage.KEY_4]: 'Key 4',
+  [HidUsage.KEY_5]: 'Key 5',
+  [HidUsage.KEY_6]: 'Key 6',
+  [HidUsage.KEY_7]: 'Key 7',
+  [HidUsage.KEY_8]: 'Key 8',
+  [HidUsage.KEY_9]: 'Key 9',
+  [HidUsage.KEY_0]: 'Key 0',
+  [HidUsage.KEY_ENTER]: 'Key Enter',
+  [HidUsage.KEY_ESCAPE]: 'Key Escape',
+  [HidUsage.KEY_BACKSPACE]: 'Key Backspace',
+  [HidUsage.KEY_TAB]: 'Key Tab',
+  [HidUsage.KEY_SPACE]: 'Key Space',
+  [HidUsage.KEY_RIGHT]: 'Key Right',
+  [HidUsage.KEY_LEFT]: 'Key Left',
+  [HidUsage.KEY_DOWN]: 'Key Down',
+  [HidUsage.KEY_UP]: 'Key Up',
+  [HidUsage.KEY_LEFT_CTRL]: 'Key Left Ctrl',
+  [HidUsage.KEY_LEFT_SHIFT]: 'Key Left Shift',
+  [HidUsage.KEY_LEFT_ALT]: 'Key Left Alt',
+  [HidUsage.KEY_LEFT_GUI]: 'Key Left GUI',
+  [HidUsage.KEY_RIGHT_CTRL]: 'Key Right Ctrl',
+  [HidUsage.KEY_RIGHT_SHIFT]: 'Key Right Shift',
+  [HidUsage.KEY_RIGHT_ALT]: 'Key Right Alt',
+  [HidUsage.KEY_RIGHT_GUI]: 'Key Right GUI',
   [HidUsage.INTG0_QA]: 'INT0.A',
   [HidUsage.INTG0_QB]: 'INT0.B',
   [HidUsage.INTG0_ABS]: 'INT0.Abs',
@@ -105,10 +219,15 @@ export const HID_USAGE_LABELS: Record<number, string> = {
   [HidUsage.INTG1_QB]: 'INT1.B',
   [HidUsage.INTG1_ABS]: 'INT1.Abs',
   [HidUsage.INTG1_ENC]: 'INT1.Enc',
+  [HidUsage.EXPR0]: 'Expression 0',
+  [HidUsage.EXPR1]: 'Expression 1',
+  [HidUsage.EXPR2]: 'Expression 2',
+  [HidUsage.EXPR3]: 'Expression 3',
+  [HidUsage.EXPR4]: 'Expression 4',
 };
 
 // Control type meta: classify HID usages as 'analog', 'digital', or 'hatswitch'
-export type HidControlType = '' | 'analog' | 'digital' | 'hatswitch' | 'analog-intg' | 'digital-intg';
+export type HidControlType = '' | 'analog' | 'digital' | 'hatswitch' | 'analog-intg' | 'digital-intg' | 'digital-expr';
 
 export const HID_USAGE_TYPE: Record<number, HidControlType> = {
   [HidUsage.NOT_ASSIGNED]: '',
@@ -165,8 +284,69 @@ export const HID_USAGE_TYPE: Record<number, HidControlType> = {
   [HidUsage.BUTTON_31]: 'digital',
   [HidUsage.BUTTON_32]: 'digital',
 
+  // Keyboard keys
+  [HidUsage.KEY_A]: 'digital',
+  [HidUsage.KEY_B]: 'digital',
+  [HidUsage.KEY_C]: 'digital',
+  [HidUsage.KEY_D]: 'digital',
+  [HidUsage.KEY_E]: 'digital',
+  [HidUsage.KEY_F]: 'digital',
+  [HidUsage.KEY_G]: 'digital',
+  [HidUsage.KEY_H]: 'digital',
+  [HidUsage.KEY_I]: 'digital',
+  [HidUsage.KEY_J]: 'digital',
+  [HidUsage.KEY_K]: 'digital',
+  [HidUsage.KEY_L]: 'digital',
+  [HidUsage.KEY_M]: 'digital',
+  [HidUsage.KEY_N]: 'digital',
+  [HidUsage.KEY_O]: 'digital',
+  [HidUsage.KEY_P]: 'digital',
+  [HidUsage.KEY_Q]: 'digital',
+  [HidUsage.KEY_R]: 'digital',
+  [HidUsage.KEY_S]: 'digital',
+  [HidUsage.KEY_T]: 'digital',
+  [HidUsage.KEY_U]: 'digital',
+  [HidUsage.KEY_V]: 'digital',
+  [HidUsage.KEY_W]: 'digital',
+  [HidUsage.KEY_X]: 'digital',
+  [HidUsage.KEY_Y]: 'digital',
+  [HidUsage.KEY_Z]: 'digital',
+  [HidUsage.KEY_1]: 'digital',
+  [HidUsage.KEY_2]: 'digital',
+  [HidUsage.KEY_3]: 'digital',
+  [HidUsage.KEY_4]: 'digital',
+  [HidUsage.KEY_5]: 'digital',
+  [HidUsage.KEY_6]: 'digital',
+  [HidUsage.KEY_7]: 'digital',
+  [HidUsage.KEY_8]: 'digital',
+  [HidUsage.KEY_9]: 'digital',
+  [HidUsage.KEY_0]: 'digital',
+  [HidUsage.KEY_ENTER]: 'digital',
+  [HidUsage.KEY_ESCAPE]: 'digital',
+  [HidUsage.KEY_BACKSPACE]: 'digital',
+  [HidUsage.KEY_TAB]: 'digital',
+  [HidUsage.KEY_SPACE]: 'digital',
+  [HidUsage.KEY_RIGHT]: 'digital',
+  [HidUsage.KEY_LEFT]: 'digital',
+  [HidUsage.KEY_DOWN]: 'digital',
+  [HidUsage.KEY_UP]: 'digital',
+  [HidUsage.KEY_LEFT_CTRL]: 'digital',
+  [HidUsage.KEY_LEFT_SHIFT]: 'digital',
+  [HidUsage.KEY_LEFT_ALT]: 'digital',
+  [HidUsage.KEY_LEFT_GUI]: 'digital',
+  [HidUsage.KEY_RIGHT_CTRL]: 'digital',
+  [HidUsage.KEY_RIGHT_SHIFT]: 'digital',
+  [HidUsage.KEY_RIGHT_ALT]: 'digital',
+  [HidUsage.KEY_RIGHT_GUI]: 'digital',
+
   [HidUsage.INTG0_QA]: 'digital-intg',
   [HidUsage.INTG0_QB]: 'digital-intg',
   [HidUsage.INTG1_QA]: 'digital-intg',
   [HidUsage.INTG1_QB]: 'digital-intg',
+
+  [HidUsage.EXPR0]: 'digital-expr',
+  [HidUsage.EXPR1]: 'digital-expr',
+  [HidUsage.EXPR2]: 'digital-expr',
+  [HidUsage.EXPR3]: 'digital-expr',
+  [HidUsage.EXPR4]: 'digital-expr',
 };
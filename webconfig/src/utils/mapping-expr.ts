@@ -0,0 +1,243 @@
+// Compiler of mapping expressions into the firmware bytecode
+//
+// Grammar (lowest to highest precedence):
+//   expr    := and ('|' and)*
+//   and     := cmp ('&' cmp)*
+//   cmp     := unary (('>' | '<') unary)?
+//   unary   := '!' unary | primary
+//   primary := NUMBER                      (constant in %, 0..100)
+//            | USAGE                       (HidUsage name, e.g. BUTTON_1, Z, KEY_A)
+//            | 'hat' '(' DIR ('+' DIR)* ')'  (DIR is UP, DOWN, LEFT or RIGHT)
+//            | 'hyst' '(' expr ',' NUMBER ',' NUMBER ')'
+//            | 'sel' '(' expr ',' expr ',' expr ')'
+//            | '(' expr ')'
+//
+// Example: `BUTTON_1 | Z > 50 | hat(UP+LEFT)`
+
+import { HidUsage } from './hid-usage.js';
+
+export enum MappingOp {
+  END = 0x00,
+  LOAD = 0x01,
+  HAT = 0x02,
+  CONST = 0x03,
+  GT = 0x04,
+  LT = 0x05,
+  AND = 0x06,
+  OR = 0x07,
+  NOT = 0x08,
+  HYST = 0x09,
+  SELECT = 0x0A,
+}
+
+// Must match MAPPER_PROGRAM_STACK_SIZE in the firmware
+const STACK_SIZE = 8;
+
+const HAT_DIRS: Record<string, number> = {
+  UP: 1 << 0,
+  DOWN: 1 << 1,
+  LEFT: 1 << 2,
+  RIGHT: 1 << 3,
+};
+
+class Parser {
+  private tokens: string[];
+  private pos = 0;
+  readonly code: number[] = [];
+  private depth = 0;
+
+  constructor(text: string) {
+    this.tokens = text.match(/[A-Za-z_][A-Za-z0-9_]*|\d+|\S/g) ?? [];
+  }
+
+  private peek(): string | undefined {
+    return this.tokens[this.pos];
+  }
+
+  private next(): string {
+    const t = this.tokens[this.pos++];
+    if (t === undefined) throw new Error('Unexpected end of expression');
+    return t;
+  }
+
+  private expect(t: string) {
+    const got = this.next();
+    if (got !== t) throw new Error(`Expected '${t}' but got '${got}'`);
+  }
+
+  private emit(op: MappingOp, stackEffect: number, ...operands: number[]) {
+    this.code.push(op, ...operands);
+    this.depth += stackEffect;
+    if (this.depth > STACK_SIZE) throw new Error('Expression is too complex');
+  }
+
+  private percent(): number {
+    const t = this.next();
+    const v = Number(t);
+    if (!/^\d+$/.test(t) || v > 100) throw new Error(`Expected a percentage but got '${t}'`);
+    return v;
+  }
+
+  parse() {
+    if (this.tokens.length === 0) throw new Error('Empty expression');
+    this.expr();
+    if (this.pos < this.tokens.length) throw new Error(`Unexpected '${this.peek()}'`);
+    this.emit(MappingOp.END, -1);
+  }
+
+  private expr() {
+    this.and();
+    while (this.peek() === '|') {
+      this.pos++;
+      this.and();
+      this.emit(MappingOp.OR, -1);
+    }
+  }
+
+  private and() {
+    this.cmp();
+    while (this.peek() === '&') {
+      this.pos++;
+      this.cmp();
+      this.emit(MappingOp.AND, -1);
+    }
+  }
+
+  private cmp() {
+    this.unary();
+    const t = this.peek();
+    if (t === '>' || t === '<') {
+      this.pos++;
+      this.unary();
+      this.emit(t === '>' ? MappingOp.GT : MappingOp.LT, -1);
+    }
+  }
+
+  private unary() {
+    if (this.peek() === '!') {
+      this.pos++;
+      this.unary();
+      this.emit(MappingOp.NOT, 0);
+    } else {
+      this.primary();
+    }
+  }
+
+  private primary() {
+    const t = this.next();
+
+    if (t === '(') {
+      this.expr();
+      this.expect(')');
+    } else if (/^\d+$/.test(t)) {
+      this.pos--;
+      this.emit(MappingOp.CONST, 1, this.percent());
+    } else if (t.toLowerCase() === 'hat') {
+      this.expect('(');
+      let mask = 0;
+      do {
+        const dir = HAT_DIRS[this.next().toUpperCase()];
+        if (dir === undefined) throw new Error('Expected UP, DOWN, LEFT or RIGHT');
+        mask |= dir;
+      } while (this.peek() === '+' && this.next());
+      this.expect(')');
+      this.emit(MappingOp.HAT, 1, mask);
+    } else if (t.toLowerCase() === 'hyst') {
+      this.expect('(');
+      this.expr();
+      this.expect(',');
+      const low = this.percent();
+      this.expect(',');
+      const high = this.percent();
+      this.expect(')');
+      this.emit(MappingOp.HYST, 0, low, high);
+    } else if (t.toLowerCase() === 'sel') {
+      this.expect('(');
+      this.expr();
+      this.expect(',');
+      this.expr();
+      this.expect(',');
+      this.expr();
+      this.expect(')');
+      this.emit(MappingOp.SELECT, -2);
+    } else {
+      const usage = (HidUsage as any)[t.toUpperCase()];
+      if (typeof usage !== 'number' || usage === HidUsage.NOT_ASSIGNED) {
+        throw new Error(`Unknown usage '${t}'`);
+      }
+      this.emit(MappingOp.LOAD, 1, usage & 0xFF, (usage >>> 8) & 0xFF,
+        (usage >>> 16) & 0xFF, (usage >>> 24) & 0xFF);
+    }
+  }
+}
+
+// Compiles a single expression, throws an Error with a readable message
+export function compileExpr(text: string): number[] {
+  const parser = new Parser(text);
+  parser.parse();
+  return parser.code;
+}
+
+// Splits the program bytecode into expressions and decompiles them
+export function decompileProgram(code: number[]): string[] {
+  const exprs: string[] = [];
+  let stack: { text: string, prec: number }[] = [];
+
+  // Wraps the operand in parentheses if it binds weaker than the operator
+  const wrap = (e: { text: string, prec: number }, prec: number) =>
+    e.prec < prec ? `(${e.text})` : e.text;
+
+  // Comparisons don't chain, so both of their operands bind tighter
+  const binary = (sep: string, prec: number, chains = true) => {
+    const b = stack.pop()!;
+    const a = stack.pop()!;
+    stack.push({ text: `${wrap(a, chains ? prec : prec + 1)} ${sep} ${wrap(b, prec + 1)}`, prec });
+  };
+
+  for (let pos = 0; pos < code.length;) {
+    const op = code[pos++];
+    switch (op) {
+      case MappingOp.END:
+        exprs.push(stack.pop()?.text ?? '');
+        stack = [];
+        break;
+      case MappingOp.LOAD: {
+        const usage = (code[pos] | (code[pos + 1] << 8) | (code[pos + 2] << 16) | (code[pos + 3] << 24)) >>> 0;
+        pos += 4;
+        const name = HidUsage[usage] ?? `0x${usage.toString(16).toUpperCase()}`;
+        stack.push({ text: name, prec: 5 });
+      } break;
+      case MappingOp.HAT: {
+        const mask = code[pos++];
+        const dirs = Object.entries(HAT_DIRS).filter(([, bit]) => mask & bit).map(([name]) => name);
+        stack.push({ text: `hat(${dirs.join('+')})`, prec: 5 });
+      } break;
+      case MappingOp.CONST:
+        stack.push({ text: String(code[pos++]), prec: 5 });
+        break;
+      case MappingOp.GT: binary('>', 3, false); break;
+      case MappingOp.LT: binary('<', 3, false); break;
+      case MappingOp.AND: binary('&', 2); break;
+      case MappingOp.OR: binary('|', 1); break;
+      case MappingOp.NOT: {
+        const a = stack.pop()!;
+        stack.push({ text: `!${wrap(a, 4)}`, prec: 4 });
+      } break;
+      case MappingOp.HYST: {
+        const a = stack.pop()!;
+        stack.push({ text: `hyst(${a.text}, ${code[pos]}, ${code[pos + 1]})`, prec: 5 });
+        pos += 2;
+      } break;
+      case MappingOp.SELECT: {
+        const c = stack.pop()!;
+        const b = stack.pop()!;
+        const a = stack.pop()!;
+        stack.push({ text: `sel(${a.text}, ${b.text}, ${c.text})`, prec: 5 });
+      } break;
+      default:
+        throw new Error(`Unknown opcode 0x${op.toString(16)}`);
+    }
+  }
+
+  return exprs;
+}